@@ -0,0 +1,115 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/storage/storage_engine_init.h"
+
+#include "mongo/db/catalog/catalog_control.h"
+#include "mongo/db/catalog/catalog_test_fixture.h"
+#include "mongo/db/client.h"
+#include "mongo/db/concurrency/d_concurrency.h"
+#include "mongo/db/storage/storage_engine.h"
+#include "mongo/idl/server_parameter.h"
+#include "mongo/stdx/thread.h"
+#include "mongo/unittest/barrier.h"
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+namespace {
+
+const NamespaceString kNss("test.coll");
+
+class ReinitializeStorageEngineTest : public CatalogTestFixture {
+protected:
+    ReinitializeStorageEngineTest() : CatalogTestFixture("wiredTiger") {}
+
+    /**
+     * Replaces the storage engine the way installing the data files copied by initial sync does.
+     */
+    void reinitialize() {
+        auto opCtx = operationContext();
+        Lock::GlobalWrite globalWrite(opCtx);
+        catalog::closeCatalog(opCtx);
+        reinitializeStorageEngine(opCtx);
+        catalog::openCatalog(opCtx, {});
+        getServiceContext()->getStorageEngine()->notifyStartupComplete();
+    }
+};
+
+TEST_F(ReinitializeStorageEngineTest, PreservesDataAndServerParameters) {
+    auto opCtx = operationContext();
+    ASSERT_OK(storageInterface()->createCollection(opCtx, kNss, CollectionOptions()));
+    auto doc = BSON("_id" << 1);
+    ASSERT_OK(storageInterface()->insertDocument(opCtx, kNss, {doc, Timestamp()}, 0));
+
+    // The server parameters of the old storage engine are deregistered before the new one
+    // registers them again.
+    reinitialize();
+    ASSERT_EQ(1UL,
+              ServerParameterSet::getGlobal()->getMap().count("wiredTigerEngineRuntimeConfig"));
+
+    ASSERT_BSONOBJ_EQ(doc,
+                      unittest::assertGet(storageInterface()->findById(opCtx, kNss, doc["_id"])));
+
+    // The new storage engine can be replaced in turn.
+    reinitialize();
+    ASSERT_EQ(1UL, unittest::assertGet(storageInterface()->getCollectionCount(opCtx, kNss)));
+}
+
+TEST_F(ReinitializeStorageEngineTest, KillsAndWaitsForOtherOperations) {
+    unittest::Barrier barrier(2);
+    Status otherStatus = Status::OK();
+    stdx::thread otherThread([&] {
+        ThreadClient tc("ReinitializeStorageEngineTest", getServiceContext());
+        auto otherOpCtx = tc->makeOperationContext();
+        barrier.countDownAndWait();
+        try {
+            otherOpCtx->sleepFor(Hours(1));
+        } catch (const DBException& ex) {
+            otherStatus = ex.toStatus();
+        }
+    });
+
+    // The storage engine is only destroyed once the other operation is gone.
+    barrier.countDownAndWait();
+    reinitialize();
+    otherThread.join();
+    ASSERT_EQ(ErrorCodes::InterruptedDueToReplStateChange, otherStatus);
+
+    // Operations created after the storage engine is replaced use the new one.
+    auto newClient = getServiceContext()->makeClient("ReinitializeStorageEngineTest");
+    AlternativeClientRegion acr(newClient);
+    auto newOpCtx = cc().makeOperationContext();
+    ASSERT_OK(storageInterface()->createCollection(newOpCtx.get(), kNss, CollectionOptions()));
+}
+
+}  // namespace
+}  // namespace mongo
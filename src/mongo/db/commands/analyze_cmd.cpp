@@ -0,0 +1,164 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/auth/authorization_session.h"
+#include "mongo/db/commands.h"
+#include "mongo/db/commands/analyze_gen.h"
+#include "mongo/db/db_raii.h"
+#include "mongo/db/dbdirectclient.h"
+#include "mongo/db/exec/working_set_common.h"
+#include "mongo/db/query/collection_statistics.h"
+#include "mongo/db/query/internal_plans.h"
+#include "mongo/platform/random.h"
+#include "mongo/rpc/get_status_from_command_result.h"
+
+namespace mongo {
+namespace {
+
+/**
+ * Collects statistics about the values of a field of a collection, and stores them in the
+ * database's statistics collection for the query planner to use.
+ *
+ * {
+ *     analyze: <collection>,
+ *     key: <field path>,
+ *     sampleSize: <maximum number of keys sampled for the histogram>,
+ *     numBuckets: <maximum number of histogram buckets>,
+ * }
+ */
+class AnalyzeCommand final : public TypedCommand<AnalyzeCommand> {
+public:
+    using Request = AnalyzeCommandRequest;
+
+    std::string help() const override {
+        return "Collects statistics about the values of a field of a collection for the query "
+               "planner. Usage: {analyze: <collection>, key: <field path>, "
+               "sampleSize: <number>, numBuckets: <number>}";
+    }
+
+    bool adminOnly() const override {
+        return false;
+    }
+
+    AllowedOnSecondary secondaryAllowed(ServiceContext*) const override {
+        return AllowedOnSecondary::kNever;
+    }
+
+    class Invocation final : public InvocationBase {
+    public:
+        using InvocationBase::InvocationBase;
+
+        AnalyzeReply typedRun(OperationContext* opCtx) {
+            const auto& nss = request().getNamespace();
+            const auto key = request().getKey();
+            uassert(ErrorCodes::InvalidNamespace,
+                    str::stream() << "Cannot analyze system collection " << nss,
+                    !nss.isSystem());
+            uassert(ErrorCodes::BadValue,
+                    "The 'key' to analyze must be a non-empty field path",
+                    !key.empty() && key[0] != '$');
+
+            FieldStatisticsBuilder builder(key.toString(),
+                                           request().getSampleSize(),
+                                           request().getNumBuckets(),
+                                           SecureRandom().nextInt64());
+            {
+                AutoGetCollectionForReadCommand autoColl(opCtx, nss);
+                auto collection = autoColl.getCollection();
+                uassert(ErrorCodes::NamespaceNotFound,
+                        str::stream() << "Collection " << nss << " does not exist",
+                        collection);
+
+                auto exec = InternalPlanner::collectionScan(
+                    opCtx, nss.ns(), collection, PlanExecutor::YIELD_AUTO);
+                BSONObj doc;
+                PlanExecutor::ExecState state;
+                while (PlanExecutor::ADVANCED == (state = exec->getNext(&doc, nullptr))) {
+                    builder.addDocument(doc);
+                }
+                if (PlanExecutor::FAILURE == state) {
+                    uassertStatusOK(WorkingSetCommon::getMemberObjectStatus(doc).withContext(
+                        "Executor error during analyze command"));
+                }
+            }
+
+            const auto stats =
+                builder.done(opCtx->getServiceContext()->getFastClockSource()->now());
+            _writeStatistics(opCtx, nss, stats);
+            CollectionStatisticsCache::get(opCtx->getServiceContext()).invalidate(nss);
+
+            AnalyzeReply reply;
+            reply.setNumDocs(stats.numDocs);
+            reply.setNumKeys(stats.numKeys);
+            reply.setNumDistinct(stats.numDistinct);
+            reply.setNumBuckets(stats.histogram.buckets().size());
+            return reply;
+        }
+
+    private:
+        NamespaceString ns() const override {
+            return request().getNamespace();
+        }
+
+        bool supportsWriteConcern() const override {
+            return true;
+        }
+
+        void doCheckAuthorization(OperationContext* opCtx) const override {
+            auto authSession = AuthorizationSession::get(opCtx->getClient());
+            const auto resource = ResourcePattern::forExactNamespace(request().getNamespace());
+            uassert(ErrorCodes::Unauthorized,
+                    "Unauthorized",
+                    authSession->isAuthorizedForActionsOnResource(resource, ActionType::find) &&
+                        authSession->isAuthorizedForActionsOnResource(
+                            resource, ActionType::planCacheWrite));
+        }
+
+        static void _writeStatistics(OperationContext* opCtx,
+                                     const NamespaceString& nss,
+                                     const FieldStatistics& stats) {
+            const auto id = FieldStatistics::makeId(nss, stats.field);
+            DBDirectClient client(opCtx);
+            BSONObj response;
+            client.runCommand(
+                nss.db().toString(),
+                BSON("update" << NamespaceString::kSystemDotStatisticsCollectionName << "updates"
+                              << BSON_ARRAY(BSON("q" << BSON("_id" << id) << "u"
+                                                     << stats.toBSON(nss) << "upsert" << true))),
+                response);
+            uassertStatusOK(getStatusFromWriteCommandReply(response));
+        }
+    };
+} analyzeCmd;
+
+}  // namespace
+}  // namespace mongo
@@ -43,6 +43,8 @@
 #include "mongo/db/curop_failpoint_helpers.h"
 #include "mongo/db/cursor_manager.h"
 #include "mongo/db/db_raii.h"
+#include "mongo/db/exec/document_value/document_arena.h"
+#include "mongo/db/exec/plan_stage.h"
 #include "mongo/db/exec/working_set_common.h"
 #include "mongo/db/query/cursor_response.h"
 #include "mongo/db/query/find.h"
@@ -50,6 +52,7 @@
 #include "mongo/db/query/getmore_request.h"
 #include "mongo/db/query/plan_executor.h"
 #include "mongo/db/query/plan_summary_stats.h"
+#include "mongo/db/query/query_knobs_gen.h"
 #include "mongo/db/read_concern.h"
 #include "mongo/db/repl/oplog.h"
 #include "mongo/db/repl/replication_coordinator.h"
@@ -289,6 +292,17 @@ public:
                              std::uint64_t* numResults) {
             PlanExecutor* exec = cursor->getExecutor();
 
+            // Allocate the documents an aggregation produces for this batch from arenas, each of
+            // which is released once every document using it has been destroyed. See
+            // DocumentArena::Scope.
+            boost::optional<DocumentArena::Scope> arenaScope;
+            const auto rootStageType = exec->getRootStage()->stageType();
+            if (internalQueryEnableDocumentArena.load() &&
+                (rootStageType == STAGE_PIPELINE_PROXY ||
+                 rootStageType == STAGE_CHANGE_STREAM_PROXY)) {
+                arenaScope.emplace(make_intrusive<DocumentArena>());
+            }
+
             // If an awaitData getMore is killed during this process due to our max time expiring at
             // an interrupt point, we just continue as normal and return rather than reporting a
             // timeout to the user.
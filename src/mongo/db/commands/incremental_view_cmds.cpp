@@ -0,0 +1,164 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/auth/action_set.h"
+#include "mongo/db/auth/action_type.h"
+#include "mongo/db/auth/privilege.h"
+#include "mongo/db/catalog/collection.h"
+#include "mongo/db/catalog/collection_catalog.h"
+#include "mongo/db/catalog_raii.h"
+#include "mongo/db/commands.h"
+#include "mongo/db/pipeline/expression_context.h"
+#include "mongo/db/views/incremental_view_catalog.h"
+
+namespace mongo {
+namespace {
+
+class CmdCreateIncrementalView : public BasicCommand {
+public:
+    CmdCreateIncrementalView() : BasicCommand("createIncrementalView") {}
+
+    std::string help() const override {
+        return "Materializes the results of a pipeline ending in a $group stage in a collection "
+               "which is kept up to date as the source collection changes.\n"
+               "{ createIncrementalView: <target>, viewOn: <source>, pipeline: [<stages>] }\n"
+               "The source collection must have recordPreImages enabled. The state of each view "
+               "is recorded in config.incrementalViews.";
+    }
+
+    AllowedOnSecondary secondaryAllowed(ServiceContext*) const override {
+        return AllowedOnSecondary::kNever;
+    }
+
+    bool supportsWriteConcern(const BSONObj& cmd) const override {
+        return false;
+    }
+
+    void addRequiredPrivileges(const std::string& dbname,
+                               const BSONObj& cmdObj,
+                               std::vector<Privilege>* out) const override {
+        const auto target = CommandHelpers::parseNsCollectionRequired(dbname, cmdObj);
+        const NamespaceString source(dbname, cmdObj["viewOn"].str());
+        out->push_back(Privilege(ResourcePattern::forExactNamespace(source),
+                                 ActionSet{ActionType::find}));
+        out->push_back(Privilege(ResourcePattern::forExactNamespace(target),
+                                 ActionSet{ActionType::createCollection,
+                                           ActionType::insert,
+                                           ActionType::update,
+                                           ActionType::remove}));
+    }
+
+    bool run(OperationContext* opCtx,
+             const std::string& dbname,
+             const BSONObj& cmdObj,
+             BSONObjBuilder& result) override {
+        const auto target = CommandHelpers::parseNsCollectionRequired(dbname, cmdObj);
+
+        const auto viewOn = cmdObj["viewOn"];
+        uassert(ErrorCodes::TypeMismatch,
+                "'viewOn' must be the name of the source collection",
+                viewOn.type() == BSONType::String && !viewOn.valueStringData().empty());
+        const NamespaceString source(dbname, viewOn.valueStringData());
+
+        const auto pipelineElem = cmdObj["pipeline"];
+        uassert(ErrorCodes::TypeMismatch,
+                "'pipeline' must be an array of stages",
+                pipelineElem.type() == BSONType::Array);
+        std::vector<BSONObj> pipeline;
+        for (auto&& stage : pipelineElem.Obj()) {
+            uassert(ErrorCodes::TypeMismatch,
+                    "Each element of 'pipeline' must be an object",
+                    stage.type() == BSONType::Object);
+            pipeline.push_back(stage.Obj().getOwned());
+        }
+
+        uassert(ErrorCodes::InvalidOptions,
+                "An incremental view can't be materialized in its own source",
+                source != target);
+        uassert(ErrorCodes::NamespaceExists,
+                str::stream() << "Collection " << target << " already exists",
+                !CollectionCatalog::get(opCtx).lookupCollectionByNamespace(opCtx, target));
+
+        // The pipeline is evaluated with the default collation of the source, as an aggregation
+        // over it would be.
+        std::unique_ptr<CollatorInterface> collator;
+        {
+            AutoGetCollection autoColl(opCtx, source, MODE_IS);
+            if (auto collection = autoColl.getCollection()) {
+                collator = CollatorInterface::cloneCollator(collection->getDefaultCollator());
+            }
+        }
+        auto expCtx = make_intrusive<ExpressionContext>(opCtx, std::move(collator), source);
+        auto view = IncrementalView::parse(expCtx, source, target, std::move(pipeline));
+
+        IncrementalViewCatalog::get(opCtx)->createView(opCtx, std::move(view));
+        return true;
+    }
+} cmdCreateIncrementalView;
+
+class CmdDropIncrementalView : public BasicCommand {
+public:
+    CmdDropIncrementalView() : BasicCommand("dropIncrementalView") {}
+
+    std::string help() const override {
+        return "Stops maintaining an incremental view, leaving its collection as it is.\n"
+               "{ dropIncrementalView: <target> }";
+    }
+
+    AllowedOnSecondary secondaryAllowed(ServiceContext*) const override {
+        return AllowedOnSecondary::kNever;
+    }
+
+    bool supportsWriteConcern(const BSONObj& cmd) const override {
+        return false;
+    }
+
+    void addRequiredPrivileges(const std::string& dbname,
+                               const BSONObj& cmdObj,
+                               std::vector<Privilege>* out) const override {
+        const auto target = CommandHelpers::parseNsCollectionRequired(dbname, cmdObj);
+        out->push_back(Privilege(ResourcePattern::forExactNamespace(target),
+                                 ActionSet{ActionType::remove}));
+    }
+
+    bool run(OperationContext* opCtx,
+             const std::string& dbname,
+             const BSONObj& cmdObj,
+             BSONObjBuilder& result) override {
+        const auto target = CommandHelpers::parseNsCollectionRequired(dbname, cmdObj);
+        IncrementalViewCatalog::get(opCtx)->dropView(opCtx, target);
+        return true;
+    }
+} cmdDropIncrementalView;
+
+}  // namespace
+}  // namespace mongo
@@ -44,6 +44,7 @@
 #include "mongo/db/db_raii.h"
 #include "mongo/db/exec/change_stream_proxy.h"
 #include "mongo/db/exec/document_value/document.h"
+#include "mongo/db/exec/document_value/document_arena.h"
 #include "mongo/db/exec/working_set_common.h"
 #include "mongo/db/namespace_string.h"
 #include "mongo/db/pipeline/accumulator.h"
@@ -61,6 +62,7 @@
 #include "mongo/db/query/find_common.h"
 #include "mongo/db/query/get_executor.h"
 #include "mongo/db/query/plan_summary_stats.h"
+#include "mongo/db/query/query_knobs_gen.h"
 #include "mongo/db/query/query_planner_common.h"
 #include "mongo/db/read_concern.h"
 #include "mongo/db/repl/oplog.h"
@@ -171,6 +173,14 @@ bool handleCursorCommand(OperationContext* opCtx,
     auto exec = cursor->getExecutor();
     invariant(exec);
 
+    // Allocate the documents produced for this batch from arenas. The scope moves on to a new arena
+    // whenever one fills up, and each arena is released once every document using it has been
+    // destroyed, so memory stays bounded by the documents which are still alive.
+    boost::optional<DocumentArena::Scope> arenaScope;
+    if (internalQueryEnableDocumentArena.load()) {
+        arenaScope.emplace(make_intrusive<DocumentArena>());
+    }
+
     bool stashedResult = false;
     for (int objCount = 0; objCount < batchSize; objCount++) {
         // The initial getNext() on a PipelineProxyStage may be very expensive so we don't
@@ -153,6 +153,8 @@
 #include "mongo/db/system_index.h"
 #include "mongo/db/transaction_participant.h"
 #include "mongo/db/ttl.h"
+#include "mongo/db/views/incremental_view_catalog.h"
+#include "mongo/db/views/incremental_view_op_observer.h"
 #include "mongo/db/wire_version.h"
 #include "mongo/executor/network_connection_hook.h"
 #include "mongo/executor/network_interface_factory.h"
@@ -674,6 +676,7 @@ ExitCode _initAndListen(ServiceContext* serviceContext, int listenPort) {
                 "http://dochub.mongodb.org/core/ttlcollections");
         } else {
             startTTLBackgroundJob(serviceContext);
+            IncrementalViewCatalog::get(serviceContext)->startRefreshing(serviceContext);
         }
 
         if (replSettings.usingReplSets() || !gInternalValidateFeaturesAsMaster) {
@@ -1013,6 +1016,8 @@ void setUpObservers(ServiceContext* serviceContext) {
     }
     opObserverRegistry->addObserver(std::make_unique<AuthOpObserver>());
 
+    opObserverRegistry->addObserver(std::make_unique<IncrementalViewOpObserver>());
+
     setupFreeMonitoringOpObserver(opObserverRegistry.get());
 
     serviceContext->setOpObserver(std::move(opObserverRegistry));
@@ -32,15 +32,18 @@
 #include "mongo/db/exec/collection_scan.h"
 
 #include <memory>
+#include <utility>
 
 #include "mongo/db/catalog/collection.h"
 #include "mongo/db/catalog/database.h"
 #include "mongo/db/concurrency/write_conflict_exception.h"
 #include "mongo/db/exec/collection_scan_common.h"
 #include "mongo/db/exec/filter.h"
+#include "mongo/db/exec/record_batch.h"
 #include "mongo/db/exec/scoped_timer.h"
 #include "mongo/db/exec/working_set.h"
 #include "mongo/db/exec/working_set_common.h"
+#include "mongo/db/query/query_knobs_gen.h"
 #include "mongo/db/repl/optime.h"
 #include "mongo/db/storage/oplog_hack.h"
 #include "mongo/logv2/log.h"
@@ -70,6 +73,9 @@ CollectionScan::CollectionScan(ExpressionContext* expCtx,
     _specificStats.minTs = params.minTs;
     _specificStats.maxTs = params.maxTs;
     _specificStats.tailable = params.tailable;
+    if (_filter && internalQueryEnableCompiledMatchExpression.load()) {
+        _compiledFilter = std::make_unique<CompiledMatchExpression>(_filter);
+    }
     if (params.minTs || params.maxTs) {
         // The 'minTs' and 'maxTs' parameters are used for a special optimization that
         // applies only to forwards scans of the oplog.
@@ -91,6 +97,13 @@ CollectionScan::CollectionScan(ExpressionContext* expCtx,
         invariant(params.direction == CollectionScanParams::FORWARD);
     }
 
+    if (params.minRecord || params.maxRecord) {
+        // Range-restricted scans are used to partition a full scan of a collection.
+        invariant(params.direction == CollectionScanParams::FORWARD);
+        invariant(!params.tailable);
+        invariant(!params.resumeAfterRecordId && !params.minTs && !params.maxTs);
+    }
+
     // Set early stop condition.
     if (params.maxTs) {
         _endConditionBSON = BSON("$gte"_sd << *(params.maxTs));
@@ -185,6 +198,16 @@ PlanStage::StageState CollectionScan::doWork(WorkingSetID* out) {
             }
         }
 
+        if (_lastSeenId.isNull() && _params.minRecord) {
+            // Position the cursor on the first record of the range. The boundary is normally an
+            // existing record, but it may since have been deleted.
+            record = _cursor->seekAtOrAfter(*_params.minRecord);
+            if (!record) {
+                _commonStats.isEOF = true;
+                return PlanStage::IS_EOF;
+            }
+        }
+
         if (!record) {
             record = _cursor->next();
         }
@@ -207,6 +230,11 @@ PlanStage::StageState CollectionScan::doWork(WorkingSetID* out) {
         return PlanStage::IS_EOF;
     }
 
+    if (_params.maxRecord && record->id >= *_params.maxRecord) {
+        _commonStats.isEOF = true;
+        return PlanStage::IS_EOF;
+    }
+
     _lastSeenId = record->id;
     if (_params.assertMinTsHasNotFallenOffOplog) {
         assertMinTsHasNotFallenOffOplog(*record);
@@ -227,6 +255,78 @@ PlanStage::StageState CollectionScan::doWork(WorkingSetID* out) {
     return returnIfMatches(member, id, out);
 }
 
+bool CollectionScan::supportsBatchedWork() const {
+    return !_params.tailable && !_params.minTs && !_params.maxTs && !_params.requestResumeToken &&
+        !_params.resumeAfterRecordId && !_params.minRecord && !_params.maxRecord &&
+        !_params.shouldTrackLatestOplogTimestamp &&
+        !_params.shouldWaitForOplogVisibility && !_params.stopApplyingFilterAfterFirstMatch;
+}
+
+PlanStage::StageState CollectionScan::doWorkBatch(RecordBatch* out) {
+    if (_commonStats.isEOF) {
+        return PlanStage::IS_EOF;
+    }
+
+    // Where to resume from if this batch is abandoned because of a write conflict.
+    const RecordId batchStartId = _lastSeenId;
+
+    // Bound the number of documents examined, rather than only the number returned, so that a
+    // selective filter cannot keep us from checking for yields and interrupts.
+    size_t numExamined = 0;
+    try {
+        boost::optional<Record> resumedRecord;
+        if (!_cursor) {
+            _cursor = collection()->getCursor(opCtx(),
+                                              _params.direction == CollectionScanParams::FORWARD);
+            if (!_lastSeenId.isNull()) {
+                // A write conflict abandoned the previous batch. Continue after the last record
+                // returned before it, which may have been deleted while we yielded.
+                resumedRecord = _cursor->seekAtOrAfter(_lastSeenId);
+                if (!resumedRecord) {
+                    _commonStats.isEOF = true;
+                    return PlanStage::IS_EOF;
+                }
+                if (resumedRecord->id == _lastSeenId) {
+                    resumedRecord = boost::none;
+                }
+            }
+        }
+        out->setSnapshotId(opCtx()->recoveryUnit()->getSnapshotId());
+
+        while (numExamined < out->capacity()) {
+            auto record = resumedRecord ? std::exchange(resumedRecord, boost::none)
+                                        : _cursor->next();
+            if (!record) {
+                _commonStats.isEOF = true;
+                break;
+            }
+            ++numExamined;
+            _lastSeenId = record->id;
+            ++_specificStats.docsTested;
+
+            // The record's data is only valid until the cursor moves, so the batch copies it.
+            auto obj = record->data.toBson();
+            const bool passes = _compiledFilter ? _compiledFilter->matchesBSON(obj)
+                                                : (!_filter || _filter->matchesBSON(obj));
+            if (passes) {
+                out->append(record->id, obj);
+            }
+        }
+    } catch (const WriteConflictException&) {
+        // The cursor belongs to the storage transaction which is about to be abandoned, so the
+        // partial batch is discarded and the next call re-reads it with a new cursor.
+        out->clear();
+        _lastSeenId = batchStartId;
+        _cursor.reset();
+        return PlanStage::NEED_YIELD;
+    }
+
+    if (!out->empty()) {
+        return PlanStage::ADVANCED;
+    }
+    return _commonStats.isEOF ? PlanStage::IS_EOF : PlanStage::NEED_TIME;
+}
+
 Status CollectionScan::setLatestOplogEntryTimestamp(const Record& record) {
     auto tsElem = record.data.toBson()[repl::OpTime::kTimestampFieldName];
     if (tsElem.type() != BSONType::bsonTimestamp) {
@@ -261,9 +361,13 @@ PlanStage::StageState CollectionScan::returnIfMatches(WorkingSetMember* member,
                                                       WorkingSetID memberID,
                                                       WorkingSetID* out) {
     ++_specificStats.docsTested;
-    if (Filter::passes(member, _filter)) {
+    const bool passes = _compiledFilter
+        ? _compiledFilter->matchesBSON(member->doc.value().toBson())
+        : Filter::passes(member, _filter);
+    if (passes) {
         if (_params.stopApplyingFilterAfterFirstMatch) {
             _filter = nullptr;
+            _compiledFilter.reset();
         }
         *out = memberID;
         return PlanStage::ADVANCED;
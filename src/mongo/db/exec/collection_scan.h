@@ -33,6 +33,7 @@
 
 #include "mongo/db/exec/collection_scan_common.h"
 #include "mongo/db/exec/requires_collection_stage.h"
+#include "mongo/db/matcher/compiled_match_expression.h"
 #include "mongo/db/matcher/expression_leaf.h"
 #include "mongo/db/record_id.h"
 
@@ -62,6 +63,12 @@ public:
     StageState doWork(WorkingSetID* out) final;
     bool isEOF() final;
 
+    /**
+     * Batched execution is supported for plain scans, which need no per-document bookkeeping
+     * visible outside the stage, such as tracking the latest oplog timestamp or resume token.
+     */
+    bool supportsBatchedWork() const final;
+
     void doDetachFromOperationContext() final;
     void doReattachToOperationContext() final;
 
@@ -82,6 +89,8 @@ public:
     const SpecificStats* getSpecificStats() const final;
 
 protected:
+    StageState doWorkBatch(RecordBatch* out) final;
+
     void doSaveStateRequiresCollection() final;
 
     void doRestoreStateRequiresCollection() final;
@@ -111,6 +120,10 @@ private:
     // The filter is not owned by us.
     const MatchExpression* _filter;
 
+    // A compiled form of '_filter' used to evaluate it against the scanned documents, if compiled
+    // filters are enabled.
+    std::unique_ptr<CompiledMatchExpression> _compiledFilter;
+
     // If a document does not pass '_filter' but passes '_endCondition', stop scanning and return
     // IS_EOF.
     BSONObj _endConditionBSON;
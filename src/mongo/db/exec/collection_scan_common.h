@@ -61,6 +61,13 @@ struct CollectionScanParams {
     // This field cannot be used in conjunction with 'minTs' or 'maxTs'.
     boost::optional<RecordId> resumeAfterRecordId;
 
+    // If present, the collection scan only returns records whose RecordId lies in the half-open
+    // range ['minRecord', 'maxRecord'). This allows a single scan to be split into disjoint ranges
+    // that are read independently. Must only be set on forward, non-tailable scans, and cannot be
+    // used in conjunction with 'resumeAfterRecordId', 'minTs' or 'maxTs'.
+    boost::optional<RecordId> minRecord;
+    boost::optional<RecordId> maxRecord;
+
     Direction direction = FORWARD;
 
     // Do we want the scan to be 'tailable'?  Only meaningful if the collection is capped.
@@ -253,13 +253,16 @@ void DocumentStorage::alloc(unsigned newSize) {
 
     uassert(16490, "Tried to make oversized document", capacity <= size_t(BufferMaxSize));
 
-    std::unique_ptr<char[]> oldBuf(_cache);
-    _cache = new char[capacity];
+    // Holding the old arena keeps the old buffer alive until it has been copied from.
+    const auto oldArena = std::move(_arena);
+    std::unique_ptr<char[]> oldBuf(oldArena ? nullptr : _cache);
+    const char* oldCache = _cache;
+    _cache = allocateBuffer(capacity);
     _cacheEnd = _cache + capacity - hashTabBytes();
 
     if (!firstAlloc) {
         // This just copies the elements
-        memcpy(_cache, oldBuf.get(), _usedBytes);
+        memcpy(_cache, oldCache, _usedBytes);
 
         if (_numFields >= HASH_TAB_MIN) {
             // if we were hashing, deal with the hash table
@@ -267,7 +270,7 @@ void DocumentStorage::alloc(unsigned newSize) {
                 rehash();
             } else {
                 // no rehash needed so just slide table down to new position
-                memcpy(_hashTab, oldBuf.get() + oldCapacity, hashTabBytes());
+                memcpy(_hashTab, oldCache + oldCapacity, hashTabBytes());
             }
         }
     }
@@ -286,10 +289,19 @@ void DocumentStorage::reserveFields(size_t expectedFields) {
 
     uassert(16491, "Tried to make oversized document", newSize <= size_t(BufferMaxSize));
 
-    _cache = new char[newSize + hashTabBytes()];
+    _cache = allocateBuffer(newSize + hashTabBytes());
     _cacheEnd = _cache + newSize;
 }
 
+char* DocumentStorage::allocateBuffer(size_t bytes) {
+    if (auto arena = DocumentArena::current()) {
+        _arena = arena;
+        return arena->allocate(bytes);
+    }
+    _arena.reset();
+    return new char[bytes];
+}
+
 intrusive_ptr<DocumentStorage> DocumentStorage::clone() const {
     auto out = make_intrusive<DocumentStorage>(_bson, _stripMetadata, _modified);
 
@@ -297,7 +309,7 @@ intrusive_ptr<DocumentStorage> DocumentStorage::clone() const {
         // Make a copy of the buffer with the fields.
         // It is very important that the positions of each field are the same after cloning.
         const size_t bufferBytes = allocatedBytes();
-        out->_cache = new char[bufferBytes];
+        out->_cache = out->allocateBuffer(bufferBytes);
         out->_cacheEnd = out->_cache + (_cacheEnd - _cache);
         memcpy(out->_cache, _cache, bufferBytes);
 
@@ -324,12 +336,32 @@ intrusive_ptr<DocumentStorage> DocumentStorage::clone() const {
     return out;
 }
 
+intrusive_ptr<DocumentStorage> DocumentStorage::cloneOutOfArena() const {
+    intrusive_ptr<DocumentStorage> out;
+    {
+        DocumentArena::Scope heapScope(nullptr);
+        out = clone();
+    }
+
+    // The cached fields are updated in place, rather than through getField(), so that the copy is
+    // not marked as modified.
+    for (auto it = out->iteratorCacheOnly(); !it.atEnd(); it.advance()) {
+        auto& val = const_cast<ValueElement&>(*it).val;
+        if (val.usesArena()) {
+            val = val.copyOutOfArena();
+        }
+    }
+
+    return out;
+}
+
 size_t DocumentStorage::getMetadataApproximateSize() const {
     return _metadataFields.getApproximateSize();
 }
 
 DocumentStorage::~DocumentStorage() {
-    std::unique_ptr<char[]> deleteBufferAtScopeEnd(_cache);
+    // A buffer allocated from an arena is released along with the arena.
+    std::unique_ptr<char[]> deleteBufferAtScopeEnd(_arena ? nullptr : _cache);
 
     for (auto it = iteratorCacheOnly(); !it.atEnd(); it.advance()) {
         it->val.~Value();  // explicit destructor call
@@ -519,6 +551,29 @@ Document Document::fromBsonWithMetaData(const BSONObj& bson) {
     return md.freeze();
 }
 
+bool Document::usesArena() const {
+    if (!_storage) {
+        return false;
+    }
+    if (_storage->isArenaAllocated()) {
+        return true;
+    }
+    for (auto it = _storage->iteratorCacheOnly(); !it.atEnd(); it.advance()) {
+        if (it->val.usesArena()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+Document Document::copyOutOfArena() const {
+    // Arenas are not in use unless one is active, so the walk is skipped otherwise.
+    if (!DocumentArena::current() || !usesArena()) {
+        return *this;
+    }
+    return Document(_storage->cloneOutOfArena());
+}
+
 Document Document::getOwned() const {
     if (isOwned()) {
         return *this;
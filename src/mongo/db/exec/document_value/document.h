@@ -338,6 +338,21 @@ public:
      */
     Document getOwned() const;
 
+    /**
+     * Returns true if the storage of this document, or of any document nested in it, was allocated
+     * from a DocumentArena.
+     */
+    bool usesArena() const;
+
+    /**
+     * Returns an equal document whose storage, and that of any nested documents, is allocated from
+     * the global heap. Stages which retain documents beyond the batch they were produced in should
+     * use this, so that a retained document does not keep its whole arena alive. Returns this
+     * document itself if it does not use an arena, or without checking if no DocumentArena::Scope
+     * is active on this thread, so that it costs nothing when arenas are not in use.
+     */
+    Document copyOutOfArena() const;
+
     /**
      * Returns true if the underlying BSONObj is owned.
      */
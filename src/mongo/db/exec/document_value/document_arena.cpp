@@ -0,0 +1,89 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/exec/document_value/document_arena.h"
+
+namespace mongo {
+
+namespace {
+thread_local DocumentArena::Scope* currentScope = nullptr;
+
+constexpr size_t kAlignment = alignof(std::max_align_t);
+}  // namespace
+
+DocumentArena::Scope::Scope(boost::intrusive_ptr<DocumentArena> arena)
+    : _arena(std::move(arena)), _previous(currentScope) {
+    currentScope = this;
+}
+
+DocumentArena::Scope::~Scope() {
+    currentScope = _previous;
+}
+
+DocumentArena* DocumentArena::Scope::arena() {
+    if (_arena && _arena->reservedBytes() >= kMaxReservedBytes) {
+        // Documents which still use the full arena keep it alive until they are destroyed.
+        _arena = make_intrusive<DocumentArena>();
+    }
+    return _arena.get();
+}
+
+DocumentArena* DocumentArena::current() {
+    return currentScope ? currentScope->arena() : nullptr;
+}
+
+char* DocumentArena::allocate(size_t bytes) {
+    bytes = (bytes + kAlignment - 1) & ~(kAlignment - 1);
+    _allocatedBytes += bytes;
+
+    if (static_cast<size_t>(_end - _next) >= bytes) {
+        char* out = _next;
+        _next += bytes;
+        return out;
+    }
+
+    // Buffers larger than a quarter of a block get a block of their own, so that they don't waste
+    // the remainder of the current one.
+    if (bytes > kBlockBytes / 4) {
+        _blocks.emplace_back(new char[bytes]);
+        _reservedBytes += bytes;
+        return _blocks.back().get();
+    }
+
+    _blocks.emplace_back(new char[kBlockBytes]);
+    _reservedBytes += kBlockBytes;
+    _next = _blocks.back().get() + bytes;
+    _end = _blocks.back().get() + kBlockBytes;
+    return _blocks.back().get();
+}
+
+}  // namespace mongo
@@ -0,0 +1,117 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#pragma once
+
+#include <boost/intrusive_ptr.hpp>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "mongo/util/intrusive_counter.h"
+
+namespace mongo {
+
+/**
+ * A bump allocator from which DocumentStorage allocates its field buffers while a
+ * DocumentArena::Scope is active on the current thread. Buffers are never freed individually:
+ * each DocumentStorage allocated from an arena holds a reference to it, and the arena releases
+ * all of its blocks at once when the last such reference goes away. Once an arena has reserved
+ * kMaxReservedBytes, the scope moves on to a new one, so that the memory of documents which have
+ * been destroyed is returned to the global heap once every other document in their arena has been
+ * destroyed too. A document which outlives its scope therefore stays valid, but keeps its whole
+ * arena alive; stages which retain documents should call Document::copyOutOfArena() on them.
+ *
+ * An arena is not thread-safe and must only be allocated from by one thread at a time.
+ */
+class DocumentArena : public RefCountable {
+public:
+    static constexpr size_t kBlockBytes = 64 * 1024;
+    static constexpr size_t kMaxReservedBytes = 16 * kBlockBytes;
+
+    /**
+     * Installs 'arena' as the arena for the current thread for the lifetime of this object,
+     * restoring the previous scope on destruction. Once 'arena' is full, the scope replaces it
+     * with a new arena. A null 'arena' makes allocations within the scope use the global heap.
+     */
+    class Scope {
+    public:
+        explicit Scope(boost::intrusive_ptr<DocumentArena> arena);
+        ~Scope();
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        friend class DocumentArena;
+
+        /**
+         * Returns the arena to allocate from, replacing '_arena' first if it is full.
+         */
+        DocumentArena* arena();
+
+        boost::intrusive_ptr<DocumentArena> _arena;
+        Scope* _previous;
+    };
+
+    /**
+     * Returns the arena to allocate from on the current thread, or nullptr if there is none.
+     */
+    static DocumentArena* current();
+
+    /**
+     * Returns 'bytes' bytes of memory aligned for any fundamental type. The memory remains valid
+     * until the arena is destroyed.
+     */
+    char* allocate(size_t bytes);
+
+    /**
+     * Returns the number of bytes handed out by allocate(), including alignment padding.
+     */
+    size_t allocatedBytes() const {
+        return _allocatedBytes;
+    }
+
+    /**
+     * Returns the number of bytes the arena has reserved from the global heap.
+     */
+    size_t reservedBytes() const {
+        return _reservedBytes;
+    }
+
+private:
+    std::vector<std::unique_ptr<char[]>> _blocks;
+    char* _next = nullptr;
+    char* _end = nullptr;
+    size_t _allocatedBytes = 0;
+    size_t _reservedBytes = 0;
+};
+
+}  // namespace mongo
@@ -35,6 +35,7 @@
 #include <boost/intrusive_ptr.hpp>
 
 #include "mongo/base/static_assert.h"
+#include "mongo/db/exec/document_value/document_arena.h"
 #include "mongo/db/exec/document_value/document_metadata_fields.h"
 #include "mongo/db/exec/document_value/value.h"
 #include "mongo/stdx/variant.h"
@@ -394,6 +395,17 @@ public:
     /// Shallow copy of this. Caller owns memory.
     boost::intrusive_ptr<DocumentStorage> clone() const;
 
+    /**
+     * Like clone(), but the copy's buffer, and those of any documents nested in its cached fields,
+     * are allocated from the global heap rather than from a DocumentArena.
+     */
+    boost::intrusive_ptr<DocumentStorage> cloneOutOfArena() const;
+
+    /// Returns true if this storage's buffer was allocated from a DocumentArena.
+    bool isArenaAllocated() const {
+        return _arena != nullptr;
+    }
+
     size_t allocatedBytes() const {
         return !_cache ? 0 : (_cacheEnd - _cache + hashTabBytes());
     }
@@ -499,6 +511,12 @@ private:
     /// Allocates space in _cache. Copies existing data if there is any.
     void alloc(unsigned newSize);
 
+    /**
+     * Returns a new buffer of 'bytes' bytes, from the current thread's DocumentArena if there is
+     * one and from the global heap otherwise, and sets _arena accordingly.
+     */
+    char* allocateBuffer(size_t bytes);
+
     /// Call after adding field to _cache and increasing _numFields
     void addFieldToHashTable(Position pos);
 
@@ -563,6 +581,10 @@ private:
     unsigned _numFields;    // this includes removed fields
     unsigned _hashTabMask;  // equal to hashTabBuckets()-1 but used more often
 
+    // The arena _cache was allocated from, or null if it came from the global heap. Holding it
+    // keeps the arena, and so _cache, alive for as long as this storage.
+    boost::intrusive_ptr<DocumentArena> _arena;
+
     BSONObj _bson;
 
     // If '_stripMetadata' is true, tracks whether or not the metadata has been lazy-loaded from the
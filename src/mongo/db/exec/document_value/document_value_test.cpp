@@ -35,6 +35,7 @@
 
 #include "mongo/bson/bson_depth.h"
 #include "mongo/db/exec/document_value/document.h"
+#include "mongo/db/exec/document_value/document_arena.h"
 #include "mongo/db/exec/document_value/document_comparator.h"
 #include "mongo/db/exec/document_value/document_value_test_util.h"
 #include "mongo/db/exec/document_value/value.h"
@@ -687,6 +688,138 @@ public:
     BSONObjBuilder objBuilder;
     BSONArrayBuilder arrBuilder;
 };
+
+TEST(DocumentArena, DocumentsBuiltInScopeAreAllocatedFromTheArena) {
+    auto arena = make_intrusive<DocumentArena>();
+    Document inArena;
+    {
+        DocumentArena::Scope scope(arena);
+        inArena = Document{{"a", 1}, {"b", "q"_sd}};
+    }
+    Document onHeap{{"a", 1}, {"b", "q"_sd}};
+
+    ASSERT_TRUE(inArena.usesArena());
+    ASSERT_FALSE(onHeap.usesArena());
+    ASSERT_GT(arena->allocatedBytes(), 0U);
+    ASSERT_DOCUMENT_EQ(inArena, onHeap);
+}
+
+TEST(DocumentArena, DocumentOutlivesScopeAndArena) {
+    Document doc;
+    {
+        DocumentArena::Scope scope(make_intrusive<DocumentArena>());
+        MutableDocument md;
+        for (int i = 0; i < 100; ++i) {
+            md.addField(str::stream() << "field" << i, mongo::Value(i));
+        }
+        doc = md.freeze();
+    }
+
+    // The document holds the only reference to the arena, which must stay alive with it.
+    ASSERT_TRUE(doc.usesArena());
+    ASSERT_EQ(100ULL, doc.computeSize());
+    ASSERT_VALUE_EQ(mongo::Value(99), doc["field99"]);
+}
+
+TEST(DocumentArena, CopyOutOfArenaCopiesNestedDocumentsAndArrays) {
+    Document doc;
+    {
+        DocumentArena::Scope scope(make_intrusive<DocumentArena>());
+        doc = Document{{"a", 1},
+                       {"b", Document{{"c", 2}}},
+                       {"d", mongo::Value(vector<mongo::Value>{mongo::Value(Document{{"e", 3}})})}};
+    }
+    ASSERT_TRUE(doc["b"].usesArena());
+    ASSERT_TRUE(doc["d"].usesArena());
+
+    // Without an active scope, copying out is skipped.
+    ASSERT_EQ(doc.getPtr(), doc.copyOutOfArena().getPtr());
+
+    Document copy;
+    {
+        DocumentArena::Scope scope(make_intrusive<DocumentArena>());
+        copy = doc.copyOutOfArena();
+    }
+    ASSERT_FALSE(copy.usesArena());
+    ASSERT_DOCUMENT_EQ(doc, copy);
+
+    doc = Document();
+    ASSERT_DOCUMENT_EQ(copy, Document(fromjson("{a: 1, b: {c: 2}, d: [{e: 3}]}")));
+}
+
+TEST(DocumentArena, CopyOutOfArenaReturnsSameStorageWithoutArena) {
+    Document doc{{"a", 1}, {"b", Document{{"c", 2}}}};
+    DocumentArena::Scope scope(make_intrusive<DocumentArena>());
+    ASSERT_EQ(doc.getPtr(), doc.copyOutOfArena().getPtr());
+
+    mongo::Value val(vector<mongo::Value>{mongo::Value(1), mongo::Value(doc)});
+    ASSERT_FALSE(val.usesArena());
+    ASSERT_VALUE_EQ(val, val.copyOutOfArena());
+}
+
+TEST(DocumentArena, DocumentGrownOutsideScopeMovesToHeap) {
+    Document doc;
+    {
+        DocumentArena::Scope scope(make_intrusive<DocumentArena>());
+        doc = Document{{"a", 1}};
+    }
+
+    MutableDocument md(doc);
+    for (int i = 0; i < 100; ++i) {
+        md.addField(str::stream() << "field" << i, mongo::Value(i));
+    }
+    Document grown = md.freeze();
+
+    ASSERT_TRUE(doc.usesArena());
+    ASSERT_FALSE(grown.usesArena());
+    ASSERT_EQ(101ULL, grown.computeSize());
+    ASSERT_VALUE_EQ(mongo::Value(1), grown["a"]);
+}
+
+TEST(DocumentArena, NullScopeAllocatesFromHeap) {
+    DocumentArena::Scope scope(make_intrusive<DocumentArena>());
+    Document doc;
+    {
+        DocumentArena::Scope heapScope(nullptr);
+        doc = Document{{"a", 1}};
+    }
+    ASSERT_FALSE(doc.usesArena());
+    ASSERT_TRUE(DocumentArena::current());
+}
+
+TEST(DocumentArena, ScopeMovesOnFromFullArena) {
+    auto first = make_intrusive<DocumentArena>();
+    std::vector<Document> docs;
+    {
+        DocumentArena::Scope scope(first);
+        while (DocumentArena::current() == first.get()) {
+            docs.push_back(Document{{"a", 1}, {"b", 2}});
+        }
+        ASSERT_GTE(first->reservedBytes(), DocumentArena::kMaxReservedBytes);
+
+        // Documents built after the first arena filled up use the new one.
+        Document next{{"a", 1}};
+        ASSERT_TRUE(next.usesArena());
+        ASSERT_LT(DocumentArena::current()->reservedBytes(), DocumentArena::kMaxReservedBytes);
+    }
+
+    // The documents in the full arena keep it alive, until they are all destroyed.
+    ASSERT_TRUE(first->isShared());
+    docs.clear();
+    ASSERT_FALSE(first->isShared());
+}
+
+TEST(DocumentArena, LargeAllocationsGetTheirOwnBlock) {
+    auto arena = make_intrusive<DocumentArena>();
+    char* small = arena->allocate(100);
+    char* large = arena->allocate(DocumentArena::kBlockBytes);
+    char* next = arena->allocate(100);
+
+    ASSERT_EQ(2 * DocumentArena::kBlockBytes, arena->reservedBytes());
+    ASSERT_EQ(0U, reinterpret_cast<uintptr_t>(large) % alignof(std::max_align_t));
+    // The small allocations share the first block.
+    ASSERT_EQ(small + 112, next);
+}
 }  // namespace Document
 
 namespace MetaFields {
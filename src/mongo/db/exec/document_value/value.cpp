@@ -41,6 +41,7 @@
 #include "mongo/bson/bson_depth.h"
 #include "mongo/bson/simple_bsonobj_comparator.h"
 #include "mongo/db/exec/document_value/document.h"
+#include "mongo/db/exec/document_value/document_arena.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/query/datetime/date_time_support.h"
 #include "mongo/platform/decimal128.h"
@@ -1078,6 +1079,45 @@ bool Value::integral64Bit() const {
     }
 }
 
+bool Value::usesArena() const {
+    switch (getType()) {
+        case Object:
+            return getDocument().usesArena();
+        case Array:
+            for (auto&& elem : getArray()) {
+                if (elem.usesArena()) {
+                    return true;
+                }
+            }
+            return false;
+        default:
+            return false;
+    }
+}
+
+Value Value::copyOutOfArena() const {
+    if (!DocumentArena::current()) {
+        return *this;
+    }
+    switch (getType()) {
+        case Object:
+            return Value(getDocument().copyOutOfArena());
+        case Array: {
+            if (!usesArena()) {
+                return *this;
+            }
+            std::vector<Value> values;
+            values.reserve(getArray().size());
+            for (auto&& elem : getArray()) {
+                values.push_back(elem.copyOutOfArena());
+            }
+            return Value(std::move(values));
+        }
+        default:
+            return *this;
+    }
+}
+
 size_t Value::getApproximateSize() const {
     switch (getType()) {
         case Code:
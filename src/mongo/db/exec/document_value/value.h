@@ -357,6 +357,18 @@ public:
         return *this;
     }
 
+    /**
+     * Returns true if this value contains a document whose storage was allocated from a
+     * DocumentArena. See Document::usesArena().
+     */
+    bool usesArena() const;
+
+    /**
+     * Returns an equal value which does not contain any arena-allocated document, if a
+     * DocumentArena::Scope is active on this thread. See Document::copyOutOfArena().
+     */
+    Value copyOutOfArena() const;
+
     /// Members to support parsing/deserialization from IDL generated code.
     void serializeForIDL(StringData fieldName, BSONObjBuilder* builder) const;
     void serializeForIDL(BSONArrayBuilder* builder) const;
@@ -64,8 +64,11 @@ void FastPathEligibleInclusionNode::_applyProjections(BSONObj bson, BSONObjBuild
     while (it.more() && nFieldsNeeded > 0) {
         const auto bsonElement{it.next()};
         const auto fieldName{bsonElement.fieldNameStringData()};
-        const absl::string_view fieldNameKey{fieldName.rawData(), fieldName.size()};
+        if (!_fieldNameFilter.mayContain(fieldName)) {
+            continue;
+        }
 
+        const absl::string_view fieldNameKey{fieldName.rawData(), fieldName.size()};
         if (_projectedFields.find(fieldNameKey) != _projectedFields.end()) {
             bob->append(bsonElement);
             --nFieldsNeeded;
@@ -46,8 +46,10 @@
 #include "mongo/db/pipeline/dependencies.h"
 #include "mongo/db/pipeline/expression_context_for_test.h"
 #include "mongo/db/query/projection_parser.h"
+#include "mongo/db/query/query_knobs_gen.h"
 #include "mongo/logv2/log.h"
 #include "mongo/unittest/unittest.h"
+#include "mongo/util/scopeguard.h"
 
 namespace mongo::projection_executor {
 namespace {
@@ -413,6 +415,28 @@ TEST_F(InclusionProjectionExecutionTestWithoutFallBackToDefault, ShouldIncludeTo
     ASSERT_DOCUMENT_EQ(result, expectedResult);
 }
 
+TEST_F(InclusionProjectionExecutionTestWithoutFallBackToDefault,
+       ShouldIncludeFewFieldsOfWideDocument) {
+    auto inclusion = makeInclusionProjectionWithDefaultPolicies(
+        BSON("_id" << false << "f10" << true << "abc" << true << "x" << BSON("f2" << true)));
+
+    // Build a wide document whose other field names share the length, first character or last
+    // character of the included names.
+    BSONObjBuilder bob;
+    for (int i = 0; i < 100; ++i) {
+        bob.append(str::stream() << "f" << i, i);
+    }
+    bob.append("abd", 1);
+    bob.append("xbc", 2);
+    bob.append("abc", 3);
+    bob.append("x", BSON("f1" << 1 << "f2" << 2 << "g2" << 3));
+    bob.append("ab", 4);
+
+    auto result = inclusion->applyTransformation(Document{bob.obj()});
+    auto expectedResult = Document{{"f10", 10}, {"abc", 3}, {"x", Document{{"f2", 2}}}};
+    ASSERT_DOCUMENT_EQ(result, expectedResult);
+}
+
 TEST_F(InclusionProjectionExecutionTestWithFallBackToDefault, ShouldAddComputedTopLevelField) {
     auto inclusion = makeInclusionProjectionWithDefaultPolicies(
         BSON("newField" << wrapInLiteral("computedVal")));
@@ -675,6 +699,30 @@ TEST_F(InclusionProjectionExecutionTestWithFallBackToDefault,
     ASSERT_DOCUMENT_EQ(result, expectedResult);
 }
 
+TEST_F(InclusionProjectionExecutionTestWithFallBackToDefault,
+       ShouldComputeFieldsWithCompiledExpressions) {
+    const bool originalEnableCompiledExpressions = internalQueryEnableCompiledExpressions.load();
+    ON_BLOCK_EXIT([&] {
+        internalQueryEnableCompiledExpressions.store(originalEnableCompiledExpressions);
+    });
+    internalQueryEnableCompiledExpressions.store(true);
+
+    auto inclusion = makeInclusionProjectionWithDefaultPolicies(
+        fromjson("{'a.inc': true, 'a.b': '$x.y', 'a.c': {$cond: ['$x.z', '$x.y', 0]}, "
+                 "d: {$gt: ['$x.y', 0]}, e: '$x.arr.v'}"));
+    inclusion->optimize();
+
+    auto result = inclusion->applyTransformation(
+        Document(fromjson("{x: {y: 5, z: true, arr: [{v: 1}, {v: 2}]}, a: [{inc: 1}, {}]}")));
+    ASSERT_DOCUMENT_EQ(result,
+                       Document(fromjson("{a: [{inc: 1, b: 5, c: 5}, {b: 5, c: 5}], d: true, "
+                                         "e: [1, 2]}")));
+
+    // Paths resolved for one document are not reused for the next.
+    result = inclusion->applyTransformation(Document(fromjson("{x: {y: -1}}")));
+    ASSERT_DOCUMENT_EQ(result, Document(fromjson("{a: {b: -1, c: 0}, d: false}")));
+}
+
 TEST_F(InclusionProjectionExecutionTestWithFallBackToDefault, ShouldAddOrIncludeSubFieldsOfId) {
     auto inclusion = makeInclusionProjectionWithDefaultPolicies(
         BSON("_id.X" << true << "_id.Z" << wrapInLiteral("NEW")));
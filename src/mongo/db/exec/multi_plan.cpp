@@ -48,6 +48,7 @@
 #include "mongo/db/query/explain.h"
 #include "mongo/db/query/plan_cache.h"
 #include "mongo/db/query/plan_ranker.h"
+#include "mongo/db/query/query_knobs_gen.h"
 #include "mongo/logv2/log.h"
 #include "mongo/util/str.h"
 
@@ -205,6 +206,7 @@ Status MultiPlanStage::pickBestPlan(PlanYieldPolicy* yieldPolicy) {
 
     size_t numWorks = getTrialPeriodWorks(opCtx(), collection());
     size_t numResults = getTrialPeriodNumToReturn(*_query);
+    const size_t eliminationPeriod = internalQueryPlanEvaluationEliminationPeriod.load();
 
     try {
         // Work the plans, stopping when a plan hits EOF or returns some fixed number of results.
@@ -213,6 +215,9 @@ Status MultiPlanStage::pickBestPlan(PlanYieldPolicy* yieldPolicy) {
             if (!moreToDo) {
                 break;
             }
+            if (eliminationPeriod > 0 && (ix + 1) % eliminationPeriod == 0) {
+                eliminateUnproductivePlans();
+            }
         }
     } catch (DBException& e) {
         e.addContext("exception thrown while multiplanner was selecting best plan");
@@ -378,7 +383,7 @@ bool MultiPlanStage::workAllPlans(size_t numResults, PlanYieldPolicy* yieldPolic
 
     for (size_t ix = 0; ix < _candidates.size(); ++ix) {
         CandidatePlan& candidate = _candidates[ix];
-        if (candidate.failed) {
+        if (candidate.failed || candidate.eliminated) {
             continue;
         }
 
@@ -436,12 +441,57 @@ bool MultiPlanStage::workAllPlans(size_t numResults, PlanYieldPolicy* yieldPolic
                 _failure = true;
                 return false;
             }
+
+            // The remaining candidates were eliminated earlier, and can still be ranked.
+            if (_failureCount + _eliminatedCount == _candidates.size()) {
+                return false;
+            }
         }
     }
 
     return !doneWorking;
 }
 
+void MultiPlanStage::eliminateUnproductivePlans() {
+    auto productivity = [](const CandidatePlan& candidate) {
+        const auto* stats = candidate.root->getCommonStats();
+        return stats->works == 0 ? 0.0 : static_cast<double>(stats->advanced) / stats->works;
+    };
+
+    // A plan with a blocking stage produces nothing until it has consumed all of its input, so its
+    // productivity part way through the trial says nothing about how it will do. Such plans are
+    // neither compared against nor eliminated.
+    auto isEligible = [](const CandidatePlan& candidate) {
+        return !candidate.failed && !candidate.eliminated && !candidate.solution->hasBlockingStage;
+    };
+
+    double bestProductivity = 0;
+    for (auto&& candidate : _candidates) {
+        if (isEligible(candidate)) {
+            bestProductivity = std::max(bestProductivity, productivity(candidate));
+        }
+    }
+    if (bestProductivity <= 0) {
+        return;
+    }
+
+    const double threshold = bestProductivity * internalQueryPlanEvaluationEliminationRatio.load();
+    for (auto&& candidate : _candidates) {
+        if (!isEligible(candidate) || productivity(candidate) >= threshold) {
+            continue;
+        }
+
+        candidate.eliminated = true;
+        ++_eliminatedCount;
+        LOGV2_DEBUG(5380400,
+                    2,
+                    "Eliminating unproductive candidate plan from the trial period",
+                    "planSummary"_attr = Explain::getPlanSummary(candidate.root),
+                    "productivity"_attr = productivity(candidate),
+                    "bestProductivity"_attr = bestProductivity);
+    }
+}
+
 bool MultiPlanStage::hasBackupPlan() const {
     return kNoSuchPlan != _backupPlanIdx;
 }
@@ -174,6 +174,14 @@ private:
      */
     bool workAllPlans(size_t numResults, PlanYieldPolicy* yieldPolicy);
 
+    /**
+     * Stops working the candidates whose productivity so far is below
+     * 'internalQueryPlanEvaluationEliminationRatio' times that of the most productive candidate.
+     * Does nothing until some candidate has produced a result. Candidates with a blocking stage
+     * are never eliminated.
+     */
+    void eliminateUnproductivePlans();
+
     /**
      * Checks whether we need to perform either a timing-based yield or a yield for a document
      * fetch. If so, then uses 'yieldPolicy' to actually perform the yield.
@@ -221,6 +229,9 @@ private:
     // If everything fails during the plan competition, we can't pick one.
     size_t _failureCount;
 
+    // The number of candidates which were eliminated early from the plan competition.
+    size_t _eliminatedCount = 0;
+
     // if pickBestPlan fails, this is set to the wsid of the statusMember
     // returned by ::work()
     WorkingSetID _statusMemberId;
@@ -33,6 +33,7 @@
 
 #include "mongo/db/exec/plan_stage.h"
 
+#include "mongo/db/exec/record_batch.h"
 #include "mongo/db/exec/scoped_timer.h"
 #include "mongo/db/operation_context.h"
 #include "mongo/db/service_context.h"
@@ -59,6 +60,27 @@ PlanStage::StageState PlanStage::work(WorkingSetID* out) {
     return workResult;
 }
 
+PlanStage::StageState PlanStage::workBatch(RecordBatch* out) {
+    invariant(_opCtx);
+    invariant(out->empty());
+    ScopedTimer timer(getClock(), &_commonStats.executionTimeMillis);
+    ++_commonStats.works;
+
+    StageState workResult = doWorkBatch(out);
+    invariant(workResult != StageState::FAILURE);
+
+    // Each document in the batch counts as an advance, so that the number of results reported by
+    // explain does not depend on the execution mode.
+    _commonStats.advanced += out->size();
+    if (StageState::NEED_TIME == workResult) {
+        ++_commonStats.needTime;
+    } else if (StageState::NEED_YIELD == workResult) {
+        ++_commonStats.needYield;
+    }
+
+    return workResult;
+}
+
 void PlanStage::saveState() {
     ++_commonStats.yields;
     for (auto&& child : _children) {
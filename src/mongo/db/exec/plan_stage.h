@@ -41,6 +41,7 @@ namespace mongo {
 class ClockSource;
 class Collection;
 class OperationContext;
+class RecordBatch;
 class RecordId;
 
 /**
@@ -201,6 +202,34 @@ public:
      */
     virtual bool isEOF() = 0;
 
+    //
+    // Batched execution:
+    //
+    // Stages which support it can exchange batches of documents (see record_batch.h) rather than
+    // a single WorkingSetID per call, which saves a virtual call, a WorkingSet allocation and a
+    // yield check for every document. A plan is executed in batched mode only if every one of its
+    // stages supports it; otherwise the PlanExecutor falls back to calling work().
+    //
+
+    /**
+     * Returns true if this stage, and every stage below it, can produce its output through
+     * workBatch(). A stage may only support batched execution when each of its results is a
+     * plain document with no metadata.
+     */
+    virtual bool supportsBatchedWork() const {
+        return false;
+    }
+
+    /**
+     * Produces the stage's next results into 'out', which must be empty. Returns ADVANCED if at
+     * least one document was appended to 'out', IS_EOF if the stage has no more results,
+     * NEED_TIME if the documents examined by this call were all filtered out, or NEED_YIELD as
+     * for work(). Errors are reported by throwing rather than by returning FAILURE.
+     *
+     * Must only be called if supportsBatchedWork() is true.
+     */
+    StageState workBatch(RecordBatch* out);
+
     //
     // Yielding and isolation semantics:
     //
@@ -343,6 +372,14 @@ protected:
      */
     virtual StageState doWork(WorkingSetID* out) = 0;
 
+    /**
+     * Produces a batch of results. See comment at workBatch() above. Must be overridden by stages
+     * whose supportsBatchedWork() may return true.
+     */
+    virtual StageState doWorkBatch(RecordBatch* out) {
+        MONGO_UNREACHABLE;
+    }
+
     /**
      * Saves any stage-specific state required to resume where it was if the underlying data
      * changes.
@@ -0,0 +1,80 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#pragma once
+
+#include <algorithm>
+#include <bitset>
+
+#include "mongo/base/string_data.h"
+
+namespace mongo {
+
+/**
+ * A compact summary of the field names a projection looks up at one level of a document, used to
+ * reject most other field names without hashing them. A field name can only be one of the added
+ * names if its length, first character and last character each match those of some added name, so
+ * projections which include a few fields of a wide document skip most of its fields after a couple
+ * of bit tests.
+ */
+class ProjectedFieldNameFilter {
+public:
+    void add(StringData fieldName) {
+        _lengths.set(lengthBit(fieldName));
+        if (!fieldName.empty()) {
+            _firstChars.set(static_cast<unsigned char>(fieldName[0]));
+            _lastChars.set(static_cast<unsigned char>(fieldName[fieldName.size() - 1]));
+        }
+    }
+
+    /**
+     * Returns false if 'fieldName' is definitely not one of the added names.
+     */
+    bool mayContain(StringData fieldName) const {
+        return _lengths[lengthBit(fieldName)] &&
+            (fieldName.empty() ||
+             (_firstChars[static_cast<unsigned char>(fieldName[0])] &&
+              _lastChars[static_cast<unsigned char>(fieldName[fieldName.size() - 1])]));
+    }
+
+private:
+    static constexpr size_t kLengthBits = 64;
+
+    // Names of kLengthBits - 1 characters or more share the last bit.
+    static size_t lengthBit(StringData fieldName) {
+        return std::min(fieldName.size(), kLengthBits - 1);
+    }
+
+    std::bitset<kLengthBits> _lengths;
+    std::bitset<256> _firstChars;
+    std::bitset<256> _lastChars;
+};
+
+}  // namespace mongo
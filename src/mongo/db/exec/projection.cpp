@@ -296,6 +296,9 @@ ProjectionStageSimple::ProjectionStageSimple(ExpressionContext* expCtx,
     invariant(projection->isSimple());
     _includedFields = {projection->getRequiredFields().begin(),
                        projection->getRequiredFields().end()};
+    for (auto&& field : _includedFields) {
+        _includedFieldsFilter.add(field);
+    }
 }
 
 Status ProjectionStageSimple::transform(WorkingSetMember* member) const {
@@ -305,22 +308,50 @@ Status ProjectionStageSimple::transform(WorkingSetMember* member) const {
     invariant(member->hasObj());
 
     // Apply the SIMPLE_DOC projection.
+    projectObj(member->doc.value().toBson(), &bob);
+
+    transitionMemberToOwnedObj(bob.obj(), member);
+    return Status::OK();
+}
+
+PlanStage::StageState ProjectionStageSimple::doWorkBatch(RecordBatch* out) {
+    if (!_childBatch) {
+        _childBatch = std::make_unique<RecordBatch>(out->capacity());
+    }
+    _childBatch->clear();
+
+    const auto status = child()->workBatch(_childBatch.get());
+    if (PlanStage::ADVANCED != status) {
+        return status;
+    }
+
+    // The projected documents are built directly into the output batch. Like transform(), this
+    // drops the RecordId since the result no longer corresponds to a stored document.
+    out->setSnapshotId(_childBatch->getSnapshotId());
+    for (size_t i = 0; i < _childBatch->size(); ++i) {
+        out->appendBuilt(RecordId(),
+                         [&](BSONObjBuilder& bob) { projectObj(_childBatch->getObj(i), &bob); });
+    }
+    return PlanStage::ADVANCED;
+}
+
+void ProjectionStageSimple::projectObj(const BSONObj& objToProject, BSONObjBuilder* bob) const {
     // Look at every field in the source document and see if we're including it.
-    auto objToProject = member->doc.value().toBson();
     auto nFieldsNeeded = _includedFields.size();
     for (auto&& elt : objToProject) {
         auto fieldName{elt.fieldNameStringData()};
+        if (!_includedFieldsFilter.mayContain(fieldName)) {
+            continue;
+        }
+
         absl::string_view fieldNameKey{fieldName.rawData(), fieldName.size()};
         if (auto fieldIt = _includedFields.find(fieldNameKey); _includedFields.end() != fieldIt) {
-            bob.append(elt);
+            bob->append(elt);
             if (--nFieldsNeeded == 0) {
                 break;
             }
         }
     }
-
-    transitionMemberToOwnedObj(bob.obj(), member);
-    return Status::OK();
 }
 
 }  // namespace mongo
@@ -30,7 +30,9 @@
 #pragma once
 
 #include "mongo/db/exec/plan_stage.h"
+#include "mongo/db/exec/projected_field_name_filter.h"
 #include "mongo/db/exec/projection_executor.h"
+#include "mongo/db/exec/record_batch.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/matcher/expression.h"
 #include "mongo/db/query/projection_ast.h"
@@ -166,11 +168,29 @@ public:
         return STAGE_PROJECTION_SIMPLE;
     }
 
+    bool supportsBatchedWork() const final {
+        return child()->supportsBatchedWork();
+    }
+
+protected:
+    StageState doWorkBatch(RecordBatch* out) final;
+
 private:
     Status transform(WorkingSetMember* member) const final;
 
+    /**
+     * Appends the fields of 'objToProject' which are included by the projection to 'bob'.
+     */
+    void projectObj(const BSONObj& objToProject, BSONObjBuilder* bob) const;
+
     // Has the field names present in the simple projection.
     stdx::unordered_set<std::string> _includedFields;
+
+    // Summarizes '_includedFields', so that most excluded fields are skipped without hashing them.
+    ProjectedFieldNameFilter _includedFieldsFilter;
+
+    // Holds the batch produced by our child during batched execution. Created on first use.
+    std::unique_ptr<RecordBatch> _childBatch;
 };
 
 }  // namespace mongo
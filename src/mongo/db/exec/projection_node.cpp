@@ -31,6 +31,8 @@
 
 #include "mongo/db/exec/projection_node.h"
 
+#include "mongo/db/query/query_knobs_gen.h"
+
 namespace mongo::projection_executor {
 using ArrayRecursionPolicy = ProjectionPolicies::ArrayRecursionPolicy;
 using ComputedFieldsPolicy = ProjectionPolicies::ComputedFieldsPolicy;
@@ -49,6 +51,7 @@ void ProjectionNode::_addProjectionForPath(const FieldPath& path) {
     makeOptimizationsStale();
     if (path.getPathLength() == 1) {
         _projectedFields.insert(path.fullPath());
+        _fieldNameFilter.add(path.fullPath());
         return;
     }
     // FieldPath can't be empty, so it is safe to obtain the first path component here.
@@ -108,6 +111,7 @@ ProjectionNode* ProjectionNode::addChild(const std::string& field) {
     makeOptimizationsStale();
     invariant(!str::contains(field, "."));
     _orderToProcessAdditionsAndChildren.push_back(field);
+    _fieldNameFilter.add(field);
     auto insertedPair = _children.emplace(std::make_pair(field, makeChild(field)));
     return insertedPair.first->second.get();
 }
@@ -142,7 +146,9 @@ void ProjectionNode::applyProjections(const Document& inputDoc, MutableDocument*
         auto fieldName = it.fieldName();
         absl::string_view fieldNameKey{fieldName.rawData(), fieldName.size()};
 
-        if (_projectedFields.find(fieldNameKey) != _projectedFields.end()) {
+        if (!_fieldNameFilter.mayContain(fieldName)) {
+            it.advance();
+        } else if (_projectedFields.find(fieldNameKey) != _projectedFields.end()) {
             outputProjectedField(
                 fieldName, applyLeafProjectionToValue(it.next().second), outputDoc);
             ++projectedFields;
@@ -189,31 +195,44 @@ void ProjectionNode::outputProjectedField(StringData field, Value val, MutableDo
 }
 
 void ProjectionNode::applyExpressions(const Document& root, MutableDocument* outputDoc) const {
+    if (_compiledExpressions) {
+        _compiledExpressions->start(root);
+    }
+    applyExpressions(root, outputDoc, _compiledExpressions.get());
+}
+
+void ProjectionNode::applyExpressions(const Document& root,
+                                      MutableDocument* outputDoc,
+                                      const CompiledExpression* compiled) const {
     for (auto&& field : _orderToProcessAdditionsAndChildren) {
         auto childIt = _children.find(field);
         if (childIt != _children.end()) {
-            outputDoc->setField(
-                field, childIt->second->applyExpressionsToValue(root, outputDoc->peek()[field]));
+            outputDoc->setField(field,
+                                childIt->second->applyExpressionsToValue(
+                                    root, outputDoc->peek()[field], compiled));
         } else {
             auto expressionIt = _expressions.find(field);
             invariant(expressionIt != _expressions.end());
+            auto variables = &expressionIt->second->getExpressionContext()->variables;
             outputDoc->setField(
                 field,
-                expressionIt->second->evaluate(
-                    root, &expressionIt->second->getExpressionContext()->variables));
+                compiled ? compiled->evaluate(_compiledExpressionIndexes.at(field), variables)
+                         : expressionIt->second->evaluate(root, variables));
         }
     }
 }
 
-Value ProjectionNode::applyExpressionsToValue(const Document& root, Value inputValue) const {
+Value ProjectionNode::applyExpressionsToValue(const Document& root,
+                                              Value inputValue,
+                                              const CompiledExpression* compiled) const {
     if (inputValue.getType() == BSONType::Object) {
         MutableDocument outputDoc(inputValue.getDocument());
-        applyExpressions(root, &outputDoc);
+        applyExpressions(root, &outputDoc, compiled);
         return outputDoc.freezeToValue();
     } else if (inputValue.getType() == BSONType::Array) {
         std::vector<Value> values = inputValue.getArray();
         for (auto& value : values) {
-            value = applyExpressionsToValue(root, value);
+            value = applyExpressionsToValue(root, value, compiled);
         }
         return Value(std::move(values));
     } else {
@@ -222,7 +241,7 @@ Value ProjectionNode::applyExpressionsToValue(const Document& root, Value inputV
             // document of all the computed values. This case represents applying a projection like
             // {"a.b": {$literal: 1}} to the document {a: 1}. This should yield {a: {b: 1}}.
             MutableDocument outputDoc;
-            applyExpressions(root, &outputDoc);
+            applyExpressions(root, &outputDoc, compiled);
             return outputDoc.freezeToValue();
         }
         // We didn't have any expressions, so just skip this value.
@@ -267,6 +286,25 @@ void ProjectionNode::optimize() {
     }
 
     _maxFieldsToProject = maxFieldsToProject();
+
+    // The root compiles the expressions of the whole tree into one program, so that expressions in
+    // different nodes share their field path lookups.
+    _compiledExpressions.reset();
+    if (_pathToNode.empty() && _subtreeContainsComputedFields &&
+        internalQueryEnableCompiledExpressions.load()) {
+        _compiledExpressions = std::make_unique<CompiledExpression>();
+        compileExpressions(_compiledExpressions.get());
+    }
+}
+
+void ProjectionNode::compileExpressions(CompiledExpression* compiled) {
+    _compiledExpressionIndexes.clear();
+    for (auto&& expressionIt : _expressions) {
+        _compiledExpressionIndexes[expressionIt.first] = compiled->add(expressionIt.second.get());
+    }
+    for (auto&& childPair : _children) {
+        childPair.second->compileExpressions(compiled);
+    }
 }
 
 Document ProjectionNode::serialize(boost::optional<ExplainOptions::Verbosity> explain) const {
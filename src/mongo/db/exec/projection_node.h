@@ -31,6 +31,8 @@
 
 #include "mongo/db/exec/projection_executor.h"
 
+#include "mongo/db/exec/projected_field_name_filter.h"
+#include "mongo/db/pipeline/compiled_expression.h"
 #include "mongo/db/query/projection_policies.h"
 
 namespace mongo::projection_executor {
@@ -163,12 +165,24 @@ protected:
     stdx::unordered_map<std::string, std::unique_ptr<ProjectionNode>> _children;
     stdx::unordered_map<std::string, boost::intrusive_ptr<Expression>> _expressions;
     stdx::unordered_set<std::string> _projectedFields;
+
+    // Summarizes the names in '_projectedFields' and '_children', so that the fields of the input
+    // document which this node doesn't touch can be skipped without looking them up in either.
+    ProjectedFieldNameFilter _fieldNameFilter;
+
     ProjectionPolicies _policies;
     std::string _pathToNode;
 
     // Whether this node or any child of this node contains a computed field.
     bool _subtreeContainsComputedFields{false};
 
+    // On the root node, the expressions of the whole tree compiled into a single program, if
+    // compiled expressions were enabled when the tree was last optimized.
+    std::unique_ptr<CompiledExpression> _compiledExpressions;
+
+    // The index of each of '_expressions' in the root's compiled program.
+    stdx::unordered_map<std::string, size_t> _compiledExpressionIndexes;
+
 private:
     // Iterates 'inputDoc' for each projected field, adding to or removing from 'outputDoc'. Also
     // copies over enough information to preserve the structure of the incoming document for the
@@ -184,9 +198,20 @@ private:
 
     // Helpers for the 'applyProjections' and 'applyExpressions' methods. Applies the transformation
     // recursively to each element of any arrays, and ensures primitives are handled appropriately.
-    Value applyExpressionsToValue(const Document& root, Value inputVal) const;
+    Value applyExpressionsToValue(const Document& root,
+                                  Value inputVal,
+                                  const CompiledExpression* compiled) const;
     Value applyProjectionsToValue(Value inputVal) const;
 
+    // Evaluates the expressions of this node and its children using 'compiled', if not null, or by
+    // walking each expression otherwise.
+    void applyExpressions(const Document& root,
+                          MutableDocument* outputDoc,
+                          const CompiledExpression* compiled) const;
+
+    // Adds the expressions of this node and its children to 'compiled'.
+    void compileExpressions(CompiledExpression* compiled);
+
     // Adds a new ProjectionNode as a child. 'field' cannot be dotted.
     ProjectionNode* addChild(const std::string& field);
 
@@ -200,6 +225,7 @@ private:
      */
     void makeOptimizationsStale() {
         _maxFieldsToProject = boost::none;
+        _compiledExpressions.reset();
     }
 
     /**
@@ -0,0 +1,130 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#pragma once
+
+#include <vector>
+
+#include "mongo/bson/bsonobj.h"
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/bson/util/builder.h"
+#include "mongo/db/record_id.h"
+#include "mongo/db/storage/snapshot.h"
+
+namespace mongo {
+
+/**
+ * A batch of documents exchanged between PlanStages executing in batched mode (see
+ * PlanStage::workBatch()). Each entry is a RecordId, which may be null, and a BSON document.
+ *
+ * The documents are copied into a single buffer owned by the batch, which is reused once the batch
+ * is cleared. This keeps the documents valid across yields and avoids allocating memory for each
+ * of them. A document returned by getObj() is an unowned view which remains valid until the batch
+ * is next modified.
+ */
+class RecordBatch {
+public:
+    explicit RecordBatch(size_t capacity);
+
+    size_t capacity() const {
+        return _capacity;
+    }
+
+    size_t size() const {
+        return _entries.size();
+    }
+
+    bool empty() const {
+        return _entries.empty();
+    }
+
+    bool full() const {
+        return _entries.size() >= _capacity;
+    }
+
+    /**
+     * Removes all documents from the batch without releasing its memory.
+     */
+    void clear();
+
+    /**
+     * Copies 'obj' into the batch. The batch must not be full.
+     */
+    void append(const RecordId& recordId, const BSONObj& obj);
+
+    /**
+     * Appends a document built by 'buildFn', which is passed a BSONObjBuilder writing directly
+     * into the batch's buffer. The batch must not be full.
+     */
+    template <typename BuildFn>
+    void appendBuilt(const RecordId& recordId, BuildFn&& buildFn) {
+        invariant(!full());
+        const int offset = _buffer.len();
+        BSONObjBuilder bob(_buffer);
+        buildFn(bob);
+        bob.done();
+        _entries.push_back({recordId, offset});
+    }
+
+    const RecordId& getRecordId(size_t i) const {
+        return _entries[i].recordId;
+    }
+
+    BSONObj getObj(size_t i) const {
+        return BSONObj(_buffer.buf() + _entries[i].offset);
+    }
+
+    /**
+     * The storage engine snapshot from which every document in the batch was read.
+     */
+    SnapshotId getSnapshotId() const {
+        return _snapshotId;
+    }
+
+    void setSnapshotId(SnapshotId snapshotId) {
+        _snapshotId = snapshotId;
+    }
+
+private:
+    struct Entry {
+        RecordId recordId;
+
+        // The offset of the document within '_buffer'. Offsets rather than pointers are kept since
+        // the buffer may be reallocated as it grows.
+        int offset;
+    };
+
+    const size_t _capacity;
+    std::vector<Entry> _entries;
+    BufBuilder _buffer;
+    SnapshotId _snapshotId;
+};
+
+}  // namespace mongo
@@ -0,0 +1,99 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/exec/record_batch.h"
+
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+namespace {
+
+TEST(RecordBatchTest, AppendCopiesDocuments) {
+    RecordBatch batch(4);
+    ASSERT_TRUE(batch.empty());
+
+    {
+        BSONObj obj = BSON("a" << 1);
+        batch.append(RecordId(1), obj);
+    }
+    batch.append(RecordId(2), BSON("b" << 2));
+
+    ASSERT_EQUALS(2U, batch.size());
+    ASSERT_FALSE(batch.full());
+    ASSERT_EQUALS(RecordId(1), batch.getRecordId(0));
+    ASSERT_BSONOBJ_EQ(BSON("a" << 1), batch.getObj(0));
+    ASSERT_EQUALS(RecordId(2), batch.getRecordId(1));
+    ASSERT_BSONOBJ_EQ(BSON("b" << 2), batch.getObj(1));
+}
+
+TEST(RecordBatchTest, AppendBuiltWritesIntoBatch) {
+    RecordBatch batch(2);
+    batch.appendBuilt(RecordId(), [](BSONObjBuilder& bob) { bob.append("x", "y"); });
+    batch.append(RecordId(7), BSON("z" << 3));
+
+    ASSERT_TRUE(batch.full());
+    ASSERT_TRUE(batch.getRecordId(0).isNull());
+    ASSERT_BSONOBJ_EQ(BSON("x"
+                           << "y"),
+                      batch.getObj(0));
+    ASSERT_BSONOBJ_EQ(BSON("z" << 3), batch.getObj(1));
+}
+
+TEST(RecordBatchTest, DocumentsSurviveBufferGrowth) {
+    RecordBatch batch(100);
+    const std::string longString(1024, 'x');
+    for (int i = 0; i < 100; ++i) {
+        batch.append(RecordId(i + 1), BSON("i" << i << "s" << longString));
+    }
+    for (int i = 0; i < 100; ++i) {
+        ASSERT_EQUALS(RecordId(i + 1), batch.getRecordId(i));
+        ASSERT_BSONOBJ_EQ(BSON("i" << i << "s" << longString), batch.getObj(i));
+    }
+}
+
+TEST(RecordBatchTest, ClearEmptiesBatch) {
+    RecordBatch batch(1);
+    batch.setSnapshotId(SnapshotId(5));
+    batch.append(RecordId(1), BSON("a" << 1));
+    ASSERT_TRUE(batch.full());
+
+    batch.clear();
+    ASSERT_TRUE(batch.empty());
+    ASSERT(batch.getSnapshotId() == SnapshotId());
+
+    batch.append(RecordId(2), BSON("b" << 2));
+    ASSERT_BSONOBJ_EQ(BSON("b" << 2), batch.getObj(0));
+}
+
+}  // namespace
+}  // namespace mongo
@@ -34,6 +34,7 @@
 #include "mongo/db/exec/sort_key_comparator.h"
 #include "mongo/db/exec/working_set.h"
 #include "mongo/db/pipeline/expression.h"
+#include "mongo/db/query/query_knobs_gen.h"
 #include "mongo/db/query/sort_pattern.h"
 #include "mongo/db/sorter/sorter.h"
 
@@ -54,14 +55,26 @@ public:
     using DocumentSorter = Sorter<Value, T>;
     class Comparator {
     public:
-        Comparator(const SortPattern& sortPattern) : _sortKeyComparator(sortPattern) {}
+        Comparator(const SortPattern& sortPattern)
+            : _sortKeyComparator(sortPattern),
+              _useKeyStrings(internalQueryEnableKeyStringSort.load()) {}
         int operator()(const typename DocumentSorter::Data& lhs,
                        const typename DocumentSorter::Data& rhs) const {
             return _sortKeyComparator(lhs.first, rhs.first);
         }
 
+        /**
+         * Lets the Sorter order in-memory data by KeyString-encoded sort keys, falling back to
+         * this comparator only for keys whose encodings are identical.
+         */
+        bool appendNormalizedKey(const typename DocumentSorter::Data& data,
+                                 BufBuilder* out) const {
+            return _useKeyStrings && _sortKeyComparator.appendKeyString(data.first, out);
+        }
+
     private:
         SortKeyComparator _sortKeyComparator;
+        bool _useKeyStrings;
     };
 
     /**
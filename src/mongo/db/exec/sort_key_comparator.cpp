@@ -29,6 +29,8 @@
 
 #include "mongo/db/exec/sort_key_comparator.h"
 
+#include "mongo/db/storage/key_string.h"
+
 namespace mongo {
 
 SortKeyComparator::SortKeyComparator(const SortPattern& sortPattern) {
@@ -40,6 +42,7 @@ SortKeyComparator::SortKeyComparator(const SortPattern& sortPattern) {
                        return part.isAscending ? SortDirection::kAscending
                                                : SortDirection::kDescending;
                    });
+    initOrdering();
 }
 
 int SortKeyComparator::operator()(const Value& lhsKey, const Value& rhsKey) const {
@@ -80,6 +83,50 @@ SortKeyComparator::SortKeyComparator(const BSONObj& sortPattern) {
                        return (part.number() >= 0) ? SortDirection::kAscending
                                                    : SortDirection::kDescending;
                    });
+    initOrdering();
+}
+
+void SortKeyComparator::initOrdering() {
+    if (_pattern.size() > Ordering::kMaxCompoundIndexKeys) {
+        // Such keys are never encoded as KeyStrings.
+        return;
+    }
+
+    BSONObjBuilder builder;
+    for (auto direction : _pattern) {
+        builder.append("", direction == SortDirection::kAscending ? 1 : -1);
+    }
+    _ordering = Ordering::make(builder.obj());
+}
+
+bool SortKeyComparator::appendKeyString(const Value& sortKey, BufBuilder* out) const {
+    if (_pattern.size() > Ordering::kMaxCompoundIndexKeys) {
+        return false;
+    }
+
+    // The sort key is already a collation comparison key, so its strings are encoded as is.
+    BSONObjBuilder builder;
+    if (_pattern.size() == 1) {
+        if (sortKey.missing()) {
+            return false;
+        }
+        sortKey.addToBsonObj(&builder, ""_sd);
+    } else {
+        if (sortKey.getType() != BSONType::Array ||
+            sortKey.getArrayLength() != _pattern.size()) {
+            return false;
+        }
+        for (auto&& component : sortKey.getArray()) {
+            if (component.missing()) {
+                return false;
+            }
+            component.addToBsonObj(&builder, ""_sd);
+        }
+    }
+
+    KeyString::Builder keyString(KeyString::Version::kLatestVersion, builder.done(), _ordering);
+    out->appendBuf(keyString.getBuffer(), keyString.getSize());
+    return true;
 }
 
 }  // namespace mongo
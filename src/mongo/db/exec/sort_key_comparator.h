@@ -31,6 +31,7 @@
 
 #include <vector>
 
+#include "mongo/bson/ordering.h"
 #include "mongo/db/exec/document_value/value.h"
 #include "mongo/db/query/sort_pattern.h"
 
@@ -48,11 +49,23 @@ public:
     SortKeyComparator(const BSONObj& sortPattern);
     int operator()(const Value& lhsKey, const Value& rhsKey) const;
 
+    /**
+     * Appends a KeyString encoding of 'sortKey' to 'out', such that comparing two encodings with
+     * memcmp() orders them as this comparator would. Returns false if the key cannot be encoded,
+     * for instance because one of its components is missing.
+     */
+    bool appendKeyString(const Value& sortKey, BufBuilder* out) const;
+
 private:
+    void initOrdering();
+
     // The comparator does not need the entire sort pattern, just the sort direction for each
     // component.
     enum class SortDirection { kDescending, kAscending };
     std::vector<SortDirection> _pattern;
+
+    // The sort directions in the form used to encode KeyStrings.
+    Ordering _ordering = Ordering::make(BSONObj());
 };
 
 }  // namespace mongo
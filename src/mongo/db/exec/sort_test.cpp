@@ -37,13 +37,16 @@
 #include <memory>
 
 #include "mongo/db/exec/queued_data_stage.h"
+#include "mongo/db/exec/sort_executor.h"
 #include "mongo/db/json.h"
 #include "mongo/db/operation_context.h"
 #include "mongo/db/query/collation/collator_factory_mock.h"
 #include "mongo/db/query/collation/collator_interface_mock.h"
+#include "mongo/db/query/query_knobs_gen.h"
 #include "mongo/db/service_context_d_test_fixture.h"
 #include "mongo/unittest/unittest.h"
 #include "mongo/util/clock_source_mock.h"
+#include "mongo/util/scopeguard.h"
 
 using namespace mongo;
 
@@ -304,4 +307,70 @@ TEST_F(SortStageDefaultTest, SortDescendingWithCollation) {
              "{input: [{a: 'ba'}, {a: 'aa'}, {a: 'ab'}]}",
              "{output: [{a: 'ab'}, {a: 'ba'}, {a: 'aa'}]}");
 }
+
+//
+// Sorting on KeyString-encoded sort keys must produce the same order as the comparator.
+//
+
+/**
+ * Sorts 'keys' with a SortExecutor and returns the positions of the keys in sorted order.
+ */
+std::vector<int> sortKeysWithExecutor(const SortPattern& pattern,
+                                      const std::vector<Value>& keys,
+                                      uint64_t limit) {
+    SortExecutor<BSONObj> executor(
+        pattern, limit, SortStageDefaultTest::kMaxMemoryUsageBytes, "", false);
+    for (size_t i = 0; i < keys.size(); ++i) {
+        executor.add(keys[i], BSON("i" << static_cast<int>(i)));
+    }
+    executor.loadingDone();
+
+    std::vector<int> order;
+    while (executor.hasNext()) {
+        order.push_back(executor.getNext().second["i"].numberInt());
+    }
+    return order;
+}
+
+TEST_F(SortStageDefaultTest, KeyStringSortMatchesComparatorSort) {
+    auto expCtx = make_intrusive<ExpressionContext>(opCtx(), nullptr, kNss);
+    SortPattern pattern{BSON("a" << 1 << "b" << -1), expCtx};
+
+    // Values of many types, including numerically equal values of different types, so that both
+    // the encoding and the ordering of ties are exercised.
+    const std::vector<Value> values = {Value(BSONNULL),
+                                       Value(1),
+                                       Value(1.0),
+                                       Value(Decimal128("1")),
+                                       Value(2LL),
+                                       Value(-0.5),
+                                       Value(std::numeric_limits<double>::quiet_NaN()),
+                                       Value(""_sd),
+                                       Value("ab"_sd),
+                                       Value("abc"_sd),
+                                       Value(BSON("x" << 1)),
+                                       Value(std::vector<Value>{Value(1), Value(2)}),
+                                       Value(true),
+                                       Value(Date_t::fromMillisSinceEpoch(5))};
+    std::vector<Value> keys;
+    for (size_t i = 0; i < 500; ++i) {
+        keys.push_back(Value(std::vector<Value>{values[(i * 5) % values.size()],
+                                                values[(i / values.size()) % values.size()]}));
+    }
+
+    const auto expectedOrder = sortKeysWithExecutor(pattern, keys, 0);
+    const auto expectedTopK = sortKeysWithExecutor(pattern, keys, 100);
+
+    internalQueryEnableKeyStringSort.store(true);
+    ON_BLOCK_EXIT([] { internalQueryEnableKeyStringSort.store(false); });
+    ASSERT(sortKeysWithExecutor(pattern, keys, 0) == expectedOrder);
+
+    // A top-k sort does not order ties stably, so only compare the keys.
+    const auto topK = sortKeysWithExecutor(pattern, keys, 100);
+    ASSERT_EQ(topK.size(), expectedTopK.size());
+    SortKeyComparator comparator(pattern);
+    for (size_t i = 0; i < topK.size(); ++i) {
+        ASSERT_EQ(0, comparator(keys[topK[i]], keys[expectedTopK[i]]));
+    }
+}
 }  // namespace
@@ -0,0 +1,319 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/matcher/compiled_match_expression.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "mongo/db/field_ref.h"
+#include "mongo/db/matcher/expression_leaf.h"
+#include "mongo/db/matcher/expression_path.h"
+#include "mongo/util/assert_util.h"
+
+namespace mongo {
+namespace {
+
+/**
+ * Returns true if a comparison against 'rhs' of the same type may be done without calling into
+ * the expression, which is the case for numbers and strings compared without a collator.
+ */
+bool canCompareInline(const ComparisonMatchExpression* expr) {
+    if (expr->getCollator()) {
+        return false;
+    }
+    const auto& rhs = expr->getData();
+    switch (rhs.type()) {
+        case NumberInt:
+        case NumberLong:
+        case String:
+            return true;
+        case NumberDouble:
+            return !std::isnan(rhs._numberDouble());
+        default:
+            return false;
+    }
+}
+
+template <typename T>
+int compareValues(T lhs, T rhs) {
+    return lhs < rhs ? -1 : (lhs > rhs ? 1 : 0);
+}
+
+}  // namespace
+
+CompiledMatchExpression::CompiledMatchExpression(const MatchExpression* expr) {
+    invariant(expr);
+    _compile(expr);
+    _topLevelValues.resize(_topLevelFields.size());
+    _pathValues.resize(_paths.size());
+    _pathGeneration.resize(_paths.size(), 0);
+}
+
+void CompiledMatchExpression::_compile(const MatchExpression* expr) {
+    Instruction instr;
+    instr.expr = expr;
+
+    bool compileChildren = true;
+    switch (expr->matchType()) {
+        case MatchExpression::AND:
+            instr.op = OpCode::kAnd;
+            break;
+        case MatchExpression::OR:
+            instr.op = OpCode::kOr;
+            break;
+        case MatchExpression::NOR:
+            instr.op = OpCode::kNor;
+            break;
+        case MatchExpression::NOT:
+            instr.op = OpCode::kNot;
+            break;
+        case MatchExpression::ALWAYS_TRUE:
+            instr.op = OpCode::kAlwaysTrue;
+            break;
+        case MatchExpression::ALWAYS_FALSE:
+            instr.op = OpCode::kAlwaysFalse;
+            break;
+        default: {
+            compileChildren = false;
+            auto pathExpr = dynamic_cast<const PathMatchExpression*>(expr);
+            if (!pathExpr || pathExpr->path().empty()) {
+                instr.op = OpCode::kTreeWalk;
+                break;
+            }
+
+            instr.pathIndex = _addPath(pathExpr->path());
+            instr.op = OpCode::kPath;
+            if (auto comparison = dynamic_cast<const ComparisonMatchExpression*>(expr)) {
+                instr.op = OpCode::kComparison;
+                instr.rhs = comparison->getData();
+                instr.rhsCanonicalType = instr.rhs.canonicalType();
+                instr.rhsIsMinOrMaxKey =
+                    instr.rhs.type() == MinKey || instr.rhs.type() == MaxKey;
+                instr.canCompareInline = canCompareInline(comparison);
+            }
+        }
+    }
+
+    const size_t pc = _program.size();
+    _program.push_back(instr);
+    if (compileChildren) {
+        for (size_t i = 0; i < expr->numChildren(); ++i) {
+            _compile(expr->getChild(i));
+        }
+    }
+    _program[pc].end = _program.size();
+}
+
+size_t CompiledMatchExpression::_addPath(StringData path) {
+    FieldRef fieldRef(path);
+    invariant(fieldRef.numParts() > 0);
+
+    std::vector<std::string> parts;
+    for (size_t i = 0; i < fieldRef.numParts(); ++i) {
+        parts.push_back(fieldRef.getPart(i).toString());
+    }
+
+    auto samePath = std::find_if(
+        _paths.begin(), _paths.end(), [&](const Path& other) { return other.parts == parts; });
+    if (samePath != _paths.end()) {
+        return samePath - _paths.begin();
+    }
+
+    auto topLevelField = std::find(_topLevelFields.begin(), _topLevelFields.end(), parts[0]);
+    if (topLevelField == _topLevelFields.end()) {
+        topLevelField = _topLevelFields.insert(_topLevelFields.end(), parts[0]);
+    }
+
+    _paths.push_back({static_cast<size_t>(topLevelField - _topLevelFields.begin()),
+                      std::move(parts)});
+    return _paths.size() - 1;
+}
+
+bool CompiledMatchExpression::matchesBSON(const BSONObj& doc) const {
+    ++_generation;
+
+    // Find every top-level field used by the program in a single pass over the document. As with
+    // BSONObj::getField(), the first occurrence of a duplicated field name is used.
+    std::fill(_topLevelValues.begin(), _topLevelValues.end(), BSONElement());
+    if (_topLevelFields.size() == 1) {
+        _topLevelValues[0] = doc.getField(_topLevelFields[0]);
+    } else if (_topLevelFields.size() > 1) {
+        size_t numRemaining = _topLevelFields.size();
+        for (auto&& elem : doc) {
+            const auto fieldName = elem.fieldNameStringData();
+            for (size_t i = 0; i < _topLevelFields.size(); ++i) {
+                if (_topLevelValues[i].eoo() && fieldName == _topLevelFields[i]) {
+                    _topLevelValues[i] = elem;
+                    --numRemaining;
+                    break;
+                }
+            }
+            if (numRemaining == 0) {
+                break;
+            }
+        }
+    }
+
+    return _evaluate(0, doc);
+}
+
+bool CompiledMatchExpression::_evaluate(size_t pc, const BSONObj& doc) const {
+    const auto& instr = _program[pc];
+    switch (instr.op) {
+        case OpCode::kAnd:
+            for (size_t child = pc + 1; child < instr.end; child = _program[child].end) {
+                if (!_evaluate(child, doc)) {
+                    return false;
+                }
+            }
+            return true;
+        case OpCode::kOr:
+            for (size_t child = pc + 1; child < instr.end; child = _program[child].end) {
+                if (_evaluate(child, doc)) {
+                    return true;
+                }
+            }
+            return false;
+        case OpCode::kNor:
+            for (size_t child = pc + 1; child < instr.end; child = _program[child].end) {
+                if (_evaluate(child, doc)) {
+                    return false;
+                }
+            }
+            return true;
+        case OpCode::kNot:
+            return !_evaluate(pc + 1, doc);
+        case OpCode::kAlwaysTrue:
+            return true;
+        case OpCode::kAlwaysFalse:
+            return false;
+        case OpCode::kComparison:
+        case OpCode::kPath: {
+            const auto elem = _resolvePath(instr.pathIndex);
+            if (elem.type() == Array) {
+                // The tree walk traverses arrays along the path, so leave it to handle them.
+                return instr.expr->matchesBSON(doc);
+            }
+            return instr.op == OpCode::kComparison ? _evaluateComparison(instr, elem)
+                                                   : instr.expr->matchesSingleElement(elem);
+        }
+        case OpCode::kTreeWalk:
+            return instr.expr->matchesBSON(doc);
+    }
+    MONGO_UNREACHABLE;
+}
+
+bool CompiledMatchExpression::_evaluateComparison(const Instruction& instr,
+                                                  const BSONElement& elem) const {
+    if (instr.canCompareInline && elem.type() == instr.rhs.type()) {
+        boost::optional<int> cmp;
+        switch (elem.type()) {
+            case NumberInt:
+                cmp = compareValues(elem._numberInt(), instr.rhs._numberInt());
+                break;
+            case NumberLong:
+                cmp = compareValues(elem._numberLong(), instr.rhs._numberLong());
+                break;
+            case NumberDouble:
+                // NaN compares specially, so leave it to the expression.
+                if (!std::isnan(elem._numberDouble())) {
+                    cmp = compareValues(elem._numberDouble(), instr.rhs._numberDouble());
+                }
+                break;
+            case String: {
+                // The same ordering as BSONElement::compareElements() without a collator.
+                const int lhsSize = elem.valuestrsize();
+                const int rhsSize = instr.rhs.valuestrsize();
+                const int res = std::memcmp(
+                    elem.valuestr(), instr.rhs.valuestr(), std::min(lhsSize, rhsSize));
+                cmp = res ? res : lhsSize - rhsSize;
+                break;
+            }
+            default:
+                MONGO_UNREACHABLE;
+        }
+
+        if (cmp) {
+            switch (instr.expr->matchType()) {
+                case MatchExpression::LT:
+                    return *cmp < 0;
+                case MatchExpression::LTE:
+                    return *cmp <= 0;
+                case MatchExpression::EQ:
+                    return *cmp == 0;
+                case MatchExpression::GT:
+                    return *cmp > 0;
+                case MatchExpression::GTE:
+                    return *cmp >= 0;
+                default:
+                    MONGO_UNREACHABLE;
+            }
+        }
+    }
+
+    // Elements in different type brackets never compare, except for null against undefined or
+    // missing, and MinKey or MaxKey against anything.
+    const int canonicalType = elem.canonicalType();
+    if (canonicalType != instr.rhsCanonicalType &&
+        canonicalType + instr.rhsCanonicalType != 5 && !instr.rhsIsMinOrMaxKey) {
+        return false;
+    }
+    return instr.expr->matchesSingleElement(elem);
+}
+
+BSONElement CompiledMatchExpression::_resolvePath(size_t pathIndex) const {
+    if (_pathGeneration[pathIndex] == _generation) {
+        return _pathValues[pathIndex];
+    }
+
+    const auto& path = _paths[pathIndex];
+    BSONElement res = _topLevelValues[path.topLevelFieldIndex];
+    size_t partNum = 0;
+    while (res.type() == Object) {
+        if (++partNum == path.parts.size()) {
+            break;
+        }
+        res = res.embeddedObject().getField(path.parts[partNum]);
+    }
+    if (res.type() != Object && res.type() != Array && partNum + 1 < path.parts.size()) {
+        // A scalar, or nothing, before the end of the path.
+        res = BSONElement();
+    }
+
+    _pathGeneration[pathIndex] = _generation;
+    _pathValues[pathIndex] = res;
+    return res;
+}
+
+}  // namespace mongo
@@ -0,0 +1,145 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "mongo/bson/bsonelement.h"
+#include "mongo/bson/bsonobj.h"
+#include "mongo/db/matcher/expression.h"
+
+namespace mongo {
+
+/**
+ * A MatchExpression lowered into a flat program for repeatedly matching BSON documents.
+ *
+ * The tree walk done by MatchExpression::matchesBSON() makes a virtual call for every node and
+ * resolves the path of every leaf from the root of the document. The compiled program instead
+ * stores the nodes in pre-order in a single vector, so that short-circuiting a logical node skips
+ * to the end of its subtree, and resolves each distinct path at most once per document, finding
+ * all the top-level fields it needs in a single pass over the document.
+ *
+ * When a path resolves to a single non-array element, the leaf is evaluated with
+ * matchesSingleElement(), which is exactly what the tree walk does in that case. Comparisons of
+ * common types without a collator are evaluated inline, and comparisons whose operands are in
+ * different type brackets are rejected without a call. Paths which reach an array, and nodes
+ * which are neither logical nodes nor path expressions (such as $expr or $where), are evaluated by
+ * the tree walk. The result is therefore always identical to matchesBSON().
+ *
+ * The expression must outlive the compiled program. Matching is not thread-safe, since it reuses
+ * scratch space held by the program.
+ */
+class CompiledMatchExpression {
+public:
+    explicit CompiledMatchExpression(const MatchExpression* expr);
+
+    /**
+     * Returns true if 'doc' matches the expression. Equivalent to expr->matchesBSON(doc).
+     */
+    bool matchesBSON(const BSONObj& doc) const;
+
+    /**
+     * Returns the number of distinct paths the program resolves for each document.
+     */
+    size_t numPaths() const {
+        return _paths.size();
+    }
+
+private:
+    enum class OpCode {
+        kAnd,
+        kOr,
+        kNor,
+        kNot,
+        kAlwaysTrue,
+        kAlwaysFalse,
+        // A $eq, $lt, $lte, $gt or $gte leaf.
+        kComparison,
+        // Any other path expression, evaluated with matchesSingleElement().
+        kPath,
+        // A node evaluated with the tree walk.
+        kTreeWalk,
+    };
+
+    struct Instruction {
+        OpCode op;
+
+        // The index one past the last instruction of this node's subtree.
+        size_t end = 0;
+
+        const MatchExpression* expr = nullptr;
+
+        // For kComparison and kPath, the index of the path in '_paths'.
+        size_t pathIndex = 0;
+
+        // For kComparison, the right-hand side and whether it may be compared inline.
+        BSONElement rhs;
+        int rhsCanonicalType = 0;
+        bool rhsIsMinOrMaxKey = false;
+        bool canCompareInline = false;
+    };
+
+    struct Path {
+        // The index of the path's first component in '_topLevelFields'.
+        size_t topLevelFieldIndex;
+        std::vector<std::string> parts;
+    };
+
+    void _compile(const MatchExpression* expr);
+    size_t _addPath(StringData path);
+
+    /**
+     * Evaluates the subtree rooted at '_program[pc]'.
+     */
+    bool _evaluate(size_t pc, const BSONObj& doc) const;
+    bool _evaluateComparison(const Instruction& instr, const BSONElement& elem) const;
+
+    /**
+     * Returns the element at the end of the path, or EOO if there is none, exactly as
+     * getFieldDottedOrArray() would. An array is returned as soon as one is reached.
+     */
+    BSONElement _resolvePath(size_t pathIndex) const;
+
+    std::vector<Instruction> _program;
+    std::vector<Path> _paths;
+    std::vector<std::string> _topLevelFields;
+
+    // Scratch space for matching a single document. '_topLevelValues' holds the value of each of
+    // '_topLevelFields'. A path's element in '_pathValues' is valid for the current document if its
+    // entry in '_pathGeneration' is equal to '_generation'.
+    mutable std::vector<BSONElement> _topLevelValues;
+    mutable std::vector<BSONElement> _pathValues;
+    mutable std::vector<uint64_t> _pathGeneration;
+    mutable uint64_t _generation = 0;
+};
+
+}  // namespace mongo
@@ -0,0 +1,305 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/matcher/compiled_match_expression.h"
+
+#include <limits>
+
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/db/json.h"
+#include "mongo/db/matcher/expression_parser.h"
+#include "mongo/db/pipeline/expression_context_for_test.h"
+#include "mongo/db/query/collation/collator_interface_mock.h"
+#include "mongo/platform/random.h"
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+namespace {
+
+std::unique_ptr<MatchExpression> parse(const BSONObj& filter,
+                                       const boost::intrusive_ptr<ExpressionContext>& expCtx) {
+    auto expr = MatchExpressionParser::parse(filter, expCtx);
+    ASSERT_OK(expr.getStatus());
+    return std::move(expr.getValue());
+}
+
+/**
+ * Generates random documents and filters over a small set of paths, so that the compiled program
+ * can be checked against the MatchExpression tree walk.
+ */
+class RandomMatchGenerator {
+public:
+    explicit RandomMatchGenerator(int32_t seed) : _random(seed) {}
+
+    BSONObj document() {
+        BSONObjBuilder bob;
+        for (auto&& fieldName : {"a", "b", "c", "a"}) {
+            if (_random.nextInt32(3) != 0) {
+                _appendValue(&bob, fieldName, 2);
+            }
+        }
+        return bob.obj();
+    }
+
+    BSONObj filter() {
+        BSONObjBuilder bob;
+        _appendFilter(&bob, 2);
+        if (_random.nextInt32(3) == 0) {
+            // An implicit $and.
+            _appendFilter(&bob, 1);
+        }
+        return bob.obj();
+    }
+
+private:
+    static constexpr auto kFieldNames = {"a", "b", "c", "0"};
+    static constexpr auto kPaths = {"a", "b", "c", "a.b", "a.c", "b.0", "a.b.c", "a.0.b"};
+
+    template <typename T>
+    T _pick(std::initializer_list<T> values) {
+        return *(values.begin() + _random.nextInt32(values.size()));
+    }
+
+    void _appendScalar(BSONObjBuilder* bob, StringData fieldName, bool allowUndefined) {
+        switch (_random.nextInt32(allowUndefined ? 12 : 11)) {
+            case 0:
+                bob->append(fieldName, _random.nextInt32(7) - 3);
+                break;
+            case 1:
+                bob->append(fieldName, static_cast<long long>(_random.nextInt32(7) - 3));
+                break;
+            case 2:
+                bob->append(fieldName, (_random.nextInt32(13) - 6) / 2.0);
+                break;
+            case 3:
+                bob->append(fieldName,
+                            _pick({std::numeric_limits<double>::quiet_NaN(),
+                                   -0.0,
+                                   std::numeric_limits<double>::infinity()}));
+                break;
+            case 4:
+                bob->append(fieldName, Decimal128(_random.nextInt32(7) - 3));
+                break;
+            case 5:
+            case 6:
+                bob->append(fieldName, _pick({"", "a", "ab", "b", "B"}));
+                break;
+            case 7:
+                bob->appendNull(fieldName);
+                break;
+            case 8:
+                bob->appendBool(fieldName, _random.nextInt32(2));
+                break;
+            case 9:
+                bob->appendMinKey(fieldName);
+                break;
+            case 10:
+                bob->appendMaxKey(fieldName);
+                break;
+            case 11:
+                bob->appendUndefined(fieldName);
+                break;
+        }
+    }
+
+    void _appendValue(BSONObjBuilder* bob, StringData fieldName, int depth) {
+        switch (depth > 0 ? _random.nextInt32(4) : 0) {
+            case 0:
+            case 1:
+                _appendScalar(bob, fieldName, true);
+                break;
+            case 2: {
+                BSONObjBuilder sub(bob->subobjStart(fieldName));
+                for (auto&& subFieldName : kFieldNames) {
+                    if (_random.nextInt32(2)) {
+                        _appendValue(&sub, subFieldName, depth - 1);
+                    }
+                }
+                break;
+            }
+            case 3: {
+                BSONObjBuilder sub;
+                const int numElements = _random.nextInt32(3);
+                for (int i = 0; i < numElements; ++i) {
+                    _appendValue(&sub, std::to_string(i), depth - 1);
+                }
+                bob->appendArray(fieldName, sub.obj());
+                break;
+            }
+        }
+    }
+
+    void _appendLeaf(BSONObjBuilder* bob, StringData op) {
+        if (op == "$exists") {
+            bob->appendBool(op, _random.nextInt32(2));
+        } else if (op == "$type") {
+            bob->append(op, _pick({"number", "string", "object", "array", "null"}));
+        } else if (op == "$in") {
+            BSONObjBuilder in;
+            const int numElements = _random.nextInt32(4);
+            for (int i = 0; i < numElements; ++i) {
+                _appendScalar(&in, std::to_string(i), false);
+            }
+            bob->appendArray(op, in.obj());
+        } else if (op == "$size") {
+            bob->append(op, _random.nextInt32(3));
+        } else if (op == "$elemMatch") {
+            BSONObjBuilder elemMatch(bob->subobjStart(op));
+            _appendScalar(&elemMatch, _pick({"$gt", "$eq"}), false);
+        } else if (op == "$mod") {
+            bob->append(op, BSON_ARRAY(2 << 0));
+        } else if (op == "$regex") {
+            bob->append(op, "^a");
+        } else if (op == "$not") {
+            BSONObjBuilder notBob(bob->subobjStart(op));
+            _appendLeaf(&notBob, _pick({"$eq", "$lt", "$gte", "$exists", "$in"}));
+        } else {
+            _appendScalar(bob, op, false);
+        }
+    }
+
+    void _appendFilter(BSONObjBuilder* bob, int depth) {
+        switch (depth > 0 ? _random.nextInt32(6) : 0) {
+            case 0:
+            case 1:
+            case 2: {
+                BSONObjBuilder leaf(bob->subobjStart(_pick(kPaths)));
+                _appendLeaf(&leaf,
+                            _pick({"$eq",
+                                   "$lt",
+                                   "$lte",
+                                   "$gt",
+                                   "$gte",
+                                   "$ne",
+                                   "$exists",
+                                   "$type",
+                                   "$in",
+                                   "$size",
+                                   "$elemMatch",
+                                   "$mod",
+                                   "$regex",
+                                   "$not"}));
+                break;
+            }
+            case 3: {
+                BSONArrayBuilder children(bob->subarrayStart(_pick({"$and", "$or", "$nor"})));
+                const int numChildren = 1 + _random.nextInt32(3);
+                for (int i = 0; i < numChildren; ++i) {
+                    BSONObjBuilder child(children.subobjStart());
+                    _appendFilter(&child, depth - 1);
+                }
+                break;
+            }
+            case 4:
+                bob->append(_pick({"$alwaysTrue", "$alwaysFalse"}), 1);
+                break;
+            case 5:
+                bob->append("$expr", BSON("$lt" << BSON_ARRAY("$a" << 2)));
+                break;
+        }
+    }
+
+    PseudoRandom _random;
+};
+
+void assertMatchesTreeWalk(const boost::intrusive_ptr<ExpressionContext>& expCtx) {
+    RandomMatchGenerator generator(20200417);
+    for (int i = 0; i < 500; ++i) {
+        const auto filter = generator.filter();
+        const auto expr = parse(filter, expCtx);
+        CompiledMatchExpression compiled(expr.get());
+        for (int j = 0; j < 50; ++j) {
+            const auto doc = generator.document();
+            ASSERT_EQ(expr->matchesBSON(doc), compiled.matchesBSON(doc))
+                << "filter: " << filter << ", document: " << doc;
+        }
+    }
+}
+
+TEST(CompiledMatchExpressionTest, MatchesSameDocumentsAsTreeWalk) {
+    assertMatchesTreeWalk(new ExpressionContextForTest());
+}
+
+TEST(CompiledMatchExpressionTest, MatchesSameDocumentsAsTreeWalkWithCollator) {
+    boost::intrusive_ptr<ExpressionContextForTest> expCtx(new ExpressionContextForTest());
+    expCtx->setCollator(
+        std::make_unique<CollatorInterfaceMock>(CollatorInterfaceMock::MockType::kReverseString));
+    assertMatchesTreeWalk(expCtx);
+}
+
+TEST(CompiledMatchExpressionTest, ResolvesEachPathOnce) {
+    boost::intrusive_ptr<ExpressionContextForTest> expCtx(new ExpressionContextForTest());
+    const auto expr = parse(
+        fromjson("{'a.b': {$gt: 1, $lt: 5}, $or: [{'a.b': 3}, {a: {$exists: true}}, {c: 1}]}"),
+        expCtx);
+    CompiledMatchExpression compiled(expr.get());
+    ASSERT_EQ(3U, compiled.numPaths());
+
+    ASSERT_TRUE(compiled.matchesBSON(fromjson("{a: {b: 3}}")));
+    ASSERT_TRUE(compiled.matchesBSON(fromjson("{a: {b: 2}, c: 1}")));
+    ASSERT_FALSE(compiled.matchesBSON(fromjson("{a: {b: 6}, c: 1}")));
+    ASSERT_FALSE(compiled.matchesBSON(fromjson("{c: 1}")));
+}
+
+TEST(CompiledMatchExpressionTest, NullMatchesMissingAndUndefined) {
+    boost::intrusive_ptr<ExpressionContextForTest> expCtx(new ExpressionContextForTest());
+    const auto expr = parse(fromjson("{'a.b': null}"), expCtx);
+    CompiledMatchExpression compiled(expr.get());
+
+    ASSERT_TRUE(compiled.matchesBSON(fromjson("{}")));
+    ASSERT_TRUE(compiled.matchesBSON(fromjson("{a: 1}")));
+    ASSERT_TRUE(compiled.matchesBSON(fromjson("{a: {b: null}}")));
+    ASSERT_TRUE(compiled.matchesBSON(BSON("a" << BSON("b" << BSONUndefined))));
+    ASSERT_FALSE(compiled.matchesBSON(fromjson("{a: {b: 1}}")));
+}
+
+TEST(CompiledMatchExpressionTest, UsesFirstOccurrenceOfDuplicateField) {
+    boost::intrusive_ptr<ExpressionContextForTest> expCtx(new ExpressionContextForTest());
+    const auto expr = parse(fromjson("{a: 1, b: 2}"), expCtx);
+    CompiledMatchExpression compiled(expr.get());
+
+    ASSERT_TRUE(compiled.matchesBSON(BSON("a" << 1 << "b" << 2 << "a" << 2)));
+    ASSERT_FALSE(compiled.matchesBSON(BSON("a" << 2 << "b" << 2 << "a" << 1)));
+}
+
+TEST(CompiledMatchExpressionTest, TraversesArraysLikeTreeWalk) {
+    boost::intrusive_ptr<ExpressionContextForTest> expCtx(new ExpressionContextForTest());
+    const auto expr = parse(fromjson("{'a.b': {$gte: 2}}"), expCtx);
+    CompiledMatchExpression compiled(expr.get());
+
+    ASSERT_TRUE(compiled.matchesBSON(fromjson("{a: [{b: 1}, {b: 2}]}")));
+    ASSERT_TRUE(compiled.matchesBSON(fromjson("{a: {b: [1, 3]}}")));
+    ASSERT_FALSE(compiled.matchesBSON(fromjson("{a: [{b: 1}, {c: 3}]}")));
+}
+
+}  // namespace
+}  // namespace mongo
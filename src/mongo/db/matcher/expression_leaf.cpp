@@ -44,6 +44,7 @@
 #include "mongo/db/matcher/expression_parser.h"
 #include "mongo/db/matcher/path.h"
 #include "mongo/db/query/collation/collator_interface.h"
+#include "mongo/db/query/query_knobs_gen.h"
 #include "mongo/util/regex_util.h"
 #include "mongo/util/str.h"
 
@@ -376,6 +377,7 @@ std::unique_ptr<MatchExpression> InMatchExpression::shallowClone() const {
     next->_hasEmptyArray = _hasEmptyArray;
     next->_equalitySet = _equalitySet;
     next->_originalEqualityVector = _originalEqualityVector;
+    next->_updateEqualityHashSet();
     for (auto&& regex : _regexes) {
         std::unique_ptr<RegexMatchExpression> clonedRegex(
             static_cast<RegexMatchExpression*>(regex->shallowClone().release()));
@@ -385,6 +387,9 @@ std::unique_ptr<MatchExpression> InMatchExpression::shallowClone() const {
 }
 
 bool InMatchExpression::contains(const BSONElement& e) const {
+    if (_equalityHashSet) {
+        return _equalityHashSet->find(e) != _equalityHashSet->end();
+    }
     return std::binary_search(_equalitySet.begin(), _equalitySet.end(), e, _eltCmp.makeLessThan());
 }
 
@@ -496,6 +501,7 @@ void InMatchExpression::_doSetCollator(const CollatorInterface* collator) {
                      _originalEqualityVector.end(),
                      std::back_inserter(_equalitySet),
                      _eltCmp.makeEqualTo());
+    _updateEqualityHashSet();
 }
 
 Status InMatchExpression::setEqualities(std::vector<BSONElement> equalities) {
@@ -529,6 +535,7 @@ Status InMatchExpression::setEqualities(std::vector<BSONElement> equalities) {
                      _originalEqualityVector.end(),
                      std::back_inserter(_equalitySet),
                      _eltCmp.makeEqualTo());
+    _updateEqualityHashSet();
 
     return Status::OK();
 }
@@ -538,6 +545,18 @@ Status InMatchExpression::addRegex(std::unique_ptr<RegexMatchExpression> expr) {
     return Status::OK();
 }
 
+void InMatchExpression::_updateEqualityHashSet() {
+    const auto threshold = internalQueryInHashSetThreshold.load();
+    if (static_cast<long long>(_equalitySet.size()) < threshold) {
+        _equalityHashSet.reset();
+        return;
+    }
+
+    _equalityHashSet = std::make_unique<BSONEltUnorderedSet>(_eltCmp.makeBSONEltUnorderedSet());
+    _equalityHashSet->reserve(_equalitySet.size());
+    _equalityHashSet->insert(_equalitySet.begin(), _equalitySet.end());
+}
+
 MatchExpression::ExpressionOptimizerFunc InMatchExpression::getOptimizer() const {
     return [](std::unique_ptr<MatchExpression> expression) -> std::unique_ptr<MatchExpression> {
         // NOTE: We do not recursively call optimize() on the RegexMatchExpression children in the
@@ -453,6 +453,12 @@ public:
 private:
     ExpressionOptimizerFunc getOptimizer() const final;
 
+    /**
+     * Rebuilds '_equalityHashSet' from '_equalitySet' if the latter is large enough, or clears it
+     * otherwise. Must be called whenever '_equalitySet' or '_eltCmp' changes.
+     */
+    void _updateEqualityHashSet();
+
     // Whether or not '_equalities' has a jstNULL element in it.
     bool _hasNull = false;
 
@@ -476,10 +482,13 @@ private:
     // support std::binary_search. Because we need to sort the elements anyway for things like index
     // bounds building, using binary search avoids the overhead of inserting into a hash table which
     // doesn't pay for itself in the common case where lookups are done a few times if ever.
-    // TODO It may be worth dynamically creating a hashset after matchesSingleElement() has been
-    // called "many" times.
     std::vector<BSONElement> _equalitySet;
 
+    // Hash set over the elements of '_equalitySet', built only for lists of at least
+    // 'internalQueryInHashSetThreshold' elements, where it does pay for itself. Hashes and compares
+    // with '_eltCmp', so lookups respect the collation.
+    std::unique_ptr<BSONEltUnorderedSet> _equalityHashSet;
+
     // Container of regex elements this object owns.
     std::vector<std::unique_ptr<RegexMatchExpression>> _regexes;
 };
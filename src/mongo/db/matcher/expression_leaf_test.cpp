@@ -37,7 +37,9 @@
 #include "mongo/db/matcher/expression_leaf.h"
 #include "mongo/db/matcher/expression_parser.h"
 #include "mongo/db/query/collation/collator_interface_mock.h"
+#include "mongo/db/query/query_knobs_gen.h"
 #include "mongo/unittest/death_test.h"
+#include "mongo/util/scopeguard.h"
 
 namespace mongo {
 
@@ -1370,6 +1372,68 @@ TEST(InMatchExpression, ChangingCollationAfterAddingEqualitiesPreservesEqualitie
     ASSERT(in.contains(obj2.firstElement()));
 }
 
+std::vector<BSONElement> arrayElements(const BSONArray& array) {
+    std::vector<BSONElement> elements;
+    for (auto&& elem : array) {
+        elements.push_back(elem);
+    }
+    return elements;
+}
+
+TEST(InMatchExpression, HashLookupMatchesSameElementsAsBinarySearch) {
+    BSONArrayBuilder operandBuilder;
+    for (int i = 0; i < 200; i += 2) {
+        operandBuilder.append(i);
+    }
+    operandBuilder.append("string");
+    operandBuilder.append(BSON("x" << 1));
+    BSONArray operand = operandBuilder.arr();
+
+    const auto originalThreshold = internalQueryInHashSetThreshold.load();
+    ON_BLOCK_EXIT([&] { internalQueryInHashSetThreshold.store(originalThreshold); });
+
+    internalQueryInHashSetThreshold.store(std::numeric_limits<int>::max());
+    InMatchExpression binarySearchIn("");
+    ASSERT_OK(binarySearchIn.setEqualities(arrayElements(operand)));
+
+    internalQueryInHashSetThreshold.store(0);
+    InMatchExpression hashIn("");
+    ASSERT_OK(hashIn.setEqualities(arrayElements(operand)));
+
+    BSONObj candidates = BSON_ARRAY(0 << 1 << 2.0 << 3.0 << 198LL << 200LL << Decimal128(4)
+                                      << Decimal128("4.5") << "string"
+                                      << "other" << BSON("x" << 1.0) << BSON("x" << 2)
+                                      << BSON("y" << 1) << BSONNULL);
+    for (auto&& candidate : candidates) {
+        ASSERT_EQ(binarySearchIn.contains(candidate), hashIn.contains(candidate)) << candidate;
+    }
+    ASSERT(hashIn.matchesSingleElement(candidates["2"]));
+    ASSERT(!hashIn.matchesSingleElement(candidates["3"]));
+}
+
+TEST(InMatchExpression, HashLookupRespectsCollation) {
+    const auto originalThreshold = internalQueryInHashSetThreshold.load();
+    ON_BLOCK_EXIT([&] { internalQueryInHashSetThreshold.store(originalThreshold); });
+    internalQueryInHashSetThreshold.store(0);
+
+    BSONArray operand = BSON_ARRAY("foo"
+                                   << "bar");
+    BSONObj match = BSON("a"
+                         << "FOO");
+    CollatorInterfaceMock collator(CollatorInterfaceMock::MockType::kToLowerString);
+    InMatchExpression in("");
+    ASSERT_OK(in.setEqualities(arrayElements(operand)));
+    ASSERT(!in.matchesSingleElement(match["a"]));
+
+    // Changing the collator rebuilds the hash set with the new comparison keys.
+    in.setCollator(&collator);
+    ASSERT(in.matchesSingleElement(match["a"]));
+
+    // Clones have their own hash set.
+    auto clone = in.shallowClone();
+    ASSERT(static_cast<InMatchExpression*>(clone.get())->matchesSingleElement(match["a"]));
+}
+
 std::vector<uint32_t> bsonArrayToBitPositions(const BSONArray& ba) {
     std::vector<uint32_t> bitPositions;
 
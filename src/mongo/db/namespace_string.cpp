@@ -50,6 +50,7 @@ constexpr StringData NamespaceString::kAdminDb;
 constexpr StringData NamespaceString::kLocalDb;
 constexpr StringData NamespaceString::kConfigDb;
 constexpr StringData NamespaceString::kSystemDotViewsCollectionName;
+constexpr StringData NamespaceString::kSystemDotStatisticsCollectionName;
 constexpr StringData NamespaceString::kOrphanCollectionPrefix;
 constexpr StringData NamespaceString::kOrphanCollectionDb;
 
@@ -122,6 +123,8 @@ bool NamespaceString::isLegalClientSystemNS() const {
 
     if (coll() == kSystemDotViewsCollectionName)
         return true;
+    if (coll() == kSystemDotStatisticsCollectionName)
+        return true;
 
     return false;
 }
@@ -65,6 +65,10 @@ public:
     // Name for the system views collection
     static constexpr StringData kSystemDotViewsCollectionName = "system.views"_sd;
 
+    // Name for the system statistics collection, which holds the statistics collected by the
+    // 'analyze' command
+    static constexpr StringData kSystemDotStatisticsCollectionName = "system.statistics"_sd;
+
     // Prefix for orphan collections
     static constexpr StringData kOrphanCollectionPrefix = "orphan."_sd;
     static constexpr StringData kOrphanCollectionDb = "local"_sd;
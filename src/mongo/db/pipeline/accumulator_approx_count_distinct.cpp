@@ -0,0 +1,261 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/pipeline/accumulator_approx_count_distinct.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "mongo/base/simple_string_data_comparator.h"
+#include "mongo/db/exec/document_value/document.h"
+#include "mongo/db/exec/document_value/value.h"
+#include "mongo/db/pipeline/expression.h"
+#include "mongo/platform/bits.h"
+
+namespace mongo {
+
+REGISTER_ACCUMULATOR_WITH_MIN_VERSION(
+    approxCountDistinct,
+    AccumulatorApproxCountDistinct::parse,
+    ServerGlobalParams::FeatureCompatibility::Version::kFullyUpgradedTo44);
+
+namespace {
+/**
+ * Returns a hash of 'input' under the collation 'collator', which is null for the simple collation.
+ * ValueComparator::hash() reduces strings to 32-bit MurmurHash3 values under the simple collation,
+ * which would saturate the sketch near 2^32 distinct values, so the simple string comparator is
+ * used instead, hashing strings and collation keys alike with 64-bit MurmurHash3. Code, Symbol,
+ * BinData and RegEx values are still reduced to 32 bits.
+ */
+uint64_t hashValue(const Value& input, const CollatorInterface* collator) {
+    size_t seed = 0xf0afbeef;
+    input.hash_combine(seed,
+                       collator ? static_cast<const StringData::ComparatorInterface*>(collator)
+                                : &SimpleStringDataComparator::kInstance);
+    return seed;
+}
+
+/**
+ * The 64-bit finalizer of MurmurHash3. Value hashes are built with boost::hash_combine, which
+ * leaves many of their bits predictable, so they are mixed before picking a register and a rank.
+ */
+uint64_t mixHash(uint64_t hash) {
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    hash *= 0xc4ceb9fe1a85ec53ULL;
+    hash ^= hash >> 33;
+    return hash;
+}
+}  // namespace
+
+AccumulationExpression AccumulatorApproxCountDistinct::parse(
+    boost::intrusive_ptr<ExpressionContext> expCtx, BSONElement elem, VariablesParseState vps) {
+    uassert(5380600,
+            str::stream() << kAccumulatorName << " requires a document argument, but found "
+                          << typeName(elem.type()),
+            elem.type() == BSONType::Object);
+
+    boost::intrusive_ptr<Expression> argument;
+    int precision = kDefaultPrecision;
+    for (auto&& element : elem.embeddedObject()) {
+        if (element.fieldNameStringData() == "input") {
+            argument = Expression::parseOperand(expCtx, element, vps);
+        } else if (element.fieldNameStringData() == "precision") {
+            uassert(5380601,
+                    str::stream() << "The 'precision' argument to " << kAccumulatorName
+                                  << " must be an integer between " << kMinPrecision << " and "
+                                  << kMaxPrecision << ", but found " << element.toString(false),
+                    element.isNumber() && element.safeNumberLong() == element.number() &&
+                        element.safeNumberLong() >= kMinPrecision &&
+                        element.safeNumberLong() <= kMaxPrecision);
+            precision = element.safeNumberLong();
+        } else {
+            uasserted(5380602,
+                      str::stream() << "Invalid argument specified to " << kAccumulatorName << ": "
+                                    << element.toString());
+        }
+    }
+    uassert(5380603,
+            str::stream() << kAccumulatorName << " requires 'input' argument, received input: "
+                          << elem.embeddedObject().toString(),
+            argument);
+
+    auto factory = [expCtx, precision]() {
+        return AccumulatorApproxCountDistinct::create(expCtx, precision);
+    };
+
+    auto initializer = ExpressionConstant::create(expCtx, Value(BSONNULL));
+    return {std::move(initializer), std::move(argument), std::move(factory)};
+}
+
+boost::intrusive_ptr<AccumulatorState> AccumulatorApproxCountDistinct::create(
+    const boost::intrusive_ptr<ExpressionContext>& expCtx, int precision) {
+    return make_intrusive<AccumulatorApproxCountDistinct>(expCtx, precision);
+}
+
+AccumulatorApproxCountDistinct::AccumulatorApproxCountDistinct(
+    const boost::intrusive_ptr<ExpressionContext>& expCtx, int precision)
+    : AccumulatorState(expCtx), _precision(precision) {
+    invariant(_precision >= kMinPrecision && _precision <= kMaxPrecision);
+    _memUsageBytes = sizeof(*this);
+}
+
+void AccumulatorApproxCountDistinct::processInternal(const Value& input, bool merging) {
+    if (!merging) {
+        if (input.missing()) {
+            return;
+        }
+        ensureRegisters();
+
+        // The top '_precision' bits of the hash pick the register, and the rank is the position of
+        // the first set bit among the remaining ones.
+        const uint64_t hash = mixHash(hashValue(input, getExpressionContext()->getCollator()));
+        const size_t index = hash >> (64 - _precision);
+        const uint64_t remaining = (hash << _precision) | (1ULL << (_precision - 1));
+        const auto rank = static_cast<unsigned char>(countLeadingZeros64(remaining) + 1);
+        _registers[index] = std::max(_registers[index], rank);
+        return;
+    }
+
+    // This is what getValue(true) produced below, unless a user ran a merging $group over
+    // arbitrary documents, so it is checked before being read.
+    uassert(5380621,
+            str::stream() << kAccumulatorName << " can only merge partial results which are "
+                          << "objects, but found " << typeName(input.getType()),
+            input.getType() == Object);
+    const Value precision = input["precision"];
+    uassert(5380622,
+            str::stream() << "The precision of a partial result of " << kAccumulatorName
+                          << " must be an int between " << kMinPrecision << " and "
+                          << kMaxPrecision << ", but found " << precision.toString(),
+            precision.getType() == NumberInt && precision.getInt() >= kMinPrecision &&
+                precision.getInt() <= kMaxPrecision);
+    uassert(5380604,
+            str::stream() << "Cannot merge " << kAccumulatorName << " sketches of precision "
+                          << precision.getInt() << " and " << _precision,
+            precision.getInt() == _precision);
+
+    const Value registersValue = input["registers"];
+    uassert(5380623,
+            str::stream() << "The registers of a partial result of " << kAccumulatorName
+                          << " must be BinData, but found " << typeName(registersValue.getType()),
+            registersValue.getType() == BinData);
+    const BSONBinData registers = registersValue.getBinData();
+    if (registers.length == 0) {
+        return;  // This partition had no data to contribute.
+    }
+    uassert(5380624,
+            str::stream() << "A partial result of " << kAccumulatorName << " of precision "
+                          << _precision << " must have " << (1ULL << _precision)
+                          << " registers, but found " << registers.length,
+            static_cast<size_t>(registers.length) == (1ULL << _precision));
+
+    ensureRegisters();
+    const auto* otherRegisters = static_cast<const unsigned char*>(registers.data);
+    for (size_t i = 0; i < _registers.size(); ++i) {
+        _registers[i] = std::max(_registers[i], otherRegisters[i]);
+    }
+}
+
+Value AccumulatorApproxCountDistinct::getValue(bool toBeMerged) {
+    if (!toBeMerged) {
+        return Value(estimate());
+    }
+    // Empty registers are sent as empty BinData rather than as a null pointer.
+    const void* registers = _registers.empty() ? static_cast<const void*>("") : _registers.data();
+    return Value(DOC("precision" << _precision << "registers"
+                                 << BSONBinData(registers,
+                                                static_cast<int>(_registers.size()),
+                                                BinDataGeneral)));
+}
+
+void AccumulatorApproxCountDistinct::reset() {
+    _registers = {};
+    _memUsageBytes = sizeof(*this);
+}
+
+Document AccumulatorApproxCountDistinct::serialize(boost::intrusive_ptr<Expression> initializer,
+                                                   boost::intrusive_ptr<Expression> argument,
+                                                   bool explain) const {
+    return DOC(getOpName() << DOC("input" << argument->serialize(explain) << "precision"
+                                          << _precision));
+}
+
+void AccumulatorApproxCountDistinct::ensureRegisters() {
+    if (_registers.empty()) {
+        _registers.resize(1ULL << _precision, 0);
+        _memUsageBytes = sizeof(*this) + _registers.size();
+    }
+}
+
+long long AccumulatorApproxCountDistinct::estimate() const {
+    if (_registers.empty()) {
+        return 0;
+    }
+
+    const double m = _registers.size();
+    double sum = 0;
+    size_t zeros = 0;
+    for (auto rank : _registers) {
+        sum += std::ldexp(1.0, -rank);
+        if (rank == 0) {
+            ++zeros;
+        }
+    }
+
+    // The bias correction constant from the HyperLogLog paper (Flajolet et al., 2007).
+    double alpha;
+    switch (_registers.size()) {
+        case 16:
+            alpha = 0.673;
+            break;
+        case 32:
+            alpha = 0.697;
+            break;
+        case 64:
+            alpha = 0.709;
+            break;
+        default:
+            alpha = 0.7213 / (1 + 1.079 / m);
+    }
+    double estimate = alpha * m * m / sum;
+
+    // Small cardinalities are estimated more accurately by counting the empty registers. Numbers and
+    // strings are hashed to 64 bits (see hashValue()), so no correction is applied for large
+    // cardinalities; values of the types which hashValue() reduces to 32 bits saturate near 2^32.
+    if (estimate <= 2.5 * m && zeros > 0) {
+        estimate = m * std::log(m / zeros);
+    }
+    return std::llround(estimate);
+}
+
+}  // namespace mongo
@@ -0,0 +1,110 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <boost/intrusive_ptr.hpp>
+#include <vector>
+
+#include "mongo/db/pipeline/accumulation_statement.h"
+#include "mongo/db/pipeline/accumulator.h"
+#include "mongo/db/pipeline/expression_context.h"
+
+namespace mongo {
+
+/**
+ * Estimates the number of distinct values in a group using a HyperLogLog sketch, in memory that
+ * depends only on the sketch's precision rather than on the number of distinct values. The syntax
+ * is
+ *     {$approxCountDistinct: {input: <expression>, precision: <int>}}
+ *
+ * where 'precision' is optional. A sketch with precision 'p' holds 2^p one-byte registers and has
+ * a standard error of about 1.04 / sqrt(2^p). Values are distinct under the collation, and missing
+ * values are ignored, exactly as in $addToSet.
+ *
+ * Partial results are the sketch's registers, which are merged by taking their maximums, so the
+ * merged estimate is the same as if all of the input had been processed by a single accumulator.
+ */
+class AccumulatorApproxCountDistinct final : public AccumulatorState {
+public:
+    static constexpr auto kAccumulatorName = "$approxCountDistinct"_sd;
+
+    static constexpr int kMinPrecision = 4;
+    static constexpr int kMaxPrecision = 16;
+    static constexpr int kDefaultPrecision = 12;
+
+    static boost::intrusive_ptr<AccumulatorState> create(
+        const boost::intrusive_ptr<ExpressionContext>& expCtx, int precision = kDefaultPrecision);
+
+    static AccumulationExpression parse(boost::intrusive_ptr<ExpressionContext> expCtx,
+                                        BSONElement elem,
+                                        VariablesParseState vps);
+
+    AccumulatorApproxCountDistinct(const boost::intrusive_ptr<ExpressionContext>& expCtx,
+                                   int precision);
+
+    const char* getOpName() const final {
+        return kAccumulatorName.rawData();
+    }
+
+    void processInternal(const Value& input, bool merging) final;
+    Value getValue(bool toBeMerged) final;
+    void reset() final;
+
+    Document serialize(boost::intrusive_ptr<Expression> initializer,
+                       boost::intrusive_ptr<Expression> argument,
+                       bool explain) const final;
+
+    bool isAssociative() const final {
+        return true;
+    }
+
+    bool isCommutative() const final {
+        return true;
+    }
+
+private:
+    /**
+     * Allocates the registers on first use, so that groups which never see a value stay small.
+     */
+    void ensureRegisters();
+
+    /**
+     * Returns the HyperLogLog estimate of the number of distinct values added to the registers.
+     */
+    long long estimate() const;
+
+    const int _precision;
+
+    // The maximum rank seen for each of the 2^'_precision' buckets, or empty if nothing has been
+    // added yet.
+    std::vector<unsigned char> _registers;
+};
+
+}  // namespace mongo
@@ -0,0 +1,156 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/pipeline/accumulator_approx_percentile.h"
+
+#include "mongo/db/exec/document_value/document.h"
+#include "mongo/db/exec/document_value/value.h"
+#include "mongo/db/pipeline/expression.h"
+
+namespace mongo {
+
+REGISTER_ACCUMULATOR_WITH_MIN_VERSION(
+    approxPercentile,
+    AccumulatorApproxPercentile::parse,
+    ServerGlobalParams::FeatureCompatibility::Version::kFullyUpgradedTo44);
+
+AccumulationExpression AccumulatorApproxPercentile::parse(
+    boost::intrusive_ptr<ExpressionContext> expCtx, BSONElement elem, VariablesParseState vps) {
+    uassert(5380607,
+            str::stream() << kAccumulatorName << " requires a document argument, but found "
+                          << typeName(elem.type()),
+            elem.type() == BSONType::Object);
+
+    boost::intrusive_ptr<Expression> argument;
+    std::vector<double> percentiles;
+    int k = QuantileSketch::kDefaultK;
+    for (auto&& element : elem.embeddedObject()) {
+        if (element.fieldNameStringData() == "input") {
+            argument = Expression::parseOperand(expCtx, element, vps);
+        } else if (element.fieldNameStringData() == "p") {
+            uassert(5380608,
+                    str::stream() << "The 'p' argument to " << kAccumulatorName
+                                  << " must be a non-empty array of numbers between 0 and 1, "
+                                     "but found "
+                                  << element.toString(false),
+                    element.type() == BSONType::Array && !element.embeddedObject().isEmpty());
+            for (auto&& p : element.embeddedObject()) {
+                uassert(5380608,
+                        str::stream() << "The 'p' argument to " << kAccumulatorName
+                                      << " must be a non-empty array of numbers between 0 and 1, "
+                                         "but found "
+                                      << element.toString(false),
+                        p.isNumber() && p.numberDouble() >= 0 && p.numberDouble() <= 1);
+                percentiles.push_back(p.numberDouble());
+            }
+        } else if (element.fieldNameStringData() == "k") {
+            uassert(5380609,
+                    str::stream() << "The 'k' argument to " << kAccumulatorName
+                                  << " must be an integer between " << QuantileSketch::kMinK
+                                  << " and " << QuantileSketch::kMaxK << ", but found "
+                                  << element.toString(false),
+                    element.isNumber() && element.safeNumberLong() == element.number() &&
+                        element.safeNumberLong() >= QuantileSketch::kMinK &&
+                        element.safeNumberLong() <= QuantileSketch::kMaxK);
+            k = element.safeNumberLong();
+        } else {
+            uasserted(5380610,
+                      str::stream() << "Invalid argument specified to " << kAccumulatorName << ": "
+                                    << element.toString());
+        }
+    }
+    uassert(5380611,
+            str::stream() << kAccumulatorName << " requires 'input' and 'p' arguments, received "
+                          << "input: " << elem.embeddedObject().toString(),
+            argument && !percentiles.empty());
+
+    auto factory = [expCtx, percentiles, k]() {
+        return AccumulatorApproxPercentile::create(expCtx, percentiles, k);
+    };
+
+    auto initializer = ExpressionConstant::create(expCtx, Value(BSONNULL));
+    return {std::move(initializer), std::move(argument), std::move(factory)};
+}
+
+boost::intrusive_ptr<AccumulatorState> AccumulatorApproxPercentile::create(
+    const boost::intrusive_ptr<ExpressionContext>& expCtx,
+    std::vector<double> percentiles,
+    int k) {
+    return make_intrusive<AccumulatorApproxPercentile>(expCtx, std::move(percentiles), k);
+}
+
+AccumulatorApproxPercentile::AccumulatorApproxPercentile(
+    const boost::intrusive_ptr<ExpressionContext>& expCtx, std::vector<double> percentiles, int k)
+    : AccumulatorState(expCtx),
+      _percentiles(std::move(percentiles)),
+      _sketch(expCtx->getValueComparator(), k) {
+    updateMemUsage();
+}
+
+void AccumulatorApproxPercentile::processInternal(const Value& input, bool merging) {
+    if (!merging) {
+        // Non-numeric types have no impact on percentiles.
+        if (!input.numeric()) {
+            return;
+        }
+        _sketch.add(input);
+    } else {
+        // This is what getValue(true) produced below.
+        _sketch.merge(QuantileSketch::parse(getExpressionContext()->getValueComparator(), input));
+    }
+    updateMemUsage();
+}
+
+Value AccumulatorApproxPercentile::getValue(bool toBeMerged) {
+    if (toBeMerged) {
+        return _sketch.serialize();
+    }
+    if (_sketch.empty()) {
+        return Value(std::vector<Value>(_percentiles.size(), Value(BSONNULL)));
+    }
+    return Value(_sketch.quantiles(_percentiles));
+}
+
+void AccumulatorApproxPercentile::reset() {
+    _sketch = QuantileSketch(getExpressionContext()->getValueComparator(), _sketch.getK());
+    updateMemUsage();
+}
+
+Document AccumulatorApproxPercentile::serialize(boost::intrusive_ptr<Expression> initializer,
+                                                boost::intrusive_ptr<Expression> argument,
+                                                bool explain) const {
+    return DOC(getOpName() << DOC("input" << argument->serialize(explain) << "p"
+                                          << Value(std::vector<Value>(_percentiles.begin(),
+                                                                      _percentiles.end()))
+                                          << "k" << _sketch.getK()));
+}
+
+}  // namespace mongo
@@ -0,0 +1,100 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <boost/intrusive_ptr.hpp>
+#include <vector>
+
+#include "mongo/db/pipeline/accumulation_statement.h"
+#include "mongo/db/pipeline/accumulator.h"
+#include "mongo/db/pipeline/expression_context.h"
+#include "mongo/db/pipeline/quantile_sketch.h"
+
+namespace mongo {
+
+/**
+ * Estimates percentiles of the numeric values in a group using a QuantileSketch, in memory that
+ * depends on the sketch's size 'k' rather than on the number of values. The syntax is
+ *     {$approxPercentile: {input: <expression>, p: [<number in [0, 1]>, ...], k: <int>}}
+ *
+ * where 'k' is optional. The result is an array holding the estimated value at each of the ranks
+ * in 'p', or null for each of them if the group had no numeric values. Non-numeric values are
+ * ignored, as in $avg.
+ *
+ * Partial results are serialized sketches, which merge without loss of accuracy, so percentiles
+ * can be computed across shards without sorting all of the values.
+ */
+class AccumulatorApproxPercentile final : public AccumulatorState {
+public:
+    static constexpr auto kAccumulatorName = "$approxPercentile"_sd;
+
+    static boost::intrusive_ptr<AccumulatorState> create(
+        const boost::intrusive_ptr<ExpressionContext>& expCtx,
+        std::vector<double> percentiles,
+        int k = QuantileSketch::kDefaultK);
+
+    static AccumulationExpression parse(boost::intrusive_ptr<ExpressionContext> expCtx,
+                                        BSONElement elem,
+                                        VariablesParseState vps);
+
+    AccumulatorApproxPercentile(const boost::intrusive_ptr<ExpressionContext>& expCtx,
+                                std::vector<double> percentiles,
+                                int k);
+
+    const char* getOpName() const final {
+        return kAccumulatorName.rawData();
+    }
+
+    void processInternal(const Value& input, bool merging) final;
+    Value getValue(bool toBeMerged) final;
+    void reset() final;
+
+    Document serialize(boost::intrusive_ptr<Expression> initializer,
+                       boost::intrusive_ptr<Expression> argument,
+                       bool explain) const final;
+
+    bool isAssociative() const final {
+        return true;
+    }
+
+    bool isCommutative() const final {
+        return true;
+    }
+
+private:
+    void updateMemUsage() {
+        _memUsageBytes = sizeof(*this) + _sketch.getApproximateSize();
+    }
+
+    const std::vector<double> _percentiles;
+    QuantileSketch _sketch;
+};
+
+}  // namespace mongo
@@ -37,6 +37,8 @@
 #include "mongo/db/exec/document_value/document_value_test_util.h"
 #include "mongo/db/pipeline/accumulation_statement.h"
 #include "mongo/db/pipeline/accumulator.h"
+#include "mongo/db/pipeline/accumulator_approx_count_distinct.h"
+#include "mongo/db/pipeline/accumulator_approx_percentile.h"
 #include "mongo/db/pipeline/expression_context_for_test.h"
 #include "mongo/db/query/collation/collator_interface_mock.h"
 #include "mongo/dbtests/dbtests.h"
@@ -368,6 +370,253 @@ TEST(Accumulators, PushRespectsMaxMemoryConstraint) {
         ErrorCodes::ExceededMemoryLimit);
 }
 
+/* ------------------------- AccumulatorApproxCountDistinct -------------------------- */
+
+TEST(AccumulatorApproxCountDistinct, CountsSmallCardinalitiesExactly) {
+    intrusive_ptr<ExpressionContext> expCtx(new ExpressionContextForTest());
+    assertExpectedResults<AccumulatorApproxCountDistinct>(
+        expCtx,
+        {
+            // No documents evaluated.
+            {{}, Value(0LL)},
+            // Numbers which compare equal are counted once.
+            {{Value(1), Value(2), Value(1.0), Value(2LL)}, Value(2LL)},
+            // Null values are counted, but missing values are ignored.
+            {{Value("a"_sd), Value(BSONNULL), Value(), Value("a"_sd)}, Value(2LL)},
+        });
+}
+
+TEST(AccumulatorApproxCountDistinct, RespectsCollation) {
+    intrusive_ptr<ExpressionContextForTest> expCtx(new ExpressionContextForTest());
+    auto collator =
+        std::make_unique<CollatorInterfaceMock>(CollatorInterfaceMock::MockType::kAlwaysEqual);
+    expCtx->setCollator(std::move(collator));
+    assertExpectedResults<AccumulatorApproxCountDistinct>(
+        expCtx, {{{Value("a"_sd), Value("b"_sd), Value("c"_sd)}, Value(1LL)}});
+}
+
+TEST(AccumulatorApproxCountDistinct, EstimatesLargeCardinalitiesInConstantMemory) {
+    intrusive_ptr<ExpressionContext> expCtx(new ExpressionContextForTest());
+    const long long numDistinct = 100000;
+    const int numShards = 4;
+
+    auto accum = AccumulatorApproxCountDistinct::create(expCtx);
+    std::vector<intrusive_ptr<AccumulatorState>> shards;
+    for (int i = 0; i < numShards; ++i) {
+        shards.push_back(AccumulatorApproxCountDistinct::create(expCtx));
+    }
+
+    int memUsageAfterFirstValue = 0;
+    for (long long i = 0; i < numDistinct; ++i) {
+        // Each value is seen twice, by different shards.
+        accum->process(Value(i), false);
+        accum->process(Value(i), false);
+        shards[i % numShards]->process(Value(i), false);
+        shards[(i + 1) % numShards]->process(Value(i), false);
+        if (i == 0) {
+            memUsageAfterFirstValue = accum->memUsageForSorter();
+        }
+    }
+    ASSERT_EQ(memUsageAfterFirstValue, accum->memUsageForSorter());
+
+    // The default precision has a standard error of about 1.6%, so allow for three times that.
+    const long long estimate = accum->getValue(false).getLong();
+    ASSERT_LT(std::abs(estimate - numDistinct), numDistinct * 5 / 100);
+
+    // Merging the shards' sketches gives exactly the same estimate.
+    auto merger = AccumulatorApproxCountDistinct::create(expCtx);
+    for (auto&& shard : shards) {
+        merger->process(shard->getValue(true), true);
+    }
+    ASSERT_EQ(estimate, merger->getValue(false).getLong());
+}
+
+TEST(AccumulatorApproxCountDistinct, ParsesAndSerializesPrecision) {
+    intrusive_ptr<ExpressionContext> expCtx(new ExpressionContextForTest());
+    auto parse = [&](const BSONObj& spec) {
+        return AccumulationStatement::parseAccumulationStatement(
+            expCtx, spec.firstElement(), expCtx->variablesParseState);
+    };
+
+    auto statement = parse(BSON("count" << BSON("$approxCountDistinct"
+                                                << BSON("input"
+                                                        << "$a"
+                                                        << "precision" << 10))));
+    auto accum = statement.makeAccumulator();
+    ASSERT_DOCUMENT_EQ(
+        Document(fromjson("{$approxCountDistinct: {input: '$a', precision: 10}}")),
+        accum->serialize(statement.expr.initializer, statement.expr.argument, false));
+    accum->process(Value(1), false);
+    ASSERT_EQ(1 << 10, accum->getValue(true)["registers"].getBinData().length);
+
+    // The precision defaults when it is omitted.
+    auto defaultStatement = parse(fromjson("{count: {$approxCountDistinct: {input: '$a'}}}"));
+    ASSERT_DOCUMENT_EQ(
+        Document(fromjson("{$approxCountDistinct: {input: '$a', precision: 12}}")),
+        defaultStatement.makeAccumulator()->serialize(
+            defaultStatement.expr.initializer, defaultStatement.expr.argument, false));
+
+    ASSERT_THROWS_CODE(
+        parse(fromjson("{count: {$approxCountDistinct: '$a'}}")), AssertionException, 5380600);
+    ASSERT_THROWS_CODE(
+        parse(fromjson("{count: {$approxCountDistinct: {input: '$a', precision: 17}}}")),
+        AssertionException,
+        5380601);
+    ASSERT_THROWS_CODE(
+        parse(fromjson("{count: {$approxCountDistinct: {input: '$a', precision: 8.5}}}")),
+        AssertionException,
+        5380601);
+    ASSERT_THROWS_CODE(
+        parse(fromjson("{count: {$approxCountDistinct: {input: '$a', bits: 8}}}")),
+        AssertionException,
+        5380602);
+    ASSERT_THROWS_CODE(parse(fromjson("{count: {$approxCountDistinct: {precision: 8}}}")),
+                       AssertionException,
+                       5380603);
+}
+
+TEST(AccumulatorApproxCountDistinct, RejectsMalformedPartialResults) {
+    intrusive_ptr<ExpressionContext> expCtx(new ExpressionContextForTest());
+    auto accum = AccumulatorApproxCountDistinct::create(expCtx);
+    const std::vector<char> bytes(1 << 12, 1);
+    auto registers = [&](int length) {
+        return BSONBinData(bytes.data(), length, BinDataGeneral);
+    };
+
+    // A merging $group can be run by users over any documents, so none of these may crash.
+    ASSERT_THROWS_CODE(accum->process(Value(1), true), AssertionException, 5380621);
+    ASSERT_THROWS_CODE(accum->process(Value(DOC("registers" << registers(1 << 12))), true),
+                       AssertionException,
+                       5380622);
+    ASSERT_THROWS_CODE(
+        accum->process(Value(DOC("precision" << 12.0 << "registers" << registers(1 << 12))), true),
+        AssertionException,
+        5380622);
+    ASSERT_THROWS_CODE(
+        accum->process(Value(DOC("precision" << 30 << "registers" << registers(1 << 12))), true),
+        AssertionException,
+        5380622);
+    ASSERT_THROWS_CODE(
+        accum->process(Value(DOC("precision" << 10 << "registers" << registers(1 << 10))), true),
+        AssertionException,
+        5380604);
+    ASSERT_THROWS_CODE(accum->process(Value(DOC("precision" << 12)), true),
+                       AssertionException,
+                       5380623);
+    ASSERT_THROWS_CODE(
+        accum->process(Value(DOC("precision" << 12 << "registers" << "AAA="_sd)), true),
+        AssertionException,
+        5380623);
+    ASSERT_THROWS_CODE(
+        accum->process(Value(DOC("precision" << 12 << "registers" << registers(2))), true),
+        AssertionException,
+        5380624);
+
+    // The accumulator is left usable by the rejected partial results.
+    accum->process(Value(DOC("precision" << 12 << "registers" << registers(1 << 12))), true);
+    ASSERT_GT(accum->getValue(false).getLong(), 0);
+}
+
+/* ------------------------- AccumulatorApproxPercentile -------------------------- */
+
+TEST(AccumulatorApproxPercentile, ComputesPercentilesOfNumericInputs) {
+    intrusive_ptr<ExpressionContext> expCtx(new ExpressionContextForTest());
+    auto accum = AccumulatorApproxPercentile::create(expCtx, {0, 0.5, 0.9, 1});
+    for (int i = 1000; i >= 1; --i) {
+        accum->process(Value(i), false);
+    }
+    // Non-numeric inputs are ignored.
+    accum->process(Value("string"_sd), false);
+    accum->process(Value(BSONNULL), false);
+    accum->process(Value(), false);
+
+    auto result = accum->getValue(false);
+    ASSERT_EQ(4U, result.getArrayLength());
+    ASSERT_VALUE_EQ(Value(1), result[0]);
+    ASSERT_LT(std::abs(result[1].coerceToDouble() - 500), 30);
+    ASSERT_LT(std::abs(result[2].coerceToDouble() - 900), 30);
+    ASSERT_VALUE_EQ(Value(1000), result[3]);
+}
+
+TEST(AccumulatorApproxPercentile, ReturnsNullsWithoutNumericInputs) {
+    intrusive_ptr<ExpressionContext> expCtx(new ExpressionContextForTest());
+    auto accum = AccumulatorApproxPercentile::create(expCtx, {0.25, 0.75});
+    accum->process(Value("string"_sd), false);
+    ASSERT_VALUE_EQ(Value(std::vector<Value>{Value(BSONNULL), Value(BSONNULL)}),
+                    accum->getValue(false));
+}
+
+TEST(AccumulatorApproxPercentile, MergesPartialResultsFromShards) {
+    intrusive_ptr<ExpressionContext> expCtx(new ExpressionContextForTest());
+    const int numValues = 100000;
+    const int numShards = 4;
+
+    std::vector<intrusive_ptr<AccumulatorState>> shards;
+    for (int i = 0; i < numShards; ++i) {
+        shards.push_back(AccumulatorApproxPercentile::create(expCtx, {0, 0.5, 0.99, 1}));
+    }
+    for (int i = 0; i < numValues; ++i) {
+        shards[i % numShards]->process(Value((i * 7919) % numValues), false);
+    }
+
+    auto merger = AccumulatorApproxPercentile::create(expCtx, {0, 0.5, 0.99, 1});
+    for (auto&& shard : shards) {
+        merger->process(shard->getValue(true), true);
+    }
+    // The merged sketch stays a small multiple of its size parameter.
+    ASSERT_LT(merger->memUsageForSorter(), 100 * 1024);
+
+    auto result = merger->getValue(false);
+    ASSERT_VALUE_EQ(Value(0), result[0]);
+    ASSERT_LT(std::abs(result[1].coerceToDouble() - 0.5 * numValues), 0.03 * numValues);
+    ASSERT_LT(std::abs(result[2].coerceToDouble() - 0.99 * numValues), 0.03 * numValues);
+    ASSERT_VALUE_EQ(Value(numValues - 1), result[3]);
+}
+
+TEST(AccumulatorApproxPercentile, ParsesAndSerializesArguments) {
+    intrusive_ptr<ExpressionContext> expCtx(new ExpressionContextForTest());
+    auto parse = [&](const BSONObj& spec) {
+        return AccumulationStatement::parseAccumulationStatement(
+            expCtx, spec.firstElement(), expCtx->variablesParseState);
+    };
+
+    auto statement = parse(fromjson("{p: {$approxPercentile: {input: '$a', p: [0.5, 1], k: 50}}}"));
+    ASSERT_DOCUMENT_EQ(
+        Document(fromjson("{$approxPercentile: {input: '$a', p: [0.5, 1], k: 50}}")),
+        statement.makeAccumulator()->serialize(
+            statement.expr.initializer, statement.expr.argument, false));
+
+    // The sketch size defaults when it is omitted.
+    auto defaultStatement = parse(fromjson("{p: {$approxPercentile: {input: '$a', p: [0.5]}}}"));
+    ASSERT_DOCUMENT_EQ(
+        Document(fromjson("{$approxPercentile: {input: '$a', p: [0.5], k: 200}}")),
+        defaultStatement.makeAccumulator()->serialize(
+            defaultStatement.expr.initializer, defaultStatement.expr.argument, false));
+
+    ASSERT_THROWS_CODE(
+        parse(fromjson("{p: {$approxPercentile: '$a'}}")), AssertionException, 5380607);
+    ASSERT_THROWS_CODE(parse(fromjson("{p: {$approxPercentile: {input: '$a', p: 0.5}}}")),
+                       AssertionException,
+                       5380608);
+    ASSERT_THROWS_CODE(parse(fromjson("{p: {$approxPercentile: {input: '$a', p: []}}}")),
+                       AssertionException,
+                       5380608);
+    ASSERT_THROWS_CODE(parse(fromjson("{p: {$approxPercentile: {input: '$a', p: [1.5]}}}")),
+                       AssertionException,
+                       5380608);
+    ASSERT_THROWS_CODE(
+        parse(fromjson("{p: {$approxPercentile: {input: '$a', p: [0.5], k: 4}}}")),
+        AssertionException,
+        5380609);
+    ASSERT_THROWS_CODE(
+        parse(fromjson("{p: {$approxPercentile: {input: '$a', p: [0.5], q: 1}}}")),
+        AssertionException,
+        5380610);
+    ASSERT_THROWS_CODE(parse(fromjson("{p: {$approxPercentile: {input: '$a'}}}")),
+                       AssertionException,
+                       5380611);
+}
+
 /* ------------------------- AccumulatorMergeObjects -------------------------- */
 
 TEST(AccumulatorMergeObjects, MergingZeroObjectsShouldReturnEmptyDocument) {
@@ -0,0 +1,91 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/pipeline/change_stream_event_cache.h"
+
+#include "mongo/db/service_context.h"
+
+namespace mongo {
+namespace {
+
+const auto getChangeStreamEventCache =
+    ServiceContext::declareDecoration<ChangeStreamEventCache>();
+
+}  // namespace
+
+ChangeStreamEventCache& ChangeStreamEventCache::get(ServiceContext* serviceContext) {
+    return getChangeStreamEventCache(serviceContext);
+}
+
+boost::optional<BSONObj> ChangeStreamEventCache::find(const Key& key) const {
+    stdx::lock_guard<Latch> lk(_mutex);
+    auto it = _events.find(key);
+    if (it == _events.end()) {
+        return boost::none;
+    }
+    return it->second;
+}
+
+void ChangeStreamEventCache::insert(const Key& key, BSONObj event, size_t maxSizeBytes) {
+    invariant(event.isOwned());
+    const size_t eventSize = event.objsize();
+
+    stdx::lock_guard<Latch> lk(_mutex);
+    if (!_events.emplace(key, std::move(event)).second) {
+        return;
+    }
+    _sizeBytes += eventSize;
+
+    while (_sizeBytes > maxSizeBytes && !_events.empty()) {
+        auto earliest = _events.begin();
+        _sizeBytes -= earliest->second.objsize();
+        _events.erase(earliest);
+    }
+}
+
+void ChangeStreamEventCache::clear() {
+    stdx::lock_guard<Latch> lk(_mutex);
+    _events.clear();
+    _sizeBytes = 0;
+}
+
+size_t ChangeStreamEventCache::numEvents() const {
+    stdx::lock_guard<Latch> lk(_mutex);
+    return _events.size();
+}
+
+size_t ChangeStreamEventCache::sizeBytes() const {
+    stdx::lock_guard<Latch> lk(_mutex);
+    return _sizeBytes;
+}
+
+}  // namespace mongo
@@ -0,0 +1,114 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#pragma once
+
+#include <boost/optional.hpp>
+#include <map>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "mongo/bson/bsonobj.h"
+#include "mongo/bson/timestamp.h"
+#include "mongo/platform/mutex.h"
+
+namespace mongo {
+
+class ServiceContext;
+
+/**
+ * Cache of recently transformed change stream events, shared by all change streams on this node.
+ * The first change stream to read an oplog entry transforms it into a change event and caches the
+ * event; every other change stream reading the same entry reuses the cached event instead of
+ * transforming the entry again, so that the per-stream cost of an event is mostly its filters.
+ *
+ * Events are keyed by their position in the oplog and by every per-stream input of the
+ * transformation which changes their contents, including the resume token. Since change streams
+ * typically tail the end of the oplog, the cache keeps the latest events and evicts the earliest
+ * once it exceeds its size limit.
+ */
+class ChangeStreamEventCache {
+    ChangeStreamEventCache(const ChangeStreamEventCache&) = delete;
+    ChangeStreamEventCache& operator=(const ChangeStreamEventCache&) = delete;
+
+public:
+    struct Key {
+        // The clusterTime of the oplog entry, or of the transaction the event is part of.
+        Timestamp clusterTime;
+        // The index of the event within its transaction, or 0 outside of transactions.
+        size_t txnOpIndex = 0;
+        // Whether the event carries the pre-image opTime in 'fullDocumentBeforeChange'.
+        bool includePreImageOpTime = false;
+        // The document key fields the stream knows for the collection, which determine the
+        // 'documentKey' of insert events and therefore their resume token.
+        std::vector<std::string> documentKeyFields;
+
+        bool operator<(const Key& other) const {
+            return std::tie(clusterTime, txnOpIndex, includePreImageOpTime, documentKeyFields) <
+                std::tie(other.clusterTime,
+                         other.txnOpIndex,
+                         other.includePreImageOpTime,
+                         other.documentKeyFields);
+        }
+    };
+
+    ChangeStreamEventCache() = default;
+
+    static ChangeStreamEventCache& get(ServiceContext* serviceContext);
+
+    /**
+     * Returns the cached event for 'key', if any.
+     */
+    boost::optional<BSONObj> find(const Key& key) const;
+
+    /**
+     * Caches 'event' under 'key', then evicts the earliest events until the cache fits within
+     * 'maxSizeBytes'. Does nothing if an event is already cached under 'key'.
+     */
+    void insert(const Key& key, BSONObj event, size_t maxSizeBytes);
+
+    /**
+     * Removes every cached event.
+     */
+    void clear();
+
+    size_t numEvents() const;
+
+    size_t sizeBytes() const;
+
+private:
+    mutable Mutex _mutex = MONGO_MAKE_LATCH("ChangeStreamEventCache::_mutex");
+
+    std::map<Key, BSONObj> _events;
+    size_t _sizeBytes = 0;
+};
+
+}  // namespace mongo
@@ -0,0 +1,122 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/db/pipeline/change_stream_event_cache.h"
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+namespace {
+
+using Key = ChangeStreamEventCache::Key;
+
+BSONObj makeEvent(int id) {
+    return BSON("_id" << id);
+}
+
+TEST(ChangeStreamEventCacheTest, FindReturnsInsertedEvent) {
+    ChangeStreamEventCache cache;
+    const Key key{Timestamp(1, 1), 0, false};
+    ASSERT_FALSE(cache.find(key));
+
+    cache.insert(key, makeEvent(1), 1024);
+
+    auto event = cache.find(key);
+    ASSERT_TRUE(event);
+    ASSERT_BSONOBJ_EQ(makeEvent(1), *event);
+    ASSERT_EQ(1U, cache.numEvents());
+    ASSERT_EQ(static_cast<size_t>(makeEvent(1).objsize()), cache.sizeBytes());
+}
+
+TEST(ChangeStreamEventCacheTest, KeyDistinguishesTransactionOpsAndPreImageOption) {
+    ChangeStreamEventCache cache;
+    cache.insert({Timestamp(1, 1), 0, false}, makeEvent(1), 1024);
+    cache.insert({Timestamp(1, 1), 1, false}, makeEvent(2), 1024);
+    cache.insert({Timestamp(1, 1), 0, true}, makeEvent(3), 1024);
+
+    ASSERT_EQ(3U, cache.numEvents());
+    ASSERT_BSONOBJ_EQ(makeEvent(2), *cache.find({Timestamp(1, 1), 1, false}));
+    ASSERT_BSONOBJ_EQ(makeEvent(3), *cache.find({Timestamp(1, 1), 0, true}));
+}
+
+TEST(ChangeStreamEventCacheTest, KeyDistinguishesDocumentKeyFields) {
+    ChangeStreamEventCache cache;
+    cache.insert({Timestamp(1, 1), 0, false, {"_id"}}, makeEvent(1), 1024);
+    cache.insert({Timestamp(1, 1), 0, false, {"shardKey", "_id"}}, makeEvent(2), 1024);
+
+    ASSERT_EQ(2U, cache.numEvents());
+    ASSERT_BSONOBJ_EQ(makeEvent(1), *cache.find({Timestamp(1, 1), 0, false, {"_id"}}));
+    ASSERT_BSONOBJ_EQ(makeEvent(2),
+                      *cache.find({Timestamp(1, 1), 0, false, {"shardKey", "_id"}}));
+    ASSERT_FALSE(cache.find({Timestamp(1, 1), 0, false}));
+}
+
+TEST(ChangeStreamEventCacheTest, InsertKeepsExistingEvent) {
+    ChangeStreamEventCache cache;
+    const Key key{Timestamp(1, 1), 0, false};
+    cache.insert(key, makeEvent(1), 1024);
+    cache.insert(key, makeEvent(2), 1024);
+
+    ASSERT_EQ(1U, cache.numEvents());
+    ASSERT_BSONOBJ_EQ(makeEvent(1), *cache.find(key));
+}
+
+TEST(ChangeStreamEventCacheTest, EvictsEarliestEventsWhenFull) {
+    ChangeStreamEventCache cache;
+    const size_t eventSize = makeEvent(0).objsize();
+    for (int i = 1; i <= 5; ++i) {
+        cache.insert({Timestamp(i, 1), 0, false}, makeEvent(i), 3 * eventSize);
+    }
+
+    ASSERT_EQ(3U, cache.numEvents());
+    ASSERT_EQ(3 * eventSize, cache.sizeBytes());
+    ASSERT_FALSE(cache.find({Timestamp(2, 1), 0, false}));
+    ASSERT_TRUE(cache.find({Timestamp(3, 1), 0, false}));
+    ASSERT_TRUE(cache.find({Timestamp(5, 1), 0, false}));
+
+    // An event earlier than everything cached is evicted straight away.
+    cache.insert({Timestamp(1, 1), 0, false}, makeEvent(1), 3 * eventSize);
+    ASSERT_FALSE(cache.find({Timestamp(1, 1), 0, false}));
+    ASSERT_EQ(3U, cache.numEvents());
+}
+
+TEST(ChangeStreamEventCacheTest, Clear) {
+    ChangeStreamEventCache cache;
+    cache.insert({Timestamp(1, 1), 0, false}, makeEvent(1), 1024);
+    cache.clear();
+
+    ASSERT_EQ(0U, cache.numEvents());
+    ASSERT_EQ(0U, cache.sizeBytes());
+}
+
+}  // namespace
+}  // namespace mongo
@@ -0,0 +1,285 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/pipeline/change_stream_filter_rewrite.h"
+
+#include <pcrecpp.h>
+#include <set>
+
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/db/field_ref.h"
+#include "mongo/db/matcher/expression_leaf.h"
+#include "mongo/db/pipeline/document_source_change_stream.h"
+
+namespace mongo {
+namespace change_stream_filter_rewrite {
+namespace {
+
+using DSCS = DocumentSourceChangeStream;
+
+// The value of the oplog 'op' field for each CRUD operation type. Updates and replacements are
+// both recorded as 'u' entries.
+const std::vector<std::pair<StringData, StringData>> kCrudOpTypes = {
+    {DSCS::kInsertOpType, "i"_sd},
+    {DSCS::kUpdateOpType, "u"_sd},
+    {DSCS::kReplaceOpType, "u"_sd},
+    {DSCS::kDeleteOpType, "d"_sd}};
+
+boost::optional<BSONObj> rewrite(const MatchExpression* expr, const CollatorInterface* collator);
+
+bool isRewritableLeaf(const MatchExpression* expr) {
+    switch (expr->matchType()) {
+        case MatchExpression::EQ:
+        case MatchExpression::LTE:
+        case MatchExpression::LT:
+        case MatchExpression::GT:
+        case MatchExpression::GTE:
+        case MatchExpression::REGEX:
+        case MatchExpression::MOD:
+        case MatchExpression::EXISTS:
+        case MatchExpression::MATCH_IN:
+        case MatchExpression::BITS_ALL_SET:
+        case MatchExpression::BITS_ALL_CLEAR:
+        case MatchExpression::BITS_ANY_SET:
+        case MatchExpression::BITS_ANY_CLEAR:
+        case MatchExpression::TYPE_OPERATOR:
+            return true;
+        default:
+            return false;
+    }
+}
+
+/**
+ * Returns 'leaf' serialized with the prefix 'from' of its path replaced by 'to'.
+ */
+BSONObj renameAndSerialize(const MatchExpression* leaf, StringData from, StringData to) {
+    auto clone = leaf->shallowClone();
+    static_cast<LeafMatchExpression*>(clone.get())->applyRename({{from.toString(), to.toString()}});
+    BSONObjBuilder bob;
+    clone->serialize(&bob);
+    return bob.obj();
+}
+
+BSONObj andOp(StringData op, BSONObj predicate) {
+    return BSON("$and" << BSON_ARRAY(BSON("op" << op) << predicate));
+}
+
+/**
+ * Every CRUD event carries an operationType, so rather than interpreting the predicate we evaluate
+ * it against each CRUD operation type and keep the oplog 'op' values of those which match.
+ */
+BSONObj rewriteOperationType(const MatchExpression* leaf) {
+    std::set<StringData> ops;
+    for (auto&& [opType, op] : kCrudOpTypes) {
+        if (leaf->matchesBSON(BSON(DSCS::kOperationTypeField << opType))) {
+            ops.insert(op);
+        }
+    }
+    BSONArrayBuilder opsArr;
+    for (auto&& op : ops) {
+        opsArr.append(op);
+    }
+    return BSON("op" << BSON("$in" << opsArr.arr()));
+}
+
+/**
+ * The 'ns' of a CRUD event is the oplog 'ns' split into its 'db' and 'coll' components. Equality
+ * on either component, or on the whole namespace document, becomes a match on the oplog 'ns'.
+ */
+boost::optional<BSONObj> rewriteNamespace(const MatchExpression* leaf) {
+    auto path = leaf->path();
+    auto dbPath = DSCS::kNamespaceField + ".db";
+    auto collPath = DSCS::kNamespaceField + ".coll";
+
+    std::vector<BSONElement> values;
+    if (leaf->matchType() == MatchExpression::EQ) {
+        values.push_back(static_cast<const EqualityMatchExpression*>(leaf)->getData());
+    } else if (leaf->matchType() == MatchExpression::MATCH_IN) {
+        auto in = static_cast<const InMatchExpression*>(leaf);
+        if (!in->getRegexes().empty()) {
+            return boost::none;
+        }
+        values = in->getEqualities();
+    } else {
+        return boost::none;
+    }
+
+    BSONArrayBuilder nsArr;
+    for (auto&& value : values) {
+        if (path == DSCS::kNamespaceField) {
+            // The namespace document is always built as {db: <db>, coll: <coll>}.
+            if (value.type() != BSONType::Object) {
+                continue;
+            }
+            auto nsObj = value.embeddedObject();
+            BSONObjIterator it(nsObj);
+            auto db = it.more() ? it.next() : BSONElement();
+            auto coll = it.more() ? it.next() : BSONElement();
+            if (it.more() || db.fieldNameStringData() != "db"_sd || db.type() != String ||
+                coll.fieldNameStringData() != "coll"_sd || coll.type() != String) {
+                continue;
+            }
+            nsArr.append(db.valueStringData() + "." + coll.valueStringData());
+        } else if (value.type() == String) {
+            // Database names never contain a '.', but collection names may.
+            auto quoted = pcrecpp::RE::QuoteMeta(value.valueStringData().toString());
+            nsArr.append(BSONRegEx(path == dbPath ? "^" + quoted + "\\."
+                                                  : "^[^.]+\\." + quoted + "$"));
+        }
+    }
+    return BSON("ns" << BSON("$in" << nsArr.arr()));
+}
+
+/**
+ * The 'fullDocument' of insert and replace events is the oplog 'o' field. Update events only carry
+ * a 'fullDocument' if the post-image is looked up later in the pipeline, so they always pass, and
+ * delete events never have one.
+ */
+BSONObj rewriteFullDocument(const MatchExpression* leaf) {
+    auto predicate = renameAndSerialize(leaf, DSCS::kFullDocumentField, "o"_sd);
+    auto isReplace = BSON("o._id" << BSON("$exists" << true));
+    return BSON("$or" << BSON_ARRAY(
+                    andOp("i"_sd, predicate)
+                    << BSON("$and" << BSON_ARRAY(BSON("op"
+                                                      << "u")
+                                                 << isReplace << predicate))
+                    << BSON("op"
+                            << "u"
+                            << "o._id" << BSON("$exists" << false))));
+}
+
+/**
+ * The 'documentKey' of an insert or delete event is drawn from the oplog 'o' field, and that of an
+ * update or replace event from the 'o2' field. The '_id' is always copied verbatim.
+ */
+BSONObj rewriteDocumentKeyId(const MatchExpression* leaf) {
+    return BSON("$or" << BSON_ARRAY(
+                    BSON("$and" << BSON_ARRAY(
+                             BSON("op" << BSON("$in" << BSON_ARRAY("i"
+                                                                   << "d")))
+                             << renameAndSerialize(leaf, DSCS::kDocumentKeyField, "o"_sd)))
+                    << andOp("u"_sd, renameAndSerialize(leaf, DSCS::kDocumentKeyField, "o2"_sd))));
+}
+
+boost::optional<BSONObj> rewriteLeaf(const MatchExpression* leaf,
+                                     const CollatorInterface* collator) {
+    if (!isRewritableLeaf(leaf)) {
+        return boost::none;
+    }
+
+    const auto path = leaf->path();
+    if (path == DSCS::kOperationTypeField) {
+        // The predicate is evaluated directly, so this is correct under any collation.
+        return rewriteOperationType(leaf);
+    }
+
+    // The oplog is always filtered using the simple collation.
+    if (collator) {
+        return boost::none;
+    }
+
+    if (path == DSCS::kNamespaceField || path == DSCS::kNamespaceField + ".db" ||
+        path == DSCS::kNamespaceField + ".coll") {
+        return rewriteNamespace(leaf);
+    }
+
+    // Events without the field, such as deletes for 'fullDocument', cannot be recognised from the
+    // oplog, so only predicates which reject a missing field may be rewritten.
+    if (leaf->matchesBSON(BSONObj())) {
+        return boost::none;
+    }
+
+    FieldRef fieldRef(path);
+    if (fieldRef.numParts() > 1 && fieldRef.getPart(0) == DSCS::kFullDocumentField) {
+        return rewriteFullDocument(leaf);
+    }
+    if (fieldRef.numParts() > 1 && fieldRef.getPart(0) == DSCS::kDocumentKeyField &&
+        fieldRef.getPart(1) == "_id"_sd) {
+        return rewriteDocumentKeyId(leaf);
+    }
+    return boost::none;
+}
+
+boost::optional<BSONObj> rewrite(const MatchExpression* expr, const CollatorInterface* collator) {
+    switch (expr->matchType()) {
+        case MatchExpression::AND: {
+            // Children which cannot be rewritten are dropped, which only makes the result less
+            // selective.
+            BSONArrayBuilder children;
+            for (size_t i = 0; i < expr->numChildren(); ++i) {
+                if (auto child = rewrite(expr->getChild(i), collator)) {
+                    children.append(*child);
+                }
+            }
+            if (children.arrSize() == 0) {
+                return boost::none;
+            }
+            return BSON("$and" << children.arr());
+        }
+        case MatchExpression::OR: {
+            // Each branch must be rewritten, otherwise the disjunction may match anything.
+            BSONArrayBuilder children;
+            for (size_t i = 0; i < expr->numChildren(); ++i) {
+                auto child = rewrite(expr->getChild(i), collator);
+                if (!child) {
+                    return boost::none;
+                }
+                children.append(*child);
+            }
+            if (children.arrSize() == 0) {
+                return boost::none;
+            }
+            return BSON("$or" << children.arr());
+        }
+        default:
+            // Negations are never rewritten, since the negation of a less selective predicate is
+            // more selective.
+            return rewriteLeaf(expr, collator);
+    }
+}
+
+}  // namespace
+
+boost::optional<BSONObj> rewriteFilterForOplog(const MatchExpression* userFilter,
+                                               const CollatorInterface* collator) {
+    auto rewritten = rewrite(userFilter, collator);
+    if (!rewritten) {
+        return boost::none;
+    }
+    return BSON("$or" << BSON_ARRAY(BSON("op" << BSON("$nin" << BSON_ARRAY("i"
+                                                                          << "u"
+                                                                          << "d")))
+                                    << *rewritten));
+}
+
+}  // namespace change_stream_filter_rewrite
+}  // namespace mongo
@@ -0,0 +1,63 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#pragma once
+
+#include <boost/optional.hpp>
+
+#include "mongo/bson/bsonobj.h"
+
+namespace mongo {
+
+class CollatorInterface;
+class MatchExpression;
+
+namespace change_stream_filter_rewrite {
+
+/**
+ * Attempts to translate 'userFilter', a predicate on the events produced by a $changeStream, into
+ * a predicate on the raw oplog entries from which those events are generated, so that entries
+ * which cannot produce a matching event are discarded before they are transformed.
+ *
+ * The rewritten filter is never more selective than 'userFilter': every oplog entry which could
+ * produce an event matching 'userFilter' also matches the rewritten filter, so it must be applied
+ * in addition to, not instead of, the original predicate. Only CRUD oplog entries are filtered.
+ * Command and no-op entries, which may produce invalidations or be unwound into the events of a
+ * transaction, always pass.
+ *
+ * Predicates on 'operationType', 'ns', 'fullDocument' and 'documentKey._id' are rewritten. Any
+ * other predicate, and any predicate which compares strings under the non-simple 'collator', is
+ * treated as matching everything. Returns boost::none if no part of 'userFilter' can be rewritten.
+ */
+boost::optional<BSONObj> rewriteFilterForOplog(const MatchExpression* userFilter,
+                                               const CollatorInterface* collator);
+
+}  // namespace change_stream_filter_rewrite
+}  // namespace mongo
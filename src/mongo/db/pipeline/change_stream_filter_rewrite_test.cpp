@@ -0,0 +1,213 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/pipeline/change_stream_filter_rewrite.h"
+
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/db/matcher/expression_parser.h"
+#include "mongo/db/pipeline/expression_context_for_test.h"
+#include "mongo/db/query/collation/collator_interface_mock.h"
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+namespace {
+
+class ChangeStreamFilterRewriteTest : public unittest::Test {
+protected:
+    std::unique_ptr<MatchExpression> parse(const BSONObj& filter) {
+        auto expr = MatchExpressionParser::parse(filter, _expCtx);
+        ASSERT_OK(expr.getStatus());
+        return std::move(expr.getValue());
+    }
+
+    /**
+     * Rewrites 'userFilter' and parses the result, which must exist, as a filter on the oplog.
+     */
+    std::unique_ptr<MatchExpression> rewrite(const BSONObj& userFilter) {
+        auto userExpr = parse(userFilter);
+        auto oplogFilter = change_stream_filter_rewrite::rewriteFilterForOplog(
+            userExpr.get(), _expCtx->getCollator());
+        ASSERT_TRUE(oplogFilter) << userFilter;
+
+        // The oplog filter is always evaluated with the simple collation.
+        auto simpleExpCtx = make_intrusive<ExpressionContextForTest>();
+        auto oplogExpr = MatchExpressionParser::parse(*oplogFilter, simpleExpCtx);
+        ASSERT_OK(oplogExpr.getStatus());
+        _oplogExpCtxs.push_back(std::move(simpleExpCtx));
+        return std::move(oplogExpr.getValue());
+    }
+
+    void assertNotRewritten(const BSONObj& userFilter) {
+        auto userExpr = parse(userFilter);
+        ASSERT_FALSE(change_stream_filter_rewrite::rewriteFilterForOplog(userExpr.get(),
+                                                                         _expCtx->getCollator()))
+            << userFilter;
+    }
+
+    static BSONObj insertEntry(BSONObj o, StringData ns = "test.coll"_sd) {
+        return BSON("op"
+                    << "i"
+                    << "ns" << ns << "o" << o);
+    }
+
+    static BSONObj updateEntry(BSONObj o, BSONObj o2) {
+        return BSON("op"
+                    << "u"
+                    << "ns"
+                    << "test.coll"
+                    << "o" << o << "o2" << o2);
+    }
+
+    static BSONObj deleteEntry(BSONObj o) {
+        return BSON("op"
+                    << "d"
+                    << "ns"
+                    << "test.coll"
+                    << "o" << o);
+    }
+
+    static BSONObj commandEntry(BSONObj o) {
+        return BSON("op"
+                    << "c"
+                    << "ns"
+                    << "test.$cmd"
+                    << "o" << o);
+    }
+
+    boost::intrusive_ptr<ExpressionContextForTest> _expCtx =
+        make_intrusive<ExpressionContextForTest>();
+    std::vector<boost::intrusive_ptr<ExpressionContextForTest>> _oplogExpCtxs;
+};
+
+TEST_F(ChangeStreamFilterRewriteTest, OperationTypeFiltersCrudEntries) {
+    auto filter = rewrite(BSON("operationType"
+                               << "insert"));
+    ASSERT_TRUE(filter->matchesBSON(insertEntry(BSON("_id" << 1))));
+    ASSERT_FALSE(filter->matchesBSON(updateEntry(BSON("_id" << 1), BSON("_id" << 1))));
+    ASSERT_FALSE(filter->matchesBSON(deleteEntry(BSON("_id" << 1))));
+
+    // Commands may produce invalidations or transaction events, so they always pass.
+    ASSERT_TRUE(filter->matchesBSON(commandEntry(BSON("drop"
+                                                      << "coll"))));
+    ASSERT_TRUE(filter->matchesBSON(commandEntry(BSON("applyOps" << BSONArray()))));
+}
+
+TEST_F(ChangeStreamFilterRewriteTest, OperationTypeMapsUpdateAndReplaceToTheSameOplogType) {
+    auto filter = rewrite(BSON("operationType" << BSON("$in" << BSON_ARRAY("replace"
+                                                                           << "delete"))));
+    ASSERT_FALSE(filter->matchesBSON(insertEntry(BSON("_id" << 1))));
+    ASSERT_TRUE(filter->matchesBSON(updateEntry(BSON("$set" << BSON("a" << 1)), BSON("_id" << 1))));
+    ASSERT_TRUE(filter->matchesBSON(deleteEntry(BSON("_id" << 1))));
+}
+
+TEST_F(ChangeStreamFilterRewriteTest, FullDocumentPredicateAppliesToInsertsAndReplacements) {
+    auto filter = rewrite(BSON("fullDocument.a" << BSON("$gt" << 5)));
+    ASSERT_TRUE(filter->matchesBSON(insertEntry(BSON("_id" << 1 << "a" << 6))));
+    ASSERT_FALSE(filter->matchesBSON(insertEntry(BSON("_id" << 1 << "a" << 4))));
+    ASSERT_TRUE(filter->matchesBSON(updateEntry(BSON("_id" << 1 << "a" << 6), BSON("_id" << 1))));
+    ASSERT_FALSE(filter->matchesBSON(updateEntry(BSON("_id" << 1 << "a" << 4), BSON("_id" << 1))));
+
+    // The post-image of an update may be looked up later, and a delete never has one.
+    ASSERT_TRUE(filter->matchesBSON(updateEntry(BSON("$set" << BSON("a" << 4)), BSON("_id" << 1))));
+    ASSERT_FALSE(filter->matchesBSON(deleteEntry(BSON("_id" << 1))));
+}
+
+TEST_F(ChangeStreamFilterRewriteTest, DocumentKeyIdPredicateUsesTheEntryDocumentKey) {
+    auto filter = rewrite(BSON("documentKey._id" << 1));
+    ASSERT_TRUE(filter->matchesBSON(insertEntry(BSON("_id" << 1))));
+    ASSERT_FALSE(filter->matchesBSON(insertEntry(BSON("_id" << 2))));
+    ASSERT_TRUE(filter->matchesBSON(deleteEntry(BSON("_id" << 1))));
+    ASSERT_FALSE(filter->matchesBSON(deleteEntry(BSON("_id" << 2))));
+    ASSERT_TRUE(
+        filter->matchesBSON(updateEntry(BSON("$set" << BSON("_id" << 2)), BSON("_id" << 1))));
+    ASSERT_FALSE(filter->matchesBSON(updateEntry(BSON("_id" << 1), BSON("_id" << 2))));
+}
+
+TEST_F(ChangeStreamFilterRewriteTest, NamespacePredicatesMatchTheOplogNamespace) {
+    auto byDb = rewrite(BSON("ns.db"
+                             << "test"));
+    ASSERT_TRUE(byDb->matchesBSON(insertEntry(BSON("_id" << 1), "test.coll"_sd)));
+    ASSERT_FALSE(byDb->matchesBSON(insertEntry(BSON("_id" << 1), "test2.coll"_sd)));
+
+    auto byColl = rewrite(BSON("ns.coll" << BSON("$in" << BSON_ARRAY("a.b"
+                                                                     << "c"))));
+    ASSERT_TRUE(byColl->matchesBSON(insertEntry(BSON("_id" << 1), "test.a.b"_sd)));
+    ASSERT_TRUE(byColl->matchesBSON(insertEntry(BSON("_id" << 1), "test.c"_sd)));
+    ASSERT_FALSE(byColl->matchesBSON(insertEntry(BSON("_id" << 1), "test.axb"_sd)));
+    ASSERT_FALSE(byColl->matchesBSON(insertEntry(BSON("_id" << 1), "test.cc"_sd)));
+
+    auto byNs = rewrite(BSON("ns" << BSON("db"
+                                          << "test"
+                                          << "coll"
+                                          << "c")));
+    ASSERT_TRUE(byNs->matchesBSON(insertEntry(BSON("_id" << 1), "test.c"_sd)));
+    ASSERT_FALSE(byNs->matchesBSON(insertEntry(BSON("_id" << 1), "test.d"_sd)));
+}
+
+TEST_F(ChangeStreamFilterRewriteTest, AndDropsChildrenWhichCannotBeRewritten) {
+    auto filter = rewrite(BSON("operationType"
+                               << "insert"
+                               << "updateDescription.updatedFields.a" << 1));
+    ASSERT_TRUE(filter->matchesBSON(insertEntry(BSON("_id" << 1))));
+    ASSERT_FALSE(filter->matchesBSON(deleteEntry(BSON("_id" << 1))));
+}
+
+TEST_F(ChangeStreamFilterRewriteTest, UnrewritablePredicatesAreNotPushedDown) {
+    assertNotRewritten(BSON("updateDescription.updatedFields.a" << 1));
+    assertNotRewritten(BSON("$or" << BSON_ARRAY(BSON("operationType"
+                                                     << "insert")
+                                                << BSON("clusterTime" << Timestamp(1, 1)))));
+    assertNotRewritten(BSON("operationType" << BSON("$ne"
+                                                    << "insert")));
+
+    // Predicates which match a missing field would also match deletes, which have no fullDocument.
+    assertNotRewritten(BSON("fullDocument.a" << BSONNULL));
+    assertNotRewritten(BSON("fullDocument.a" << BSON("$exists" << false)));
+}
+
+TEST_F(ChangeStreamFilterRewriteTest, NonSimpleCollationOnlyRewritesOperationType) {
+    _expCtx->setCollator(
+        std::make_unique<CollatorInterfaceMock>(CollatorInterfaceMock::MockType::kToLowerString));
+    assertNotRewritten(BSON("fullDocument.a"
+                            << "x"));
+    assertNotRewritten(BSON("ns.db"
+                            << "TEST"));
+
+    // The operationType predicate is evaluated using the collation of the user's filter.
+    auto filter = rewrite(BSON("operationType"
+                               << "INSERT"));
+    ASSERT_TRUE(filter->matchesBSON(insertEntry(BSON("_id" << 1))));
+    ASSERT_FALSE(filter->matchesBSON(deleteEntry(BSON("_id" << 1))));
+}
+
+}  // namespace
+}  // namespace mongo
@@ -0,0 +1,266 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/pipeline/compiled_expression.h"
+
+#include <algorithm>
+
+#include "mongo/util/assert_util.h"
+
+namespace mongo {
+
+size_t CompiledExpression::add(const Expression* expr) {
+    invariant(expr);
+    _entryPoints.push_back(_program.size());
+    _compile(expr);
+    _componentValues.resize(_components.size());
+    _componentCrossesArray.resize(_components.size(), false);
+    _componentGeneration.resize(_components.size(), 0);
+    return _entryPoints.size() - 1;
+}
+
+void CompiledExpression::_compile(const Expression* expr) {
+    Instruction instr;
+    instr.expr = expr;
+
+    std::vector<const Expression*> children;
+    auto compileAllChildren = [&]() {
+        for (auto&& child : expr->getChildren()) {
+            children.push_back(child.get());
+        }
+    };
+
+    if (dynamic_cast<const ExpressionConstant*>(expr)) {
+        instr.op = OpCode::kConstant;
+    } else if (auto fieldPath = dynamic_cast<const ExpressionFieldPath*>(expr)) {
+        if (!fieldPath->isRootFieldPath()) {
+            instr.op = OpCode::kTreeWalk;
+        } else if (fieldPath->getFieldPath().getPathLength() == 1) {
+            instr.op = OpCode::kRoot;
+        } else {
+            instr.op = OpCode::kPath;
+            instr.componentIndex = _addPath(fieldPath->getFieldPath());
+        }
+    } else if (auto object = dynamic_cast<const ExpressionObject*>(expr)) {
+        instr.op = OpCode::kObject;
+        for (auto&& field : object->getChildExpressions()) {
+            instr.fieldNames.push_back(field.first);
+            children.push_back(field.second.get());
+        }
+    } else if (dynamic_cast<const ExpressionArray*>(expr)) {
+        instr.op = OpCode::kArray;
+        compileAllChildren();
+    } else if (dynamic_cast<const ExpressionAnd*>(expr)) {
+        instr.op = OpCode::kAnd;
+        compileAllChildren();
+    } else if (dynamic_cast<const ExpressionOr*>(expr)) {
+        instr.op = OpCode::kOr;
+        compileAllChildren();
+    } else if (dynamic_cast<const ExpressionNot*>(expr)) {
+        instr.op = OpCode::kNot;
+        compileAllChildren();
+    } else if (dynamic_cast<const ExpressionCompare*>(expr)) {
+        instr.op = OpCode::kCompare;
+        compileAllChildren();
+    } else if (dynamic_cast<const ExpressionCond*>(expr)) {
+        const auto& operands = expr->getChildren();
+        if (auto condition = dynamic_cast<const ExpressionConstant*>(operands[0].get())) {
+            _compile(operands[condition->getValue().coerceToBool() ? 1 : 2].get());
+            return;
+        }
+        instr.op = OpCode::kCond;
+        compileAllChildren();
+    } else if (dynamic_cast<const ExpressionIfNull*>(expr)) {
+        const auto& operands = expr->getChildren();
+        if (auto first = dynamic_cast<const ExpressionConstant*>(operands[0].get())) {
+            _compile(operands[first->getValue().nullish() ? 1 : 0].get());
+            return;
+        }
+        instr.op = OpCode::kIfNull;
+        compileAllChildren();
+    } else {
+        instr.op = OpCode::kTreeWalk;
+    }
+
+    // The node is appended before its children, which are compiled into the instructions that
+    // follow it.
+    const size_t pc = _program.size();
+    _program.push_back(std::move(instr));
+    for (auto&& child : children) {
+        _compile(child);
+    }
+    _program[pc].end = _program.size();
+}
+
+size_t CompiledExpression::_addPath(const FieldPath& path) {
+    // The first component of the path is the variable, so the fields start at the second.
+    size_t parent = PathComponent::kNoParent;
+    for (size_t i = 1; i < path.getPathLength(); ++i) {
+        const auto fieldName = path.getFieldName(i);
+        auto it = std::find_if(_components.begin(), _components.end(), [&](const auto& component) {
+            return component.parent == parent && component.fieldName == fieldName;
+        });
+        if (it == _components.end()) {
+            _components.push_back({parent, fieldName.toString()});
+            it = std::prev(_components.end());
+        }
+        parent = std::distance(_components.begin(), it);
+    }
+    return parent;
+}
+
+void CompiledExpression::start(const Document& root) const {
+    _root = root;
+    ++_generation;
+}
+
+Value CompiledExpression::evaluate(size_t index, Variables* variables) const {
+    invariant(index < _entryPoints.size());
+    invariant(_generation > 0);
+    return _evaluate(_entryPoints[index], variables);
+}
+
+const Value& CompiledExpression::_resolve(size_t index) const {
+    if (_componentGeneration[index] == _generation) {
+        return _componentValues[index];
+    }
+
+    const auto& component = _components[index];
+    Value value;
+    bool crossesArray = false;
+    if (component.parent == PathComponent::kNoParent) {
+        value = _root[component.fieldName];
+    } else {
+        const Value& parentValue = _resolve(component.parent);
+        if (_componentCrossesArray[component.parent] || parentValue.isArray()) {
+            crossesArray = true;
+        } else if (parentValue.getType() == BSONType::Object) {
+            value = parentValue.getDocument()[component.fieldName];
+        }
+    }
+
+    _componentValues[index] = std::move(value);
+    _componentCrossesArray[index] = crossesArray;
+    _componentGeneration[index] = _generation;
+    return _componentValues[index];
+}
+
+Value CompiledExpression::_evaluate(size_t pc, Variables* variables) const {
+    const auto& instr = _program[pc];
+    switch (instr.op) {
+        case OpCode::kConstant:
+            return static_cast<const ExpressionConstant*>(instr.expr)->getValue();
+        case OpCode::kRoot:
+            return Value(_root);
+        case OpCode::kPath: {
+            const Value& value = _resolve(instr.componentIndex);
+            if (_componentCrossesArray[instr.componentIndex]) {
+                // Field paths through arrays collect the values from each element.
+                return instr.expr->evaluate(_root, variables);
+            }
+            return value;
+        }
+        case OpCode::kObject: {
+            MutableDocument output(instr.fieldNames.size());
+            size_t child = pc + 1;
+            for (auto&& fieldName : instr.fieldNames) {
+                output.addField(fieldName, _evaluate(child, variables));
+                child = _program[child].end;
+            }
+            return output.freezeToValue();
+        }
+        case OpCode::kArray: {
+            std::vector<Value> values;
+            for (size_t child = pc + 1; child < instr.end; child = _program[child].end) {
+                Value value = _evaluate(child, variables);
+                values.push_back(value.missing() ? Value(BSONNULL) : std::move(value));
+            }
+            return Value(std::move(values));
+        }
+        case OpCode::kAnd:
+            for (size_t child = pc + 1; child < instr.end; child = _program[child].end) {
+                if (!_evaluate(child, variables).coerceToBool()) {
+                    return Value(false);
+                }
+            }
+            return Value(true);
+        case OpCode::kOr:
+            for (size_t child = pc + 1; child < instr.end; child = _program[child].end) {
+                if (_evaluate(child, variables).coerceToBool()) {
+                    return Value(true);
+                }
+            }
+            return Value(false);
+        case OpCode::kNot:
+            return Value(!_evaluate(pc + 1, variables).coerceToBool());
+        case OpCode::kCond: {
+            const size_t thenPc = _program[pc + 1].end;
+            const size_t elsePc = _program[thenPc].end;
+            return _evaluate(_evaluate(pc + 1, variables).coerceToBool() ? thenPc : elsePc,
+                             variables);
+        }
+        case OpCode::kIfNull: {
+            Value value = _evaluate(pc + 1, variables);
+            if (!value.nullish()) {
+                return value;
+            }
+            return _evaluate(_program[pc + 1].end, variables);
+        }
+        case OpCode::kCompare: {
+            const Value lhs = _evaluate(pc + 1, variables);
+            const Value rhs = _evaluate(_program[pc + 1].end, variables);
+            const int cmp =
+                instr.expr->getExpressionContext()->getValueComparator().compare(lhs, rhs);
+            switch (static_cast<const ExpressionCompare*>(instr.expr)->getOp()) {
+                case ExpressionCompare::EQ:
+                    return Value(cmp == 0);
+                case ExpressionCompare::NE:
+                    return Value(cmp != 0);
+                case ExpressionCompare::GT:
+                    return Value(cmp > 0);
+                case ExpressionCompare::GTE:
+                    return Value(cmp >= 0);
+                case ExpressionCompare::LT:
+                    return Value(cmp < 0);
+                case ExpressionCompare::LTE:
+                    return Value(cmp <= 0);
+                case ExpressionCompare::CMP:
+                    return Value(cmp < 0 ? -1 : (cmp > 0 ? 1 : 0));
+            }
+            MONGO_UNREACHABLE;
+        }
+        case OpCode::kTreeWalk:
+            return instr.expr->evaluate(_root, variables);
+    }
+    MONGO_UNREACHABLE;
+}
+
+}  // namespace mongo
@@ -0,0 +1,164 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "mongo/db/exec/document_value/document.h"
+#include "mongo/db/exec/document_value/value.h"
+#include "mongo/db/pipeline/expression.h"
+#include "mongo/db/pipeline/variables.h"
+
+namespace mongo {
+
+/**
+ * One or more Expression trees lowered into a flat program for repeated evaluation against the
+ * documents of a stream, such as the computed fields of a $project or the _id and accumulator
+ * arguments of a $group.
+ *
+ * Evaluating the trees directly makes a virtual call for every node, and every field path walks
+ * its components from the root of the document, even when another field path in the same
+ * expression or a sibling expression has just walked the same prefix. The compiled program stores
+ * the nodes of all the trees in pre-order in a single vector, and the field paths rooted at $$ROOT
+ * or $$CURRENT in a table of path components shared by all of them, so that each distinct prefix
+ * is looked up at most once per document. A $cond or $ifNull whose deciding operand is a constant
+ * is folded to the branch that is taken.
+ *
+ * Constants, field paths, object and array literals, $and, $or, $not, $cond, $ifNull and the
+ * comparison operators are evaluated by the program. A field path which crosses an array, and any
+ * other node, is evaluated by calling Expression::evaluate() on it, so the results are always
+ * identical to evaluating the trees directly.
+ *
+ * The expressions must outlive the compiled program. Evaluation is not thread-safe, since it reuses
+ * scratch space held by the program.
+ */
+class CompiledExpression {
+public:
+    /**
+     * Compiles 'expr', which is expected to have been optimized, and returns the index to pass to
+     * evaluate() for it.
+     */
+    size_t add(const Expression* expr);
+
+    /**
+     * Prepares to evaluate the expressions against 'root'. Must be called for each new document
+     * before calling evaluate(), since path components resolved for the previous document are
+     * reused until then.
+     */
+    void start(const Document& root) const;
+
+    /**
+     * Evaluates the expression at 'index' against the document passed to the last call to
+     * start(). Equivalent to calling evaluate() on the expression with the same document.
+     */
+    Value evaluate(size_t index, Variables* variables) const;
+
+    /**
+     * Returns the number of distinct path components the program resolves for each document.
+     */
+    size_t numPathComponents() const {
+        return _components.size();
+    }
+
+private:
+    enum class OpCode {
+        kConstant,
+        kRoot,
+        kPath,
+        kObject,
+        kArray,
+        kAnd,
+        kOr,
+        kNot,
+        kCond,
+        kIfNull,
+        kCompare,
+        // A node evaluated by calling Expression::evaluate().
+        kTreeWalk,
+    };
+
+    struct Instruction {
+        OpCode op;
+
+        // The index one past the last instruction of this node's subtree.
+        size_t end = 0;
+
+        const Expression* expr = nullptr;
+
+        // For kPath, the index in '_components' of the last component of the path.
+        size_t componentIndex = 0;
+
+        // For kObject, the names of the fields produced by the children, in order.
+        std::vector<std::string> fieldNames;
+    };
+
+    struct PathComponent {
+        static constexpr size_t kNoParent = static_cast<size_t>(-1);
+
+        // The index of the previous component of the path in '_components', or kNoParent if this
+        // is a top-level field.
+        size_t parent;
+        std::string fieldName;
+    };
+
+    void _compile(const Expression* expr);
+    size_t _addPath(const FieldPath& path);
+
+    /**
+     * Evaluates the subtree rooted at '_program[pc]'.
+     */
+    Value _evaluate(size_t pc, Variables* variables) const;
+
+    /**
+     * Resolves the component at 'index' for the current document, assuming every earlier
+     * component of its path is an object. Sets '_componentCrossesArray' if one of them is an
+     * array instead, in which case the value is not meaningful.
+     */
+    const Value& _resolve(size_t index) const;
+
+    std::vector<Instruction> _program;
+
+    // The index in '_program' of the first instruction of each expression passed to add().
+    std::vector<size_t> _entryPoints;
+
+    std::vector<PathComponent> _components;
+
+    // Scratch space for evaluating against a single document. A component's entries in
+    // '_componentValues' and '_componentCrossesArray' are valid for the current document if its
+    // entry in '_componentGeneration' is equal to '_generation'.
+    mutable Document _root;
+    mutable std::vector<Value> _componentValues;
+    mutable std::vector<char> _componentCrossesArray;
+    mutable std::vector<uint64_t> _componentGeneration;
+    mutable uint64_t _generation = 0;
+};
+
+}  // namespace mongo
@@ -0,0 +1,184 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/pipeline/compiled_expression.h"
+
+#include "mongo/db/exec/document_value/document_value_test_util.h"
+#include "mongo/db/json.h"
+#include "mongo/db/pipeline/expression_context_for_test.h"
+#include "mongo/db/query/collation/collator_interface_mock.h"
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+namespace {
+
+boost::intrusive_ptr<Expression> parse(const boost::intrusive_ptr<ExpressionContext>& expCtx,
+                                       const std::string& json) {
+    auto spec = fromjson("{expr: " + json + "}");
+    return Expression::parseOperand(expCtx, spec.firstElement(), expCtx->variablesParseState)
+        ->optimize();
+}
+
+/**
+ * Checks that every expression gives the same result when compiled together as when evaluated
+ * directly, against each of the documents.
+ */
+void assertSameResults(const boost::intrusive_ptr<ExpressionContext>& expCtx,
+                       const std::vector<std::string>& expressions,
+                       const std::vector<std::string>& documents) {
+    std::vector<boost::intrusive_ptr<Expression>> parsed;
+    CompiledExpression compiled;
+    for (auto&& json : expressions) {
+        parsed.push_back(parse(expCtx, json));
+        ASSERT_EQ(parsed.size() - 1, compiled.add(parsed.back().get()));
+    }
+
+    for (auto&& json : documents) {
+        Document root(fromjson(json));
+        compiled.start(root);
+        for (size_t i = 0; i < parsed.size(); ++i) {
+            Value expected = parsed[i]->evaluate(root, &expCtx->variables);
+            Value actual = compiled.evaluate(i, &expCtx->variables);
+            ASSERT_EQ(expected.getType(), actual.getType())
+                << expressions[i] << " on " << json << ": expected " << expected.toString()
+                << ", got " << actual.toString();
+            ASSERT_VALUE_EQ(expected, actual);
+        }
+    }
+}
+
+const std::vector<std::string> kDocuments = {
+    "{}",
+    "{a: 1, b: 2}",
+    "{a: {b: 1, c: 'x'}, b: null}",
+    "{a: {b: {c: 3}}, b: [1, 2]}",
+    "{a: [{b: 1}, {b: [2, 3]}, 4, {c: 5}], b: {c: [{d: 1}]}}",
+    "{a: {b: [{c: 1}, {c: [2]}, [{c: 3}]]}, c: false}",
+    "{a: 'string', b: {c: {d: null}}, c: true}",
+    "{a: {b: 0, c: ''}, b: {c: 1}, c: 0}",
+};
+
+TEST(CompiledExpressionTest, MatchesTreeWalkForFieldPaths) {
+    auto expCtx = make_intrusive<ExpressionContextForTest>();
+    assertSameResults(
+        expCtx,
+        {"'$a'", "'$a.b'", "'$a.b.c'", "'$a.c'", "'$b.c'", "'$b.c.d'", "'$$ROOT'", "'$$CURRENT.a'",
+         "'$$ROOT.a.b'", "'$nonexistent.field'"},
+        kDocuments);
+}
+
+TEST(CompiledExpressionTest, MatchesTreeWalkForCompiledOperators) {
+    auto expCtx = make_intrusive<ExpressionContextForTest>();
+    assertSameResults(expCtx,
+                      {"{x: '$a.b', y: {z: '$a.c', w: 1}, v: '$missing'}",
+                       "['$a.b', '$missing', 1, '$b']",
+                       "{$and: ['$a.b', '$c']}",
+                       "{$or: ['$a.b', '$c']}",
+                       "{$not: ['$a.b']}",
+                       "{$cond: ['$c', '$a.b', '$a.c']}",
+                       "{$ifNull: ['$a.b', '$b']}",
+                       "{$eq: ['$a.b', 1]}",
+                       "{$ne: ['$a.b', '$b.c']}",
+                       "{$gt: ['$a.b', 0]}",
+                       "{$gte: ['$a.b', 1]}",
+                       "{$lt: ['$a.c', 'y']}",
+                       "{$lte: ['$b', null]}",
+                       "{$cmp: ['$a.b', '$b.c']}"},
+                      kDocuments);
+}
+
+TEST(CompiledExpressionTest, MatchesTreeWalkForOtherExpressions) {
+    auto expCtx = make_intrusive<ExpressionContextForTest>();
+    assertSameResults(expCtx,
+                      {"{$type: '$a.b'}",
+                       "{$isArray: ['$a.b']}",
+                       "{$let: {vars: {v: '$a'}, in: {$ifNull: ['$$v.b', '$$v']}}}",
+                       "{$map: {input: {$cond: [{$isArray: ['$b']}, '$b', []]}, in: "
+                       "{$cmp: ['$$this', '$a.b']}}}",
+                       "{$cond: [{$eq: [{$type: '$a'}, 'object']}, {$objectToArray: '$a'}, null]}",
+                       "{$concat: [{$toString: '$c'}, '-', {$type: '$b.c'}]}"},
+                      kDocuments);
+}
+
+TEST(CompiledExpressionTest, ResolvesSharedPrefixesOnce) {
+    auto expCtx = make_intrusive<ExpressionContextForTest>();
+    auto first = parse(expCtx, "{x: '$a.b.c', y: '$a.b.d'}");
+    auto second = parse(expCtx, "{$cond: ['$a.e', '$a.b', '$f']}");
+
+    CompiledExpression compiled;
+    compiled.add(first.get());
+    compiled.add(second.get());
+
+    // The components are a, a.b, a.b.c, a.b.d, a.e and f.
+    ASSERT_EQ(6U, compiled.numPathComponents());
+}
+
+TEST(CompiledExpressionTest, FoldsBranchesWithConstantConditions) {
+    auto expCtx = make_intrusive<ExpressionContextForTest>();
+    auto cond = parse(expCtx, "{$cond: [{$literal: true}, '$a', '$b']}");
+    auto ifNull = parse(expCtx, "{$ifNull: [null, '$c']}");
+
+    CompiledExpression compiled;
+    compiled.add(cond.get());
+    compiled.add(ifNull.get());
+
+    // Only the branches that can be taken are compiled.
+    ASSERT_EQ(2U, compiled.numPathComponents());
+
+    compiled.start(Document{{"a", 1}, {"b", 2}, {"c", 3}});
+    ASSERT_VALUE_EQ(Value(1), compiled.evaluate(0, &expCtx->variables));
+    ASSERT_VALUE_EQ(Value(3), compiled.evaluate(1, &expCtx->variables));
+}
+
+TEST(CompiledExpressionTest, ForgetsResolvedPathsOnNewDocument) {
+    auto expCtx = make_intrusive<ExpressionContextForTest>();
+    auto expr = parse(expCtx, "'$a.b'");
+
+    CompiledExpression compiled;
+    compiled.add(expr.get());
+
+    compiled.start(Document{{"a", Document{{"b", 1}}}});
+    ASSERT_VALUE_EQ(Value(1), compiled.evaluate(0, &expCtx->variables));
+    compiled.start(Document{{"a", Document{{"b", 2}}}});
+    ASSERT_VALUE_EQ(Value(2), compiled.evaluate(0, &expCtx->variables));
+}
+
+TEST(CompiledExpressionTest, ComparesWithCollation) {
+    auto expCtx = make_intrusive<ExpressionContextForTest>();
+    expCtx->setCollator(
+        std::make_unique<CollatorInterfaceMock>(CollatorInterfaceMock::MockType::kAlwaysEqual));
+    assertSameResults(expCtx,
+                      {"{$eq: ['$a.c', 'abc']}", "{$cmp: ['$a.c', '$b']}"},
+                      {"{a: {c: 'x'}, b: 'y'}", "{a: {c: 1}, b: 'y'}"});
+}
+
+}  // namespace
+}  // namespace mongo
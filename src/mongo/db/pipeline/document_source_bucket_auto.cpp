@@ -31,8 +31,11 @@
 
 #include "mongo/db/pipeline/document_source_bucket_auto.h"
 
+#include <boost/filesystem/operations.hpp>
+
 #include "mongo/db/pipeline/accumulation_statement.h"
 #include "mongo/db/pipeline/lite_parsed_document_source.h"
+#include "mongo/util/destructor_guard.h"
 
 namespace mongo {
 
@@ -83,19 +86,31 @@ std::string nextFileName() {
 
 }  // namespace
 
+DocumentSourceBucketAuto::~DocumentSourceBucketAuto() {
+    // Close any spilled runs before removing the file they read from.
+    _approximateInputRuns.clear();
+    if (!_spillFileName.empty()) {
+        DESTRUCTOR_GUARD(boost::filesystem::remove(_spillFileName));
+    }
+}
+
 const char* DocumentSourceBucketAuto::getSourceName() const {
     return kStageName.rawData();
 }
 
 DocumentSource::GetNextResult DocumentSourceBucketAuto::doGetNext() {
     if (!_populated) {
-        const auto populationResult = populateSorter();
+        const auto populationResult = _approximate ? populateSketch() : populateSorter();
         if (populationResult.isPaused()) {
             return populationResult;
         }
         invariant(populationResult.isEOF());
 
-        populateBuckets();
+        if (_approximate) {
+            populateBucketsFromSketch();
+        } else {
+            populateBuckets();
+        }
 
         _populated = true;
         _bucketsIterator = _buckets.begin();
@@ -153,15 +168,77 @@ DocumentSource::GetNextResult DocumentSourceBucketAuto::populateSorter() {
         _sorter.reset(Sorter<Value, Document>::make(opts, comparator));
     }
 
+    auto next = pSource->getNext();
+    for (; next.isAdvanced(); next = pSource->getNext()) {
+        // The sorter retains the input until all of it has been read, so it is copied out of the
+        // arena of the batch it was produced in, if any.
+        auto nextDoc = next.releaseDocument().copyOutOfArena();
+        _sorter->add(extractKey(nextDoc).copyOutOfArena(), nextDoc);
+        _nDocuments++;
+    }
+    return next;
+}
+
+DocumentSource::GetNextResult DocumentSourceBucketAuto::populateSketch() {
+    if (!_sketch) {
+        // Use a larger sketch than the default when asked for many buckets, so that the rank error
+        // stays small relative to the size of a bucket.
+        const long long k = std::min<long long>(
+            QuantileSketch::kMaxK, std::max<long long>(QuantileSketch::kDefaultK, 4LL * _nBuckets));
+        _sketch.emplace(pExpCtx->getValueComparator(), static_cast<int>(k));
+    }
+
     auto next = pSource->getNext();
     for (; next.isAdvanced(); next = pSource->getNext()) {
         auto nextDoc = next.releaseDocument();
-        _sorter->add(extractKey(nextDoc), nextDoc);
+        // The key and the arguments are retained until all of the input has been read, so they are
+        // copied out of the arena of the batch they were produced in, if any.
+        Value key = extractKey(nextDoc).copyOutOfArena();
+
+        // The arguments are evaluated now, so that only they need to be buffered.
+        MutableDocument arguments(_accumulatedFields.size());
+        for (size_t k = 0; k < _accumulatedFields.size(); ++k) {
+            arguments.addField(
+                std::to_string(k),
+                _accumulatedFields[k].expr.argument->evaluate(nextDoc, &pExpCtx->variables));
+        }
+
+        _sketch->add(key);
+        _approximateInput.emplace_back(std::move(key), arguments.freeze().copyOutOfArena());
+        _approximateInputBytes += _approximateInput.back().first.getApproximateSize() +
+            _approximateInput.back().second.getApproximateSize();
         _nDocuments++;
+
+        if (_approximateInputBytes + _sketch->getApproximateSize() > _maxMemoryUsageBytes) {
+            uassert(ErrorCodes::QueryExceededMemoryLimitNoDiskUseAllowed,
+                    str::stream() << "$bucketAuto exceeded memory limit of " << _maxMemoryUsageBytes
+                                  << " bytes, but did not opt in to external sorting. Aborting "
+                                     "operation. Pass allowDiskUse:true to opt in.",
+                    pExpCtx->allowDiskUse && !pExpCtx->inMongos);
+            spillApproximateInput();
+        }
     }
     return next;
 }
 
+void DocumentSourceBucketAuto::spillApproximateInput() {
+    if (_spillFileName.empty()) {
+        _spillFileName = pExpCtx->tempDir + "/" + nextFileName();
+    }
+
+    // Runs are only ever read back in full, so their contents need not be sorted.
+    SortedFileWriter<Value, Document> writer(
+        SortOptions().TempDir(pExpCtx->tempDir), _spillFileName, _nextSpillFileOffset);
+    for (auto&& entry : _approximateInput) {
+        writer.addAlreadySorted(entry.first, entry.second);
+    }
+    _approximateInputRuns.emplace_back(writer.done());
+    _nextSpillFileOffset = writer.getFileEndOffset();
+
+    _approximateInput.clear();
+    _approximateInputBytes = 0;
+}
+
 Value DocumentSourceBucketAuto::extractKey(const Document& doc) {
     if (!_groupByExpression) {
         return Value(BSONNULL);
@@ -245,17 +322,7 @@ void DocumentSourceBucketAuto::populateBuckets() {
         }
 
         // Initialize the current bucket.
-        Bucket currentBucket(pExpCtx, currentValue.first, currentValue.first, _accumulatedFields);
-
-        // Evaluate each initializer against an empty document. Normally the
-        // initializer can refer to the group key, but in $bucketAuto there is no single
-        // group key per bucket.
-        Document emptyDoc;
-        for (size_t k = 0; k < _accumulatedFields.size(); ++k) {
-            Value initializerValue =
-                _accumulatedFields[k].expr.initializer->evaluate(emptyDoc, &pExpCtx->variables);
-            currentBucket._accums[k]->startNewGroup(initializerValue);
-        }
+        Bucket currentBucket = makeBucket(currentValue.first, currentValue.first);
 
         // Add the first value into the current bucket.
         addDocumentToBucket(currentValue, currentBucket);
@@ -326,6 +393,83 @@ void DocumentSourceBucketAuto::populateBuckets() {
     }
 }
 
+void DocumentSourceBucketAuto::populateBucketsFromSketch() {
+    if (_nDocuments == 0) {
+        return;
+    }
+
+    // Find the minimum, the estimated first value of each bucket after the first one, and the
+    // maximum. As in the exact algorithm, bucket 'i' should start with the document at position
+    // floor(i * n / numBuckets) in sorted order. There can be no more buckets than documents.
+    const long long numBuckets = std::min<long long>(_nBuckets, _nDocuments);
+    std::vector<double> ranks;
+    ranks.reserve(numBuckets + 1);
+    ranks.push_back(0);
+    for (long long i = 1; i < numBuckets; ++i) {
+        const double position = std::floor(double(i) * _nDocuments / numBuckets);
+        ranks.push_back(std::min(1.0, (position + 1) / _nDocuments));
+    }
+    ranks.push_back(1);
+    const auto quantiles = _sketch->quantiles(ranks);
+    _sketch.reset();
+
+    // Each bucket starts at one of the quantiles, which are values of the input, so no bucket is
+    // empty. Like equal values in the exact algorithm, equal quantiles are never split between
+    // buckets, so there may be fewer buckets than requested.
+    const auto& valueCmp = pExpCtx->getValueComparator();
+    std::vector<Value> bucketMins;
+    for (size_t i = 0; i + 1 < quantiles.size(); ++i) {
+        if (bucketMins.empty() || valueCmp.evaluate(quantiles[i] > bucketMins.back())) {
+            bucketMins.push_back(quantiles[i]);
+        }
+    }
+    for (size_t i = 0; i < bucketMins.size(); ++i) {
+        _buckets.push_back(makeBucket(bucketMins[i],
+                                      i + 1 < bucketMins.size() ? bucketMins[i + 1]
+                                                                : quantiles.back()));
+    }
+
+    auto addToBucket = [&](const Value& key, const Document& arguments) {
+        auto it =
+            std::upper_bound(bucketMins.begin(), bucketMins.end(), key, valueCmp.getLessThan());
+        invariant(it != bucketMins.begin());
+        auto& bucket = _buckets[std::distance(bucketMins.begin(), it) - 1];
+        for (size_t k = 0; k < _accumulatedFields.size(); ++k) {
+            bucket._accums[k]->process(arguments[std::to_string(k)], false);
+        }
+    };
+
+    for (auto&& run : _approximateInputRuns) {
+        run->openSource();
+        while (run->more()) {
+            auto entry = run->next();
+            addToBucket(entry.first, entry.second);
+        }
+        run->closeSource();
+    }
+    _approximateInputRuns.clear();
+
+    for (auto&& entry : _approximateInput) {
+        addToBucket(entry.first, entry.second);
+    }
+    _approximateInput.clear();
+    _approximateInputBytes = 0;
+}
+
+DocumentSourceBucketAuto::Bucket DocumentSourceBucketAuto::makeBucket(Value min, Value max) {
+    Bucket bucket(pExpCtx, std::move(min), std::move(max), _accumulatedFields);
+
+    // Evaluate each initializer against an empty document. Normally the initializer can refer to
+    // the group key, but in $bucketAuto there is no single group key per bucket.
+    Document emptyDoc;
+    for (size_t k = 0; k < _accumulatedFields.size(); ++k) {
+        Value initializerValue =
+            _accumulatedFields[k].expr.initializer->evaluate(emptyDoc, &pExpCtx->variables);
+        bucket._accums[k]->startNewGroup(initializerValue);
+    }
+    return bucket;
+}
+
 DocumentSourceBucketAuto::Bucket::Bucket(
     const boost::intrusive_ptr<ExpressionContext>& expCtx,
     Value min,
@@ -389,6 +533,9 @@ Document DocumentSourceBucketAuto::makeDocument(const Bucket& bucket) {
 
 void DocumentSourceBucketAuto::doDispose() {
     _sortedInput.reset();
+    _sketch.reset();
+    _approximateInput.clear();
+    _approximateInputRuns.clear();
     _bucketsIterator = _buckets.end();
 }
 
@@ -403,6 +550,10 @@ Value DocumentSourceBucketAuto::serialize(
         insides["granularity"] = Value(_granularityRounder->getName());
     }
 
+    if (_approximate) {
+        insides["approximate"] = Value(true);
+    }
+
     MutableDocument outputSpec(_accumulatedFields.size());
     for (auto&& accumulatedField : _accumulatedFields) {
         intrusive_ptr<AccumulatorState> accum = accumulatedField.makeAccumulator();
@@ -422,7 +573,8 @@ intrusive_ptr<DocumentSourceBucketAuto> DocumentSourceBucketAuto::create(
     int numBuckets,
     std::vector<AccumulationStatement> accumulationStatements,
     const boost::intrusive_ptr<GranularityRounder>& granularityRounder,
-    uint64_t maxMemoryUsageBytes) {
+    uint64_t maxMemoryUsageBytes,
+    bool approximate) {
     uassert(40243,
             str::stream() << "The $bucketAuto 'buckets' field must be greater than 0, but found: "
                           << numBuckets,
@@ -440,7 +592,8 @@ intrusive_ptr<DocumentSourceBucketAuto> DocumentSourceBucketAuto::create(
                                         numBuckets,
                                         accumulationStatements,
                                         granularityRounder,
-                                        maxMemoryUsageBytes);
+                                        maxMemoryUsageBytes,
+                                        approximate);
 }
 
 DocumentSourceBucketAuto::DocumentSourceBucketAuto(
@@ -449,12 +602,14 @@ DocumentSourceBucketAuto::DocumentSourceBucketAuto(
     int numBuckets,
     std::vector<AccumulationStatement> accumulationStatements,
     const boost::intrusive_ptr<GranularityRounder>& granularityRounder,
-    uint64_t maxMemoryUsageBytes)
+    uint64_t maxMemoryUsageBytes,
+    bool approximate)
     : DocumentSource(kStageName, pExpCtx),
       _nBuckets(numBuckets),
       _maxMemoryUsageBytes(maxMemoryUsageBytes),
       _groupByExpression(groupByExpression),
-      _granularityRounder(granularityRounder) {
+      _granularityRounder(granularityRounder),
+      _approximate(approximate) {
 
     invariant(!accumulationStatements.empty());
     for (auto&& accumulationStatement : accumulationStatements) {
@@ -482,6 +637,7 @@ intrusive_ptr<DocumentSource> DocumentSourceBucketAuto::createFromBson(
     boost::intrusive_ptr<Expression> groupByExpression;
     boost::optional<int> numBuckets;
     boost::intrusive_ptr<GranularityRounder> granularityRounder;
+    bool approximate = false;
 
     for (auto&& argument : elem.Obj()) {
         const auto argName = argument.fieldNameStringData();
@@ -527,6 +683,13 @@ intrusive_ptr<DocumentSource> DocumentSourceBucketAuto::createFromBson(
                         << typeName(argument.type()),
                     argument.type() == BSONType::String);
             granularityRounder = GranularityRounder::getGranularityRounder(pExpCtx, argument.str());
+        } else if ("approximate" == argName) {
+            uassert(5380612,
+                    str::stream()
+                        << "The $bucketAuto 'approximate' field must be a boolean, but found type: "
+                        << typeName(argument.type()),
+                    argument.type() == BSONType::Bool);
+            approximate = argument.boolean();
         } else {
             uasserted(40245, str::stream() << "Unrecognized option to $bucketAuto: " << argName);
         }
@@ -536,8 +699,17 @@ intrusive_ptr<DocumentSource> DocumentSourceBucketAuto::createFromBson(
             "$bucketAuto requires 'groupBy' and 'buckets' to be specified",
             groupByExpression && numBuckets);
 
-    return DocumentSourceBucketAuto::create(
-        pExpCtx, groupByExpression, numBuckets.get(), accumulationStatements, granularityRounder);
+    uassert(5380613,
+            "$bucketAuto cannot specify both 'granularity' and 'approximate: true'",
+            !(granularityRounder && approximate));
+
+    return DocumentSourceBucketAuto::create(pExpCtx,
+                                            groupByExpression,
+                                            numBuckets.get(),
+                                            accumulationStatements,
+                                            granularityRounder,
+                                            kDefaultMaxMemoryUsageBytes,
+                                            approximate);
 }
 
 }  // namespace mongo
@@ -34,6 +34,7 @@
 #include "mongo/db/pipeline/document_source.h"
 #include "mongo/db/pipeline/expression.h"
 #include "mongo/db/pipeline/granularity_rounder.h"
+#include "mongo/db/pipeline/quantile_sketch.h"
 #include "mongo/db/sorter/sorter.h"
 
 namespace mongo {
@@ -41,10 +42,17 @@ namespace mongo {
 /**
  * The $bucketAuto stage takes a user-specified number of buckets and automatically determines
  * boundaries such that the values are approximately equally distributed between those buckets.
+ *
+ * By default the boundaries are found by sorting all of the input. With 'approximate: true', they
+ * are instead estimated from a QuantileSketch built in the same pass that buffers the input, and
+ * the buffered input is then placed into buckets without being sorted.
  */
 class DocumentSourceBucketAuto final : public DocumentSource {
 public:
     static constexpr StringData kStageName = "$bucketAuto"_sd;
+
+    ~DocumentSourceBucketAuto();
+
     Value serialize(boost::optional<ExplainOptions::Verbosity> explain = boost::none) const final;
     DepsTracker::State getDependencies(DepsTracker* deps) const final;
 
@@ -84,7 +92,8 @@ public:
         int numBuckets,
         std::vector<AccumulationStatement> accumulationStatements = {},
         const boost::intrusive_ptr<GranularityRounder>& granularityRounder = nullptr,
-        uint64_t maxMemoryUsageBytes = kDefaultMaxMemoryUsageBytes);
+        uint64_t maxMemoryUsageBytes = kDefaultMaxMemoryUsageBytes,
+        bool approximate = false);
 
     /**
      * Parses a $bucketAuto stage from the user-supplied BSON.
@@ -105,7 +114,8 @@ private:
                              int numBuckets,
                              std::vector<AccumulationStatement> accumulationStatements,
                              const boost::intrusive_ptr<GranularityRounder>& granularityRounder,
-                             uint64_t maxMemoryUsageBytes);
+                             uint64_t maxMemoryUsageBytes,
+                             bool approximate);
 
     // struct for holding information about a bucket.
     struct Bucket {
@@ -126,6 +136,19 @@ private:
      */
     GetNextResult populateSorter();
 
+    /**
+     * The alternative to populateSorter() in approximate mode. Consumes all of the documents from
+     * the source, adding their 'groupBy' values to '_sketch' and buffering them, unsorted, along
+     * with the values of the accumulators' arguments. Like populateSorter(), this may return
+     * kPauseExecution before the input is exhausted.
+     */
+    GetNextResult populateSketch();
+
+    /**
+     * Writes the buffered input of approximate mode to a new run in the spill file.
+     */
+    void spillApproximateInput();
+
     /**
      * Computes the 'groupBy' expression value for 'doc'.
      */
@@ -136,6 +159,18 @@ private:
      */
     void populateBuckets();
 
+    /**
+     * The alternative to populateBuckets() in approximate mode. Chooses the bucket boundaries from
+     * quantiles of '_sketch', and then adds each buffered input to the bucket containing its
+     * 'groupBy' value.
+     */
+    void populateBucketsFromSketch();
+
+    /**
+     * Creates a bucket with the given boundaries and initializes its accumulators.
+     */
+    Bucket makeBucket(Value min, Value max);
+
     /**
      * Adds the document in 'entry' to 'bucket' by updating the accumulators in 'bucket'.
      */
@@ -165,6 +200,16 @@ private:
     boost::intrusive_ptr<Expression> _groupByExpression;
     boost::intrusive_ptr<GranularityRounder> _granularityRounder;
     long long _nDocuments = 0;
+
+    // The following are only used in approximate mode. Each buffered input is its 'groupBy' value
+    // paired with a document holding its accumulators' arguments, keyed by accumulator position.
+    const bool _approximate;
+    boost::optional<QuantileSketch> _sketch;
+    std::vector<std::pair<Value, Document>> _approximateInput;
+    size_t _approximateInputBytes = 0;
+    std::vector<std::unique_ptr<Sorter<Value, Document>::Iterator>> _approximateInputRuns;
+    std::string _spillFileName;
+    std::streampos _nextSpillFileOffset = 0;
 };
 
 }  // namespace mongo
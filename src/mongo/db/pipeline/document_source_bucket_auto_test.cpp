@@ -810,5 +810,156 @@ TEST_F(BucketAutoTests, ShouldFailOnNegativeNumbersWhenGranularitySpecified) {
         AssertionException,
         40260);
 }
+
+TEST_F(BucketAutoTests, ApproximateModeMatchesExactModeWhenInputFitsInSketch) {
+    deque<Document> inputs;
+    for (int i = 7; i >= 0; --i) {
+        inputs.push_back(Document{{"x", i}});
+    }
+
+    auto exactResults =
+        getResults(fromjson("{$bucketAuto : {groupBy : '$x', buckets : 4}}"), inputs);
+    auto approximateResults = getResults(
+        fromjson("{$bucketAuto : {groupBy : '$x', buckets : 4, approximate : true}}"), inputs);
+
+    ASSERT_EQUALS(approximateResults.size(), 4UL);
+    ASSERT_DOCUMENT_EQ(approximateResults[0],
+                       Document(fromjson("{_id : {min : 0, max : 2}, count : 2}")));
+    ASSERT_DOCUMENT_EQ(approximateResults[3],
+                       Document(fromjson("{_id : {min : 6, max : 7}, count : 2}")));
+    ASSERT_EQUALS(exactResults.size(), approximateResults.size());
+    for (size_t i = 0; i < exactResults.size(); ++i) {
+        ASSERT_DOCUMENT_EQ(exactResults[i], approximateResults[i]);
+    }
+}
+
+TEST_F(BucketAutoTests, ApproximateModeReturnsContiguousBucketsOfSimilarSize) {
+    const int numDocuments = 20011;
+    const int numBuckets = 10;
+    deque<Document> inputs;
+    for (int i = 0; i < numDocuments; ++i) {
+        inputs.push_back(Document{{"x", (i * 7919) % numDocuments}});
+    }
+
+    auto results = getResults(
+        fromjson("{$bucketAuto : {groupBy : '$x', buckets : 10, approximate : true, "
+                 "output : {count : {$sum : 1}, largest : {$max : '$x'}}}}"),
+        inputs);
+
+    ASSERT_EQUALS(results.size(), size_t(numBuckets));
+    ASSERT_VALUE_EQ(results.front()["_id"]["min"], Value(0));
+    ASSERT_VALUE_EQ(results.back()["_id"]["max"], Value(numDocuments - 1));
+    int totalCount = 0;
+    for (size_t i = 0; i < results.size(); ++i) {
+        if (i > 0) {
+            ASSERT_VALUE_EQ(results[i]["_id"]["min"], results[i - 1]["_id"]["max"]);
+        }
+        if (i + 1 < results.size()) {
+            ASSERT_VALUE_LT(results[i]["largest"], results[i]["_id"]["max"]);
+        } else {
+            ASSERT_VALUE_EQ(results[i]["largest"], results[i]["_id"]["max"]);
+        }
+
+        // The sketch bounds the rank error of each boundary to a few percent of the input.
+        const int count = results[i]["count"].getInt();
+        ASSERT_LT(std::abs(count - numDocuments / numBuckets), numDocuments * 6 / 100);
+        totalCount += count;
+    }
+    ASSERT_EQUALS(totalCount, numDocuments);
+}
+
+TEST_F(BucketAutoTests, ApproximateModeSpillsBufferedInputToDisk) {
+    auto expCtx = getExpCtx();
+    unittest::TempDir tempDir("DocumentSourceBucketAutoTest");
+    expCtx->tempDir = tempDir.path();
+    expCtx->allowDiskUse = true;
+    const size_t maxMemoryUsageBytes = 1000;
+
+    VariablesParseState vps = expCtx->variablesParseState;
+    auto groupByExpression = ExpressionFieldPath::parse(expCtx, "$a", vps);
+    std::vector<AccumulationStatement> accumulationStatements;
+    accumulationStatements.push_back(AccumulationStatement::parseAccumulationStatement(
+        expCtx, fromjson("{largeStr : {$max : '$largeStr'}}").firstElement(), vps));
+
+    const int numBuckets = 2;
+    auto bucketAutoStage = DocumentSourceBucketAuto::create(expCtx,
+                                                            groupByExpression,
+                                                            numBuckets,
+                                                            std::move(accumulationStatements),
+                                                            nullptr,
+                                                            maxMemoryUsageBytes,
+                                                            true);
+
+    string largeStr(maxMemoryUsageBytes, 'x');
+    auto mock = DocumentSourceMock::createForTest({Document{{"a", 3}, {"largeStr", largeStr}},
+                                                   Document{{"a", 1}, {"largeStr", largeStr}},
+                                                   Document{{"a", 2}, {"largeStr", largeStr}},
+                                                   Document{{"a", 0}, {"largeStr", largeStr}}});
+    bucketAutoStage->setSource(mock.get());
+
+    auto next = bucketAutoStage->getNext();
+    ASSERT_TRUE(next.isAdvanced());
+    ASSERT_DOCUMENT_EQ(
+        next.releaseDocument(),
+        (Document{{"_id", Document{{"min", 0}, {"max", 2}}}, {"largeStr", largeStr}}));
+
+    next = bucketAutoStage->getNext();
+    ASSERT_TRUE(next.isAdvanced());
+    ASSERT_DOCUMENT_EQ(
+        next.releaseDocument(),
+        (Document{{"_id", Document{{"min", 2}, {"max", 3}}}, {"largeStr", largeStr}}));
+
+    ASSERT_TRUE(bucketAutoStage->getNext().isEOF());
+}
+
+TEST_F(BucketAutoTests, ApproximateModeFailsWhenOverMemoryLimitWithoutDiskUse) {
+    auto expCtx = getExpCtx();
+    expCtx->allowDiskUse = false;
+    const size_t maxMemoryUsageBytes = 1000;
+
+    VariablesParseState vps = expCtx->variablesParseState;
+    auto groupByExpression = ExpressionFieldPath::parse(expCtx, "$a", vps);
+    std::vector<AccumulationStatement> accumulationStatements;
+    accumulationStatements.push_back(AccumulationStatement::parseAccumulationStatement(
+        expCtx, fromjson("{largeStr : {$max : '$largeStr'}}").firstElement(), vps));
+
+    const int numBuckets = 2;
+    auto bucketAutoStage = DocumentSourceBucketAuto::create(expCtx,
+                                                            groupByExpression,
+                                                            numBuckets,
+                                                            std::move(accumulationStatements),
+                                                            nullptr,
+                                                            maxMemoryUsageBytes,
+                                                            true);
+
+    string largeStr(maxMemoryUsageBytes, 'x');
+    auto mock = DocumentSourceMock::createForTest(
+        {Document{{"a", 0}, {"largeStr", largeStr}}, Document{{"a", 1}, {"largeStr", largeStr}}});
+    bucketAutoStage->setSource(mock.get());
+
+    ASSERT_THROWS_CODE(bucketAutoStage->getNext(),
+                       AssertionException,
+                       ErrorCodes::QueryExceededMemoryLimitNoDiskUseAllowed);
+}
+
+TEST_F(BucketAutoTests, SerializesApproximateFieldIfSpecified) {
+    testSerialize(fromjson("{$bucketAuto : {groupBy : '$x', buckets : 2, approximate : true}}"),
+                  fromjson("{groupBy : '$x', buckets : 2, approximate : true, output : {count : "
+                           "{$sum : {$const : 1}}}}"));
+    testSerialize(fromjson("{$bucketAuto : {groupBy : '$x', buckets : 2, approximate : false}}"),
+                  fromjson("{groupBy : '$x', buckets : 2, output : {count : {$sum : {$const : "
+                           "1}}}}"));
+}
+
+TEST_F(BucketAutoTests, FailsWithInvalidApproximateField) {
+    ASSERT_THROWS_CODE(createBucketAuto(fromjson(
+                           "{$bucketAuto : {groupBy : '$x', buckets : 2, approximate : 1}}")),
+                       AssertionException,
+                       5380612);
+    ASSERT_THROWS_CODE(createBucketAuto(fromjson("{$bucketAuto : {groupBy : '$x', buckets : 2, "
+                                                 "granularity : 'R5', approximate : true}}")),
+                       AssertionException,
+                       5380613);
+}
 }  // namespace
 }  // namespace mongo
@@ -36,6 +36,7 @@
 #include "mongo/db/commands/feature_compatibility_version_documentation.h"
 #include "mongo/db/logical_clock.h"
 #include "mongo/db/pipeline/change_stream_constants.h"
+#include "mongo/db/pipeline/change_stream_filter_rewrite.h"
 #include "mongo/db/pipeline/document_path_support.h"
 #include "mongo/db/pipeline/document_source_change_stream_close_cursor.h"
 #include "mongo/db/pipeline/document_source_change_stream_transform.h"
@@ -104,8 +105,8 @@ static constexpr StringData kOplogMatchExplainName = "$_internalOplogMatch"_sd;
 }  // namespace
 
 intrusive_ptr<DocumentSourceOplogMatch> DocumentSourceOplogMatch::create(
-    BSONObj filter, const intrusive_ptr<ExpressionContext>& expCtx) {
-    return new DocumentSourceOplogMatch(std::move(filter), expCtx);
+    BSONObj filter, const intrusive_ptr<ExpressionContext>& expCtx, Timestamp startFromInclusive) {
+    return new DocumentSourceOplogMatch(std::move(filter), expCtx, startFromInclusive);
 }
 
 const char* DocumentSourceOplogMatch::getSourceName() const {
@@ -140,6 +141,25 @@ Value DocumentSourceOplogMatch::serialize(optional<ExplainOptions::Verbosity> ex
     return Value();
 }
 
+void DocumentSourceOplogMatch::pushDownUserFilter(const MatchExpression* userFilter) {
+    if (_pushedDownUserFilter) {
+        return;
+    }
+    _pushedDownUserFilter = true;
+
+    auto oplogFilter =
+        change_stream_filter_rewrite::rewriteFilterForOplog(userFilter, pExpCtx->getCollator());
+    if (!oplogFilter) {
+        return;
+    }
+
+    // The entries at the start timestamp must always pass, so that the resume stages can verify
+    // that the resume token is still present in the oplog even if its event is filtered out.
+    rebuild(BSON("$and" << BSON_ARRAY(
+                     _predicate << BSON("$or" << BSON_ARRAY(BSON("ts" << _startFromInclusive)
+                                                            << *oplogFilter)))));
+}
+
 void DocumentSourceChangeStream::checkValueType(const Value v,
                                                 const StringData filedName,
                                                 BSONType expectedType) {
@@ -423,7 +443,8 @@ list<intrusive_ptr<DocumentSource>> buildPipeline(const intrusive_ptr<Expression
     // upon the fact that it is always the first stage in the pipeline.
     stages.push_back(DocumentSourceOplogMatch::create(
         DocumentSourceChangeStream::buildMatchFilter(expCtx, *startFrom, showMigrationEvents),
-        expCtx));
+        expCtx,
+        *startFrom));
 
     // If we haven't already populated the initial PBRT, then we are starting from a specific
     // timestamp rather than a resume token. Initialize the PBRT to a high water mark token.
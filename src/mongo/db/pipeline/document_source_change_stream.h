@@ -217,14 +217,19 @@ private:
  */
 class DocumentSourceOplogMatch final : public DocumentSourceMatch {
 public:
-    DocumentSourceOplogMatch(const DocumentSourceOplogMatch& other) : DocumentSourceMatch(other) {}
+    DocumentSourceOplogMatch(const DocumentSourceOplogMatch& other)
+        : DocumentSourceMatch(other),
+          _startFromInclusive(other._startFromInclusive),
+          _pushedDownUserFilter(other._pushedDownUserFilter) {}
 
     virtual boost::intrusive_ptr<DocumentSourceMatch> clone() const {
         return make_intrusive<std::decay_t<decltype(*this)>>(*this);
     }
 
     static boost::intrusive_ptr<DocumentSourceOplogMatch> create(
-        BSONObj filter, const boost::intrusive_ptr<ExpressionContext>& expCtx);
+        BSONObj filter,
+        const boost::intrusive_ptr<ExpressionContext>& expCtx,
+        Timestamp startFromInclusive);
 
     const char* getSourceName() const final;
 
@@ -240,8 +245,26 @@ public:
 
     Value serialize(boost::optional<ExplainOptions::Verbosity> explain) const final;
 
+    /**
+     * Adds to this stage's filter whatever part of 'userFilter', a $match on the change events
+     * produced by the stream, can be safely evaluated against the raw oplog entries. This allows
+     * CRUD entries which cannot produce a matching event to be discarded before they are
+     * transformed. Only the first filter offered to this stage is pushed down.
+     */
+    void pushDownUserFilter(const MatchExpression* userFilter);
+
 private:
-    using DocumentSourceMatch::DocumentSourceMatch;
+    DocumentSourceOplogMatch(BSONObj filter,
+                             const boost::intrusive_ptr<ExpressionContext>& expCtx,
+                             Timestamp startFromInclusive)
+        : DocumentSourceMatch(std::move(filter), expCtx),
+          _startFromInclusive(startFromInclusive) {}
+
+    // The earliest timestamp this stream may return, which is the timestamp of the resume token if
+    // the stream is resumed.
+    Timestamp _startFromInclusive;
+
+    bool _pushedDownUserFilter = false;
 };
 
 }  // namespace mongo
@@ -42,6 +42,7 @@
 #include "mongo/db/exec/document_value/value.h"
 #include "mongo/db/exec/document_value/value_comparator.h"
 #include "mongo/db/pipeline/aggregation_context_fixture.h"
+#include "mongo/db/pipeline/change_stream_event_cache.h"
 #include "mongo/db/pipeline/document_source.h"
 #include "mongo/db/pipeline/document_source_change_stream.h"
 #include "mongo/db/pipeline/document_source_change_stream_transform.h"
@@ -51,6 +52,7 @@
 #include "mongo/db/pipeline/document_source_mock.h"
 #include "mongo/db/pipeline/document_source_sort.h"
 #include "mongo/db/pipeline/process_interface/stub_mongo_process_interface.h"
+#include "mongo/db/query/query_knobs_gen.h"
 #include "mongo/db/repl/oplog_entry.h"
 #include "mongo/db/repl/replication_coordinator_mock.h"
 #include "mongo/db/transaction_history_iterator.h"
@@ -82,7 +84,19 @@ class ChangeStreamStageTestNoSetup : public AggregationContextFixture {
 public:
     ChangeStreamStageTestNoSetup() : ChangeStreamStageTestNoSetup(nss) {}
     explicit ChangeStreamStageTestNoSetup(NamespaceString nsString)
-        : AggregationContextFixture(nsString) {}
+        : AggregationContextFixture(nsString) {
+        // Tests reuse the same oplog timestamps for different oplog entries, which the shared event
+        // cache would take for the same event. Tests of the cache enable it explicitly.
+        internalChangeStreamSharedEventCacheSizeBytes.store(0);
+    }
+
+    ~ChangeStreamStageTestNoSetup() {
+        internalChangeStreamSharedEventCacheSizeBytes.store(_originalEventCacheSizeBytes);
+    }
+
+private:
+    const long long _originalEventCacheSizeBytes =
+        internalChangeStreamSharedEventCacheSizeBytes.load();
 };
 
 struct MockMongoInterface final : public StubMongoProcessInterface {
@@ -571,6 +585,33 @@ TEST_F(ChangeStreamStageTest, TransformInsertDocKeyXAndId) {
     checkTransformation(insert2, expectedInsert, {{"x"}, {"_id"}});
 }
 
+TEST_F(ChangeStreamStageTest, TransformReusesEventCachedByAnotherChangeStream) {
+    internalChangeStreamSharedEventCacheSizeBytes.store(1024 * 1024);
+    auto insert = makeOplogEntry(OpTypeEnum::kInsert,           // op type
+                                 nss,                           // namespace
+                                 BSON("_id" << 1 << "x" << 2),  // o
+                                 testUuid(),                    // uuid
+                                 boost::none,                   // fromMigrate
+                                 boost::none);                  // o2
+
+    Document expectedInsert{
+        {DSChangeStream::kIdField,
+         makeResumeToken(kDefaultTs, testUuid(), BSON("x" << 2 << "_id" << 1))},
+        {DSChangeStream::kOperationTypeField, DSChangeStream::kInsertOpType},
+        {DSChangeStream::kClusterTimeField, kDefaultTs},
+        {DSChangeStream::kFullDocumentField, D{{"_id", 1}, {"x", 2}}},
+        {DSChangeStream::kNamespaceField, D{{"db", nss.db()}, {"coll", nss.coll()}}},
+        {DSChangeStream::kDocumentKeyField, D{{"x", 2}, {"_id", 1}}},
+    };
+    checkTransformation(insert, expectedInsert, {{"x"}, {"_id"}});
+
+    // A second change stream reading the same oplog entry returns the event transformed by the
+    // first one, rather than one built from its own (here deliberately different) document key.
+    checkTransformation(insert, expectedInsert, {{"_id"}});
+    ASSERT_EQ(
+        1U, ChangeStreamEventCache::get(getExpCtx()->opCtx->getServiceContext()).numEvents());
+}
+
 TEST_F(ChangeStreamStageTest, TransformInsertDocKeyIdAndX) {
     auto insert = makeOplogEntry(OpTypeEnum::kInsert,           // op type
                                  nss,                           // namespace
@@ -897,6 +938,33 @@ TEST_F(ChangeStreamStageTest, MatchFiltersDropDatabaseCommand) {
     checkTransformation(dropDB, boost::none);
 }
 
+TEST_F(ChangeStreamStageTest, UserMatchIsPushedDownIntoOplogMatch) {
+    auto stages = DSChangeStream::createFromBson(kDefaultSpec.firstElement(), getExpCtx());
+    stages.push_back(DocumentSourceMatch::create(BSON(DSChangeStream::kOperationTypeField
+                                                      << DSChangeStream::kInsertOpType),
+                                                 getExpCtx()));
+    auto transformItr = std::next(stages.begin());
+    (*transformItr)->optimizeAt(transformItr, &stages);
+
+    auto oplogMatch = dynamic_cast<DocumentSourceOplogMatch*>(stages.front().get());
+    ASSERT(oplogMatch);
+    auto insert = makeOplogEntry(OpTypeEnum::kInsert, nss, BSON("_id" << 1));
+    auto update = makeOplogEntry(OpTypeEnum::kUpdate,
+                                 nss,
+                                 BSON("$set" << BSON("x" << 1)),
+                                 testUuid(),
+                                 boost::none,  // fromMigrate
+                                 BSON("_id" << 1));
+    auto drop = createCommand(BSON("drop" << nss.coll()), testUuid());
+    ASSERT_TRUE(oplogMatch->getMatchExpression()->matchesBSON(insert.toBSON()));
+    ASSERT_FALSE(oplogMatch->getMatchExpression()->matchesBSON(update.toBSON()));
+    ASSERT_TRUE(oplogMatch->getMatchExpression()->matchesBSON(drop.toBSON()));
+
+    // The user's $match is still applied to the transformed events.
+    ASSERT_EQ(stages.size(), 5U);
+    ASSERT(dynamic_cast<DocumentSourceMatch*>(stages.back().get()));
+}
+
 TEST_F(ChangeStreamStageTest, TransformNewShardDetected) {
     auto o2Field = D{{"type", "migrateChunkToNewShard"_sd}};
     auto newShardDetected = makeOplogEntry(OpTypeEnum::kNoop,
@@ -39,6 +39,7 @@
 #include "mongo/db/commands/feature_compatibility_version_documentation.h"
 #include "mongo/db/logical_clock.h"
 #include "mongo/db/pipeline/change_stream_constants.h"
+#include "mongo/db/pipeline/change_stream_event_cache.h"
 #include "mongo/db/pipeline/document_path_support.h"
 #include "mongo/db/pipeline/document_source.h"
 #include "mongo/db/pipeline/document_source_change_stream.h"
@@ -49,6 +50,7 @@
 #include "mongo/db/pipeline/expression.h"
 #include "mongo/db/pipeline/lite_parsed_document_source.h"
 #include "mongo/db/pipeline/resume_token.h"
+#include "mongo/db/query/query_knobs_gen.h"
 #include "mongo/db/repl/bson_extract_optime.h"
 #include "mongo/db/repl/oplog_entry.h"
 #include "mongo/db/repl/oplog_entry_gen.h"
@@ -163,7 +165,46 @@ ResumeTokenData DocumentSourceChangeStreamTransform::getResumeToken(Value ts,
     return resumeTokenData;
 }
 
+std::vector<FieldPath> DocumentSourceChangeStreamTransform::getDocumentKeyFields(
+    const Document& input) {
+    checkValueType(input[repl::OplogEntry::kOpTypeFieldName],
+                   repl::OplogEntry::kOpTypeFieldName,
+                   BSONType::String);
+    auto opType = repl::OpType_parse(IDLParserErrorContext("ChangeStreamEntry.op"),
+                                     input[repl::OplogEntry::kOpTypeFieldName].getString());
+    Value ns = input[repl::OplogEntry::kNssFieldName];
+    checkValueType(ns, repl::OplogEntry::kNssFieldName, BSONType::String);
+    Value uuid = input[repl::OplogEntry::kUuidFieldName];
+
+    // Ignore commands in the oplog when looking up the document key fields since a command implies
+    // that the change stream is about to be invalidated (e.g. collection drop).
+    if (uuid.missing() || opType == repl::OpTypeEnum::kCommand) {
+        return {};
+    }
+
+    checkValueType(uuid, repl::OplogEntry::kUuidFieldName, BSONType::BinData);
+    // We need to retrieve the document key fields if our cache does not have an entry for this
+    // UUID or if the cache entry is not definitively final, indicating that the collection was
+    // unsharded when the entry was last populated.
+    auto it = _documentKeyCache.find(uuid.getUuid());
+    if (it == _documentKeyCache.end() || !it->second.isFinal) {
+        auto docKeyFields =
+            pExpCtx->mongoProcessInterface->collectDocumentKeyFieldsForHostedCollection(
+                pExpCtx->opCtx, NamespaceString(ns.getString()), uuid.getUuid());
+        if (it == _documentKeyCache.end() || docKeyFields.second) {
+            _documentKeyCache[uuid.getUuid()] = DocumentKeyCacheEntry(docKeyFields);
+        }
+    }
+
+    return _documentKeyCache.find(uuid.getUuid())->second.documentKeyFields;
+}
+
 Document DocumentSourceChangeStreamTransform::applyTransformation(const Document& input) {
+    return applyTransformation(input, getDocumentKeyFields(input));
+}
+
+Document DocumentSourceChangeStreamTransform::applyTransformation(
+    const Document& input, const std::vector<FieldPath>& documentKeyFields) {
     // If we're executing a change stream pipeline that was forwarded from mongos, then we expect it
     // to "need merge"---we expect to be executing the shards part of a split pipeline. It is never
     // correct for mongos to pass through the change stream without splitting into into a merging
@@ -192,31 +233,11 @@ Document DocumentSourceChangeStreamTransform::applyTransformation(const Document
     checkValueType(ns, repl::OplogEntry::kNssFieldName, BSONType::String);
     Value uuid = input[repl::OplogEntry::kUuidFieldName];
     Value preImageOpTime = input[repl::OplogEntry::kPreImageOpTimeFieldName];
-    std::vector<FieldPath> documentKeyFields;
 
     // Deal with CRUD operations and commands.
     auto opType = repl::OpType_parse(IDLParserErrorContext("ChangeStreamEntry.op"), op);
 
     NamespaceString nss(ns.getString());
-    // Ignore commands in the oplog when looking up the document key fields since a command implies
-    // that the change stream is about to be invalidated (e.g. collection drop).
-    if (!uuid.missing() && opType != repl::OpTypeEnum::kCommand) {
-        checkValueType(uuid, repl::OplogEntry::kUuidFieldName, BSONType::BinData);
-        // We need to retrieve the document key fields if our cache does not have an entry for this
-        // UUID or if the cache entry is not definitively final, indicating that the collection was
-        // unsharded when the entry was last populated.
-        auto it = _documentKeyCache.find(uuid.getUuid());
-        if (it == _documentKeyCache.end() || !it->second.isFinal) {
-            auto docKeyFields =
-                pExpCtx->mongoProcessInterface->collectDocumentKeyFieldsForHostedCollection(
-                    pExpCtx->opCtx, nss, uuid.getUuid());
-            if (it == _documentKeyCache.end() || docKeyFields.second) {
-                _documentKeyCache[uuid.getUuid()] = DocumentKeyCacheEntry(docKeyFields);
-            }
-        }
-
-        documentKeyFields = _documentKeyCache.find(uuid.getUuid())->second.documentKeyFields;
-    }
     Value id = input.getNestedField("o._id");
     // Non-replace updates have the _id in field "o2".
     StringData operationType;
@@ -361,6 +382,42 @@ Document DocumentSourceChangeStreamTransform::applyTransformation(const Document
     return doc.freeze();
 }
 
+Document DocumentSourceChangeStreamTransform::transformOrReuseCachedEvent(const Document& input,
+                                                                         Timestamp clusterTime,
+                                                                         size_t txnOpIndex) {
+    const long long maxCacheSizeBytes = internalChangeStreamSharedEventCacheSizeBytes.load();
+    if (maxCacheSizeBytes == 0) {
+        return applyTransformation(input);
+    }
+
+    // Streams which know different document key fields for the collection, such as before and
+    // after it becomes sharded, produce different documentKeys and resume tokens for its inserts.
+    const auto documentKeyFields = getDocumentKeyFields(input);
+    ChangeStreamEventCache::Key key{clusterTime, txnOpIndex, _includePreImageOptime};
+    key.documentKeyFields.reserve(documentKeyFields.size());
+    for (const auto& field : documentKeyFields) {
+        key.documentKeyFields.push_back(field.fullPath());
+    }
+
+    auto& cache = ChangeStreamEventCache::get(pExpCtx->opCtx->getServiceContext());
+    if (auto cachedEvent = cache.find(key)) {
+        // The cached event does not carry metadata, so restore the sort key which
+        // applyTransformation() sets to the resume token.
+        MutableDocument doc{Document(*cachedEvent)};
+        const bool isSingleElementKey = true;
+        doc.metadata().setSortKey(doc.peek()[DocumentSourceChangeStream::kIdField],
+                                  isSingleElementKey);
+        return doc.freeze();
+    }
+
+    auto event = applyTransformation(input, documentKeyFields);
+    // Events which cannot be stored as BSON are left for each change stream to transform.
+    if (event.getApproximateSize() <= static_cast<size_t>(BSONObjMaxUserSize)) {
+        cache.insert(key, event.toBson(), maxCacheSizeBytes);
+    }
+    return event;
+}
+
 Value DocumentSourceChangeStreamTransform::serialize(
     boost::optional<ExplainOptions::Verbosity> explain) const {
     Document changeStreamOptions(_changeStreamSpec);
@@ -383,6 +440,31 @@ Value DocumentSourceChangeStreamTransform::serialize(
     return Value(Document{{getSourceName(), changeStreamOptions}});
 }
 
+Pipeline::SourceContainer::iterator DocumentSourceChangeStreamTransform::doOptimizeAt(
+    Pipeline::SourceContainer::iterator itr, Pipeline::SourceContainer* container) {
+    invariant(*itr == this);
+    if (itr == container->begin()) {
+        return std::next(itr);
+    }
+
+    auto oplogMatch = dynamic_cast<DocumentSourceOplogMatch*>(std::prev(itr)->get());
+    if (!oplogMatch) {
+        return std::next(itr);
+    }
+
+    // None of the other change stream stages filter events or modify the fields which the oplog
+    // match can rewrite predicates on, so look past them for the first user stage.
+    auto userStageItr = std::find_if(std::next(itr), container->end(), [](const auto& stage) {
+        return !stage->constraints().isChangeStreamStage();
+    });
+    if (userStageItr != container->end()) {
+        if (auto userMatch = dynamic_cast<DocumentSourceMatch*>(userStageItr->get())) {
+            oplogMatch->pushDownUserFilter(userMatch->getMatchExpression());
+        }
+    }
+    return std::next(itr);
+}
+
 DepsTracker::State DocumentSourceChangeStreamTransform::getDependencies(DepsTracker* deps) const {
     deps->fields.insert(repl::OplogEntry::kOpTypeFieldName.toString());
     deps->fields.insert(repl::OplogEntry::kTimestampFieldName.toString());
@@ -416,7 +498,8 @@ DocumentSource::GetNextResult DocumentSourceChangeStreamTransform::doGetNext() {
         // have stored that can be returned.
         if (_txnIterator) {
             if (auto next = _txnIterator->getNextTransactionOp(pExpCtx->opCtx)) {
-                return applyTransformation(*next);
+                return transformOrReuseCachedEvent(
+                    *next, _txnIterator->clusterTime(), _txnIterator->txnOpIndex());
             }
             _txnIterator = boost::none;
         }
@@ -441,7 +524,8 @@ DocumentSource::GetNextResult DocumentSourceChangeStreamTransform::doGetNext() {
 
             // This oplog entry represents a single change. Apply the transform to it and return the
             // resulting document.
-            return applyTransformation(doc);
+            return transformOrReuseCachedEvent(
+                doc, doc[repl::OplogEntry::kTimestampFieldName].getTimestamp(), 0);
         }
 
         // The only two commands we will see here are an applyOps or a commit, which both mean we
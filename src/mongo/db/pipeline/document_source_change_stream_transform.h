@@ -66,12 +66,31 @@ public:
 protected:
     DocumentSource::GetNextResult doGetNext() override;
 
+    /**
+     * Pushes the filter of the first $match following the change stream stages down into the
+     * oplog match which precedes this stage, where possible.
+     */
+    Pipeline::SourceContainer::iterator doOptimizeAt(Pipeline::SourceContainer::iterator itr,
+                                                     Pipeline::SourceContainer* container) final;
+
 private:
     // This constructor is private, callers should use the 'create()' method above.
     DocumentSourceChangeStreamTransform(const boost::intrusive_ptr<ExpressionContext>&,
                                         const ServerGlobalParams::FeatureCompatibility::Version&,
                                         BSONObj changeStreamSpec);
 
+    /**
+     * Returns the document key fields of the collection the oplog entry 'input' applies to, or no
+     * fields if the entry is a command or has no UUID.
+     */
+    std::vector<FieldPath> getDocumentKeyFields(const Document& input);
+
+    /**
+     * Transforms the oplog entry 'input' into a change event, given its 'documentKeyFields'.
+     */
+    Document applyTransformation(const Document& input,
+                                 const std::vector<FieldPath>& documentKeyFields);
+
     struct DocumentKeyCacheEntry {
         DocumentKeyCacheEntry() = default;
 
@@ -200,6 +219,15 @@ private:
      */
     ResumeTokenData getResumeToken(Value ts, Value uuid, Value documentKey);
 
+    /**
+     * Returns the change event for the oplog entry 'input' at position 'clusterTime' and
+     * 'txnOpIndex'. If another change stream has already transformed the same entry, the event it
+     * cached is returned instead of transforming the entry again.
+     */
+    Document transformOrReuseCachedEvent(const Document& input,
+                                         Timestamp clusterTime,
+                                         size_t txnOpIndex);
+
     BSONObj _changeStreamSpec;
 
     // Map of collection UUID to document key fields.
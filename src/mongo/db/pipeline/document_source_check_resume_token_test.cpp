@@ -79,6 +79,9 @@ public:
     boost::optional<Record> seekExact(const RecordId& id) override {
         return Record{};
     }
+    boost::optional<Record> seekAtOrAfter(const RecordId& id) override {
+        return Record{};
+    }
     void save() override {}
     bool restore() override {
         return true;
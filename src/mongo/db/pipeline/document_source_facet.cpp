@@ -31,6 +31,7 @@
 
 #include "mongo/db/pipeline/document_source_facet.h"
 
+#include <algorithm>
 #include <memory>
 #include <vector>
 
@@ -40,12 +41,16 @@
 #include "mongo/bson/bsontypes.h"
 #include "mongo/db/exec/document_value/document.h"
 #include "mongo/db/exec/document_value/value.h"
+#include "mongo/db/client.h"
+#include "mongo/db/pipeline/document_source_queue.h"
 #include "mongo/db/pipeline/document_source_tee_consumer.h"
 #include "mongo/db/pipeline/expression_context.h"
 #include "mongo/db/pipeline/field_path.h"
 #include "mongo/db/pipeline/pipeline.h"
 #include "mongo/db/pipeline/tee_buffer.h"
+#include "mongo/db/service_context.h"
 #include "mongo/util/assert_util.h"
+#include "mongo/util/scopeguard.h"
 #include "mongo/util/str.h"
 
 namespace mongo {
@@ -55,6 +60,44 @@ using std::pair;
 using std::string;
 using std::vector;
 
+namespace {
+
+Value deepCopy(const Value& value);
+
+/**
+ * Returns a copy of 'doc' which shares no lazily materialized storage with it, so that it may be
+ * read by another thread.
+ */
+Document deepCopy(const Document& doc) {
+    MutableDocument copy;
+    auto it = doc.fieldIterator();
+    while (it.more()) {
+        auto field = it.next();
+        copy.addField(field.first, deepCopy(field.second));
+    }
+    copy.copyMetaDataFrom(doc);
+    return copy.freeze();
+}
+
+Value deepCopy(const Value& value) {
+    switch (value.getType()) {
+        case Object:
+            return Value(deepCopy(value.getDocument()));
+        case Array: {
+            std::vector<Value> elements;
+            elements.reserve(value.getArrayLength());
+            for (auto&& element : value.getArray()) {
+                elements.push_back(deepCopy(element));
+            }
+            return Value(std::move(elements));
+        }
+        default:
+            return value;
+    }
+}
+
+}  // namespace
+
 DocumentSourceFacet::DocumentSourceFacet(std::vector<FacetPipeline> facetPipelines,
                                          const intrusive_ptr<ExpressionContext>& expCtx,
                                          size_t bufferSizeBytes,
@@ -62,6 +105,7 @@ DocumentSourceFacet::DocumentSourceFacet(std::vector<FacetPipeline> facetPipelin
     : DocumentSource(kStageName, expCtx),
       _teeBuffer(TeeBuffer::create(facetPipelines.size(), bufferSizeBytes)),
       _facets(std::move(facetPipelines)),
+      _bufferSizeBytes(bufferSizeBytes),
       _maxOutputDocSizeBytes(maxOutputDocBytes) {
     for (size_t facetId = 0; facetId < _facets.size(); ++facetId) {
         auto& facet = _facets[facetId];
@@ -135,6 +179,8 @@ intrusive_ptr<DocumentSourceFacet> DocumentSourceFacet::create(
 }
 
 void DocumentSourceFacet::setSource(DocumentSource* source) {
+    // The source is read directly when the sub-pipelines are executed concurrently.
+    pSource = source;
     _teeBuffer->setSource(source);
 }
 
@@ -150,6 +196,11 @@ DocumentSource::GetNextResult DocumentSourceFacet::doGetNext() {
         return GetNextResult::makeEOF();
     }
 
+    if (canRunConcurrently()) {
+        _done = true;  // We will only ever produce one result.
+        return runConcurrently();
+    }
+
     const size_t maxBytes = _maxOutputDocSizeBytes;
     auto ensureUnderMemoryLimit = [usedBytes = 0ul, &maxBytes](long long additional) mutable {
         usedBytes += additional;
@@ -168,7 +219,9 @@ DocumentSource::GetNextResult DocumentSourceFacet::doGetNext() {
             auto next = pipeline->getSources().back()->getNext();
             for (; next.isAdvanced(); next = pipeline->getSources().back()->getNext()) {
                 ensureUnderMemoryLimit(next.getDocument().getApproximateSize());
-                results[facetId].emplace_back(next.releaseDocument());
+                // The results are retained until all of the input has been read, so they are
+                // copied out of the arena of the batch they were produced in, if any.
+                results[facetId].emplace_back(next.releaseDocument().copyOutOfArena());
             }
             allPipelinesEOF = allPipelinesEOF && next.isEOF();
         }
@@ -183,6 +236,263 @@ DocumentSource::GetNextResult DocumentSourceFacet::doGetNext() {
     return resultDoc.freeze();
 }
 
+bool DocumentSourceFacet::canRunConcurrently() const {
+    // Explain reports the execution of the original sub-pipelines, so it must run them itself.
+    if (!internalQueryEnableConcurrentFacet.load() || _facets.size() < 2 || pExpCtx->explain) {
+        return false;
+    }
+
+    // Stages which read from other collections, such as $lookup, use the OperationContext of the
+    // originating operation and so must run on its thread.
+    stdx::unordered_set<NamespaceString> involvedNamespaces;
+    addInvolvedCollections(&involvedNamespaces);
+    return involvedNamespaces.empty();
+}
+
+Document DocumentSourceFacet::runConcurrently() {
+    auto opCtx = pExpCtx->opCtx;
+    _deadline = opCtx->getDeadline();
+    _timeoutError = opCtx->getTimeoutError();
+    _workerResults.resize(_facets.size());
+
+    ON_BLOCK_EXIT([&] { stopWorkers(); });
+    {
+        stdx::lock_guard<Latch> lk(_mutex);
+        _numActiveWorkers = _facets.size();
+    }
+    for (size_t facetId = 0; facetId < _facets.size(); ++facetId) {
+        _workerQueues.push_back(std::make_unique<InputBatchQueue>([this] {
+            InputBatchQueue::Options options;
+            // Allow each worker to fall up to two batches behind the reader of the input.
+            options.maxQueueDepth = 2 * _bufferSizeBytes;
+            return options;
+        }()));
+    }
+    for (size_t facetId = 0; facetId < _facets.size(); ++facetId) {
+        // Each worker parses its own copy of the sub-pipeline, since the stages and expressions of
+        // a pipeline share the mutable state of its ExpressionContext.
+        auto workerExpCtx = pExpCtx->copyWith(pExpCtx->ns, pExpCtx->uuid);
+        workerExpCtx->opCtx = nullptr;
+        _workers.emplace_back([this,
+                               facetId,
+                               pipeline = _facets[facetId].pipeline->serializeToBson(),
+                               workerExpCtx = std::move(workerExpCtx)]() mutable {
+            runWorker(facetId, std::move(pipeline), std::move(workerExpCtx));
+        });
+    }
+
+    // Read the input in batches and hand each batch to every worker which still wants input.
+    std::vector<bool> workerWantsInput(_facets.size(), true);
+    bool exhausted = false;
+    while (!exhausted) {
+        auto batch = std::make_shared<InputBatch>();
+        size_t batchBytes = 0;
+        while (batchBytes < _bufferSizeBytes) {
+            auto input = pSource->getNext();
+            // As for TeeBuffer, the input is never paused since $facet cannot be nested.
+            invariant(!input.isPaused());
+            if (input.isEOF()) {
+                exhausted = true;
+                break;
+            }
+
+            const auto& doc = input.getDocument();
+            batchBytes += doc.getApproximateSize();
+            batch->documents.push_back(shareDocument(doc));
+        }
+        if (batch->documents.empty()) {
+            break;
+        }
+        batch->cost = std::min(batchBytes, _bufferSizeBytes);
+
+        std::shared_ptr<const InputBatch> sharedBatch = std::move(batch);
+        for (size_t facetId = 0; facetId < _facets.size(); ++facetId) {
+            if (!workerWantsInput[facetId]) {
+                continue;
+            }
+            try {
+                _workerQueues[facetId]->push(std::shared_ptr<const InputBatch>(sharedBatch), opCtx);
+            } catch (const ExceptionFor<ErrorCodes::ProducerConsumerQueueEndClosed>&) {
+                // The worker has finished early, for instance due to a $limit, or has failed.
+                workerWantsInput[facetId] = false;
+            }
+        }
+
+        stdx::lock_guard<Latch> lk(_mutex);
+        if (!_workerStatus.isOK()) {
+            break;
+        }
+    }
+    for (auto&& queue : _workerQueues) {
+        queue->closeProducerEnd();
+    }
+
+    {
+        stdx::unique_lock<Latch> lk(_mutex);
+        opCtx->waitForConditionOrInterrupt(
+            _workersDone, lk, [&] { return _numActiveWorkers == 0; });
+        uassertStatusOK(_workerStatus);
+    }
+    stopWorkers();
+
+    MutableDocument resultDoc;
+    for (size_t facetId = 0; facetId < _facets.size(); ++facetId) {
+        resultDoc[_facets[facetId].name] = Value(std::move(_workerResults[facetId]));
+    }
+    return resultDoc.freeze();
+}
+
+DocumentSourceFacet::SharedDocument DocumentSourceFacet::shareDocument(const Document& doc) const {
+    SharedDocument shared;
+    try {
+        if (doc.metadata()) {
+            shared.bson = doc.toBsonWithMetaData(SortKeyFormat::k44SortKey);
+            shared.hasMetadata = true;
+        } else {
+            shared.bson = doc.toBson().getOwned();
+        }
+        return shared;
+    } catch (const DBException& ex) {
+        // Intermediate documents may exceed the BSON size limit, so long as the output does not.
+        // Such a document grows the BufBuilder past its limit of 64MB (code 13548) or fails
+        // validation as a BSONObj.
+        if (ex.code() != ErrorCodes::BSONObjectTooLarge && ex.code() != 13548) {
+            throw;
+        }
+    }
+
+    shared.bson = BSONObj();
+    shared.copies.reserve(_facets.size());
+    for (size_t facetId = 0; facetId < _facets.size(); ++facetId) {
+        shared.copies.push_back(deepCopy(doc));
+    }
+    return shared;
+}
+
+void DocumentSourceFacet::runWorker(size_t facetId,
+                                    std::vector<BSONObj> pipeline,
+                                    boost::intrusive_ptr<ExpressionContext> workerExpCtx) {
+    Status status = Status::OK();
+    try {
+        const std::string desc = str::stream() << "facet-" << facetId;
+        ThreadClient tc(desc, pExpCtx->opCtx->getServiceContext());
+        auto opCtx = tc->makeOperationContext();
+        bool stopping;
+        {
+            stdx::lock_guard<Latch> lk(_mutex);
+            stopping = _stopping;
+            if (!stopping) {
+                _workerOpCtxs.push_back(opCtx.get());
+            }
+        }
+        if (!stopping) {
+            ON_BLOCK_EXIT([&] {
+                stdx::lock_guard<Latch> lk(_mutex);
+                _workerOpCtxs.erase(
+                    std::find(_workerOpCtxs.begin(), _workerOpCtxs.end(), opCtx.get()));
+            });
+            runWorkerPipeline(opCtx.get(), facetId, pipeline, workerExpCtx);
+        }
+    } catch (const DBException& ex) {
+        status = ex.toStatus();
+    }
+
+    // Tell the reader of the input that this worker wants no more of it.
+    _workerQueues[facetId]->closeConsumerEnd();
+
+    stdx::lock_guard<Latch> lk(_mutex);
+    if (!status.isOK() && _workerStatus.isOK()) {
+        _workerStatus = status;
+    }
+    if (--_numActiveWorkers == 0) {
+        _workersDone.notify_all();
+    }
+}
+
+void DocumentSourceFacet::runWorkerPipeline(
+    OperationContext* opCtx,
+    size_t facetId,
+    const std::vector<BSONObj>& pipelineBson,
+    const boost::intrusive_ptr<ExpressionContext>& workerExpCtx) {
+    opCtx->setDeadlineByDate(_deadline, _timeoutError);
+    workerExpCtx->opCtx = opCtx;
+
+    auto pipeline = Pipeline::parse(pipelineBson, workerExpCtx);
+    pipeline->optimizePipeline();
+    auto input = DocumentSourceQueue::create(workerExpCtx);
+    pipeline->addInitialSource(input);
+    ON_BLOCK_EXIT([&] {
+        if (pipeline->usedDisk()) {
+            _workersUsedDisk.store(true);
+        }
+    });
+
+    const size_t maxBytes = _maxOutputDocSizeBytes;
+    auto& results = _workerResults[facetId];
+
+    // Returns the output of the sub-pipeline until it pauses for more input, and whether it has
+    // reached EOF.
+    auto drainPipeline = [&] {
+        auto& lastStage = pipeline->getSources().back();
+        auto next = lastStage->getNext();
+        for (; next.isAdvanced(); next = lastStage->getNext()) {
+            const long long usedBytes =
+                _workerOutputBytes.addAndFetch(next.getDocument().getApproximateSize());
+            uassert(4031700,
+                    str::stream() << "document constructed by $facet is at least " << usedBytes
+                                  << " bytes, which exceeds the limit of " << maxBytes << " bytes",
+                    static_cast<size_t>(usedBytes) <= maxBytes);
+            results.emplace_back(next.releaseDocument());
+        }
+        return next.isEOF();
+    };
+
+    while (true) {
+        std::shared_ptr<const InputBatch> batch;
+        try {
+            batch = _workerQueues[facetId]->pop(opCtx);
+        } catch (const ExceptionFor<ErrorCodes::ProducerConsumerQueueConsumed>&) {
+            // The input is exhausted, so the queue stage now returns EOF.
+            invariant(drainPipeline());
+            return;
+        }
+
+        for (auto&& doc : batch->documents) {
+            if (!doc.copies.empty()) {
+                input->emplace_back(Document(doc.copies[facetId]));
+            } else {
+                input->emplace_back(doc.hasMetadata ? Document::fromBsonWithMetaData(doc.bson)
+                                                    : Document(doc.bson));
+            }
+        }
+        input->emplace_back(GetNextResult::makePauseExecution());
+        if (drainPipeline()) {
+            // The sub-pipeline needs no more input, for instance because of a $limit.
+            return;
+        }
+    }
+}
+
+void DocumentSourceFacet::stopWorkers() {
+    {
+        stdx::lock_guard<Latch> lk(_mutex);
+        _stopping = true;
+        for (auto workerOpCtx : _workerOpCtxs) {
+            stdx::lock_guard<Client> clientLock(*workerOpCtx->getClient());
+            workerOpCtx->getServiceContext()->killOperation(
+                clientLock, workerOpCtx, ErrorCodes::Interrupted);
+        }
+    }
+
+    for (auto&& queue : _workerQueues) {
+        queue->closeConsumerEnd();
+    }
+    for (auto&& worker : _workers) {
+        worker.join();
+    }
+    _workers.clear();
+}
+
 Value DocumentSourceFacet::serialize(boost::optional<ExplainOptions::Verbosity> explain) const {
     MutableDocument serialized;
     for (auto&& facet : _facets) {
@@ -262,6 +572,9 @@ StageConstraints DocumentSourceFacet::constraints(Pipeline::SplitState) const {
 }
 
 bool DocumentSourceFacet::usedDisk() {
+    if (_workersUsedDisk.load()) {
+        return true;
+    }
     for (auto&& facet : _facets) {
         if (facet.pipeline->usedDisk())
             return true;
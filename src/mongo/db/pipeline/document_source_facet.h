@@ -38,6 +38,12 @@
 #include "mongo/db/pipeline/lite_parsed_document_source.h"
 #include "mongo/db/pipeline/lite_parsed_pipeline.h"
 #include "mongo/db/pipeline/pipeline.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/platform/mutex.h"
+#include "mongo/stdx/condition_variable.h"
+#include "mongo/stdx/thread.h"
+#include "mongo/util/producer_consumer_queue.h"
+#include "mongo/util/time_support.h"
 
 namespace mongo {
 
@@ -55,6 +61,10 @@ class NamespaceString;
  * For example, {$facet: {facetA: [{$skip: 1}], facetB: [{$limit: 1}]}} would describe a $facet
  * stage which will produce a document like the following:
  * {facetA: [<all input documents except the first one>], facetB: [<the first document>]}.
+ *
+ * If 'internalQueryEnableConcurrentFacet' is set and none of the sub-pipelines reads from another
+ * collection, each sub-pipeline is executed on its own worker thread instead. The input is then
+ * read in batches of BSON documents which are shared by all of the workers.
  */
 class DocumentSourceFacet final : public DocumentSource {
 public:
@@ -157,11 +167,112 @@ private:
 
     Value serialize(boost::optional<ExplainOptions::Verbosity> explain = boost::none) const final;
 
+    /**
+     * An input document shared by the workers of a concurrent $facet. Documents lazily materialize
+     * their fields when read, so they cannot be shared between threads; instead each worker builds
+     * its own Document from the immutable BSON. An intermediate document which is too large to be
+     * converted to BSON is instead deep-copied once per worker, into 'copies'.
+     */
+    struct SharedDocument {
+        BSONObj bson;
+        bool hasMetadata = false;
+        std::vector<Document> copies;
+    };
+
+    struct InputBatch {
+        std::vector<SharedDocument> documents;
+
+        // The size of the batch, capped at the buffer size so that any batch fits in a queue.
+        size_t cost = 0;
+    };
+
+    struct InputBatchCostFunction {
+        size_t operator()(const std::shared_ptr<const InputBatch>& batch) const {
+            return batch->cost;
+        }
+    };
+
+    using InputBatchQueue = SingleProducerSingleConsumerQueue<std::shared_ptr<const InputBatch>,
+                                                              InputBatchCostFunction>;
+
+    /**
+     * Returns true if the sub-pipelines can be executed concurrently by worker threads.
+     */
+    bool canRunConcurrently() const;
+
+    /**
+     * Returns 'doc' in a form which the worker threads can read concurrently.
+     */
+    SharedDocument shareDocument(const Document& doc) const;
+
+    /**
+     * Executes each sub-pipeline on its own worker thread, feeding them the input of this stage,
+     * and returns the single output document.
+     */
+    Document runConcurrently();
+
+    /**
+     * Executes a copy of the sub-pipeline 'facetId', parsed from 'pipeline' with 'workerExpCtx',
+     * over the batches in its input queue. Runs on a worker thread.
+     */
+    void runWorker(size_t facetId,
+                   std::vector<BSONObj> pipeline,
+                   boost::intrusive_ptr<ExpressionContext> workerExpCtx);
+
+    /**
+     * Executes the sub-pipeline of worker 'facetId' using 'opCtx', storing its output in
+     * '_workerResults'.
+     */
+    void runWorkerPipeline(OperationContext* opCtx,
+                           size_t facetId,
+                           const std::vector<BSONObj>& pipeline,
+                           const boost::intrusive_ptr<ExpressionContext>& workerExpCtx);
+
+    /**
+     * Stops and joins the worker threads. Workers which are still running are interrupted.
+     */
+    void stopWorkers();
+
     boost::intrusive_ptr<TeeBuffer> _teeBuffer;
     std::vector<FacetPipeline> _facets;
 
+    const size_t _bufferSizeBytes;
     const size_t _maxOutputDocSizeBytes;
 
     bool _done = false;
+
+    // The following members are used when the sub-pipelines are executed concurrently. Each worker
+    // has its own input queue, and is the only writer of its entry of '_workerResults', which is
+    // read once the workers have been joined.
+    std::vector<std::unique_ptr<InputBatchQueue>> _workerQueues;
+    std::vector<std::vector<Value>> _workerResults;
+    std::vector<stdx::thread> _workers;
+
+    // The time limit of the originating operation, which the workers inherit.
+    Date_t _deadline = Date_t::max();
+    ErrorCodes::Error _timeoutError = ErrorCodes::ExceededTimeLimit;
+
+    // The combined size of the output of all workers, which is subject to the limit on the size of
+    // the output document.
+    AtomicWord<long long> _workerOutputBytes{0};
+    AtomicWord<bool> _workersUsedDisk{false};
+
+    Mutex _mutex = MONGO_MAKE_LATCH("DocumentSourceFacet::_mutex");
+
+    // Notified when the last worker finishes.
+    stdx::condition_variable _workersDone;
+
+    // Guarded by '_mutex'. The operations of the running workers, so that they can be interrupted.
+    std::vector<OperationContext*> _workerOpCtxs;
+
+    // Guarded by '_mutex'. The number of workers which have not yet finished.
+    size_t _numActiveWorkers = 0;
+
+    // Guarded by '_mutex'. The first error raised by any worker.
+    Status _workerStatus = Status::OK();
+
+    // Guarded by '_mutex'. Set once the workers are being stopped, so that workers which have not
+    // yet started exit immediately.
+    bool _stopping = false;
 };
 }  // namespace mongo
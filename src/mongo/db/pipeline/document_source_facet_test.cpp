@@ -44,8 +44,10 @@
 #include "mongo/db/pipeline/document_source_limit.h"
 #include "mongo/db/pipeline/document_source_mock.h"
 #include "mongo/db/pipeline/document_source_skip.h"
+#include "mongo/db/query/query_knobs_gen.h"
 #include "mongo/unittest/death_test.h"
 #include "mongo/unittest/unittest.h"
+#include "mongo/util/scopeguard.h"
 
 namespace mongo {
 using std::deque;
@@ -450,6 +452,73 @@ TEST_F(DocumentSourceFacetTest, ShouldBeAbleToEvaluateMultipleStagesWithinOneSub
     ASSERT_DOCUMENT_EQ(output.getDocument(), Document(fromjson("{subPipe: [{_id: 0}, {_id: 1}]}")));
 }
 
+TEST_F(DocumentSourceFacetTest, ShouldExecuteSubPipelinesConcurrently) {
+    auto ctx = getExpCtx();
+
+    const bool originalConcurrentFacet = internalQueryEnableConcurrentFacet.load();
+    const int originalBufferSizeBytes = internalQueryFacetBufferSizeBytes.load();
+    ON_BLOCK_EXIT([&] {
+        internalQueryEnableConcurrentFacet.store(originalConcurrentFacet);
+        internalQueryFacetBufferSizeBytes.store(originalBufferSizeBytes);
+    });
+    internalQueryEnableConcurrentFacet.store(true);
+    // Use a small buffer so that the input is split into many batches.
+    internalQueryFacetBufferSizeBytes.store(256);
+
+    deque<DocumentSource::GetNextResult> inputs;
+    for (int i = 0; i < 100; ++i) {
+        inputs.emplace_back(Document{{"_id", i}, {"a", i % 3}});
+    }
+    auto mock = DocumentSourceMock::createForTest(inputs);
+
+    auto spec = fromjson(
+        "{$facet: {count: [{$group: {_id: null, n: {$sum: 1}}}],"
+        "          byA: [{$group: {_id: '$a', n: {$sum: 1}}}, {$sort: {_id: 1}}],"
+        "          first: [{$limit: 2}]}}");
+    auto facetStage = DocumentSourceFacet::createFromBson(spec.firstElement(), ctx);
+    facetStage->setSource(mock.get());
+
+    auto output = facetStage->getNext();
+    ASSERT(output.isAdvanced());
+    ASSERT_DOCUMENT_EQ(
+        output.getDocument(),
+        Document(fromjson("{count: [{_id: null, n: 100}],"
+                          " byA: [{_id: 0, n: 34}, {_id: 1, n: 33}, {_id: 2, n: 33}],"
+                          " first: [{_id: 0, a: 0}, {_id: 1, a: 1}]}")));
+    ASSERT(facetStage->getNext().isEOF());
+}
+
+TEST_F(DocumentSourceFacetTest, ConcurrentSubPipelinesShouldAcceptInputLargerThanBsonLimit) {
+    auto ctx = getExpCtx();
+
+    const bool originalConcurrentFacet = internalQueryEnableConcurrentFacet.load();
+    ON_BLOCK_EXIT([&] { internalQueryEnableConcurrentFacet.store(originalConcurrentFacet); });
+    internalQueryEnableConcurrentFacet.store(true);
+
+    // Intermediate documents may exceed the BSON size limit, so long as the output of $facet does
+    // not.
+    const std::string largeString(BSONObjMaxUserSize / 2 + 1, 'x');
+    deque<DocumentSource::GetNextResult> inputs;
+    inputs.emplace_back(Document{{"_id", 0}, {"a", largeString}, {"b", largeString}});
+    inputs.emplace_back(Document{{"_id", 1}, {"a", 1}, {"b", 1}});
+    auto mock = DocumentSourceMock::createForTest(inputs);
+
+    auto spec = fromjson(
+        "{$facet: {ids: [{$project: {_id: 1}}],"
+        "          lengths: [{$project: {_id: 0, len: {$strLenBytes: {$toString: '$a'}}}}]}}");
+    auto facetStage = DocumentSourceFacet::createFromBson(spec.firstElement(), ctx);
+    facetStage->setSource(mock.get());
+
+    auto output = facetStage->getNext();
+    ASSERT(output.isAdvanced());
+    ASSERT_DOCUMENT_EQ(output.getDocument(),
+                       Document(BSON("ids" << BSON_ARRAY(BSON("_id" << 0) << BSON("_id" << 1))
+                                           << "lengths"
+                                           << BSON_ARRAY(BSON("len" << int(largeString.size()))
+                                                         << BSON("len" << 1)))));
+    ASSERT(facetStage->getNext().isEOF());
+}
+
 TEST_F(DocumentSourceFacetTest, ShouldPropagateDisposeThroughToSource) {
     auto ctx = getExpCtx();
 
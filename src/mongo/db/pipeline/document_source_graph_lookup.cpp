@@ -31,6 +31,7 @@
 
 #include "mongo/db/pipeline/document_source_graph_lookup.h"
 
+#include <boost/filesystem/operations.hpp>
 #include <memory>
 
 #include "mongo/base/init.h"
@@ -44,6 +45,7 @@
 #include "mongo/db/pipeline/expression_context.h"
 #include "mongo/db/query/query_knobs_gen.h"
 #include "mongo/db/query/query_planner_common.h"
+#include "mongo/util/destructor_guard.h"
 
 namespace mongo {
 
@@ -57,6 +59,21 @@ void assertIsValidCollectionState(const boost::intrusive_ptr<ExpressionContext>&
         }
     }
 }
+
+/**
+ * Generates a new file name on each call using a static, atomic and monotonically increasing
+ * number.
+ *
+ * Each user of the Sorter must implement this function to ensure that all temporary files that the
+ * Sorter instances produce are uniquely identified using a unique file name extension with separate
+ * atomic variable. This is necessary because the sorter.cpp code is separately included in multiple
+ * places, rather than compiled in one place and linked, and so cannot provide a globally unique ID.
+ */
+std::string nextFileName() {
+    static AtomicWord<unsigned> documentSourceGraphLookUpFileCounter;
+    return "extsort-doc-graph-lookup." +
+        std::to_string(documentSourceGraphLookUpFileCounter.fetchAndAdd(1));
+}
 }  // namespace
 
 using boost::intrusive_ptr;
@@ -92,6 +109,14 @@ REGISTER_DOCUMENT_SOURCE(graphLookup,
                          DocumentSourceGraphLookUp::LiteParsed::parse,
                          DocumentSourceGraphLookUp::createFromBson);
 
+DocumentSourceGraphLookUp::~DocumentSourceGraphLookUp() {
+    // Close any spilled runs before removing the file they read from.
+    _spilledRuns.clear();
+    if (!_spillFileName.empty()) {
+        DESTRUCTOR_GUARD(boost::filesystem::remove(_spillFileName));
+    }
+}
+
 const char* DocumentSourceGraphLookUp::getSourceName() const {
     return kStageName.rawData();
 }
@@ -112,11 +137,11 @@ DocumentSource::GetNextResult DocumentSourceGraphLookUp::doGetNext() {
     performSearch();
 
     std::vector<Value> results;
-    while (!_visited.empty()) {
+    // Results are only spilled when a $unwind has been absorbed.
+    invariant(_spilledRuns.empty());
+    while (auto result = popNextResult()) {
         // Remove elements one at a time to avoid consuming more memory.
-        auto it = _visited.begin();
-        results.push_back(Value(it->second));
-        _visited.erase(it);
+        results.push_back(Value(std::move(*result)));
     }
 
     MutableDocument output(*_input);
@@ -135,7 +160,8 @@ DocumentSource::GetNextResult DocumentSourceGraphLookUp::getNextUnwound() {
     // If the unwind is not preserving empty arrays, we might have to process multiple inputs before
     // we get one that will produce an output.
     while (true) {
-        if (_visited.empty()) {
+        auto result = popNextResult();
+        if (!result) {
             // No results are left for the current input, so we should move on to the next one and
             // perform a new search.
 
@@ -148,10 +174,11 @@ DocumentSource::GetNextResult DocumentSourceGraphLookUp::getNextUnwound() {
             performSearch();
             _visitedUsageBytes = 0;
             _outputIndex = 0;
+            result = popNextResult();
         }
         MutableDocument unwound(*_input);
 
-        if (_visited.empty()) {
+        if (!result) {
             if ((*_unwind)->preserveNullAndEmptyArrays()) {
                 // Since "preserveNullAndEmptyArrays" was specified, output a document even though
                 // we had no result.
@@ -165,23 +192,49 @@ DocumentSource::GetNextResult DocumentSourceGraphLookUp::getNextUnwound() {
                 continue;
             }
         } else {
-            auto it = _visited.begin();
-            unwound.setNestedField(_as, Value(it->second));
+            unwound.setNestedField(_as, Value(std::move(*result)));
             if (indexPath) {
                 unwound.setNestedField(*indexPath, Value(_outputIndex));
                 ++_outputIndex;
             }
-            _visited.erase(it);
         }
 
         return unwound.freeze();
     }
 }
 
+boost::optional<Document> DocumentSourceGraphLookUp::popNextResult() {
+    if (!_visited.empty()) {
+        auto it = _visited.begin();
+        Document result = std::move(it->second.doc);
+        _visited.erase(it);
+        return result;
+    }
+
+    while (!_spilledRuns.empty()) {
+        auto& run = _spilledRuns.front();
+        if (!_spilledRunIsOpen) {
+            run->openSource();
+            _spilledRunIsOpen = true;
+        }
+        if (run->more()) {
+            return run->next().second;
+        }
+        run->closeSource();
+        _spilledRunIsOpen = false;
+        _spilledRuns.pop_front();
+    }
+    return boost::none;
+}
+
 void DocumentSourceGraphLookUp::doDispose() {
     _cache.clear();
     _frontier.clear();
     _visited.clear();
+    _spilledIds.clear();
+    _spilledIdsUsageBytes = 0;
+    _spilledRuns.clear();
+    _spilledRunIsOpen = false;
 }
 
 void DocumentSourceGraphLookUp::doBreadthFirstSearch() {
@@ -193,10 +246,7 @@ void DocumentSourceGraphLookUp::doBreadthFirstSearch() {
 
         // Check whether each key in the frontier exists in the cache or needs to be queried.
         auto cached = pExpCtx->getDocumentComparator().makeUnorderedDocumentSet();
-        auto matchStage = makeMatchStageFromFrontier(&cached);
-
-        ValueUnorderedSet queried = pExpCtx->getValueComparator().makeUnorderedValueSet();
-        _frontier.swap(queried);
+        auto queryBatches = makeQueryBatchesFromFrontier(&cached);
         _frontierUsageBytes = 0;
 
         // Process cached values, populating '_frontier' for the next iteration of search.
@@ -208,12 +258,11 @@ void DocumentSourceGraphLookUp::doBreadthFirstSearch() {
             checkMemoryUsage();
         }
 
-        if (matchStage) {
-            // Query for all keys that were in the frontier and not in the cache, populating
-            // '_frontier' for the next iteration of search.
-
+        // Query for each batch of keys that were in the frontier and not in the cache, populating
+        // '_frontier' for the next iteration of search.
+        for (auto&& queried : queryBatches) {
             // We've already allocated space for the trailing $match stage in '_fromPipeline'.
-            _fromPipeline.back() = *matchStage;
+            _fromPipeline.back() = makeMatchStage(queried);
             MakePipelineOptions pipelineOpts;
             pipelineOpts.optimize = true;
             pipelineOpts.attachCursorSource = true;
@@ -227,11 +276,14 @@ void DocumentSourceGraphLookUp::doBreadthFirstSearch() {
                             << "' namespace must contain an _id for de-duplication in $graphLookup",
                         !(*next)["_id"].missing());
 
+                // The results are cached across inputs, so they must not keep the arena of the
+                // current batch alive.
+                Document result = next->copyOutOfArena();
                 shouldPerformAnotherQuery =
-                    addToVisitedAndFrontier(*next, depth) || shouldPerformAnotherQuery;
-                addToCache(std::move(*next), queried);
+                    addToVisitedAndFrontier(result, depth) || shouldPerformAnotherQuery;
+                addToCache(std::move(result), queried);
+                checkMemoryUsage();
             }
-            checkMemoryUsage();
         }
 
         ++depth;
@@ -240,12 +292,14 @@ void DocumentSourceGraphLookUp::doBreadthFirstSearch() {
 
     _frontier.clear();
     _frontierUsageBytes = 0;
+    _spilledIds.clear();
+    _spilledIdsUsageBytes = 0;
 }
 
 bool DocumentSourceGraphLookUp::addToVisitedAndFrontier(Document result, long long depth) {
     auto id = result.getField("_id");
 
-    if (_visited.find(id) != _visited.end()) {
+    if (_visited.find(id) != _visited.end() || _spilledIds.find(id) != _spilledIds.end()) {
         // We've already seen this object, don't repeat any work.
         return false;
     }
@@ -255,7 +309,7 @@ bool DocumentSourceGraphLookUp::addToVisitedAndFrontier(Document result, long lo
     if (_depthField) {
         MutableDocument mutableDoc(std::move(result));
         mutableDoc.setNestedField(*_depthField, Value(depth));
-        result = mutableDoc.freeze();
+        result = mutableDoc.freeze().copyOutOfArena();
     }
 
     // Add the 'connectFromField' of 'result' into '_frontier'. If the 'connectFromField' is an
@@ -268,10 +322,10 @@ bool DocumentSourceGraphLookUp::addToVisitedAndFrontier(Document result, long lo
         });
 
     // Add the object to our '_visited' list and update the size of '_visited' appropriately.
-    _visitedUsageBytes += id.getApproximateSize();
-    _visitedUsageBytes += result.getApproximateSize();
+    const size_t usageBytes = id.getApproximateSize() + result.getApproximateSize();
+    _visitedUsageBytes += usageBytes;
 
-    _visited[id] = std::move(result);
+    _visited[id] = {std::move(result), usageBytes};
 
     // We inserted into _visited, so return true.
     return true;
@@ -292,7 +346,7 @@ void DocumentSourceGraphLookUp::addToCache(const Document& result,
         });
 }
 
-boost::optional<BSONObj> DocumentSourceGraphLookUp::makeMatchStageFromFrontier(
+std::vector<ValueUnorderedSet> DocumentSourceGraphLookUp::makeQueryBatchesFromFrontier(
     DocumentUnorderedSet* cached) {
     // Add any cached values to 'cached' and remove them from '_frontier'.
     for (auto it = _frontier.begin(); it != _frontier.end();) {
@@ -310,6 +364,21 @@ boost::optional<BSONObj> DocumentSourceGraphLookUp::makeMatchStageFromFrontier(
         }
     }
 
+    // Split the remaining values into batches, so that no single query has to carry the entire
+    // frontier in its $in.
+    const size_t batchSize = internalDocumentSourceGraphLookupFrontierBatchSize.load();
+    std::vector<ValueUnorderedSet> batches;
+    for (auto&& value : _frontier) {
+        if (batches.empty() || (batchSize > 0 && batches.back().size() >= batchSize)) {
+            batches.push_back(pExpCtx->getValueComparator().makeUnorderedValueSet());
+        }
+        batches.back().insert(value);
+    }
+    _frontier.clear();
+    return batches;
+}
+
+BSONObj DocumentSourceGraphLookUp::makeMatchStage(const ValueUnorderedSet& queried) const {
     // Create a query of the form {$and: [_additionalFilter, {_connectToField: {$in: [...]}}]}.
     //
     // We wrap the query in a $match so that it can be parsed into a DocumentSourceMatch when
@@ -329,7 +398,7 @@ boost::optional<BSONObj> DocumentSourceGraphLookUp::makeMatchStageFromFrontier(
                     BSONObjBuilder subObj(connectToObj.subobjStart(_connectToField.fullPath()));
                     {
                         BSONArrayBuilder in(subObj.subarrayStart("$in"));
-                        for (auto&& value : _frontier) {
+                        for (auto&& value : queried) {
                             in << value;
                         }
                     }
@@ -338,7 +407,7 @@ boost::optional<BSONObj> DocumentSourceGraphLookUp::makeMatchStageFromFrontier(
         }
     }
 
-    return _frontier.empty() ? boost::none : boost::optional<BSONObj>(match.obj());
+    return match.obj();
 }
 
 void DocumentSourceGraphLookUp::performSearch() {
@@ -392,11 +461,44 @@ Pipeline::SourceContainer::iterator DocumentSourceGraphLookUp::doOptimizeAt(
 }
 
 void DocumentSourceGraphLookUp::checkMemoryUsage() {
-    // TODO SERVER-23980: Implement spilling to disk if allowDiskUse is specified.
+    // Without an absorbed $unwind, every result of an input is returned in a single array, so
+    // spilling them would not bound the memory used.
+    if ((_visitedUsageBytes + _frontierUsageBytes + _spilledIdsUsageBytes) >=
+            _maxMemoryUsageBytes &&
+        _unwind && pExpCtx->allowDiskUse && !pExpCtx->inMongos && !_visited.empty()) {
+        spill();
+    }
+
+    const size_t usageBytes = _visitedUsageBytes + _frontierUsageBytes + _spilledIdsUsageBytes;
     uassert(40099,
             "$graphLookup reached maximum memory consumption",
-            (_visitedUsageBytes + _frontierUsageBytes) < _maxMemoryUsageBytes);
-    _cache.evictDownTo(_maxMemoryUsageBytes - _frontierUsageBytes - _visitedUsageBytes);
+            usageBytes < _maxMemoryUsageBytes);
+    _cache.evictDownTo(_maxMemoryUsageBytes - usageBytes);
+}
+
+void DocumentSourceGraphLookUp::spill() {
+    if (_spillFileName.empty()) {
+        _spillFileName = pExpCtx->tempDir + "/" + nextFileName();
+    }
+    _usedDisk = true;
+
+    SortedFileWriter<Value, Document> writer(
+        SortOptions().TempDir(pExpCtx->tempDir), _spillFileName, _nextSpillFileOffset);
+    while (!_visited.empty()) {
+        auto it = _visited.begin();
+
+        // Only the '_id' stays in memory, now accounted for in '_spilledIdsUsageBytes'.
+        invariant(it->second.usageBytes <= _visitedUsageBytes);
+        _visitedUsageBytes -= it->second.usageBytes;
+        _spilledIdsUsageBytes += it->first.getApproximateSize();
+
+        writer.addAlreadySorted(it->first, it->second.doc);
+        _spilledIds.insert(it->first);
+        _visited.erase(it);
+    }
+
+    _spilledRuns.emplace_back(writer.done());
+    _nextSpillFileOffset = writer.getFileEndOffset();
 }
 
 void DocumentSourceGraphLookUp::serializeToArray(
@@ -466,8 +568,11 @@ DocumentSourceGraphLookUp::DocumentSourceGraphLookUp(
       _additionalFilter(additionalFilter),
       _depthField(depthField),
       _maxDepth(maxDepth),
+      _maxMemoryUsageBytes(
+          static_cast<size_t>(internalDocumentSourceGraphLookupMaxMemoryBytes.load())),
       _frontier(pExpCtx->getValueComparator().makeUnorderedValueSet()),
-      _visited(ValueComparator::kInstance.makeUnorderedValueMap<Document>()),
+      _visited(ValueComparator::kInstance.makeUnorderedValueMap<VisitedDocument>()),
+      _spilledIds(ValueComparator::kInstance.makeUnorderedValueSet()),
       _cache(pExpCtx->getValueComparator()),
       _unwind(unwindSrc) {
     const auto& resolvedNamespace = pExpCtx->getResolvedNamespace(_from);
@@ -613,3 +718,6 @@ void DocumentSourceGraphLookUp::addInvolvedCollections(
     }
 }
 }  // namespace mongo
+
+#include "mongo/db/sorter/sorter.cpp"
+// Explicit instantiation unneeded since we aren't exposing Sorter outside of this file.
@@ -29,11 +29,14 @@
 
 #pragma once
 
+#include <deque>
+
 #include "mongo/db/exec/document_value/value_comparator.h"
 #include "mongo/db/pipeline/document_source.h"
 #include "mongo/db/pipeline/document_source_unwind.h"
 #include "mongo/db/pipeline/expression.h"
 #include "mongo/db/pipeline/lookup_set_cache.h"
+#include "mongo/db/sorter/sorter.h"
 
 namespace mongo {
 
@@ -60,6 +63,8 @@ public:
         }
     };
 
+    ~DocumentSourceGraphLookUp();
+
     const char* getSourceName() const final;
 
     const FieldPath& getConnectFromField() const {
@@ -95,7 +100,7 @@ public:
         StageConstraints constraints(StreamType::kStreaming,
                                      PositionRequirement::kNone,
                                      HostTypeRequirement::kPrimaryShard,
-                                     DiskUseRequirement::kNoDiskUse,
+                                     DiskUseRequirement::kWritesTmpData,
                                      FacetRequirement::kAllowed,
                                      TransactionRequirement::kAllowed,
                                      LookupRequirement::kAllowed,
@@ -105,6 +110,10 @@ public:
         return constraints;
     }
 
+    bool usedDisk() final {
+        return _usedDisk;
+    }
+
     boost::optional<DistributedPlanLogic> distributedPlanLogic() final {
         // {shardsStage, mergingStage, sortPattern}
         return DistributedPlanLogic{nullptr, this, boost::none};
@@ -165,15 +174,21 @@ private:
     }
 
     /**
-     * Prepares the query to execute on the 'from' collection wrapped in a $match by using the
-     * contents of '_frontier'.
+     * Drains '_frontier', filling 'cached' with any values that were retrieved from the cache and
+     * splitting the remaining values into batches of at most
+     * 'internalDocumentSourceGraphLookupFrontierBatchSize' values, each of which is queried for
+     * separately.
      *
-     * Fills 'cached' with any values that were retrieved from the cache.
-     *
-     * Returns boost::none if no query is necessary, i.e., all values were retrieved from the cache.
-     * Otherwise, returns a query object.
+     * Returns an empty vector if no query is necessary, i.e., all values were retrieved from the
+     * cache.
+     */
+    std::vector<ValueUnorderedSet> makeQueryBatchesFromFrontier(DocumentUnorderedSet* cached);
+
+    /**
+     * Prepares the query to execute on the 'from' collection wrapped in a $match, matching
+     * documents whose 'connectToField' is one of the values in 'queried'.
      */
-    boost::optional<BSONObj> makeMatchStageFromFrontier(DocumentUnorderedSet* cached);
+    BSONObj makeMatchStage(const ValueUnorderedSet& queried) const;
 
     /**
      * If we have internalized a $unwind, getNext() dispatches to this function.
@@ -200,11 +215,25 @@ private:
     void addToCache(const Document& result, const ValueUnorderedSet& queried);
 
     /**
-     * Assert that '_visited' and '_frontier' have not exceeded the maximum meory usage, and then
-     * evict from '_cache' until this source is using less than '_maxMemoryUsageBytes'.
+     * Assert that '_visited', '_frontier' and '_spilledIds' have not exceeded the maximum meory
+     * usage, spilling the documents in '_visited' to disk first if allowDiskUse is enabled and a
+     * $unwind has been absorbed, and then evict from '_cache' until this source is using less than
+     * '_maxMemoryUsageBytes'.
      */
     void checkMemoryUsage();
 
+    /**
+     * Writes the documents in '_visited' to a new run in the spill file, keeping only their '_id'
+     * values in memory so that they can still be de-duplicated against.
+     */
+    void spill();
+
+    /**
+     * Removes and returns one of the documents discovered for the current input, first from
+     * '_visited' and then from the spilled runs. Returns boost::none once none are left.
+     */
+    boost::optional<Document> popNextResult();
+
     /**
      * Process 'result', adding it to '_visited' with the given 'depth', and updating '_frontier'
      * with the object's 'connectTo' values.
@@ -230,7 +259,7 @@ private:
     // The aggregation pipeline to perform against the '_from' namespace.
     std::vector<BSONObj> _fromPipeline;
 
-    size_t _maxMemoryUsageBytes = 100 * 1024 * 1024;
+    const size_t _maxMemoryUsageBytes;
 
     // Track memory usage to ensure we don't exceed '_maxMemoryUsageBytes'.
     size_t _visitedUsageBytes = 0;
@@ -239,10 +268,33 @@ private:
     // Only used during the breadth-first search, tracks the set of values on the current frontier.
     ValueUnorderedSet _frontier;
 
+    // A document in '_visited', along with the number of bytes it added to '_visitedUsageBytes'. A
+    // document shares its storage with the copy in '_cache', so its approximate size can grow
+    // afterwards as fields of the cached copy are materialized.
+    struct VisitedDocument {
+        Document doc;
+        size_t usageBytes = 0;
+    };
+
     // Tracks nodes that have been discovered for a given input. Keys are the '_id' value of the
     // document from the foreign collection, value is the document itself.  The keys are compared
     // using the simple collation.
-    ValueUnorderedMap<Document> _visited;
+    ValueUnorderedMap<VisitedDocument> _visited;
+
+    // The '_id' values of the documents in '_visited' that were spilled to disk while searching on
+    // behalf of the current input, compared using the simple collation.
+    ValueUnorderedSet _spilledIds;
+    size_t _spilledIdsUsageBytes = 0;
+
+    // Runs of documents spilled from '_visited' for the current input, which are returned once
+    // '_visited' is empty. Each run is only read sequentially, so its documents are not sorted.
+    std::deque<std::unique_ptr<Sorter<Value, Document>::Iterator>> _spilledRuns;
+    bool _spilledRunIsOpen = false;
+
+    // Only set once this stage spills. The file is shared by all runs, and removed on destruction.
+    std::string _spillFileName;
+    std::streampos _nextSpillFileOffset = 0;
+    bool _usedDisk = false;
 
     // Caches query results to avoid repeating any work. This structure is maintained across calls
     // to getNext().
@@ -38,8 +38,11 @@
 #include "mongo/db/pipeline/document_source_graph_lookup.h"
 #include "mongo/db/pipeline/document_source_mock.h"
 #include "mongo/db/pipeline/process_interface/stub_mongo_process_interface.h"
+#include "mongo/db/query/query_knobs_gen.h"
+#include "mongo/unittest/temp_dir.h"
 #include "mongo/unittest/unittest.h"
 #include "mongo/util/assert_util.h"
+#include "mongo/util/scopeguard.h"
 #include "mongo/util/str.h"
 
 namespace mongo {
@@ -67,11 +70,17 @@ public:
         std::unique_ptr<Pipeline, PipelineDeleter> pipeline(
             ownedPipeline, PipelineDeleter(ownedPipeline->getContext()->opCtx));
         pipeline->addInitialSource(DocumentSourceMock::createForTest(_results));
+        ++_numQueries;
         return pipeline;
     }
 
+    int numQueries() const {
+        return _numQueries;
+    }
+
 private:
     std::deque<DocumentSource::GetNextResult> _results;
+    int _numQueries = 0;
 };
 
 TEST_F(DocumentSourceGraphLookUpTest,
@@ -609,5 +618,188 @@ TEST_F(DocumentSourceGraphLookUpTest, ShouldNotExpandArraysWithinArraysAtEndOfCo
     ASSERT(graphLookupStage->getNext().isEOF());
 }
 
+TEST_F(DocumentSourceGraphLookUpTest, ShouldQueryFrontierInBoundedBatches) {
+    auto expCtx = getExpCtx();
+
+    const int originalBatchSize = internalDocumentSourceGraphLookupFrontierBatchSize.load();
+    ON_BLOCK_EXIT(
+        [&] { internalDocumentSourceGraphLookupFrontierBatchSize.store(originalBatchSize); });
+    internalDocumentSourceGraphLookupFrontierBatchSize.store(2);
+
+    std::deque<DocumentSource::GetNextResult> inputs{Document{{"_id", 0}}};
+    auto inputMock = DocumentSourceMock::createForTest(std::move(inputs));
+
+    Document to1{{"_id", 1}, {"to", 1}};
+    Document to2{{"_id", 2}, {"to", 2}};
+    Document to3{{"_id", 3}, {"to", 3}};
+    std::deque<DocumentSource::GetNextResult> fromContents{
+        Document(to1), Document(to2), Document(to3)};
+
+    NamespaceString fromNs("test", "graph_lookup");
+    expCtx->setResolvedNamespaces(StringMap<ExpressionContext::ResolvedNamespace>{
+        {fromNs.coll().toString(), {fromNs, std::vector<BSONObj>()}}});
+    auto mongoInterface = std::make_shared<MockMongoInterface>(std::move(fromContents));
+    expCtx->mongoProcessInterface = mongoInterface;
+    auto graphLookupStage = DocumentSourceGraphLookUp::create(
+        expCtx,
+        fromNs,
+        "results",
+        "from",
+        "to",
+        ExpressionConstant::create(expCtx, Value(std::vector<Value>{Value(1), Value(2), Value(3)})),
+        boost::none,
+        boost::none,
+        boost::none,
+        boost::none);
+    graphLookupStage->setSource(inputMock.get());
+
+    auto next = graphLookupStage->getNext();
+    ASSERT_TRUE(next.isAdvanced());
+
+    // The three starting values are split into a batch of two and a batch of one, each of which is
+    // queried for separately. The mock returns every document for each query, so the results must
+    // still be de-duplicated across batches.
+    ASSERT_EQ(2, mongoInterface->numQueries());
+
+    auto resultsValue = next.getDocument().getField("results");
+    ASSERT(resultsValue.isArray());
+    auto resultsArray = resultsValue.getArray();
+    ASSERT_EQ(3U, resultsArray.size());
+    ASSERT(arrayContains(expCtx, resultsArray, Value(to1)));
+    ASSERT(arrayContains(expCtx, resultsArray, Value(to2)));
+    ASSERT(arrayContains(expCtx, resultsArray, Value(to3)));
+    ASSERT(graphLookupStage->getNext().isEOF());
+}
+
+TEST_F(DocumentSourceGraphLookUpTest, ShouldSpillDiscoveredDocumentsWhenOverMemoryLimit) {
+    auto expCtx = getExpCtx();
+    unittest::TempDir tempDir("DocumentSourceGraphLookUpTest");
+    expCtx->tempDir = tempDir.path();
+
+    const long long originalMaxMemoryBytes = internalDocumentSourceGraphLookupMaxMemoryBytes.load();
+    ON_BLOCK_EXIT(
+        [&] { internalDocumentSourceGraphLookupMaxMemoryBytes.store(originalMaxMemoryBytes); });
+    // Only a handful of the discovered documents fit in memory, but all of their _ids do.
+    internalDocumentSourceGraphLookupMaxMemoryBytes.store(4 * 1024);
+
+    const std::string padding(1024, 'x');
+    std::deque<DocumentSource::GetNextResult> fromContents;
+    for (int i = 0; i < 20; ++i) {
+        fromContents.emplace_back(Document{{"_id", i}, {"to", 0}, {"padding", padding}});
+    }
+
+    NamespaceString fromNs("test", "graph_lookup");
+    expCtx->setResolvedNamespaces(StringMap<ExpressionContext::ResolvedNamespace>{
+        {fromNs.coll().toString(), {fromNs, std::vector<BSONObj>()}}});
+    expCtx->mongoProcessInterface = std::make_shared<MockMongoInterface>(std::move(fromContents));
+
+    auto makeGraphLookupStage = [&](bool absorbUnwind) {
+        boost::optional<boost::intrusive_ptr<DocumentSourceUnwind>> unwind;
+        if (absorbUnwind) {
+            unwind = DocumentSourceUnwind::create(expCtx, "results", false, boost::none);
+        }
+        return DocumentSourceGraphLookUp::create(expCtx,
+                                                 fromNs,
+                                                 "results",
+                                                 "from",
+                                                 "to",
+                                                 ExpressionFieldPath::create(expCtx, "_id"),
+                                                 boost::none,
+                                                 boost::none,
+                                                 boost::none,
+                                                 unwind);
+    };
+
+    // Without allowDiskUse, the search fails once it exceeds the memory limit.
+    expCtx->allowDiskUse = false;
+    auto inputMock = DocumentSourceMock::createForTest(Document{{"_id", 0}});
+    auto graphLookupStage = makeGraphLookupStage(true);
+    graphLookupStage->setSource(inputMock.get());
+    ASSERT_THROWS_CODE(graphLookupStage->getNext(), AssertionException, 40099);
+
+    // Without an absorbed $unwind, every result would be returned in one in-memory array, so the
+    // search fails even with allowDiskUse.
+    expCtx->allowDiskUse = true;
+    inputMock = DocumentSourceMock::createForTest(Document{{"_id", 0}});
+    graphLookupStage = makeGraphLookupStage(false);
+    graphLookupStage->setSource(inputMock.get());
+    ASSERT_THROWS_CODE(graphLookupStage->getNext(), AssertionException, 40099);
+    ASSERT_FALSE(graphLookupStage->usedDisk());
+
+    // With allowDiskUse and an absorbed $unwind, the discovered documents are spilled and all of
+    // them are returned.
+    inputMock = DocumentSourceMock::createForTest(Document{{"_id", 0}});
+    graphLookupStage = makeGraphLookupStage(true);
+    graphLookupStage->setSource(inputMock.get());
+
+    std::vector<Value> results;
+    for (auto next = graphLookupStage->getNext(); next.isAdvanced();
+         next = graphLookupStage->getNext()) {
+        results.push_back(next.getDocument().getField("results"));
+    }
+    ASSERT_TRUE(graphLookupStage->usedDisk());
+    ASSERT_EQ(20U, results.size());
+    for (int i = 0; i < 20; ++i) {
+        ASSERT(arrayContains(
+            expCtx, results, Value(Document{{"_id", i}, {"to", 0}, {"padding", padding}})));
+    }
+}
+
+TEST_F(DocumentSourceGraphLookUpTest, ShouldSpillDocumentsWhichGrewAfterBeingDiscovered) {
+    auto expCtx = getExpCtx();
+    unittest::TempDir tempDir("DocumentSourceGraphLookUpTest");
+    expCtx->tempDir = tempDir.path();
+    expCtx->allowDiskUse = true;
+
+    const long long originalMaxMemoryBytes = internalDocumentSourceGraphLookupMaxMemoryBytes.load();
+    ON_BLOCK_EXIT(
+        [&] { internalDocumentSourceGraphLookupMaxMemoryBytes.store(originalMaxMemoryBytes); });
+    internalDocumentSourceGraphLookupMaxMemoryBytes.store(4 * 1024);
+
+    // The documents are backed by BSON, and the embedded document holding the long string
+    // 'connectToField' is only materialized when the document is cached, after its size was
+    // accounted for on discovery.
+    const std::string key(64, 'k');
+    const std::string padding(1024, 'x');
+    std::vector<BSONObj> fromDocs;
+    std::deque<DocumentSource::GetNextResult> fromContents;
+    for (int i = 0; i < 20; ++i) {
+        fromDocs.push_back(BSON("_id" << i << "from" << key << "to"
+                                      << BSON("key" << key << "other" << key) << "padding"
+                                      << padding));
+        fromContents.emplace_back(Document(fromDocs.back()));
+    }
+
+    NamespaceString fromNs("test", "graph_lookup");
+    expCtx->setResolvedNamespaces(StringMap<ExpressionContext::ResolvedNamespace>{
+        {fromNs.coll().toString(), {fromNs, std::vector<BSONObj>()}}});
+    expCtx->mongoProcessInterface = std::make_shared<MockMongoInterface>(std::move(fromContents));
+
+    auto inputMock = DocumentSourceMock::createForTest(Document{{"_id", 0}, {"start", key}});
+    auto graphLookupStage = DocumentSourceGraphLookUp::create(
+        expCtx,
+        fromNs,
+        "results",
+        "from",
+        "to.key",
+        ExpressionFieldPath::create(expCtx, "start"),
+        boost::none,
+        boost::none,
+        boost::none,
+        DocumentSourceUnwind::create(expCtx, "results", false, boost::none));
+    graphLookupStage->setSource(inputMock.get());
+
+    std::vector<Value> results;
+    for (auto next = graphLookupStage->getNext(); next.isAdvanced();
+         next = graphLookupStage->getNext()) {
+        results.push_back(next.getDocument().getField("results"));
+    }
+    ASSERT_TRUE(graphLookupStage->usedDisk());
+    ASSERT_EQ(fromDocs.size(), results.size());
+    for (auto&& doc : fromDocs) {
+        ASSERT(arrayContains(expCtx, results, Value(doc)));
+    }
+}
+
 }  // namespace
 }  // namespace mongo
@@ -41,6 +41,7 @@
 #include "mongo/db/pipeline/expression.h"
 #include "mongo/db/pipeline/expression_context.h"
 #include "mongo/db/pipeline/lite_parsed_document_source.h"
+#include "mongo/db/query/query_knobs_gen.h"
 #include "mongo/util/destructor_guard.h"
 
 namespace mongo {
@@ -116,9 +117,10 @@ DocumentSource::GetModPathsReturn GroupFromFirstDocumentTransformation::getModif
 std::unique_ptr<GroupFromFirstDocumentTransformation> GroupFromFirstDocumentTransformation::create(
     const intrusive_ptr<ExpressionContext>& expCtx,
     const std::string& groupId,
-    vector<pair<std::string, intrusive_ptr<Expression>>> accumulatorExprs) {
-    return std::make_unique<GroupFromFirstDocumentTransformation>(groupId,
-                                                                  std::move(accumulatorExprs));
+    vector<pair<std::string, intrusive_ptr<Expression>>> accumulatorExprs,
+    ExpectedInput expectedInput) {
+    return std::make_unique<GroupFromFirstDocumentTransformation>(
+        groupId, std::move(accumulatorExprs), expectedInput);
 }
 
 constexpr StringData DocumentSourceGroup::kStageName;
@@ -176,11 +178,11 @@ DocumentSource::GetNextResult DocumentSourceGroup::doGetNext() {
         accum->reset();  // Prep accumulators for a new group.
     }
 
-    if (_spilled) {
-        return getNextSpilled();
-    } else {
-        return getNextStandard();
+    auto result = _spilled ? getNextSpilled() : getNextStandard();
+    while (result.isEOF() && loadNextPartition()) {
+        result = _spilled ? getNextSpilled() : getNextStandard();
     }
+    return result;
 }
 
 DocumentSource::GetNextResult DocumentSourceGroup::getNextSpilled() {
@@ -204,21 +206,10 @@ DocumentSource::GetNextResult DocumentSourceGroup::getNextSpilled() {
     while (pExpCtx->getValueComparator().evaluate(_currentId == _firstPartOfNextGroup.first)) {
         // Inside of this loop, _firstPartOfNextGroup is the current data being processed.
         // At loop exit, it is the first value to be processed in the next group.
-        switch (numAccumulators) {  // mirrors switch in spill()
-            case 1:                 // Single accumulators serialize as a single Value.
-                _currentAccumulators[0]->process(_firstPartOfNextGroup.second, true);
-            case 0:  // No accumulators so no Values.
-                break;
-            default: {  // Multiple accumulators serialize as an array of Values.
-                const vector<Value>& accumulatorStates = _firstPartOfNextGroup.second.getArray();
-                for (size_t i = 0; i < numAccumulators; i++) {
-                    _currentAccumulators[i]->process(accumulatorStates[i], true);
-                }
-            }
-        }
+        mergeSpilledStates(_firstPartOfNextGroup.second, &_currentAccumulators);
 
         if (!_sorterIterator->more()) {
-            dispose();
+            finishReturningGroups();
             break;
         }
 
@@ -236,15 +227,30 @@ DocumentSource::GetNextResult DocumentSourceGroup::getNextStandard() {
     Document out = makeDocument(groupsIterator->first, groupsIterator->second, pExpCtx->needsMerge);
 
     if (++groupsIterator == _groups->end())
-        dispose();
+        finishReturningGroups();
 
     return std::move(out);
 }
 
+void DocumentSourceGroup::finishReturningGroups() {
+    if (_partitionsToLoad.empty()) {
+        dispose();
+        return;
+    }
+
+    // Free the groups which were just returned, but keep the partitions which are still on disk.
+    _groups = pExpCtx->getValueComparator().makeUnorderedValueMap<Accumulators>();
+    _sorterIterator.reset();
+    groupsIterator = _groups->end();
+}
+
 void DocumentSourceGroup::doDispose() {
     // Free our resources.
     _groups = pExpCtx->getValueComparator().makeUnorderedValueMap<Accumulators>();
     _sorterIterator.reset();
+    _partitionRuns.clear();
+    _partitionsToLoad.clear();
+    _compiledExpressions.reset();
 
     // Make us look done.
     groupsIterator = _groups->end();
@@ -263,6 +269,9 @@ intrusive_ptr<DocumentSource> DocumentSourceGroup::optimize() {
         accumulatedField.expr.argument = accumulatedField.expr.argument->optimize();
     }
 
+    // Any program compiled from the expressions they replaced is stale.
+    _compiledExpressions.reset();
+
     return this;
 }
 
@@ -379,7 +388,9 @@ DocumentSourceGroup::DocumentSourceGroup(const intrusive_ptr<ExpressionContext>&
                                          : internalDocumentSourceGroupMaxMemoryBytes.load()},
       _initialized(false),
       _groups(pExpCtx->getValueComparator().makeUnorderedValueMap<Accumulators>()),
-      _spilled(false) {
+      _spilled(false),
+      _numSpillPartitions(
+          static_cast<size_t>(internalDocumentSourceGroupSpillPartitions.load())) {
     if (!pExpCtx->inMongos && (pExpCtx->allowDiskUse || kDebugBuild)) {
         // We spill to disk in debug mode, regardless of allowDiskUse, to stress the system.
         _fileName = pExpCtx->tempDir + "/" + nextFileName();
@@ -390,6 +401,9 @@ DocumentSourceGroup::~DocumentSourceGroup() {
     if (_ownsFileDeletion) {
         DESTRUCTOR_GUARD(boost::filesystem::remove(_fileName));
     }
+    if (!_partitionFileName.empty()) {
+        DESTRUCTOR_GUARD(boost::filesystem::remove(_partitionFileName));
+    }
 }
 
 void DocumentSourceGroup::addAccumulator(AccumulationStatement accumulationStatement) {
@@ -511,42 +525,35 @@ private:
 DocumentSource::GetNextResult DocumentSourceGroup::initialize() {
     const size_t numAccumulators = _accumulatedFields.size();
 
+    if (!_compiledExpressions && internalQueryEnableCompiledExpressions.load()) {
+        compileExpressions();
+    }
+
     // Barring any pausing, this loop exhausts 'pSource' and populates '_groups'.
     GetNextResult input = pSource->getNext();
 
     for (; input.isAdvanced(); input = pSource->getNext()) {
         if (_memoryTracker.shouldSpillWithAttemptToSaveMemory([this]() { return freeMemory(); })) {
-            _sortedFiles.push_back(spill());
+            if (_numSpillPartitions > 0) {
+                spillPartitions();
+            } else {
+                _sortedFiles.push_back(spill());
+            }
         }
 
         // We release the result document here so that it does not outlive the end of this loop
         // iteration. Not releasing could lead to an array copy when this group follows an unwind.
         auto rootDocument = input.releaseDocument();
-        Value id = computeId(rootDocument);
-
-        // Look for the _id value in the map. If it's not there, add a new entry with a blank
-        // accumulator. This is done in a somewhat odd way in order to avoid hashing 'id' and
-        // looking it up in '_groups' multiple times.
-        const size_t oldSize = _groups->size();
-        vector<intrusive_ptr<AccumulatorState>>& group = (*_groups)[id];
-        const bool inserted = _groups->size() != oldSize;
-
-        if (inserted) {
-            _memoryTracker.memoryUsageBytes += id.getApproximateSize();
-
-            // Initialize and add the accumulators
-            Value expandedId = expandId(id);
-            Document idDoc =
-                expandedId.getType() == BSONType::Object ? expandedId.getDocument() : Document();
-            group.reserve(numAccumulators);
-            for (auto&& accumulatedField : _accumulatedFields) {
-                auto accum = accumulatedField.makeAccumulator();
-                Value initializerValue =
-                    accumulatedField.expr.initializer->evaluate(idDoc, &pExpCtx->variables);
-                accum->startNewGroup(initializerValue);
-                group.push_back(accum);
-            }
-        } else {
+        if (_compiledExpressions) {
+            _compiledExpressions->start(rootDocument);
+        }
+        // The group key and the accumulator arguments may be retained until the $group completes,
+        // so they are copied out of the batch's arena, if any.
+        Value id = computeId(rootDocument).copyOutOfArena();
+
+        bool inserted;
+        Accumulators& group = findOrCreateGroup(id, &inserted);
+        if (!inserted) {
             for (auto&& groupObj : group) {
                 // subtract old mem usage. New usage added back after processing.
                 _memoryTracker.memoryUsageBytes -= groupObj->memUsageForSorter();
@@ -557,9 +564,13 @@ DocumentSource::GetNextResult DocumentSourceGroup::initialize() {
         dassert(numAccumulators == group.size());
 
         for (size_t i = 0; i < numAccumulators; i++) {
-            group[i]->process(
-                _accumulatedFields[i].expr.argument->evaluate(rootDocument, &pExpCtx->variables),
-                _doingMerge);
+            group[i]->process((_compiledExpressions
+                                   ? _compiledExpressions->evaluate(_idExpressions.size() + i,
+                                                                    &pExpCtx->variables)
+                                   : _accumulatedFields[i].expr.argument->evaluate(
+                                         rootDocument, &pExpCtx->variables))
+                                  .copyOutOfArena(),
+                              _doingMerge);
 
             _memoryTracker.memoryUsageBytes += group[i]->memUsageForSorter();
         }
@@ -585,30 +596,18 @@ DocumentSource::GetNextResult DocumentSourceGroup::initialize() {
         }
         case DocumentSource::GetNextResult::ReturnStatus::kEOF: {
             // Do any final steps necessary to prepare to output results.
-            if (!_sortedFiles.empty()) {
-                _spilled = true;
-                if (!_groups->empty()) {
-                    _sortedFiles.push_back(spill());
+            if (!_partitionRuns.empty()) {
+                // Return the groups of the resident partitions first, and then read back the
+                // spilled partitions one at a time.
+                writeSpilledPartitions();
+                for (size_t partition = 0; partition < _numSpillPartitions; ++partition) {
+                    if (_partitionIsSpilled[partition]) {
+                        _partitionsToLoad.push_back(partition);
+                    }
                 }
-
-                // We won't be using groups again so free its memory.
-                _groups = pExpCtx->getValueComparator().makeUnorderedValueMap<Accumulators>();
-
-                _sorterIterator.reset(Sorter<Value, Value>::Iterator::merge(
-                    _sortedFiles,
-                    _fileName,
-                    SortOptions(),
-                    SorterComparator(pExpCtx->getValueComparator())));
-                _ownsFileDeletion = false;
-
-                // prepare current to accumulate data
-                _currentAccumulators.reserve(numAccumulators);
-                for (auto&& accumulatedField : _accumulatedFields) {
-                    _currentAccumulators.push_back(accumulatedField.makeAccumulator());
-                }
-
-                verify(_sorterIterator->more());  // we put data in, we should get something out.
-                _firstPartOfNextGroup = _sorterIterator->next();
+                groupsIterator = _groups->begin();
+            } else if (!_sortedFiles.empty()) {
+                startMergingSortedFiles();
             } else {
                 // start the group iterator
                 groupsIterator = _groups->begin();
@@ -639,42 +638,243 @@ shared_ptr<Sorter<Value, Value>::Iterator> DocumentSourceGroup::spill() {
 
     SortedFileWriter<Value, Value> writer(
         SortOptions().TempDir(pExpCtx->tempDir), _fileName, _nextSortedFileWriterOffset);
-    switch (_accumulatedFields.size()) {  // same as ptrs[i]->second.size() for all i.
+    for (size_t i = 0; i < ptrs.size(); i++) {
+        writer.addAlreadySorted(ptrs[i]->first, getSpilledStates(ptrs[i]->second));
+    }
+
+    _groups->clear();
+
+    Sorter<Value, Value>::Iterator* iteratorPtr = writer.done();
+    _nextSortedFileWriterOffset = writer.getFileEndOffset();
+    return shared_ptr<Sorter<Value, Value>::Iterator>(iteratorPtr);
+}
+
+Value DocumentSourceGroup::getSpilledStates(const Accumulators& accums) const {
+    switch (_accumulatedFields.size()) {  // same as accums.size()
         case 0:                           // no values, essentially a distinct
-            for (size_t i = 0; i < ptrs.size(); i++) {
-                writer.addAlreadySorted(ptrs[i]->first, Value());
-            }
-            break;
+            return Value();
 
         case 1:  // just one value, use optimized serialization as single Value
-            for (size_t i = 0; i < ptrs.size(); i++) {
-                writer.addAlreadySorted(ptrs[i]->first,
-                                        ptrs[i]->second[0]->getValue(/*toBeMerged=*/true));
+            return accums[0]->getValue(/*toBeMerged=*/true);
+
+        default: {  // multiple values, serialize as array-typed Value
+            vector<Value> states;
+            states.reserve(accums.size());
+            for (auto&& accum : accums) {
+                states.push_back(accum->getValue(/*toBeMerged=*/true));
             }
+            return Value(std::move(states));
+        }
+    }
+}
+
+void DocumentSourceGroup::mergeSpilledStates(const Value& states, Accumulators* accums) const {
+    switch (_accumulatedFields.size()) {  // mirrors switch in getSpilledStates()
+        case 0:                           // No accumulators so no Values.
+            break;
+
+        case 1:  // Single accumulators serialize as a single Value.
+            (*accums)[0]->process(states, true);
             break;
 
-        default:  // multiple values, serialize as array-typed Value
-            for (size_t i = 0; i < ptrs.size(); i++) {
-                vector<Value> accums;
-                for (size_t j = 0; j < ptrs[i]->second.size(); j++) {
-                    accums.push_back(ptrs[i]->second[j]->getValue(/*toBeMerged=*/true));
+        default: {  // Multiple accumulators serialize as an array of Values.
+            const vector<Value>& accumulatorStates = states.getArray();
+            for (size_t i = 0; i < accums->size(); i++) {
+                (*accums)[i]->process(accumulatorStates[i], true);
+            }
+        }
+    }
+}
+
+size_t DocumentSourceGroup::partitionOf(const Value& id) const {
+    // Mix the hash so that the partitions are independent of the buckets of '_groups', which are
+    // chosen from the same hash.
+    const uint64_t hash = pExpCtx->getValueComparator().hash(id);
+    return ((hash * 0x9E3779B97F4A7C15ULL) >> 32) % _numSpillPartitions;
+}
+
+void DocumentSourceGroup::spillPartitions() {
+    _usedDisk = true;
+    if (_partitionRuns.empty()) {
+        _partitionRuns.resize(_numSpillPartitions);
+        _partitionIsSpilled.assign(_numSpillPartitions, false);
+        _partitionFileName = pExpCtx->tempDir + "/" + nextFileName();
+    }
+
+    vector<size_t> partitionBytes(_numSpillPartitions, 0);
+    for (auto&& group : *_groups) {
+        size_t& bytes = partitionBytes[partitionOf(group.first)];
+        bytes += group.first.getApproximateSize();
+        for (auto&& accum : group.second) {
+            bytes += accum->memUsageForSorter();
+        }
+    }
+
+    size_t residentBytes = 0;
+    for (size_t partition = 0; partition < _numSpillPartitions; ++partition) {
+        if (!_partitionIsSpilled[partition]) {
+            residentBytes += partitionBytes[partition];
+        }
+    }
+    for (size_t partition = _numSpillPartitions;
+         partition-- > 0 && residentBytes > _memoryTracker.maxMemoryUsageBytes / 2;) {
+        if (!_partitionIsSpilled[partition]) {
+            _partitionIsSpilled[partition] = true;
+            residentBytes -= partitionBytes[partition];
+        }
+    }
+
+    writeSpilledPartitions();
+    _memoryTracker.memoryUsageBytes = residentBytes;
+}
+
+void DocumentSourceGroup::writeSpilledPartitions() {
+    vector<vector<GroupsMap::iterator>> groupsByPartition(_numSpillPartitions);
+    for (auto it = _groups->begin(); it != _groups->end(); ++it) {
+        const size_t partition = partitionOf(it->first);
+        if (_partitionIsSpilled[partition]) {
+            groupsByPartition[partition].push_back(it);
+        }
+    }
+
+    // The runs of each partition are read back in the order they were written, which preserves
+    // the order in which documents were processed for accumulators such as $first.
+    for (size_t partition = 0; partition < _numSpillPartitions; ++partition) {
+        if (groupsByPartition[partition].empty()) {
+            continue;
+        }
+
+        SortedFileWriter<Value, Value> writer(SortOptions().TempDir(pExpCtx->tempDir),
+                                              _partitionFileName,
+                                              _nextPartitionFileOffset);
+        for (auto&& it : groupsByPartition[partition]) {
+            writer.addAlreadySorted(it->first, getSpilledStates(it->second));
+            _groups->erase(it);
+        }
+        _partitionRuns[partition].emplace_back(writer.done());
+        _nextPartitionFileOffset = writer.getFileEndOffset();
+    }
+}
+
+bool DocumentSourceGroup::loadNextPartition() {
+    if (_partitionsToLoad.empty()) {
+        return false;
+    }
+
+    const size_t partition = _partitionsToLoad.front();
+    _partitionsToLoad.pop_front();
+    auto runs = std::move(_partitionRuns[partition]);
+
+    _groups = pExpCtx->getValueComparator().makeUnorderedValueMap<Accumulators>();
+    _sortedFiles.clear();
+    _spilled = false;
+    _memoryTracker.memoryUsageBytes = 0;
+    if (!_ownsFileDeletion) {
+        // The sorted runs of a previous partition were handed over to a MergeIterator, which
+        // deletes their file, so spill this partition to a new one.
+        _fileName = pExpCtx->tempDir + "/" + nextFileName();
+        _nextSortedFileWriterOffset = 0;
+        _ownsFileDeletion = true;
+    }
+
+    for (auto&& run : runs) {
+        run->openSource();
+        while (run->more()) {
+            if (_memoryTracker.shouldSpillWithAttemptToSaveMemory(
+                    [this]() { return freeMemory(); })) {
+                _sortedFiles.push_back(spill());
+            }
+
+            auto next = run->next();
+            bool inserted;
+            Accumulators& group = findOrCreateGroup(next.first, &inserted);
+            if (!inserted) {
+                // The initial memory of new accumulators was never added, so it is not subtracted.
+                for (auto&& accum : group) {
+                    _memoryTracker.memoryUsageBytes -= accum->memUsageForSorter();
                 }
-                writer.addAlreadySorted(ptrs[i]->first, Value(std::move(accums)));
             }
-            break;
+            mergeSpilledStates(next.second, &group);
+            for (auto&& accum : group) {
+                _memoryTracker.memoryUsageBytes += accum->memUsageForSorter();
+            }
+        }
+        run->closeSource();
     }
 
-    _groups->clear();
+    if (!_sortedFiles.empty()) {
+        startMergingSortedFiles();
+    } else {
+        groupsIterator = _groups->begin();
+    }
+    return true;
+}
 
-    Sorter<Value, Value>::Iterator* iteratorPtr = writer.done();
-    _nextSortedFileWriterOffset = writer.getFileEndOffset();
-    return shared_ptr<Sorter<Value, Value>::Iterator>(iteratorPtr);
+void DocumentSourceGroup::startMergingSortedFiles() {
+    _spilled = true;
+    if (!_groups->empty()) {
+        _sortedFiles.push_back(spill());
+    }
+
+    // We won't be using groups again so free its memory.
+    _groups = pExpCtx->getValueComparator().makeUnorderedValueMap<Accumulators>();
+
+    _sorterIterator.reset(
+        Sorter<Value, Value>::Iterator::merge(_sortedFiles,
+                                              _fileName,
+                                              SortOptions(),
+                                              SorterComparator(pExpCtx->getValueComparator())));
+    _ownsFileDeletion = false;
+
+    // prepare current to accumulate data
+    _currentAccumulators.clear();
+    _currentAccumulators.reserve(_accumulatedFields.size());
+    for (auto&& accumulatedField : _accumulatedFields) {
+        _currentAccumulators.push_back(accumulatedField.makeAccumulator());
+    }
+
+    verify(_sorterIterator->more());  // we put data in, we should get something out.
+    _firstPartOfNextGroup = _sorterIterator->next();
+}
+
+DocumentSourceGroup::Accumulators& DocumentSourceGroup::findOrCreateGroup(const Value& id,
+                                                                          bool* inserted) {
+    // Look for the _id value in the map. If it's not there, add a new entry with a blank
+    // accumulator. This is done in a somewhat odd way in order to avoid hashing 'id' and
+    // looking it up in '_groups' multiple times.
+    const size_t oldSize = _groups->size();
+    Accumulators& group = (*_groups)[id];
+    *inserted = _groups->size() != oldSize;
+
+    if (*inserted) {
+        _memoryTracker.memoryUsageBytes += id.getApproximateSize();
+
+        // Initialize and add the accumulators
+        Value expandedId = expandId(id);
+        Document idDoc =
+            expandedId.getType() == BSONType::Object ? expandedId.getDocument() : Document();
+        group.reserve(_accumulatedFields.size());
+        for (auto&& accumulatedField : _accumulatedFields) {
+            auto accum = accumulatedField.makeAccumulator();
+            Value initializerValue =
+                accumulatedField.expr.initializer->evaluate(idDoc, &pExpCtx->variables);
+            accum->startNewGroup(initializerValue);
+            group.push_back(accum);
+        }
+    }
+    return group;
 }
 
 Value DocumentSourceGroup::computeId(const Document& root) {
+    // The compiled program, if any, has already been started on 'root'.
+    auto evaluateId = [&](size_t i) {
+        return _compiledExpressions ? _compiledExpressions->evaluate(i, &pExpCtx->variables)
+                                    : _idExpressions[i]->evaluate(root, &pExpCtx->variables);
+    };
+
     // If only one expression, return result directly
     if (_idExpressions.size() == 1) {
-        Value retValue = _idExpressions[0]->evaluate(root, &pExpCtx->variables);
+        Value retValue = evaluateId(0);
         return retValue.missing() ? Value(BSONNULL) : std::move(retValue);
     }
 
@@ -682,11 +882,21 @@ Value DocumentSourceGroup::computeId(const Document& root) {
     vector<Value> vals;
     vals.reserve(_idExpressions.size());
     for (size_t i = 0; i < _idExpressions.size(); i++) {
-        vals.push_back(_idExpressions[i]->evaluate(root, &pExpCtx->variables));
+        vals.push_back(evaluateId(i));
     }
     return Value(std::move(vals));
 }
 
+void DocumentSourceGroup::compileExpressions() {
+    _compiledExpressions = std::make_unique<CompiledExpression>();
+    for (auto&& idExpression : _idExpressions) {
+        _compiledExpressions->add(idExpression.get());
+    }
+    for (auto&& accumulatedField : _accumulatedFields) {
+        _compiledExpressions->add(accumulatedField.expr.argument.get());
+    }
+}
+
 Value DocumentSourceGroup::expandId(const Value& val) {
     // _id doesn't get wrapped in a document
     if (_idFieldNames.empty())
@@ -813,12 +1023,16 @@ DocumentSourceGroup::rewriteGroupAsTransformOnFirstDocument() const {
 
     const auto groupId = fieldPath.tail().fullPath();
 
-    // We can't do this transformation if there are any non-$first accumulators.
-    for (auto&& accumulator : _accumulatedFields) {
-        if (AccumulatorDocumentsNeeded::kFirstDocument !=
-            accumulator.makeAccumulator()->documentsNeeded()) {
+    // We can only do this transformation if the accumulators are either all $first or all $last,
+    // so that a single document of each group provides every accumulated value.
+    auto documentsNeeded = AccumulatorDocumentsNeeded::kFirstDocument;
+    for (size_t i = 0; i < _accumulatedFields.size(); ++i) {
+        const auto needed = _accumulatedFields[i].makeAccumulator()->documentsNeeded();
+        if (AccumulatorDocumentsNeeded::kAllDocuments == needed ||
+            (i > 0 && needed != documentsNeeded)) {
             return nullptr;
         }
+        documentsNeeded = needed;
     }
 
     std::vector<std::pair<std::string, boost::intrusive_ptr<Expression>>> fields;
@@ -827,11 +1041,17 @@ DocumentSourceGroup::rewriteGroupAsTransformOnFirstDocument() const {
     for (auto&& accumulator : _accumulatedFields) {
         fields.push_back(std::make_pair(accumulator.fieldName, accumulator.expr.argument));
 
-        // Since we don't attempt this transformation for non-$first accumulators,
-        // the initializer should always be trivial.
+        // Since we don't attempt this transformation for accumulators other than $first and
+        // $last, the initializer should always be trivial.
     }
 
-    return GroupFromFirstDocumentTransformation::create(pExpCtx, groupId, std::move(fields));
+    return GroupFromFirstDocumentTransformation::create(
+        pExpCtx,
+        groupId,
+        std::move(fields),
+        AccumulatorDocumentsNeeded::kLastDocument == documentsNeeded
+            ? GroupFromFirstDocumentTransformation::ExpectedInput::kLastDocument
+            : GroupFromFirstDocumentTransformation::ExpectedInput::kFirstDocument);
 }
 
 }  // namespace mongo
@@ -29,11 +29,13 @@
 
 #pragma once
 
+#include <deque>
 #include <memory>
 #include <utility>
 
 #include "mongo/db/pipeline/accumulation_statement.h"
 #include "mongo/db/pipeline/accumulator.h"
+#include "mongo/db/pipeline/compiled_expression.h"
 #include "mongo/db/pipeline/document_source.h"
 #include "mongo/db/pipeline/transformer_interface.h"
 #include "mongo/db/sorter/sorter.h"
@@ -44,14 +46,27 @@ namespace mongo {
  * GroupFromFirstTransformation consists of a list of (field name, expression pairs). It returns a
  * document synthesized by assigning each field name in the output document to the result of
  * evaluating the corresponding expression. If the expression evaluates to missing, we assign a
- * value of BSONNULL. This is necessary to match the semantics of $first for missing fields.
+ * value of BSONNULL. This is necessary to match the semantics of $first and $last for missing
+ * fields.
  */
 class GroupFromFirstDocumentTransformation final : public TransformerInterface {
 public:
+    /**
+     * Which document of each group the transformation must be applied to, in the order of the
+     * $group's input. A $group whose accumulators are all $last is answered by the last document.
+     */
+    enum class ExpectedInput {
+        kFirstDocument,
+        kLastDocument,
+    };
+
     GroupFromFirstDocumentTransformation(
         const std::string& groupId,
-        std::vector<std::pair<std::string, boost::intrusive_ptr<Expression>>> accumulatorExprs)
-        : _accumulatorExprs(std::move(accumulatorExprs)), _groupId(groupId) {}
+        std::vector<std::pair<std::string, boost::intrusive_ptr<Expression>>> accumulatorExprs,
+        ExpectedInput expectedInput = ExpectedInput::kFirstDocument)
+        : _accumulatorExprs(std::move(accumulatorExprs)),
+          _groupId(groupId),
+          _expectedInput(expectedInput) {}
 
     TransformerType getType() const final {
         return TransformerType::kGroupFromFirstDocument;
@@ -65,6 +80,10 @@ public:
         return _groupId;
     }
 
+    ExpectedInput expectedInput() const {
+        return _expectedInput;
+    }
+
     Document applyTransformation(const Document& input) final;
 
     void optimize() final;
@@ -79,11 +98,13 @@ public:
     static std::unique_ptr<GroupFromFirstDocumentTransformation> create(
         const boost::intrusive_ptr<ExpressionContext>& expCtx,
         const std::string& groupId,
-        std::vector<std::pair<std::string, boost::intrusive_ptr<Expression>>> accumulatorExprs);
+        std::vector<std::pair<std::string, boost::intrusive_ptr<Expression>>> accumulatorExprs,
+        ExpectedInput expectedInput = ExpectedInput::kFirstDocument);
 
 private:
     std::vector<std::pair<std::string, boost::intrusive_ptr<Expression>>> _accumulatorExprs;
     std::string _groupId;
+    ExpectedInput _expectedInput;
 };
 
 class DocumentSourceGroup final : public DocumentSource {
@@ -229,6 +250,55 @@ private:
      */
     std::shared_ptr<Sorter<Value, Value>::Iterator> spill();
 
+    /**
+     * The alternative to spill() when partitioned spilling is enabled. Marks partitions as spilled,
+     * starting from the last one, until the groups of the partitions which are still resident take
+     * up at most half of the memory budget, and then writes the in-memory groups of every spilled
+     * partition to the partition file. The groups of resident partitions stay in memory.
+     */
+    void spillPartitions();
+
+    /**
+     * Appends the in-memory groups of every spilled partition to that partition's data in the
+     * partition file, and removes them from '_groups'.
+     */
+    void writeSpilledPartitions();
+
+    /**
+     * Reads the next spilled partition back into '_groups', merging the partial groups written for
+     * each key, and prepares to return its groups. Falls back to spill() if a single partition does
+     * not fit in memory. Returns false if there are no more spilled partitions.
+     */
+    bool loadNextPartition();
+
+    /**
+     * Called once all the groups held in memory or in '_sortedFiles' have been returned.
+     */
+    void finishReturningGroups();
+
+    /**
+     * Prepares to return the groups spilled to '_sortedFiles' by merging the sorted files.
+     */
+    void startMergingSortedFiles();
+
+    /**
+     * Returns the group for 'id' in '_groups', adding a group with newly initialized accumulators
+     * if there is none. Sets 'inserted' to whether the group was added.
+     */
+    Accumulators& findOrCreateGroup(const Value& id, bool* inserted);
+
+    /**
+     * Returns the partition which the group with key 'id' is spilled to.
+     */
+    size_t partitionOf(const Value& id) const;
+
+    /**
+     * Serializes the partial states of 'accums' as they are written to spill files, and merges
+     * such serialized states into 'accums'.
+     */
+    Value getSpilledStates(const Accumulators& accums) const;
+    void mergeSpilledStates(const Value& states, Accumulators* accums) const;
+
     /**
      * If we ran out of memory, finish all the pending operations so that some memory
      * can be freed.
@@ -242,6 +312,11 @@ private:
      */
     Value computeId(const Document& root);
 
+    /**
+     * Compiles the group keys and accumulator arguments into '_compiledExpressions'.
+     */
+    void compileExpressions();
+
     /**
      * Converts the internal representation of the group key to the _id shape specified by the
      * user.
@@ -267,6 +342,10 @@ private:
     std::vector<std::string> _idFieldNames;  // used when id is a document
     std::vector<boost::intrusive_ptr<Expression>> _idExpressions;
 
+    // The group keys followed by the accumulator arguments, compiled into a single program if
+    // compiled expressions are enabled.
+    std::unique_ptr<CompiledExpression> _compiledExpressions;
+
     bool _initialized;
 
     Value _currentId;
@@ -287,6 +366,19 @@ private:
     std::unique_ptr<Sorter<Value, Value>::Iterator> _sorterIterator;
 
     std::pair<Value, Value> _firstPartOfNextGroup;
+
+    // The number of partitions to spill to, or zero to spill sorted runs of all the groups.
+    const size_t _numSpillPartitions;
+
+    // The following are only used once spillPartitions() has been called. For each partition, the
+    // ranges of the partition file holding its partial groups in the order they were written.
+    std::vector<std::vector<std::shared_ptr<Sorter<Value, Value>::Iterator>>> _partitionRuns;
+    std::vector<bool> _partitionIsSpilled;
+    std::string _partitionFileName;
+    std::streampos _nextPartitionFileOffset = 0;
+
+    // Spilled partitions which are yet to be read back and returned.
+    std::deque<size_t> _partitionsToLoad;
 };
 
 }  // namespace mongo
@@ -49,11 +49,13 @@
 #include "mongo/db/pipeline/document_source_mock.h"
 #include "mongo/db/pipeline/expression.h"
 #include "mongo/db/pipeline/expression_context_for_test.h"
+#include "mongo/db/query/query_knobs_gen.h"
 #include "mongo/db/query/query_test_service_context.h"
 #include "mongo/dbtests/dbtests.h"
 #include "mongo/stdx/unordered_set.h"
 #include "mongo/unittest/temp_dir.h"
 #include "mongo/unittest/unittest.h"
+#include "mongo/util/scopeguard.h"
 
 namespace mongo {
 
@@ -145,6 +147,93 @@ TEST_F(DocumentSourceGroupTest, ShouldBeAbleToPauseLoadingWhileSpilled) {
     ASSERT_EQ(idSet.count(2), 1UL);
 }
 
+TEST_F(DocumentSourceGroupTest, ShouldAggregateSpilledPartitionsCorrectly) {
+    auto expCtx = getExpCtx();
+
+    // Allow the $group stage to spill to disk, dividing its groups into hash partitions.
+    TempDir tempDir("DocumentSourceGroupTest");
+    expCtx->tempDir = tempDir.path();
+    expCtx->allowDiskUse = true;
+    const size_t maxMemoryUsageBytes = 1000;
+    const int originalSpillPartitions = internalDocumentSourceGroupSpillPartitions.load();
+    ON_BLOCK_EXIT(
+        [&] { internalDocumentSourceGroupSpillPartitions.store(originalSpillPartitions); });
+    internalDocumentSourceGroupSpillPartitions.store(4);
+
+    auto&& parser = AccumulationStatement::getParser("$sum", boost::none);
+    auto accumulatorArg = BSON(""
+                               << "$x");
+    auto accExpr = parser(expCtx, accumulatorArg.firstElement(), expCtx->variablesParseState);
+    AccumulationStatement sumStatement{"total", accExpr};
+    auto groupByExpression =
+        ExpressionFieldPath::parse(expCtx, "$_id", expCtx->variablesParseState);
+    auto group = DocumentSourceGroup::create(
+        expCtx, groupByExpression, {sumStatement}, maxMemoryUsageBytes);
+
+    // Revisit every group several times so that groups are merged across spills.
+    const int numGroups = 100;
+    const int numRounds = 5;
+    deque<DocumentSource::GetNextResult> inputs;
+    for (int round = 0; round < numRounds; ++round) {
+        for (int id = 0; id < numGroups; ++id) {
+            inputs.emplace_back(Document{{"_id", id}, {"x", id}});
+        }
+    }
+    auto mock = DocumentSourceMock::createForTest(std::move(inputs));
+    group->setSource(mock.get());
+
+    map<int, long long> totals;
+    for (auto result = group->getNext(); result.isAdvanced(); result = group->getNext()) {
+        auto doc = result.releaseDocument();
+        ASSERT_TRUE(totals.emplace(doc["_id"].coerceToInt(), doc["total"].coerceToLong()).second);
+    }
+    ASSERT_TRUE(group->getNext().isEOF());
+    ASSERT_TRUE(group->usedDisk());
+
+    ASSERT_EQ(totals.size(), static_cast<size_t>(numGroups));
+    for (auto&& [id, total] : totals) {
+        ASSERT_EQ(total, static_cast<long long>(id) * numRounds);
+    }
+}
+
+TEST_F(DocumentSourceGroupTest, ShouldGroupWithCompiledExpressions) {
+    auto expCtx = getExpCtx();
+    const bool originalEnableCompiledExpressions = internalQueryEnableCompiledExpressions.load();
+    ON_BLOCK_EXIT([&] {
+        internalQueryEnableCompiledExpressions.store(originalEnableCompiledExpressions);
+    });
+    internalQueryEnableCompiledExpressions.store(true);
+
+    auto spec = fromjson(
+        "{$group: {_id: {k: '$a.k', big: {$gt: ['$a.v', 1]}}, total: {$sum: '$a.v'}, "
+        "values: {$push: '$a.list.v'}}}");
+    auto group = DocumentSourceGroup::createFromBson(spec.firstElement(), expCtx)->optimize();
+    auto mock = DocumentSourceMock::createForTest(
+        {Document{{"a", Document{{"k", 1}, {"v", 1}}}},
+         Document{{"a", Document{{"k", 1}, {"v", 2}, {"list", {Document{{"v", 3}}}}}}},
+         Document{{"a", Document{{"k", 1}, {"v", 3}}}},
+         Document{{"a", Document{{"k", 2}, {"v", 1}, {"list", Document{{"v", 4}}}}}}});
+    group->setSource(mock.get());
+
+    std::vector<Document> results;
+    for (auto result = group->getNext(); result.isAdvanced(); result = group->getNext()) {
+        results.push_back(result.releaseDocument());
+    }
+    std::sort(results.begin(), results.end(), [](const auto& lhs, const auto& rhs) {
+        return Document::compare(lhs, rhs, nullptr) < 0;
+    });
+
+    ASSERT_EQ(results.size(), 3U);
+    ASSERT_DOCUMENT_EQ(
+        results[0],
+        Document(fromjson("{_id: {k: 1, big: false}, total: 1, values: []}")));
+    ASSERT_DOCUMENT_EQ(
+        results[1],
+        Document(fromjson("{_id: {k: 1, big: true}, total: 5, values: [[3]]}")));
+    ASSERT_DOCUMENT_EQ(results[2],
+                       Document(fromjson("{_id: {k: 2, big: false}, total: 1, values: [4]}")));
+}
+
 TEST_F(DocumentSourceGroupTest, ShouldErrorIfNotAllowedToSpillToDiskAndResultSetIsTooLarge) {
     auto expCtx = getExpCtx();
     const size_t maxMemoryUsageBytes = 1000;
@@ -240,6 +329,43 @@ TEST_F(DocumentSourceGroupTest, ShouldNotReportDottedGroupKeyAsARename) {
     ASSERT_EQ(modifiedPathsRet.renames.size(), 0UL);
 }
 
+std::unique_ptr<GroupFromFirstDocumentTransformation> rewriteGroup(
+    const intrusive_ptr<ExpressionContext>& expCtx, const BSONObj& spec) {
+    auto source =
+        DocumentSourceGroup::createFromBson(BSON("$group" << spec).firstElement(), expCtx);
+    auto group = dynamic_cast<DocumentSourceGroup*>(source.get());
+    ASSERT(group);
+    return group->rewriteGroupAsTransformOnFirstDocument();
+}
+
+TEST_F(DocumentSourceGroupTest, ShouldRewriteGroupWithOnlyFirstAccumulators) {
+    auto rewritten = rewriteGroup(getExpCtx(), fromjson("{_id: '$x', y: {$first: '$y'}}"));
+    ASSERT(rewritten);
+    ASSERT_EQ(rewritten->groupId(), "x");
+    ASSERT(rewritten->expectedInput() ==
+           GroupFromFirstDocumentTransformation::ExpectedInput::kFirstDocument);
+}
+
+TEST_F(DocumentSourceGroupTest, ShouldRewriteGroupWithOnlyLastAccumulators) {
+    auto rewritten = rewriteGroup(getExpCtx(),
+                                  fromjson("{_id: '$x', y: {$last: '$y'}, z: {$last: '$z'}}"));
+    ASSERT(rewritten);
+    ASSERT_EQ(rewritten->groupId(), "x");
+    ASSERT(rewritten->expectedInput() ==
+           GroupFromFirstDocumentTransformation::ExpectedInput::kLastDocument);
+
+    auto output = rewritten->applyTransformation(Document{{"x", 1}, {"y", 2}});
+    ASSERT_DOCUMENT_EQ(output, (Document{{"_id", 1}, {"y", 2}, {"z", BSONNULL}}));
+}
+
+TEST_F(DocumentSourceGroupTest, ShouldNotRewriteGroupMixingFirstAndLastAccumulators) {
+    ASSERT_FALSE(
+        rewriteGroup(getExpCtx(), fromjson("{_id: '$x', y: {$first: '$y'}, z: {$last: '$z'}}")));
+    ASSERT_FALSE(
+        rewriteGroup(getExpCtx(), fromjson("{_id: '$x', y: {$last: '$y'}, z: {$first: '$z'}}")));
+    ASSERT_FALSE(rewriteGroup(getExpCtx(), fromjson("{_id: '$x', y: {$max: '$y'}}")));
+}
+
 BSONObj toBson(const intrusive_ptr<DocumentSource>& source) {
     vector<Value> arr;
     source->serializeToArray(arr);
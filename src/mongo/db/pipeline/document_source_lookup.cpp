@@ -27,10 +27,13 @@
  *    it in the license file.
  */
 
+#define MONGO_LOGV2_DEFAULT_COMPONENT ::mongo::logv2::LogComponent::kQuery
+
 #include "mongo/platform/basic.h"
 
 #include "mongo/db/pipeline/document_source_lookup.h"
 
+#include <algorithm>
 #include <memory>
 
 #include "mongo/base/init.h"
@@ -42,6 +45,7 @@
 #include "mongo/db/pipeline/expression.h"
 #include "mongo/db/pipeline/expression_context.h"
 #include "mongo/db/query/query_knobs_gen.h"
+#include "mongo/logv2/log.h"
 #include "mongo/platform/overflow_arithmetic.h"
 #include "mongo/util/fail_point.h"
 
@@ -50,6 +54,16 @@ namespace mongo {
 using boost::intrusive_ptr;
 using std::vector;
 
+namespace {
+// The most bytes of local values a batched $lookup query may hold. This stays well below the BSON
+// size limit, leaving room for the additional filter and for the operators around each value.
+constexpr long long kMaxBatchFilterBytes = BSONObjMaxUserSize / 2;
+
+// The bytes added to a batched $lookup query for each of its local values, beyond the value itself,
+// when the values are wrapped in {<foreignField>: {$eq: <value>}}.
+constexpr long long kBatchFilterBytesPerValue = 32;
+}  // namespace
+
 DocumentSourceLookUp::DocumentSourceLookUp(NamespaceString fromNs,
                                            std::string as,
                                            const boost::intrusive_ptr<ExpressionContext>& expCtx)
@@ -77,6 +91,15 @@ DocumentSourceLookUp::DocumentSourceLookUp(NamespaceString fromNs,
     _resolvedPipeline.reserve(_resolvedPipeline.size() + 1);
     _resolvedPipeline.push_back(BSON("$match" << BSONObj()));
     initializeResolvedIntrospectionPipeline();
+
+    const auto hashJoinMaxBytes = internalDocumentSourceLookupHashJoinMaxBytes.load();
+    if (hashJoinMaxBytes > 0 && LookUpHashTable::canJoinOn(*_foreignField)) {
+        _hashTable.emplace(*_foreignField, _fromExpCtx->getValueComparator(), hashJoinMaxBytes);
+    }
+
+    if (LookUpHashTable::canJoinOn(*_foreignField)) {
+        _maxBatchSize = static_cast<size_t>(internalDocumentSourceLookupBatchSize.load());
+    }
 }
 
 DocumentSourceLookUp::DocumentSourceLookUp(NamespaceString fromNs,
@@ -260,7 +283,8 @@ DocumentSource::GetNextResult DocumentSourceLookUp::doGetNext() {
         return unwindResult();
     }
 
-    auto nextInput = pSource->getNext();
+    boost::optional<std::vector<Document>> matches;
+    auto nextInput = getNextInput(&matches);
     if (!nextInput.isAdvanced()) {
         return nextInput;
     }
@@ -271,22 +295,13 @@ DocumentSource::GetNextResult DocumentSourceLookUp::doGetNext() {
     // '_unwindSrc' would be non-null, and we would not have made it here.
     invariant(!_matchSrc);
 
-    if (!wasConstructedWithPipelineSyntax()) {
-        auto matchStage =
-            makeMatchStageFromInput(inputDoc, *_localField, _foreignField->fullPath(), BSONObj());
-        // We've already allocated space for the trailing $match stage in '_resolvedPipeline'.
-        _resolvedPipeline.back() = matchStage;
-    }
-
-    auto pipeline = buildPipeline(inputDoc);
-
     std::vector<Value> results;
     long long objsize = 0;
     const auto maxBytes = internalLookupStageIntermediateDocumentMaxSizeBytes.load();
 
-    while (auto result = pipeline->getNext()) {
+    auto addResult = [&](Document&& result) {
         long long safeSum = 0;
-        bool hasOverflowed = overflow::add(objsize, result->getApproximateSize(), &safeSum);
+        bool hasOverflowed = overflow::add(objsize, result.getApproximateSize(), &safeSum);
         uassert(4568,
                 str::stream() << "Total size of documents in " << _fromNs.coll()
                               << " matching pipeline's $lookup stage exceeds " << maxBytes
@@ -294,9 +309,27 @@ DocumentSource::GetNextResult DocumentSourceLookUp::doGetNext() {
 
                 !hasOverflowed && objsize <= maxBytes);
         objsize = safeSum;
-        results.emplace_back(std::move(*result));
+        results.emplace_back(std::move(result));
+    };
+
+    if (matches) {
+        for (auto&& match : *matches) {
+            addResult(std::move(match));
+        }
+    } else {
+        if (!wasConstructedWithPipelineSyntax()) {
+            auto matchStage = makeMatchStageFromInput(
+                inputDoc, *_localField, _foreignField->fullPath(), BSONObj());
+            // We've already allocated space for the trailing $match stage in '_resolvedPipeline'.
+            _resolvedPipeline.back() = matchStage;
+        }
+
+        auto pipeline = buildPipeline(inputDoc);
+        while (auto result = pipeline->getNext()) {
+            addResult(std::move(*result));
+        }
+        _usedDisk = _usedDisk || pipeline->usedDisk();
     }
-    _usedDisk = _usedDisk || pipeline->usedDisk();
 
     MutableDocument output(std::move(inputDoc));
     output.setNestedField(_as, Value(std::move(results)));
@@ -362,6 +395,222 @@ std::unique_ptr<Pipeline, PipelineDeleter> DocumentSourceLookUp::buildPipeline(
     return pipeline;
 }
 
+DocumentSource::GetNextResult DocumentSourceLookUp::getNextInput(
+    boost::optional<std::vector<Document>>* matches) {
+    *matches = boost::none;
+
+    if (_maxBatchSize > 1 && _joinedInputs.empty() && !_deferredInputResult) {
+        batchInputs();
+    }
+
+    if (!_joinedInputs.empty()) {
+        auto joinedInput = std::move(_joinedInputs.front());
+        _joinedInputs.pop_front();
+        *matches = std::move(joinedInput.second);
+        return std::move(joinedInput.first);
+    }
+
+    if (_deferredInputResult) {
+        auto deferredInputResult = std::move(*_deferredInputResult);
+        _deferredInputResult = boost::none;
+        return deferredInputResult;
+    }
+
+    auto nextInput = pSource->getNext();
+    if (nextInput.isAdvanced()) {
+        if (auto localValues = getProbeValues(nextInput.getDocument())) {
+            *matches = probeHashTable(*localValues);
+        }
+    }
+    return nextInput;
+}
+
+boost::optional<std::vector<Value>> DocumentSourceLookUp::getProbeValues(
+    const Document& inputDoc) const {
+    if (wasConstructedWithPipelineSyntax()) {
+        return boost::none;
+    }
+
+    // A missing local field joins with foreign documents whose field is null or missing, which
+    // cannot be found by equality on the values at 'foreignField'.
+    std::vector<Value> localValues;
+    bool canProbe = true;
+    document_path_support::visitAllValuesAtPath(
+        inputDoc, *_localField, [&](const Value& localValue) {
+            canProbe = canProbe && LookUpHashTable::canProbeWith(localValue);
+            localValues.push_back(localValue);
+        });
+    if (localValues.empty() || !canProbe) {
+        return boost::none;
+    }
+    return localValues;
+}
+
+boost::optional<std::vector<Document>> DocumentSourceLookUp::probeHashTable(
+    const std::vector<Value>& localValues) {
+    if (!_hashTable) {
+        return boost::none;
+    }
+
+    if (_hashTable->isBuilding()) {
+        buildHashTable();
+        if (!_hashTable) {
+            return boost::none;
+        }
+    }
+
+    return _hashTable->probe(localValues);
+}
+
+void DocumentSourceLookUp::buildHashTable() {
+    invariant(_hashTable && _hashTable->isBuilding());
+
+    // Any $match absorbed alongside an $unwind does not depend on the input document, so it can
+    // be applied to the foreign collection once up front.
+    _resolvedPipeline.back() = BSON("$match" << _additionalFilter.value_or(BSONObj()));
+    auto pipeline = buildPipeline(Document());
+    while (auto result = pipeline->getNext()) {
+        _hashTable->add(std::move(*result));
+        if (_hashTable->isAbandoned()) {
+            break;
+        }
+    }
+    _usedDisk = _usedDisk || pipeline->usedDisk();
+
+    if (_hashTable->isAbandoned()) {
+        LOGV2_DEBUG(5380501,
+                    1,
+                    "Abandoning $lookup hash join since the foreign documents exceed the memory "
+                    "limit",
+                    "foreignNamespace"_attr = _resolvedNs,
+                    "maxMemoryUsageBytes"_attr =
+                        internalDocumentSourceLookupHashJoinMaxBytes.load());
+        _hashTable.reset();
+        return;
+    }
+    _hashTable->freeze();
+}
+
+void DocumentSourceLookUp::batchInputs() {
+    invariant(_joinedInputs.empty() && !_deferredInputResult);
+
+    // Maps each local value of the batched input documents to their positions in '_joinedInputs'.
+    auto inputsByValue =
+        _fromExpCtx->getValueComparator().makeUnorderedValueMap<std::vector<size_t>>();
+    std::vector<Value> batchValues;
+    std::vector<size_t> batchedInputs;
+    long long batchFilterBytes = 0;
+
+    while (_joinedInputs.size() < _maxBatchSize) {
+        auto nextInput = pSource->getNext();
+        if (!nextInput.isAdvanced()) {
+            _deferredInputResult = std::move(nextInput);
+            break;
+        }
+
+        auto inputDoc = nextInput.releaseDocument();
+        boost::optional<std::vector<Document>> matches;
+        if (auto localValues = getProbeValues(inputDoc)) {
+            matches = probeHashTable(*localValues);
+            if (!matches) {
+                long long newValueBytes = 0;
+                for (auto&& localValue : *localValues) {
+                    if (inputsByValue.find(localValue) == inputsByValue.end()) {
+                        newValueBytes += localValue.getApproximateSize() +
+                            _foreignField->fullPath().size() + kBatchFilterBytesPerValue;
+                    }
+                }
+                if (!batchedInputs.empty() &&
+                    batchFilterBytes + newValueBytes > kMaxBatchFilterBytes) {
+                    // Adding this document's values would make the batched query too large, so
+                    // the batch ends here and this document queries the foreign collection on its
+                    // own.
+                    _joinedInputs.emplace_back(std::move(inputDoc), boost::none);
+                    break;
+                }
+                batchFilterBytes += newValueBytes;
+
+                // Join this document through the batched query below.
+                matches.emplace();
+                batchedInputs.push_back(_joinedInputs.size());
+                for (auto&& localValue : *localValues) {
+                    auto& positions = inputsByValue[localValue];
+                    if (positions.empty()) {
+                        batchValues.push_back(localValue);
+                    }
+                    positions.push_back(_joinedInputs.size());
+                }
+            }
+        }
+        _joinedInputs.emplace_back(std::move(inputDoc), std::move(matches));
+    }
+
+    if (batchedInputs.empty()) {
+        return;
+    }
+
+    // Build the query from a document holding all of the batch's local values, so that it takes
+    // the same $in shape as the query for a single input document with an array local field.
+    const FieldPath batchValuesPath("values");
+    _resolvedPipeline.back() =
+        makeMatchStageFromInput(Document{{batchValuesPath.fullPath(), std::move(batchValues)}},
+                                batchValuesPath,
+                                _foreignField->fullPath(),
+                                _additionalFilter.value_or(BSONObj()));
+    auto pipeline = buildPipeline(Document());
+
+    const auto maxBytes = internalLookupStageIntermediateDocumentMaxSizeBytes.load();
+    long long batchBytes = 0;
+    std::vector<size_t> positions;
+    while (auto result = pipeline->getNext()) {
+        positions.clear();
+        document_path_support::visitAllValuesAtPath(
+            *result, *_foreignField, [&](const Value& foreignValue) {
+                auto it = inputsByValue.find(foreignValue);
+                if (it != inputsByValue.end()) {
+                    positions.insert(positions.end(), it->second.begin(), it->second.end());
+                }
+            });
+        std::sort(positions.begin(), positions.end());
+        positions.erase(std::unique(positions.begin(), positions.end()), positions.end());
+
+        batchBytes += result->getApproximateSize() * positions.size();
+        if (batchBytes > maxBytes) {
+            // The matches of the whole batch are too large to hold at once. Leave each input
+            // document to query the foreign collection on its own, which enforces the limit on
+            // the matches of a single input document.
+            LOGV2_DEBUG(5380502,
+                        1,
+                        "Abandoning batched $lookup query since its results exceed the memory "
+                        "limit",
+                        "foreignNamespace"_attr = _resolvedNs,
+                        "batchSize"_attr = batchedInputs.size(),
+                        "maxMemoryUsageBytes"_attr = maxBytes);
+            for (auto position : batchedInputs) {
+                _joinedInputs[position].second = boost::none;
+            }
+            break;
+        }
+
+        for (auto position : positions) {
+            _joinedInputs[position].second->push_back(*result);
+        }
+    }
+    _usedDisk = _usedDisk || pipeline->usedDisk();
+}
+
+boost::optional<Document> DocumentSourceLookUp::getNextForeignDocument() {
+    if (_pipeline) {
+        return _pipeline->getNext();
+    }
+    if (_inputMatches.empty()) {
+        return boost::none;
+    }
+    auto next = std::move(_inputMatches.front());
+    _inputMatches.pop_front();
+    return next;
+}
+
 DocumentSource::GetModPathsReturn DocumentSourceLookUp::getModifiedPaths() const {
     std::set<std::string> modifiedPaths{_as.fullPath()};
     if (_unwindSrc) {
@@ -503,6 +752,10 @@ void DocumentSourceLookUp::doDispose() {
         _pipeline->dispose(pExpCtx->opCtx);
         _pipeline.reset();
     }
+    _inputMatches.clear();
+    _joinedInputs.clear();
+    _deferredInputResult = boost::none;
+    _hashTable.reset();
 }
 
 BSONObj DocumentSourceLookUp::makeMatchStageFromInput(const Document& input,
@@ -595,36 +848,44 @@ DocumentSource::GetNextResult DocumentSourceLookUp::unwindResult() {
     // Loop until we get a document that has at least one match.
     // Note we may return early from this loop if our source stage is exhausted or if the unwind
     // source was asked to return empty arrays and we get a document without a match.
-    while (!_pipeline || !_nextValue) {
-        auto nextInput = pSource->getNext();
+    while (!_nextValue) {
+        boost::optional<std::vector<Document>> matches;
+        auto nextInput = getNextInput(&matches);
         if (!nextInput.isAdvanced()) {
             return nextInput;
         }
 
         _input = nextInput.releaseDocument();
 
-        if (!wasConstructedWithPipelineSyntax()) {
-            BSONObj filter = _additionalFilter.value_or(BSONObj());
-            auto matchStage =
-                makeMatchStageFromInput(*_input, *_localField, _foreignField->fullPath(), filter);
-            // We've already allocated space for the trailing $match stage in '_resolvedPipeline'.
-            _resolvedPipeline.back() = matchStage;
-        }
-
         if (_pipeline) {
             _usedDisk = _usedDisk || _pipeline->usedDisk();
             _pipeline->dispose(pExpCtx->opCtx);
+            _pipeline.reset();
         }
 
-        _pipeline = buildPipeline(*_input);
+        if (matches) {
+            _inputMatches.assign(std::make_move_iterator(matches->begin()),
+                                 std::make_move_iterator(matches->end()));
+        } else {
+            if (!wasConstructedWithPipelineSyntax()) {
+                BSONObj filter = _additionalFilter.value_or(BSONObj());
+                auto matchStage = makeMatchStageFromInput(
+                    *_input, *_localField, _foreignField->fullPath(), filter);
+                // We've already allocated space for the trailing $match stage in
+                // '_resolvedPipeline'.
+                _resolvedPipeline.back() = matchStage;
+            }
+
+            _pipeline = buildPipeline(*_input);
 
-        // The $lookup stage takes responsibility for disposing of its Pipeline, since it will
-        // potentially be used by multiple OperationContexts, and the $lookup stage is part of an
-        // outer Pipeline that will propagate dispose() calls before being destroyed.
-        _pipeline.get_deleter().dismissDisposal();
+            // The $lookup stage takes responsibility for disposing of its Pipeline, since it will
+            // potentially be used by multiple OperationContexts, and the $lookup stage is part of
+            // an outer Pipeline that will propagate dispose() calls before being destroyed.
+            _pipeline.get_deleter().dismissDisposal();
+        }
 
         _cursorIndex = 0;
-        _nextValue = _pipeline->getNext();
+        _nextValue = getNextForeignDocument();
 
         if (_unwindSrc->preserveNullAndEmptyArrays() && !_nextValue) {
             // There were no results for this cursor, but the $unwind was asked to preserve empty
@@ -642,7 +903,7 @@ DocumentSource::GetNextResult DocumentSourceLookUp::unwindResult() {
 
     invariant(bool(_input) && bool(_nextValue));
     auto currentValue = *_nextValue;
-    _nextValue = _pipeline->getNext();
+    _nextValue = getNextForeignDocument();
 
     // Move input document into output if this is the last or only result, otherwise perform a copy.
     MutableDocument output(_nextValue ? *_input : std::move(*_input));
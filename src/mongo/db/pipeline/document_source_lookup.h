@@ -30,6 +30,7 @@
 #pragma once
 
 #include <boost/optional.hpp>
+#include <deque>
 
 #include "mongo/db/exec/document_value/value_comparator.h"
 #include "mongo/db/pipeline/document_source.h"
@@ -38,6 +39,7 @@
 #include "mongo/db/pipeline/document_source_unwind.h"
 #include "mongo/db/pipeline/expression.h"
 #include "mongo/db/pipeline/lite_parsed_pipeline.h"
+#include "mongo/db/pipeline/lookup_hash_table.h"
 #include "mongo/db/pipeline/lookup_set_cache.h"
 
 namespace mongo {
@@ -266,6 +268,45 @@ private:
      */
     std::unique_ptr<Pipeline, PipelineDeleter> buildPipeline(const Document& inputDoc);
 
+    /**
+     * Returns the next input document. If its joining foreign documents were already found by a
+     * hash table probe or a batched query, they are returned through 'matches'. Otherwise
+     * 'matches' is set to boost::none and the caller must query the foreign collection.
+     */
+    GetNextResult getNextInput(boost::optional<std::vector<Document>>* matches);
+
+    /**
+     * Returns the values at 'localField' in 'inputDoc', or boost::none if there are none or if any
+     * of them has query semantics which cannot be reproduced by joining on equal values.
+     */
+    boost::optional<std::vector<Value>> getProbeValues(const Document& inputDoc) const;
+
+    /**
+     * Returns the foreign documents joining with 'localValues' from '_hashTable', building the
+     * table from a single scan of the foreign collection on first use. Returns boost::none if there
+     * is no table or if it was abandoned.
+     */
+    boost::optional<std::vector<Document>> probeHashTable(const std::vector<Value>& localValues);
+
+    /**
+     * Buffers up to '_maxBatchSize' input documents in '_joinedInputs' and finds the foreign
+     * documents joining with all of them using a single $in query over their local values. The
+     * batch also ends early once the query's local values approach the BSON size limit.
+     */
+    void batchInputs();
+
+    /**
+     * Fills '_hashTable' with the foreign documents which pass '_additionalFilter', abandoning the
+     * table if they do not fit.
+     */
+    void buildHashTable();
+
+    /**
+     * Returns the next foreign document joining with '_input' while unwinding, drawn from either
+     * '_pipeline' or '_inputMatches'.
+     */
+    boost::optional<Document> getNextForeignDocument();
+
     /**
      * Reinitialize the cache with a new max size. May only be called if this DSLookup was created
      * with pipeline syntax, the cache has not been frozen or abandoned, and no data has been added
@@ -299,6 +340,23 @@ private:
     // from a cursor source.
     boost::optional<SequentialDocumentCache> _cache;
 
+    // Indexes the foreign collection on 'foreignField' for $lookup with localField/foreignField
+    // syntax, if enabled by 'internalDocumentSourceLookupHashJoinMaxBytes'. Reset if the foreign
+    // documents do not fit, after which every input document queries the foreign collection.
+    boost::optional<LookUpHashTable> _hashTable;
+
+    // The number of input documents joined by each batched query against the foreign collection,
+    // as set by 'internalDocumentSourceLookupBatchSize'. Batching is disabled if less than two.
+    size_t _maxBatchSize = 0;
+
+    // Input documents buffered by batchInputs(), each with its joining foreign documents, or
+    // boost::none if they must be found by querying the foreign collection for that document.
+    std::deque<std::pair<Document, boost::optional<std::vector<Document>>>> _joinedInputs;
+
+    // A pause or EOF received from the source while batching, to be returned once '_joinedInputs'
+    // is drained.
+    boost::optional<GetNextResult> _deferredInputResult;
+
     // The ExpressionContext used when performing aggregation pipelines against the '_resolvedNs'
     // namespace.
     boost::intrusive_ptr<ExpressionContext> _fromExpCtx;
@@ -322,6 +380,7 @@ private:
     // not null.
     long long _cursorIndex = 0;
     std::unique_ptr<Pipeline, PipelineDeleter> _pipeline;
+    std::deque<Document> _inputMatches;
     boost::optional<Document> _input;
     boost::optional<Document> _nextValue;
 };
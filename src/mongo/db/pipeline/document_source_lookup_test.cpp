@@ -48,6 +48,7 @@
 #include "mongo/db/repl/replication_coordinator_mock.h"
 #include "mongo/db/repl/storage_interface_mock.h"
 #include "mongo/db/server_options.h"
+#include "mongo/util/scopeguard.h"
 
 namespace mongo {
 namespace {
@@ -507,11 +508,17 @@ public:
         }
 
         pipeline->addInitialSource(DocumentSourceMock::createForTest(_mockResults));
+        ++_numCursorSourcesAttached;
         return pipeline;
     }
 
+    int numCursorSourcesAttached() const {
+        return _numCursorSourcesAttached;
+    }
+
 private:
     deque<DocumentSource::GetNextResult> _mockResults;
+    int _numCursorSourcesAttached = 0;
     bool _removeLeadingQueryStages = false;
 };
 
@@ -621,6 +628,222 @@ TEST_F(DocumentSourceLookUpTest, ShouldPropagatePausesWhileUnwinding) {
     lookup->dispose();
 }
 
+TEST_F(DocumentSourceLookUpTest, ShouldProbeHashTableInsteadOfQueryingPerDocument) {
+    auto expCtx = getExpCtx();
+    NamespaceString fromNs("test", "foreign");
+    expCtx->setResolvedNamespaces(StringMap<ExpressionContext::ResolvedNamespace>{
+        {fromNs.coll().toString(), {fromNs, std::vector<BSONObj>()}}});
+
+    const long long originalHashJoinMaxBytes = internalDocumentSourceLookupHashJoinMaxBytes.load();
+    ON_BLOCK_EXIT([&] {
+        internalDocumentSourceLookupHashJoinMaxBytes.store(originalHashJoinMaxBytes);
+    });
+    internalDocumentSourceLookupHashJoinMaxBytes.store(1024 * 1024);
+
+    // Mock out the foreign collection.
+    deque<DocumentSource::GetNextResult> mockForeignContents{
+        Document{{"_id", 0}, {"key", 0}},
+        Document{{"_id", 1}, {"key", 1}},
+        Document{{"_id", 2}, {"key", vector<Value>{Value(0), Value(1)}}},
+        Document{{"_id", 3}}};
+    auto mongoInterface = std::make_shared<MockMongoInterface>(std::move(mockForeignContents));
+    expCtx->mongoProcessInterface = mongoInterface;
+
+    // Set up the $lookup stage.
+    auto lookupSpec = Document{{"$lookup",
+                                Document{{"from", fromNs.coll()},
+                                         {"localField", "local"_sd},
+                                         {"foreignField", "key"_sd},
+                                         {"as", "foreignDocs"_sd}}}}
+                          .toBson();
+    auto parsed = DocumentSourceLookUp::createFromBson(lookupSpec.firstElement(), expCtx);
+    auto lookup = static_cast<DocumentSourceLookUp*>(parsed.get());
+
+    auto mockLocalSource = DocumentSourceMock::createForTest(
+        {Document{{"local", 0}},
+         Document{{"local", vector<Value>{Value(0), Value(1)}}},
+         Document{{"local", 5}},
+         Document()});
+    lookup->setSource(mockLocalSource.get());
+
+    auto foreignIds = [](const Document& doc) {
+        vector<int> ids;
+        for (auto&& foreignDoc : doc["foreignDocs"].getArray()) {
+            ids.push_back(foreignDoc["_id"].getInt());
+        }
+        return ids;
+    };
+
+    auto next = lookup->getNext();
+    ASSERT_TRUE(next.isAdvanced());
+    ASSERT(foreignIds(next.releaseDocument()) == (vector<int>{0, 2}));
+
+    // A document matching several local values is only returned once.
+    next = lookup->getNext();
+    ASSERT_TRUE(next.isAdvanced());
+    ASSERT(foreignIds(next.releaseDocument()) == (vector<int>{0, 1, 2}));
+
+    next = lookup->getNext();
+    ASSERT_TRUE(next.isAdvanced());
+    ASSERT(foreignIds(next.releaseDocument()).empty());
+
+    // The foreign collection was scanned once to build the hash table.
+    ASSERT_EQ(mongoInterface->numCursorSourcesAttached(), 1);
+
+    // A missing local field matches foreign documents with a missing or null field, which must be
+    // found by querying the foreign collection.
+    next = lookup->getNext();
+    ASSERT_TRUE(next.isAdvanced());
+    ASSERT(foreignIds(next.releaseDocument()) == (vector<int>{3}));
+    ASSERT_EQ(mongoInterface->numCursorSourcesAttached(), 2);
+
+    ASSERT_TRUE(lookup->getNext().isEOF());
+    lookup->dispose();
+}
+
+TEST_F(DocumentSourceLookUpTest, ShouldJoinBatchesOfInputDocumentsWithASingleQuery) {
+    auto expCtx = getExpCtx();
+    NamespaceString fromNs("test", "foreign");
+    expCtx->setResolvedNamespaces(StringMap<ExpressionContext::ResolvedNamespace>{
+        {fromNs.coll().toString(), {fromNs, std::vector<BSONObj>()}}});
+
+    const int originalBatchSize = internalDocumentSourceLookupBatchSize.load();
+    ON_BLOCK_EXIT([&] { internalDocumentSourceLookupBatchSize.store(originalBatchSize); });
+    internalDocumentSourceLookupBatchSize.store(3);
+
+    // Mock out the foreign collection.
+    deque<DocumentSource::GetNextResult> mockForeignContents{
+        Document{{"_id", 0}, {"key", 0}},
+        Document{{"_id", 1}, {"key", 1}},
+        Document{{"_id", 2}, {"key", vector<Value>{Value(0), Value(1)}}},
+        Document{{"_id", 3}}};
+    auto mongoInterface = std::make_shared<MockMongoInterface>(std::move(mockForeignContents));
+    expCtx->mongoProcessInterface = mongoInterface;
+
+    // Set up the $lookup stage.
+    auto lookupSpec = Document{{"$lookup",
+                                Document{{"from", fromNs.coll()},
+                                         {"localField", "local"_sd},
+                                         {"foreignField", "key"_sd},
+                                         {"as", "foreignDocs"_sd}}}}
+                          .toBson();
+    auto parsed = DocumentSourceLookUp::createFromBson(lookupSpec.firstElement(), expCtx);
+    auto lookup = static_cast<DocumentSourceLookUp*>(parsed.get());
+
+    auto mockLocalSource =
+        DocumentSourceMock::createForTest({Document{{"local", 0}},
+                                           Document{{"local", 1}},
+                                           Document{{"local", vector<Value>{Value(0), Value(1)}}},
+                                           Document{{"local", 5}},
+                                           DocumentSource::GetNextResult::makePauseExecution(),
+                                           Document(),
+                                           Document{{"local", 1}}});
+    lookup->setSource(mockLocalSource.get());
+
+    auto foreignIds = [](const Document& doc) {
+        vector<int> ids;
+        for (auto&& foreignDoc : doc["foreignDocs"].getArray()) {
+            ids.push_back(foreignDoc["_id"].getInt());
+        }
+        return ids;
+    };
+
+    // The first three input documents are joined by a single query.
+    auto next = lookup->getNext();
+    ASSERT_TRUE(next.isAdvanced());
+    ASSERT(foreignIds(next.releaseDocument()) == (vector<int>{0, 2}));
+    ASSERT_EQ(mongoInterface->numCursorSourcesAttached(), 1);
+
+    next = lookup->getNext();
+    ASSERT_TRUE(next.isAdvanced());
+    ASSERT(foreignIds(next.releaseDocument()) == (vector<int>{1, 2}));
+
+    next = lookup->getNext();
+    ASSERT_TRUE(next.isAdvanced());
+    ASSERT(foreignIds(next.releaseDocument()) == (vector<int>{0, 1, 2}));
+    ASSERT_EQ(mongoInterface->numCursorSourcesAttached(), 1);
+
+    // A pause ends the batch early, and is returned once the batch has been drained.
+    next = lookup->getNext();
+    ASSERT_TRUE(next.isAdvanced());
+    ASSERT(foreignIds(next.releaseDocument()).empty());
+    ASSERT_EQ(mongoInterface->numCursorSourcesAttached(), 2);
+    ASSERT_TRUE(lookup->getNext().isPaused());
+
+    // A missing local field is joined by a query of its own.
+    next = lookup->getNext();
+    ASSERT_TRUE(next.isAdvanced());
+    ASSERT(foreignIds(next.releaseDocument()) == (vector<int>{3}));
+    ASSERT_EQ(mongoInterface->numCursorSourcesAttached(), 4);
+
+    next = lookup->getNext();
+    ASSERT_TRUE(next.isAdvanced());
+    ASSERT(foreignIds(next.releaseDocument()) == (vector<int>{1, 2}));
+
+    ASSERT_TRUE(lookup->getNext().isEOF());
+    ASSERT_EQ(mongoInterface->numCursorSourcesAttached(), 4);
+    lookup->dispose();
+}
+
+TEST_F(DocumentSourceLookUpTest, ShouldEndBatchBeforeItsQueryExceedsTheBsonSizeLimit) {
+    auto expCtx = getExpCtx();
+    NamespaceString fromNs("test", "foreign");
+    expCtx->setResolvedNamespaces(StringMap<ExpressionContext::ResolvedNamespace>{
+        {fromNs.coll().toString(), {fromNs, std::vector<BSONObj>()}}});
+
+    const int originalBatchSize = internalDocumentSourceLookupBatchSize.load();
+    ON_BLOCK_EXIT([&] { internalDocumentSourceLookupBatchSize.store(originalBatchSize); });
+    internalDocumentSourceLookupBatchSize.store(10);
+
+    // Each local value is large enough that no two of them fit in one batched query.
+    std::vector<std::string> keys;
+    for (char c : {'a', 'b', 'c'}) {
+        keys.push_back(std::string(5 * 1024 * 1024, c));
+    }
+
+    // Mock out the foreign collection.
+    deque<DocumentSource::GetNextResult> mockForeignContents;
+    for (size_t i = 0; i < keys.size(); ++i) {
+        mockForeignContents.push_back(Document{{"_id", static_cast<int>(i)}, {"key", keys[i]}});
+    }
+    auto mongoInterface = std::make_shared<MockMongoInterface>(std::move(mockForeignContents));
+    expCtx->mongoProcessInterface = mongoInterface;
+
+    // Set up the $lookup stage.
+    auto lookupSpec = Document{{"$lookup",
+                                Document{{"from", fromNs.coll()},
+                                         {"localField", "local"_sd},
+                                         {"foreignField", "key"_sd},
+                                         {"as", "foreignDocs"_sd}}}}
+                          .toBson();
+    auto parsed = DocumentSourceLookUp::createFromBson(lookupSpec.firstElement(), expCtx);
+    auto lookup = static_cast<DocumentSourceLookUp*>(parsed.get());
+
+    auto mockLocalSource = DocumentSourceMock::createForTest(
+        {Document{{"local", keys[0]}}, Document{{"local", keys[1]}}, Document{{"local", keys[2]}}});
+    lookup->setSource(mockLocalSource.get());
+
+    auto foreignIds = [](const Document& doc) {
+        vector<int> ids;
+        for (auto&& foreignDoc : doc["foreignDocs"].getArray()) {
+            ids.push_back(foreignDoc["_id"].getInt());
+        }
+        return ids;
+    };
+
+    // The first document is batched alone, since adding the second would make the query too
+    // large. The second then queries on its own, and the third starts a new batch.
+    for (int i = 0; i < 3; ++i) {
+        auto next = lookup->getNext();
+        ASSERT_TRUE(next.isAdvanced());
+        ASSERT(foreignIds(next.releaseDocument()) == (vector<int>{i}));
+        ASSERT_EQ(mongoInterface->numCursorSourcesAttached(), i + 1);
+    }
+
+    ASSERT_TRUE(lookup->getNext().isEOF());
+    lookup->dispose();
+}
+
 TEST_F(DocumentSourceLookUpTest, LookupReportsAsFieldIsModified) {
     auto expCtx = getExpCtx();
     NamespaceString fromNs("test", "foreign");
@@ -0,0 +1,320 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/pipeline/document_source_parallel_collection_scan.h"
+
+#include <algorithm>
+
+#include "mongo/db/catalog/collection.h"
+#include "mongo/db/client.h"
+#include "mongo/db/db_raii.h"
+#include "mongo/db/exec/collection_scan.h"
+#include "mongo/db/exec/working_set.h"
+#include "mongo/db/matcher/expression_parser.h"
+#include "mongo/db/matcher/extensions_callback_real.h"
+#include "mongo/db/pipeline/document_source_cursor.h"
+#include "mongo/db/pipeline/document_source_group.h"
+#include "mongo/db/query/plan_executor.h"
+#include "mongo/db/service_context.h"
+#include "mongo/db/storage/record_store.h"
+#include "mongo/util/fail_point.h"
+#include "mongo/util/scopeguard.h"
+
+namespace mongo {
+
+MONGO_FAIL_POINT_DEFINE(hangParallelCollectionScanWorkerBeforeScanning);
+
+namespace {
+// The number of records sampled for each partition when choosing the split points.
+constexpr size_t kSamplesPerPartition = 32;
+
+// The maximum number of bytes of partial groups buffered between the workers and the consumer.
+constexpr size_t kMaxQueueBytes = 64 * 1024 * 1024;
+}  // namespace
+
+size_t DocumentSourceParallelCollectionScan::QueueCostFunction::operator()(
+    const Document& doc) const {
+    return std::min(doc.getApproximateSize(), kMaxQueueBytes);
+}
+
+std::vector<RecordId> DocumentSourceParallelCollectionScan::sampleSplitPoints(
+    OperationContext* opCtx, const Collection* collection, size_t numPartitions) {
+    if (numPartitions < 2) {
+        return {};
+    }
+
+    auto cursor = collection->getRecordStore()->getRandomCursor(opCtx);
+    if (!cursor) {
+        return {};
+    }
+
+    std::vector<RecordId> samples;
+    samples.reserve(numPartitions * kSamplesPerPartition);
+    while (samples.size() < numPartitions * kSamplesPerPartition) {
+        auto record = cursor->next();
+        if (!record) {
+            break;
+        }
+        samples.push_back(record->id);
+    }
+    std::sort(samples.begin(), samples.end());
+    samples.erase(std::unique(samples.begin(), samples.end()), samples.end());
+    if (samples.size() < numPartitions) {
+        return {};
+    }
+
+    // Each split point is the first RecordId of the range that follows it, so every range is
+    // non-empty at the time of sampling.
+    std::vector<RecordId> splitPoints;
+    splitPoints.reserve(numPartitions - 1);
+    for (size_t i = 1; i < numPartitions; ++i) {
+        splitPoints.push_back(samples[i * samples.size() / numPartitions]);
+    }
+    return splitPoints;
+}
+
+boost::intrusive_ptr<DocumentSourceParallelCollectionScan>
+DocumentSourceParallelCollectionScan::create(const boost::intrusive_ptr<ExpressionContext>& expCtx,
+                                             const Collection* collection,
+                                             const BSONObj& query,
+                                             const DocumentSourceGroup& group,
+                                             std::vector<RecordId> splitPoints) {
+    invariant(collection);
+    invariant(!splitPoints.empty());
+    return new DocumentSourceParallelCollectionScan(expCtx,
+                                                    collection,
+                                                    query,
+                                                    group.serialize().getDocument().toBson(),
+                                                    std::move(splitPoints));
+}
+
+DocumentSourceParallelCollectionScan::DocumentSourceParallelCollectionScan(
+    const boost::intrusive_ptr<ExpressionContext>& expCtx,
+    const Collection* collection,
+    const BSONObj& query,
+    BSONObj groupSpec,
+    std::vector<RecordId> splitPoints)
+    : DocumentSource(kStageName, expCtx),
+      _nss(collection->ns()),
+      _uuid(collection->uuid()),
+      _query(query.getOwned()),
+      _groupSpec(std::move(groupSpec)),
+      _splitPoints(std::move(splitPoints)),
+      _readSource(expCtx->opCtx->recoveryUnit()->getTimestampReadSource()),
+      _readTimestamp(expCtx->opCtx->recoveryUnit()->getPointInTimeReadTimestamp()),
+      _queue([] {
+          Queue::Options options;
+          options.maxQueueDepth = kMaxQueueBytes;
+          return options;
+      }()) {}
+
+DocumentSourceParallelCollectionScan::~DocumentSourceParallelCollectionScan() {
+    stopWorkers();
+}
+
+Value DocumentSourceParallelCollectionScan::serialize(
+    boost::optional<ExplainOptions::Verbosity> explain) const {
+    return Value(DOC(getSourceName() << DOC("partitions" << static_cast<int>(numPartitions())
+                                                         << "filter" << _query << "group"
+                                                         << _groupSpec)));
+}
+
+DocumentSource::GetNextResult DocumentSourceParallelCollectionScan::doGetNext() {
+    if (_exhausted) {
+        return GetNextResult::makeEOF();
+    }
+
+    if (!_workersStarted) {
+        startWorkers();
+    }
+
+    try {
+        return _queue.pop(pExpCtx->opCtx);
+    } catch (const ExceptionFor<ErrorCodes::ProducerConsumerQueueConsumed>&) {
+        // Every worker has finished and all of their results have been returned.
+        _exhausted = true;
+        stopWorkers();
+        stdx::lock_guard<Latch> lk(_mutex);
+        uassertStatusOK(_workerStatus);
+        return GetNextResult::makeEOF();
+    }
+}
+
+void DocumentSourceParallelCollectionScan::doDispose() {
+    stopWorkers();
+}
+
+void DocumentSourceParallelCollectionScan::startWorkers() {
+    _workersStarted = true;
+    _deadline = pExpCtx->opCtx->getDeadline();
+    _timeoutError = pExpCtx->opCtx->getTimeoutError();
+
+    {
+        stdx::lock_guard<Latch> lk(_mutex);
+        _numActiveWorkers = numPartitions();
+    }
+
+    try {
+        _workers.reserve(numPartitions());
+        for (size_t partition = 0; partition < numPartitions(); ++partition) {
+            // Each worker evaluates its own copy of the $group, which must produce partial results
+            // for the merging $group which follows this stage.
+            auto workerExpCtx = pExpCtx->copyWith(_nss, _uuid);
+            workerExpCtx->needsMerge = true;
+            workerExpCtx->opCtx = nullptr;
+
+            _workers.emplace_back(
+                [this, partition, workerExpCtx = std::move(workerExpCtx)]() mutable {
+                    runWorker(partition, std::move(workerExpCtx));
+                });
+        }
+    } catch (...) {
+        stopWorkers();
+        throw;
+    }
+}
+
+void DocumentSourceParallelCollectionScan::runWorker(
+    size_t partition, boost::intrusive_ptr<ExpressionContext> workerExpCtx) {
+    Status status = Status::OK();
+    try {
+        const std::string desc = str::stream() << "parallelCollectionScan-" << partition;
+        ThreadClient tc(desc, getGlobalServiceContext());
+        auto opCtx = tc->makeOperationContext();
+        {
+            stdx::lock_guard<Latch> lk(_mutex);
+            if (_stopping) {
+                return;
+            }
+            _workerOpCtxs.push_back(opCtx.get());
+        }
+        ON_BLOCK_EXIT([&] {
+            stdx::lock_guard<Latch> lk(_mutex);
+            _workerOpCtxs.erase(
+                std::find(_workerOpCtxs.begin(), _workerOpCtxs.end(), opCtx.get()));
+        });
+
+        scanPartition(opCtx.get(), partition, workerExpCtx);
+    } catch (const DBException& ex) {
+        status = ex.toStatus();
+    }
+
+    stdx::lock_guard<Latch> lk(_mutex);
+    // A closed queue means that another worker failed or that this stage is being disposed, and
+    // neither is an error of this worker.
+    if (!status.isOK() && status != ErrorCodes::ProducerConsumerQueueEndClosed &&
+        _workerStatus.isOK()) {
+        _workerStatus = status.withContext("Error in parallel collection scan");
+        _queue.closeProducerEnd();
+    }
+    if (--_numActiveWorkers == 0) {
+        _queue.closeProducerEnd();
+    }
+}
+
+void DocumentSourceParallelCollectionScan::scanPartition(
+    OperationContext* opCtx,
+    size_t partition,
+    const boost::intrusive_ptr<ExpressionContext>& workerExpCtx) {
+    opCtx->setDeadlineByDate(_deadline, _timeoutError);
+    if (_readTimestamp) {
+        opCtx->recoveryUnit()->setTimestampReadSource(RecoveryUnit::ReadSource::kProvided,
+                                                      _readTimestamp);
+    } else if (_readSource != RecoveryUnit::ReadSource::kNoTimestamp) {
+        opCtx->recoveryUnit()->setTimestampReadSource(_readSource);
+    }
+    workerExpCtx->opCtx = opCtx;
+
+    // The filter must outlive the collection scan which refers to it.
+    std::unique_ptr<MatchExpression> filter;
+    boost::intrusive_ptr<DocumentSourceCursor> cursor;
+    {
+        AutoGetCollectionForRead autoColl(opCtx, _nss);
+        auto collection = autoColl.getCollection();
+        uassert(ErrorCodes::QueryPlanKilled,
+                str::stream() << "collection " << _nss
+                              << " was dropped or renamed during a parallel scan",
+                collection && collection->uuid() == _uuid);
+
+        filter = uassertStatusOK(MatchExpressionParser::parse(_query,
+                                                              workerExpCtx,
+                                                              ExtensionsCallbackReal(opCtx, &_nss),
+                                                              Pipeline::kAllowedMatcherFeatures));
+        filter = MatchExpression::optimize(std::move(filter));
+
+        CollectionScanParams params;
+        if (partition > 0) {
+            params.minRecord = _splitPoints[partition - 1];
+        }
+        if (partition < _splitPoints.size()) {
+            params.maxRecord = _splitPoints[partition];
+        }
+
+        auto ws = std::make_unique<WorkingSet>();
+        auto root = std::make_unique<CollectionScan>(
+            workerExpCtx.get(), collection, params, ws.get(), filter.get());
+        auto exec = uassertStatusOK(PlanExecutor::make(
+            workerExpCtx, std::move(ws), std::move(root), collection, PlanExecutor::YIELD_AUTO));
+        cursor = DocumentSourceCursor::create(
+            collection, std::move(exec), workerExpCtx, DocumentSourceCursor::CursorType::kRegular);
+    }
+    ON_BLOCK_EXIT([&] { cursor->dispose(); });
+
+    hangParallelCollectionScanWorkerBeforeScanning.pauseWhileSet(opCtx);
+
+    auto group = DocumentSourceGroup::createFromBson(_groupSpec.firstElement(), workerExpCtx);
+    group->setSource(cursor.get());
+    ON_BLOCK_EXIT([&] { group->dispose(); });
+
+    for (auto next = group->getNext(); next.isAdvanced(); next = group->getNext()) {
+        _queue.push(next.releaseDocument(), opCtx);
+    }
+}
+
+void DocumentSourceParallelCollectionScan::stopWorkers() {
+    {
+        stdx::lock_guard<Latch> lk(_mutex);
+        _stopping = true;
+        for (auto opCtx : _workerOpCtxs) {
+            stdx::lock_guard<Client> clientLock(*opCtx->getClient());
+            opCtx->getServiceContext()->killOperation(clientLock, opCtx, ErrorCodes::Interrupted);
+        }
+    }
+
+    _queue.closeConsumerEnd();
+    for (auto&& worker : _workers) {
+        worker.join();
+    }
+    _workers.clear();
+}
+
+}  // namespace mongo
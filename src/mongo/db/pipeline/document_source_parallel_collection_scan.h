@@ -0,0 +1,197 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#pragma once
+
+#include <vector>
+
+#include "mongo/db/namespace_string.h"
+#include "mongo/db/pipeline/document_source.h"
+#include "mongo/db/record_id.h"
+#include "mongo/db/storage/recovery_unit.h"
+#include "mongo/platform/mutex.h"
+#include "mongo/stdx/thread.h"
+#include "mongo/util/producer_consumer_queue.h"
+#include "mongo/util/time_support.h"
+#include "mongo/util/uuid.h"
+
+namespace mongo {
+
+class Collection;
+class DocumentSourceGroup;
+
+/**
+ * Scans a collection with several worker threads and computes a partial $group over each worker's
+ * share of the records. The collection is split into disjoint RecordId ranges; each worker runs a
+ * filtered collection scan over one range on its own OperationContext and feeds the documents into
+ * its own copy of the $group, configured to produce mergeable partial results. This stage returns
+ * the partial groups from all of the workers, in no particular order, and must be followed by the
+ * merging half of the $group as given by DocumentSourceGroup::distributedPlanLogic().
+ *
+ * If the originating operation reads at a point in time, the workers all read at that same
+ * timestamp. Otherwise each worker reads from its own snapshot and yields as usual, which gives
+ * the same guarantees as a single yielding collection scan.
+ */
+class DocumentSourceParallelCollectionScan final : public DocumentSource {
+public:
+    static constexpr StringData kStageName = "$_internalParallelCollectionScan"_sd;
+
+    /**
+     * Chooses up to 'numPartitions' - 1 RecordIds that split 'collection' into ranges holding
+     * roughly the same number of records, by sampling the record store with a random cursor.
+     * Returns an empty vector if the record store cannot produce random samples or the collection
+     * is too small to split.
+     */
+    static std::vector<RecordId> sampleSplitPoints(OperationContext* opCtx,
+                                                   const Collection* collection,
+                                                   size_t numPartitions);
+
+    /**
+     * Creates a stage which scans 'collection' in 'splitPoints.size() + 1' ranges, applying
+     * 'query' to each record and grouping the results with a partial copy of 'group'. Must be
+     * called while holding a lock on 'collection'.
+     */
+    static boost::intrusive_ptr<DocumentSourceParallelCollectionScan> create(
+        const boost::intrusive_ptr<ExpressionContext>& expCtx,
+        const Collection* collection,
+        const BSONObj& query,
+        const DocumentSourceGroup& group,
+        std::vector<RecordId> splitPoints);
+
+    ~DocumentSourceParallelCollectionScan();
+
+    const char* getSourceName() const final {
+        return kStageName.rawData();
+    }
+
+    Value serialize(boost::optional<ExplainOptions::Verbosity> explain = boost::none) const final;
+
+    StageConstraints constraints(Pipeline::SplitState pipeState) const final {
+        StageConstraints constraints(StreamType::kStreaming,
+                                     PositionRequirement::kFirst,
+                                     HostTypeRequirement::kAnyShard,
+                                     DiskUseRequirement::kWritesTmpData,
+                                     FacetRequirement::kNotAllowed,
+                                     TransactionRequirement::kNotAllowed,
+                                     LookupRequirement::kNotAllowed,
+                                     UnionRequirement::kNotAllowed);
+
+        constraints.requiresInputDocSource = false;
+        return constraints;
+    }
+
+    boost::optional<DistributedPlanLogic> distributedPlanLogic() final {
+        return boost::none;
+    }
+
+protected:
+    GetNextResult doGetNext() final;
+
+    /**
+     * Stops and joins the worker threads. Workers which are still running are interrupted.
+     */
+    void doDispose() final;
+
+private:
+    /**
+     * Charges each queued document by its size, capped so that any single document fits.
+     */
+    struct QueueCostFunction {
+        size_t operator()(const Document& doc) const;
+    };
+
+    using Queue = MultiProducerSingleConsumerQueue<Document, QueueCostFunction>;
+
+    DocumentSourceParallelCollectionScan(const boost::intrusive_ptr<ExpressionContext>& expCtx,
+                                         const Collection* collection,
+                                         const BSONObj& query,
+                                         BSONObj groupSpec,
+                                         std::vector<RecordId> splitPoints);
+
+    size_t numPartitions() const {
+        return _splitPoints.size() + 1;
+    }
+
+    void startWorkers();
+
+    /**
+     * Scans and groups the records of partition 'partition', pushing the partial groups into
+     * '_queue'. Runs on a worker thread.
+     */
+    void runWorker(size_t partition, boost::intrusive_ptr<ExpressionContext> workerExpCtx);
+
+    /**
+     * Scans and groups the records of partition 'partition' using 'opCtx'.
+     */
+    void scanPartition(OperationContext* opCtx,
+                       size_t partition,
+                       const boost::intrusive_ptr<ExpressionContext>& workerExpCtx);
+
+    void stopWorkers();
+
+    const NamespaceString _nss;
+    const UUID _uuid;
+    const BSONObj _query;
+    const BSONObj _groupSpec;
+    const std::vector<RecordId> _splitPoints;
+
+    // How the workers should read from the storage engine, captured from the originating
+    // operation so that they all observe the same point in time when it has one.
+    const RecoveryUnit::ReadSource _readSource;
+    const boost::optional<Timestamp> _readTimestamp;
+
+    // The time limit of the originating operation, which the workers inherit.
+    Date_t _deadline = Date_t::max();
+    ErrorCodes::Error _timeoutError = ErrorCodes::ExceededTimeLimit;
+
+    Queue _queue;
+    std::vector<stdx::thread> _workers;
+    bool _workersStarted = false;
+    bool _exhausted = false;
+
+    Mutex _mutex = MONGO_MAKE_LATCH("DocumentSourceParallelCollectionScan::_mutex");
+
+    // Guarded by '_mutex'. The operations of the workers which are currently scanning, so that
+    // they can be interrupted when this stage is disposed.
+    std::vector<OperationContext*> _workerOpCtxs;
+
+    // Guarded by '_mutex'. The number of workers which have not yet finished. The last worker to
+    // finish closes the producer end of '_queue'.
+    size_t _numActiveWorkers = 0;
+
+    // Guarded by '_mutex'. The first error raised by any worker.
+    Status _workerStatus = Status::OK();
+
+    // Guarded by '_mutex'. Set once this stage is disposed, so that workers which have not yet
+    // started scanning exit immediately.
+    bool _stopping = false;
+};
+
+}  // namespace mongo
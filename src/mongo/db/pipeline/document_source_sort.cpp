@@ -227,7 +227,9 @@ void DocumentSourceSort::loadDocument(Document&& doc) {
     // already computed the sort key we'd have split the pipeline there, would be merging presorted
     // documents, and wouldn't use this method.
     std::tie(sortKey, docForSorter) = extractSortKey(std::move(doc));
-    _sortExecutor->add(sortKey, docForSorter);
+    // The sorter retains the document until the sort is complete, so it must not keep the arena of
+    // the batch it was produced in alive.
+    _sortExecutor->add(sortKey.copyOutOfArena(), docForSorter.copyOutOfArena());
 }
 
 void DocumentSourceSort::loadingDone() {
@@ -0,0 +1,152 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/pipeline/lookup_hash_table.h"
+
+#include <algorithm>
+
+#include "mongo/db/pipeline/document_path_support.h"
+#include "mongo/util/str.h"
+
+namespace mongo {
+
+LookUpHashTable::LookUpHashTable(FieldPath foreignField,
+                                 const ValueComparator& valueComparator,
+                                 size_t maxSizeBytes)
+    : _foreignField(std::move(foreignField)),
+      _maxSizeBytes(maxSizeBytes),
+      _table(valueComparator.makeUnorderedValueMap<std::vector<size_t>>()) {}
+
+bool LookUpHashTable::canJoinOn(const FieldPath& foreignField) {
+    for (size_t i = 0; i < foreignField.getPathLength(); ++i) {
+        if (str::parseUnsignedBase10Integer(foreignField.getFieldName(i))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool LookUpHashTable::canProbeWith(const Value& localValue) {
+    switch (localValue.getType()) {
+        case BSONType::EOO:
+        case BSONType::jstNULL:
+        case BSONType::Undefined:
+        case BSONType::RegEx:
+        case BSONType::Array:
+            return false;
+        default:
+            return true;
+    }
+}
+
+void LookUpHashTable::add(Document doc) {
+    invariant(_status == TableStatus::kBuilding);
+
+    // The table outlives the batch of results it is built in, so neither the document nor the keys
+    // taken from it may keep that batch's arena alive.
+    doc = doc.copyOutOfArena();
+
+    const size_t position = _documents.size();
+    size_t sizeBytes = doc.getApproximateSize();
+    bool indexed = false;
+    document_path_support::visitAllValuesAtPath(doc, _foreignField, [&](const Value& key) {
+        // Values which cannot be probed for, such as nulls, never need to be looked up.
+        if (!canProbeWith(key)) {
+            return;
+        }
+
+        auto& positions = _table[key];
+        if (positions.empty()) {
+            sizeBytes += key.getApproximateSize();
+        }
+        if (positions.empty() || positions.back() != position) {
+            positions.push_back(position);
+            sizeBytes += sizeof(size_t);
+        }
+        indexed = true;
+    });
+
+    if (!indexed) {
+        return;
+    }
+
+    _documents.push_back(std::move(doc));
+    _sizeBytes += sizeBytes;
+    if (_sizeBytes > _maxSizeBytes) {
+        abandon();
+    }
+}
+
+void LookUpHashTable::freeze() {
+    invariant(_status == TableStatus::kBuilding);
+
+    _status = TableStatus::kServing;
+    _documents.shrink_to_fit();
+}
+
+void LookUpHashTable::abandon() {
+    _status = TableStatus::kAbandoned;
+
+    _documents.clear();
+    _documents.shrink_to_fit();
+    _table.clear();
+    _sizeBytes = 0;
+}
+
+std::vector<Document> LookUpHashTable::probe(const std::vector<Value>& localValues) const {
+    invariant(_status == TableStatus::kServing);
+
+    std::vector<size_t> positions;
+    for (auto&& localValue : localValues) {
+        invariant(canProbeWith(localValue));
+        auto it = _table.find(localValue);
+        if (it != _table.end()) {
+            positions.insert(positions.end(), it->second.begin(), it->second.end());
+        }
+    }
+
+    // A document matching several of the local values is only returned once, as it would be by a
+    // query with an $in predicate.
+    if (localValues.size() > 1) {
+        std::sort(positions.begin(), positions.end());
+        positions.erase(std::unique(positions.begin(), positions.end()), positions.end());
+    }
+
+    std::vector<Document> matches;
+    matches.reserve(positions.size());
+    for (auto position : positions) {
+        matches.push_back(_documents[position]);
+    }
+    return matches;
+}
+
+}  // namespace mongo
@@ -0,0 +1,155 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#pragma once
+
+#include <stddef.h>
+#include <vector>
+
+#include "mongo/db/exec/document_value/document.h"
+#include "mongo/db/exec/document_value/value.h"
+#include "mongo/db/exec/document_value/value_comparator.h"
+#include "mongo/db/pipeline/field_path.h"
+
+namespace mongo {
+
+/**
+ * An in-memory hash table over the documents of a $lookup's foreign collection, keyed on the values
+ * found at the $lookup's 'foreignField' path. Allows a $lookup specified with localField/
+ * foreignField syntax to scan the foreign collection once and then probe the table for each input
+ * document, rather than issuing a query against the foreign collection per input document.
+ *
+ * Like SequentialDocumentCache, the table can be in one of three states: building, serving, or
+ * abandoned. It abandons itself once the documents it holds exceed the maximum size.
+ */
+class LookUpHashTable {
+    LookUpHashTable(const LookUpHashTable&) = delete;
+    LookUpHashTable& operator=(const LookUpHashTable&) = delete;
+
+public:
+    LookUpHashTable(FieldPath foreignField,
+                    const ValueComparator& valueComparator,
+                    size_t maxSizeBytes);
+
+    /**
+     * Defines the states that the table may be in at any given time.
+     */
+    enum class TableStatus {
+        // The table is being filled. More documents may be added.
+        kBuilding,
+
+        // The caller has invoked freeze() to indicate that no more documents need to be added. The
+        // table is read-only at this point.
+        kServing,
+
+        // The maximum permitted size has been exceeded, or the caller has explicitly abandoned the
+        // table. Cannot add more documents or probe the table.
+        kAbandoned,
+    };
+
+    /**
+     * Returns true if the values a query on 'foreignField' would compare against are exactly the
+     * values found by document_path_support::visitAllValuesAtPath(). This is not the case if the
+     * path has numeric components, since queries treat them as positions in arrays as well as
+     * field names.
+     */
+    static bool canJoinOn(const FieldPath& foreignField);
+
+    /**
+     * Returns true if an equality match against 'localValue' on the foreign field can be answered
+     * by the table. Nullish, regex and array values have query semantics beyond those of Value
+     * equality, so their matches must be found by querying the foreign collection.
+     */
+    static bool canProbeWith(const Value& localValue);
+
+    /**
+     * Adds 'doc' to the table, indexing it under each value at the foreign field path. Documents
+     * without any such value are discarded, since no probe can match them. May only be called while
+     * the table is in 'kBuilding' mode.
+     */
+    void add(Document doc);
+
+    /**
+     * Moves the table into 'kServing' (read-only) mode. May only be called while the table is in
+     * 'kBuilding' mode.
+     */
+    void freeze();
+
+    /**
+     * Abandons the table, marking it as 'kAbandoned' and freeing any memory allocated while
+     * building.
+     */
+    void abandon();
+
+    /**
+     * Returns the documents which have a value equal to any of 'localValues' at the foreign field
+     * path, each at most once and in the order they were added. May only be called while the table
+     * is in 'kServing' mode, and each of 'localValues' must satisfy canProbeWith().
+     */
+    std::vector<Document> probe(const std::vector<Value>& localValues) const;
+
+    TableStatus status() const {
+        return _status;
+    }
+
+    size_t sizeBytes() const {
+        return _sizeBytes;
+    }
+
+    size_t count() const {
+        return _documents.size();
+    }
+
+    bool isBuilding() const {
+        return _status == TableStatus::kBuilding;
+    }
+
+    bool isServing() const {
+        return _status == TableStatus::kServing;
+    }
+
+    bool isAbandoned() const {
+        return _status == TableStatus::kAbandoned;
+    }
+
+private:
+    TableStatus _status = TableStatus::kBuilding;
+    const FieldPath _foreignField;
+    const size_t _maxSizeBytes;
+    size_t _sizeBytes = 0;
+
+    std::vector<Document> _documents;
+
+    // Maps each value at the foreign field path to the positions in '_documents' of the documents
+    // which have that value, in ascending order and without duplicates.
+    ValueUnorderedMap<std::vector<size_t>> _table;
+};
+
+}  // namespace mongo
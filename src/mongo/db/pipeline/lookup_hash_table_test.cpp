@@ -0,0 +1,140 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/pipeline/lookup_hash_table.h"
+
+#include "mongo/db/exec/document_value/document_value_test_util.h"
+#include "mongo/db/query/collation/collator_interface_mock.h"
+#include "mongo/unittest/death_test.h"
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+namespace {
+
+const size_t kMaxSizeBytes = 1024 * 1024;
+
+std::vector<int> probeIds(const LookUpHashTable& table, std::vector<Value> localValues) {
+    std::vector<int> ids;
+    for (auto&& doc : table.probe(localValues)) {
+        ids.push_back(doc["_id"].getInt());
+    }
+    return ids;
+}
+
+TEST(LookUpHashTableTest, ProbeReturnsDocumentsWithEqualValues) {
+    ValueComparator comparator;
+    LookUpHashTable table(FieldPath("key"), comparator, kMaxSizeBytes);
+    table.add(DOC("_id" << 0 << "key" << 1));
+    table.add(DOC("_id" << 1 << "key" << 2.0));
+    table.add(DOC("_id" << 2 << "key"
+                        << "1"_sd));
+    table.freeze();
+
+    ASSERT(probeIds(table, {Value(1)}) == (std::vector<int>{0}));
+    ASSERT(probeIds(table, {Value(2LL)}) == (std::vector<int>{1}));
+    ASSERT(probeIds(table, {Value("1"_sd)}) == (std::vector<int>{2}));
+    ASSERT(probeIds(table, {Value(3)}).empty());
+}
+
+TEST(LookUpHashTableTest, IndexesEachElementOfArraysAlongForeignField) {
+    ValueComparator comparator;
+    LookUpHashTable table(FieldPath("a.b"), comparator, kMaxSizeBytes);
+    table.add(DOC("_id" << 0 << "a"
+                        << BSON_ARRAY(BSON("b" << 1) << BSON("b" << BSON_ARRAY(2 << 1)))));
+    table.add(DOC("_id" << 1 << "a" << BSON("b" << 2)));
+    table.freeze();
+
+    ASSERT(probeIds(table, {Value(1)}) == (std::vector<int>{0}));
+    ASSERT(probeIds(table, {Value(2)}) == (std::vector<int>{0, 1}));
+    ASSERT(probeIds(table, {Value(2), Value(1)}) == (std::vector<int>{0, 1}));
+}
+
+TEST(LookUpHashTableTest, DiscardsDocumentsWithoutProbeableValues) {
+    ValueComparator comparator;
+    LookUpHashTable table(FieldPath("key"), comparator, kMaxSizeBytes);
+    table.add(DOC("_id" << 0));
+    table.add(DOC("_id" << 1 << "key" << BSONNULL));
+    table.add(DOC("_id" << 2 << "key" << 1));
+    table.freeze();
+
+    ASSERT_EQ(table.count(), 1ul);
+}
+
+TEST(LookUpHashTableTest, RespectsCollation) {
+    CollatorInterfaceMock collator(CollatorInterfaceMock::MockType::kAlwaysEqual);
+    ValueComparator comparator(&collator);
+    LookUpHashTable table(FieldPath("key"), comparator, kMaxSizeBytes);
+    table.add(DOC("_id" << 0 << "key"
+                        << "foo"_sd));
+    table.freeze();
+
+    ASSERT(probeIds(table, {Value("bar"_sd)}) == (std::vector<int>{0}));
+}
+
+TEST(LookUpHashTableTest, AbandonsTableWhenMaxSizeIsExceeded) {
+    ValueComparator comparator;
+    auto smallDoc = DOC("_id" << 0 << "key" << 0);
+    const size_t maxSizeBytes = 2 * smallDoc.getApproximateSize();
+    LookUpHashTable table(FieldPath("key"), comparator, maxSizeBytes);
+    table.add(smallDoc);
+    ASSERT(table.isBuilding());
+
+    table.add(DOC("_id" << 1 << "key" << std::string(maxSizeBytes, 'x')));
+    ASSERT(table.isAbandoned());
+    ASSERT_EQ(table.count(), 0ul);
+    ASSERT_EQ(table.sizeBytes(), 0ul);
+}
+
+TEST(LookUpHashTableTest, CannotProbeWithNullishRegexOrArrayValues) {
+    ASSERT_FALSE(LookUpHashTable::canProbeWith(Value()));
+    ASSERT_FALSE(LookUpHashTable::canProbeWith(Value(BSONNULL)));
+    ASSERT_FALSE(LookUpHashTable::canProbeWith(Value(BSONUndefined)));
+    ASSERT_FALSE(LookUpHashTable::canProbeWith(Value(BSONRegEx("a"))));
+    ASSERT_FALSE(LookUpHashTable::canProbeWith(Value(std::vector<Value>{Value(1)})));
+    ASSERT_TRUE(LookUpHashTable::canProbeWith(Value(1)));
+    ASSERT_TRUE(LookUpHashTable::canProbeWith(Value(Document{{"a", 1}})));
+}
+
+TEST(LookUpHashTableTest, CannotJoinOnPathsWithNumericComponents) {
+    ASSERT_TRUE(LookUpHashTable::canJoinOn(FieldPath("a.b")));
+    ASSERT_FALSE(LookUpHashTable::canJoinOn(FieldPath("a.0")));
+    ASSERT_FALSE(LookUpHashTable::canJoinOn(FieldPath("0")));
+}
+
+DEATH_TEST(LookUpHashTableTest, CannotProbeTableWhileBuilding, "invariant") {
+    ValueComparator comparator;
+    LookUpHashTable table(FieldPath("key"), comparator, kMaxSizeBytes);
+    table.probe({Value(1)});
+}
+
+}  // namespace
+}  // namespace mongo
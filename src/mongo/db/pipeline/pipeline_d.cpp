@@ -63,6 +63,7 @@
 #include "mongo/db/pipeline/document_source_geo_near_cursor.h"
 #include "mongo/db/pipeline/document_source_group.h"
 #include "mongo/db/pipeline/document_source_match.h"
+#include "mongo/db/pipeline/document_source_parallel_collection_scan.h"
 #include "mongo/db/pipeline/document_source_sample.h"
 #include "mongo/db/pipeline/document_source_sample_from_random_cursor.h"
 #include "mongo/db/pipeline/document_source_single_document_transformation.h"
@@ -71,6 +72,7 @@
 #include "mongo/db/query/collation/collator_interface.h"
 #include "mongo/db/query/get_executor.h"
 #include "mongo/db/query/plan_summary_stats.h"
+#include "mongo/db/query/query_knobs_gen.h"
 #include "mongo/db/query/query_planner.h"
 #include "mongo/db/query/sort_pattern.h"
 #include "mongo/db/s/collection_sharding_state.h"
@@ -80,6 +82,7 @@
 #include "mongo/db/storage/record_store.h"
 #include "mongo/db/storage/sorted_data_interface.h"
 #include "mongo/db/transaction_participant.h"
+#include "mongo/logv2/log.h"
 #include "mongo/rpc/metadata/client_metadata_ismaster.h"
 #include "mongo/s/catalog_cache.h"
 #include "mongo/s/chunk_manager.h"
@@ -171,6 +174,21 @@ StatusWith<unique_ptr<PlanExecutor, PlanExecutor::Deleter>> createRandomCursorEx
         opCtx, std::move(ws), std::move(root), coll, PlanExecutor::YIELD_AUTO);
 }
 
+/**
+ * Returns the sort pattern which orders documents in the reverse of 'sortObj', or boost::none if
+ * 'sortObj' has a component, such as a $meta sort, which cannot be reversed.
+ */
+boost::optional<BSONObj> reverseSortPattern(const BSONObj& sortObj) {
+    BSONObjBuilder reversed;
+    for (auto&& elem : sortObj) {
+        if (!elem.isNumber()) {
+            return boost::none;
+        }
+        reversed.append(elem.fieldNameStringData(), elem.number() > 0 ? -1 : 1);
+    }
+    return reversed.obj();
+}
+
 StatusWith<std::unique_ptr<PlanExecutor, PlanExecutor::Deleter>> attemptToGetExecutor(
     const intrusive_ptr<ExpressionContext>& expCtx,
     Collection* collection,
@@ -481,6 +499,63 @@ auto buildProjectionForPushdown(const DepsTracker& deps, Pipeline* pipeline) {
     // happen. This covers cases 2 and 3.
     return deps.toProjectionWithoutMetadata();
 }
+
+/**
+ * Returns a stage which computes the leading $group of 'pipeline' by scanning 'collection' with
+ * several threads, or nullptr if the pipeline cannot be parallelized. 'exec' is the executor which
+ * would otherwise feed the pipeline; it is only replaced if it is a plain collection scan, since
+ * any index, sort, limit or shard filter it applies would be lost.
+ */
+boost::intrusive_ptr<DocumentSourceParallelCollectionScan> attemptToBuildParallelCollectionScan(
+    const Collection* collection,
+    const PlanExecutor& exec,
+    const BSONObj& queryObj,
+    const Pipeline* pipeline) {
+    const int numWorkers = internalQueryParallelCollectionScanWorkers.load();
+    if (numWorkers < 2 || !collection) {
+        return nullptr;
+    }
+
+    const auto& expCtx = pipeline->getContext();
+    if (expCtx->explain || expCtx->needsMerge || expCtx->fromMongos ||
+        expCtx->opCtx->inMultiDocumentTransaction()) {
+        return nullptr;
+    }
+
+    auto groupStage = dynamic_cast<DocumentSourceGroup*>(pipeline->peekFront());
+    if (!groupStage) {
+        return nullptr;
+    }
+
+    // The workers fetch whole documents, so a projection over the scan can be dropped.
+    auto root = exec.getRootStage();
+    if (root->stageType() == STAGE_PROJECTION_DEFAULT ||
+        root->stageType() == STAGE_PROJECTION_SIMPLE) {
+        root = root->getChildren()[0].get();
+    }
+    if (root->stageType() != STAGE_COLLSCAN) {
+        return nullptr;
+    }
+
+    if (static_cast<long long>(collection->numRecords(expCtx->opCtx)) <
+        internalQueryParallelCollectionScanMinRecords.load()) {
+        return nullptr;
+    }
+
+    auto splitPoints = DocumentSourceParallelCollectionScan::sampleSplitPoints(
+        expCtx->opCtx, collection, static_cast<size_t>(numWorkers));
+    if (splitPoints.empty()) {
+        return nullptr;
+    }
+
+    LOGV2_DEBUG(5380500,
+                2,
+                "Computing leading $group with a parallel collection scan",
+                "namespace"_attr = collection->ns(),
+                "partitions"_attr = splitPoints.size() + 1);
+    return DocumentSourceParallelCollectionScan::create(
+        expCtx, collection, queryObj, *groupStage, std::move(splitPoints));
+}
 }  // namespace
 
 std::pair<PipelineD::AttachExecutorCallback, std::unique_ptr<PlanExecutor, PlanExecutor::Deleter>>
@@ -562,9 +637,23 @@ PipelineD::buildInnerQueryExecutorGeneric(Collection* collection,
         (pipeline->peekFront() && pipeline->peekFront()->constraints().isChangeStreamStage());
 
     auto attachExecutorCallback =
-        [cursorType, trackOplogTS](Collection* collection,
-                                   std::unique_ptr<PlanExecutor, PlanExecutor::Deleter> exec,
-                                   Pipeline* pipeline) {
+        [cursorType, trackOplogTS, queryObj](
+            Collection* collection,
+            std::unique_ptr<PlanExecutor, PlanExecutor::Deleter> exec,
+            Pipeline* pipeline) {
+            if (auto parallelScan =
+                    attemptToBuildParallelCollectionScan(collection, *exec, queryObj, pipeline)) {
+                // Split the $group into the partial groups computed by the workers and the stage
+                // which merges them, exactly as when the $group runs on several shards. The
+                // executor is no longer needed since the workers build their own scans.
+                auto& sources = pipeline->_sources;
+                auto mergingStage = sources.front()->distributedPlanLogic()->mergingStage;
+                sources.pop_front();
+                pipeline->addInitialSource(std::move(mergingStage));
+                pipeline->addInitialSource(std::move(parallelScan));
+                return;
+            }
+
             auto cursor = DocumentSourceCursor::create(
                 collection, std::move(exec), pipeline->getContext(), cursorType, trackOplogTS);
             pipeline->addInitialSource(std::move(cursor));
@@ -692,7 +781,16 @@ StatusWith<std::unique_ptr<PlanExecutor, PlanExecutor::Deleter>> PipelineD::prep
         projObj = buildProjectionForPushdown(deps, pipeline);
     }
 
-    if (rewrittenGroupStage) {
+    // A $group which needs the last document of each group is answered by scanning in the reverse
+    // of the requested sort order, which finds the last document of each group first.
+    boost::optional<BSONObj> groupSortObj = sortObj;
+    if (rewrittenGroupStage &&
+        rewrittenGroupStage->expectedInput() ==
+            GroupFromFirstDocumentTransformation::ExpectedInput::kLastDocument) {
+        groupSortObj = reverseSortPattern(sortObj);
+    }
+
+    if (rewrittenGroupStage && groupSortObj) {
         // See if the query system can handle the $group and $sort stage using a DISTINCT_SCAN
         // (SERVER-9507).
         auto swExecutorGrouped = attemptToGetExecutor(expCtx,
@@ -701,7 +799,7 @@ StatusWith<std::unique_ptr<PlanExecutor, PlanExecutor::Deleter>> PipelineD::prep
                                                       queryObj,
                                                       projObj,
                                                       deps.metadataDeps(),
-                                                      sortObj,
+                                                      *groupSortObj,
                                                       boost::none, /* limit */
                                                       rewrittenGroupStage->groupId(),
                                                       aggRequest,
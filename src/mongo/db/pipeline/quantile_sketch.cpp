@@ -0,0 +1,248 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/pipeline/quantile_sketch.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+#include "mongo/db/exec/document_value/document.h"
+#include "mongo/util/assert_util.h"
+#include "mongo/util/str.h"
+
+namespace mongo {
+
+QuantileSketch::QuantileSketch(const ValueComparator& comparator, int k)
+    : _comparator(comparator), _k(k), _levels(1) {
+    invariant(_k >= kMinK && _k <= kMaxK);
+}
+
+QuantileSketch QuantileSketch::parse(const ValueComparator& comparator, const Value& serialized) {
+    auto isValid = [&]() {
+        if (serialized.getType() != BSONType::Object || !serialized["k"].integral() ||
+            serialized["count"].getType() != BSONType::NumberLong ||
+            serialized["levels"].getType() != BSONType::Array) {
+            return false;
+        }
+        const int k = serialized["k"].coerceToInt();
+        return k >= kMinK && k <= kMaxK && !serialized["levels"].getArray().empty() &&
+            (serialized["count"].getLong() == 0 ||
+             (!serialized["min"].missing() && !serialized["max"].missing()));
+    };
+    uassert(5380606,
+            str::stream() << "Invalid serialized quantile sketch: " << serialized.toString(),
+            isValid());
+
+    QuantileSketch sketch(comparator, serialized["k"].coerceToInt());
+    sketch._count = serialized["count"].getLong();
+    sketch._min = serialized["min"];
+    sketch._max = serialized["max"];
+    sketch._levels.clear();
+    for (auto&& level : serialized["levels"].getArray()) {
+        uassert(5380606,
+                str::stream() << "Invalid serialized quantile sketch: " << serialized.toString(),
+                level.getType() == BSONType::Array);
+        sketch._levels.emplace_back(level.getArray());
+        sketch._numRetained += level.getArray().size();
+        for (auto&& value : level.getArray()) {
+            sketch._approximateSize += value.getApproximateSize();
+        }
+    }
+    return sketch;
+}
+
+void QuantileSketch::add(Value value) {
+    if (_count == 0 || _comparator.evaluate(value < _min)) {
+        _min = value;
+    }
+    if (_count == 0 || _comparator.evaluate(value > _max)) {
+        _max = value;
+    }
+    ++_count;
+
+    _approximateSize += value.getApproximateSize();
+    _levels.front().push_back(std::move(value));
+    ++_numRetained;
+    compress();
+}
+
+void QuantileSketch::merge(const QuantileSketch& other) {
+    uassert(5380605,
+            str::stream() << "Cannot merge quantile sketches with different sizes: " << _k
+                          << " and " << other._k,
+            _k == other._k);
+    if (other.empty()) {
+        return;
+    }
+
+    if (_count == 0 || _comparator.evaluate(other._min < _min)) {
+        _min = other._min;
+    }
+    if (_count == 0 || _comparator.evaluate(other._max > _max)) {
+        _max = other._max;
+    }
+    _count += other._count;
+
+    if (_levels.size() < other._levels.size()) {
+        _levels.resize(other._levels.size());
+    }
+    for (size_t level = 0; level < other._levels.size(); ++level) {
+        _levels[level].insert(
+            _levels[level].end(), other._levels[level].begin(), other._levels[level].end());
+    }
+    _numRetained += other._numRetained;
+    _approximateSize += other._approximateSize;
+    compress();
+}
+
+size_t QuantileSketch::capacity(size_t level) const {
+    const size_t depth = _levels.size() - 1 - level;
+    return std::max<size_t>(2, std::ceil(_k * std::pow(2.0 / 3.0, depth)));
+}
+
+void QuantileSketch::compress() {
+    while (true) {
+        size_t totalCapacity = 0;
+        for (size_t level = 0; level < _levels.size(); ++level) {
+            totalCapacity += capacity(level);
+        }
+        if (_numRetained <= totalCapacity) {
+            return;
+        }
+
+        // Some level must be full, since the sketch as a whole is. Compact the lowest one.
+        size_t level = 0;
+        while (_levels[level].size() < capacity(level)) {
+            ++level;
+        }
+        if (level + 1 == _levels.size()) {
+            _levels.emplace_back();
+        }
+        auto& compactor = _levels[level];
+        auto& nextCompactor = _levels[level + 1];
+
+        std::sort(compactor.begin(), compactor.end(), _comparator.getLessThan());
+
+        // With an odd number of values, one of them stays behind so that the total weight of the
+        // sketch is preserved.
+        boost::optional<Value> leftover;
+        if (compactor.size() % 2 == 1) {
+            leftover = std::move(compactor.back());
+            compactor.pop_back();
+        }
+
+        // Promote either the values at even or at odd positions, each of which now stands for
+        // itself and its discarded neighbor.
+        const size_t offset = _random.nextInt32(2);
+        for (size_t i = 0; i < compactor.size(); ++i) {
+            if (i % 2 == offset) {
+                nextCompactor.push_back(std::move(compactor[i]));
+            } else {
+                _approximateSize -= compactor[i].getApproximateSize();
+            }
+        }
+        _numRetained -= compactor.size() / 2;
+
+        compactor.clear();
+        if (leftover) {
+            compactor.push_back(std::move(*leftover));
+        }
+    }
+}
+
+Value QuantileSketch::quantile(double rank) const {
+    return quantiles({rank}).front();
+}
+
+std::vector<Value> QuantileSketch::quantiles(const std::vector<double>& ranks) const {
+    invariant(!empty());
+
+    std::vector<std::pair<const Value*, long long>> weightedValues;
+    weightedValues.reserve(_numRetained);
+    for (size_t level = 0; level < _levels.size(); ++level) {
+        for (auto&& value : _levels[level]) {
+            weightedValues.emplace_back(&value, 1LL << level);
+        }
+    }
+    std::sort(weightedValues.begin(),
+              weightedValues.end(),
+              [this](const auto& lhs, const auto& rhs) {
+                  return _comparator.evaluate(*lhs.first < *rhs.first);
+              });
+
+    // Visit the ranks in increasing order, so that the retained values are only walked once.
+    std::vector<size_t> order(ranks.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](size_t lhs, size_t rhs) {
+        return ranks[lhs] < ranks[rhs];
+    });
+
+    std::vector<Value> results(ranks.size());
+    auto it = weightedValues.begin();
+    long long cumulativeWeight = 0;
+    for (size_t index : order) {
+        const double rank = ranks[index];
+        if (rank <= 0) {
+            results[index] = _min;
+            continue;
+        }
+
+        // Find the first value whose cumulative weight reaches the target rank.
+        const double target = rank * _count;
+        while (it != weightedValues.end() && cumulativeWeight + it->second < target) {
+            cumulativeWeight += it->second;
+            ++it;
+        }
+        results[index] = rank >= 1 || it == weightedValues.end() ? _max : *it->first;
+    }
+    return results;
+}
+
+Value QuantileSketch::serialize() const {
+    std::vector<Value> levels;
+    levels.reserve(_levels.size());
+    for (auto&& level : _levels) {
+        levels.emplace_back(level);
+    }
+
+    MutableDocument serialized;
+    serialized.addField("k", Value(_k));
+    serialized.addField("count", Value(_count));
+    if (!empty()) {
+        serialized.addField("min", _min);
+        serialized.addField("max", _max);
+    }
+    serialized.addField("levels", Value(std::move(levels)));
+    return serialized.freezeToValue();
+}
+
+}  // namespace mongo
@@ -0,0 +1,139 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <vector>
+
+#include "mongo/db/exec/document_value/value.h"
+#include "mongo/db/exec/document_value/value_comparator.h"
+#include "mongo/platform/random.h"
+
+namespace mongo {
+
+/**
+ * A KLL sketch (Karnin, Lang and Liberty, 2016) for estimating the quantiles of a stream of Values
+ * in bounded memory. The sketch keeps about 3 * k of the values it has seen, in levels of
+ * "compactors". A value in level h stands for 2^h of the input values. When the sketch is full,
+ * the lowest level that is over its capacity is sorted, and every other value in it is promoted to
+ * the next level.
+ *
+ * The values are compared with the given ValueComparator, so any Values can be sketched, and every
+ * quantile returned is one of the values that was added. The rank error is proportional to 1 / k.
+ * The minimum and maximum values are tracked exactly.
+ *
+ * Sketches merge by concatenating their levels and then compacting, so they can be computed
+ * separately, for example on each shard, and combined without loss of accuracy.
+ */
+class QuantileSketch {
+public:
+    static constexpr int kDefaultK = 200;
+    static constexpr int kMinK = 8;
+    static constexpr int kMaxK = 65535;
+
+    explicit QuantileSketch(const ValueComparator& comparator, int k = kDefaultK);
+
+    /**
+     * Parses a sketch serialized by serialize(). Throws if 'serialized' was not produced by it.
+     */
+    static QuantileSketch parse(const ValueComparator& comparator, const Value& serialized);
+
+    void add(Value value);
+
+    /**
+     * Adds all of the values represented by 'other', which must have the same 'k', to this sketch.
+     */
+    void merge(const QuantileSketch& other);
+
+    /**
+     * Returns an estimate of the value with the given normalized rank in [0, 1]. A rank of 0 is
+     * the minimum and a rank of 1 the maximum. The sketch must not be empty.
+     */
+    Value quantile(double rank) const;
+
+    /**
+     * Returns quantile() for each of 'ranks', sorting the retained values only once.
+     */
+    std::vector<Value> quantiles(const std::vector<double>& ranks) const;
+
+    /**
+     * Returns the sketch as a Value, including every retained value, so that it can be sent to
+     * another node and merged there.
+     */
+    Value serialize() const;
+
+    int getK() const {
+        return _k;
+    }
+
+    long long count() const {
+        return _count;
+    }
+
+    bool empty() const {
+        return _count == 0;
+    }
+
+    /**
+     * Returns the approximate memory used by the retained values.
+     */
+    size_t getApproximateSize() const {
+        return _approximateSize;
+    }
+
+private:
+    /**
+     * The number of values that level 'level' may hold before it needs to be compacted. Levels
+     * shrink geometrically below the top one, so most of the retained values are in the levels
+     * with the highest weights.
+     */
+    size_t capacity(size_t level) const;
+
+    /**
+     * Compacts levels until the sketch holds no more values than the sum of their capacities.
+     */
+    void compress();
+
+    ValueComparator _comparator;
+    int _k;
+    long long _count = 0;
+    Value _min;
+    Value _max;
+
+    // The values in each level. A value in _levels[h] has a weight of 2^h.
+    std::vector<std::vector<Value>> _levels;
+    size_t _numRetained = 0;
+    size_t _approximateSize = 0;
+
+    // Decides which half of a level is promoted. Seeded with a constant, so that the result of a
+    // sketch only depends on its input.
+    PseudoRandom _random{0};
+};
+
+}  // namespace mongo
@@ -0,0 +1,135 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <cmath>
+#include <vector>
+
+#include "mongo/db/exec/document_value/document_value_test_util.h"
+#include "mongo/db/exec/document_value/value.h"
+#include "mongo/db/exec/document_value/value_comparator.h"
+#include "mongo/db/pipeline/quantile_sketch.h"
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+namespace {
+
+// Permutes [0, n) for a prime 'n', so that values are not added to the sketch in sorted order.
+long long permuted(long long i, long long n) {
+    return (i * 7919) % n;
+}
+
+void assertRankWithin(const QuantileSketch& sketch, double rank, double tolerance) {
+    const double estimate = sketch.quantile(rank).coerceToDouble();
+    ASSERT_LTE(std::abs(estimate / sketch.count() - rank), tolerance)
+        << "rank " << rank << " estimated as " << estimate;
+}
+
+TEST(QuantileSketchTest, IsExactWhileNoValuesHaveBeenCompacted) {
+    QuantileSketch sketch(ValueComparator::kInstance);
+    for (int i = 99; i >= 0; --i) {
+        sketch.add(Value(i));
+    }
+
+    ASSERT_EQ(100, sketch.count());
+    ASSERT_VALUE_EQ(Value(0), sketch.quantile(0));
+    ASSERT_VALUE_EQ(Value(49), sketch.quantile(0.5));
+    ASSERT_VALUE_EQ(Value(89), sketch.quantile(0.9));
+    ASSERT_VALUE_EQ(Value(99), sketch.quantile(1));
+
+    const auto quantiles = sketch.quantiles({0.9, 0.1, 0.5});
+    ASSERT_VALUE_EQ(Value(89), quantiles[0]);
+    ASSERT_VALUE_EQ(Value(9), quantiles[1]);
+    ASSERT_VALUE_EQ(Value(49), quantiles[2]);
+}
+
+TEST(QuantileSketchTest, EstimatesRanksOfLargeInputsInBoundedMemory) {
+    const long long n = 100003;
+    QuantileSketch sketch(ValueComparator::kInstance);
+    for (long long i = 0; i < n; ++i) {
+        sketch.add(Value(permuted(i, n)));
+    }
+
+    ASSERT_EQ(n, sketch.count());
+    ASSERT_VALUE_EQ(Value(0LL), sketch.quantile(0));
+    ASSERT_VALUE_EQ(Value(n - 1), sketch.quantile(1));
+    for (double rank = 0.1; rank < 1; rank += 0.1) {
+        assertRankWithin(sketch, rank, 0.03);
+    }
+
+    // The sketch keeps a few times 'k' values, not a fraction of the input.
+    ASSERT_LT(sketch.getApproximateSize(), 10 * QuantileSketch::kDefaultK * sizeof(Value));
+}
+
+TEST(QuantileSketchTest, MergesSerializedSketches) {
+    const long long n = 100003;
+    const int numShards = 4;
+    std::vector<QuantileSketch> shards(numShards, QuantileSketch(ValueComparator::kInstance));
+    for (long long i = 0; i < n; ++i) {
+        shards[i % numShards].add(Value(permuted(i, n)));
+    }
+
+    QuantileSketch merged(ValueComparator::kInstance);
+    for (auto&& shard : shards) {
+        merged.merge(QuantileSketch::parse(ValueComparator::kInstance, shard.serialize()));
+    }
+
+    ASSERT_EQ(n, merged.count());
+    ASSERT_VALUE_EQ(Value(0LL), merged.quantile(0));
+    ASSERT_VALUE_EQ(Value(n - 1), merged.quantile(1));
+    for (double rank = 0.1; rank < 1; rank += 0.1) {
+        assertRankWithin(merged, rank, 0.03);
+    }
+}
+
+TEST(QuantileSketchTest, MergingEmptySketchesLeavesSketchEmpty) {
+    QuantileSketch sketch(ValueComparator::kInstance);
+    QuantileSketch empty(ValueComparator::kInstance);
+    sketch.merge(QuantileSketch::parse(ValueComparator::kInstance, empty.serialize()));
+    ASSERT_TRUE(sketch.empty());
+}
+
+TEST(QuantileSketchTest, RejectsIncompatibleSketches) {
+    QuantileSketch sketch(ValueComparator::kInstance);
+    QuantileSketch other(ValueComparator::kInstance, QuantileSketch::kDefaultK / 2);
+    ASSERT_THROWS_CODE(sketch.merge(other), AssertionException, 5380605);
+
+    ASSERT_THROWS_CODE(QuantileSketch::parse(ValueComparator::kInstance, Value(1)),
+                       AssertionException,
+                       5380606);
+    ASSERT_THROWS_CODE(
+        QuantileSketch::parse(ValueComparator::kInstance,
+                              Value(Document{{"k", 1}, {"count", 0LL}, {"levels", Value()}})),
+        AssertionException,
+        5380606);
+}
+
+}  // namespace
+}  // namespace mongo
@@ -41,7 +41,8 @@ void SequentialDocumentCache::add(Document doc) {
 
     if (checkCacheSize(doc) != CacheStatus::kAbandoned) {
         _sizeBytes += doc.getApproximateSize();
-        _cache.push_back(std::move(doc));
+        // The cache is served across batches, so it must not keep the arena of this one alive.
+        _cache.push_back(doc.copyOutOfArena());
     }
 }
 
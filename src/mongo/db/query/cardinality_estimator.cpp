@@ -0,0 +1,186 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#define MONGO_LOGV2_DEFAULT_COMPONENT ::mongo::logv2::LogComponent::kQuery
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/query/cardinality_estimator.h"
+
+#include <algorithm>
+
+#include "mongo/db/catalog/collection.h"
+#include "mongo/db/operation_context.h"
+#include "mongo/db/query/canonical_query.h"
+#include "mongo/db/query/collection_statistics.h"
+#include "mongo/db/query/query_knobs_gen.h"
+#include "mongo/db/query/query_solution.h"
+#include "mongo/logv2/log.h"
+
+namespace mongo {
+namespace cardinality_estimator {
+namespace {
+
+// Estimates below this many keys and documents are too small for a plan which is many times more
+// expensive to be worth discarding untried.
+constexpr double kMinEstimateForPruning = 100;
+
+bool isUnbounded(const OrderedIntervalList& oil) {
+    if (oil.intervals.size() != 1) {
+        return false;
+    }
+    const auto& interval = oil.intervals[0];
+    return interval.isMinToMax() ||
+        (interval.start.type() == BSONType::MaxKey && interval.end.type() == BSONType::MinKey);
+}
+
+boost::optional<double> estimateIndexScan(OperationContext* opCtx,
+                                          const Collection* collection,
+                                          const IndexScanNode* node) {
+    // The histograms order values as BSON does without a collation, so they only describe the keys
+    // of ordinary indexes without one.
+    if (node->index.type != INDEX_BTREE || node->index.collator || node->bounds.isSimpleRange ||
+        node->bounds.fields.empty()) {
+        return boost::none;
+    }
+
+    // The fields are assumed to be independent, so the fraction of keys within the bounds is the
+    // product of the fractions within each field's bounds. The leading field is always estimated,
+    // since its statistics also say how many keys each document has, and a later field only if it
+    // is bounded.
+    auto& statsCache = CollectionStatisticsCache::get(opCtx->getServiceContext());
+    double selectivity = 1;
+    double keysPerDoc = 1;
+    BSONObjIterator keyPattern(node->index.keyPattern);
+    for (size_t i = 0; i < node->bounds.fields.size() && keyPattern.more(); ++i) {
+        const auto field = keyPattern.next().fieldNameStringData();
+        const auto& oil = node->bounds.fields[i];
+        if (i > 0 && isUnbounded(oil)) {
+            continue;
+        }
+
+        auto stats = statsCache.getFieldStatistics(opCtx, collection->ns(), field);
+        if (!stats || stats->numDocs == 0) {
+            return boost::none;
+        }
+        const auto fieldSelectivity = stats->estimateSelectivity(oil);
+        if (!fieldSelectivity) {
+            return boost::none;
+        }
+        selectivity *= *fieldSelectivity;
+
+        // A document has more than one key only for the values of its one array field, if any.
+        keysPerDoc = std::max(keysPerDoc, static_cast<double>(stats->numKeys) / stats->numDocs);
+    }
+
+    // Scale the sample to the current size of the collection.
+    return selectivity * keysPerDoc * collection->numRecords(opCtx);
+}
+
+}  // namespace
+
+boost::optional<double> estimateNumExamined(OperationContext* opCtx,
+                                            const Collection* collection,
+                                            const QuerySolutionNode* node) {
+    switch (node->getType()) {
+        case STAGE_COLLSCAN:
+            return static_cast<double>(collection->numRecords(opCtx));
+        case STAGE_IXSCAN:
+            return estimateIndexScan(opCtx, collection, static_cast<const IndexScanNode*>(node));
+        default:
+            break;
+    }
+
+    // Other stages examine nothing themselves, but must have children to estimate.
+    if (node->children.empty()) {
+        return boost::none;
+    }
+    double total = 0;
+    for (auto&& child : node->children) {
+        auto estimate = estimateNumExamined(opCtx, collection, child);
+        if (!estimate) {
+            return boost::none;
+        }
+        total += *estimate;
+    }
+
+    // A fetch examines about one document for each index key its children examine.
+    return node->getType() == STAGE_FETCH ? 2 * total : total;
+}
+
+void estimateAndPruneSolutions(OperationContext* opCtx,
+                               const Collection* collection,
+                               const CanonicalQuery& query,
+                               std::vector<std::unique_ptr<QuerySolution>>* solutions) {
+    if (!internalQueryPlannerUseStatistics.load() || solutions->size() < 2 ||
+        collection->ns().isSystem() || opCtx->inMultiDocumentTransaction()) {
+        return;
+    }
+
+    boost::optional<double> bestEstimate;
+    for (auto&& solution : *solutions) {
+        solution->estimatedNumExamined =
+            estimateNumExamined(opCtx, collection, solution->root.get());
+        if (solution->estimatedNumExamined &&
+            (!bestEstimate || *solution->estimatedNumExamined < *bestEstimate)) {
+            bestEstimate = solution->estimatedNumExamined;
+        }
+    }
+
+    // A plan which examines much more in total may still produce the first few results sooner, for
+    // instance by providing the requested sort order, so only prune when all results are needed.
+    const auto& request = query.getQueryRequest();
+    if (!bestEstimate || request.getLimit() || request.getNToReturn() ||
+        !request.getSort().isEmpty() || request.isTailable()) {
+        return;
+    }
+
+    const double threshold = internalQueryPlannerStatisticsPruningRatio.load() *
+        std::max(*bestEstimate, kMinEstimateForPruning);
+    auto isTooExpensive = [&](const std::unique_ptr<QuerySolution>& solution) {
+        return solution->estimatedNumExamined && *solution->estimatedNumExamined > threshold;
+    };
+    const auto numPruned = std::count_if(solutions->begin(), solutions->end(), isTooExpensive);
+    if (numPruned == 0) {
+        return;
+    }
+
+    LOGV2_DEBUG(5380307,
+                2,
+                "Discarding candidate plans estimated to be much more expensive than the best plan",
+                "query"_attr = redact(query.toStringShort()),
+                "numPruned"_attr = numPruned,
+                "bestEstimate"_attr = *bestEstimate);
+    solutions->erase(std::remove_if(solutions->begin(), solutions->end(), isTooExpensive),
+                     solutions->end());
+}
+
+}  // namespace cardinality_estimator
+}  // namespace mongo
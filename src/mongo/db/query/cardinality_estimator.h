@@ -0,0 +1,73 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#pragma once
+
+#include <boost/optional.hpp>
+#include <memory>
+#include <vector>
+
+namespace mongo {
+
+class CanonicalQuery;
+class Collection;
+class OperationContext;
+struct QuerySolution;
+class QuerySolutionNode;
+
+/**
+ * Estimates how much work candidate plans do, using the statistics collected by the 'analyze'
+ * command.
+ */
+namespace cardinality_estimator {
+
+/**
+ * Returns the estimated number of index keys and documents the plan for 'node' examines, or
+ * boost::none if some part of the plan cannot be estimated. Only collection scans, and scans of
+ * ascending or descending indexes without a collation whose leading field and bounded fields all
+ * have statistics, can be estimated.
+ */
+boost::optional<double> estimateNumExamined(OperationContext* opCtx,
+                                            const Collection* collection,
+                                            const QuerySolutionNode* node);
+
+/**
+ * Sets QuerySolution::estimatedNumExamined on each of 'solutions' which can be estimated. Unless
+ * the query needs only some of its results, also removes the solutions estimated to examine more
+ * than 'internalQueryPlannerStatisticsPruningRatio' times as much as the best estimated solution,
+ * so that they are not trial run. Never removes every solution.
+ */
+void estimateAndPruneSolutions(OperationContext* opCtx,
+                               const Collection* collection,
+                               const CanonicalQuery& query,
+                               std::vector<std::unique_ptr<QuerySolution>>* solutions);
+
+}  // namespace cardinality_estimator
+}  // namespace mongo
@@ -0,0 +1,419 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#define MONGO_LOGV2_DEFAULT_COMPONENT ::mongo::logv2::LogComponent::kQuery
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/query/collection_statistics.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/bson/simple_bsonelement_comparator.h"
+#include "mongo/db/bson/dotted_path_support.h"
+#include "mongo/db/catalog/collection.h"
+#include "mongo/db/catalog/collection_catalog.h"
+#include "mongo/db/concurrency/d_concurrency.h"
+#include "mongo/db/operation_context.h"
+#include "mongo/db/query/query_knobs_gen.h"
+#include "mongo/db/service_context.h"
+#include "mongo/logv2/log.h"
+
+namespace mongo {
+namespace {
+
+const auto getCollectionStatisticsCache =
+    ServiceContext::declareDecoration<CollectionStatisticsCache>();
+
+int compareValues(const BSONElement& lhs, const BSONElement& rhs) {
+    return lhs.woCompare(rhs, false);
+}
+
+double getNumber(const BSONObj& obj, StringData fieldName) {
+    const auto elem = obj[fieldName];
+    uassert(5380301,
+            str::stream() << "Expected a number for statistics field '" << fieldName
+                          << "', got: " << elem,
+            elem.isNumber());
+    return elem.numberDouble();
+}
+
+/**
+ * Returns the fraction of the values which lie strictly between 'lower' and 'upper' that also fall
+ * within 'interval', which must be ascending.
+ */
+double rangeFraction(const Interval& interval,
+                     const BSONElement& lower,
+                     const BSONElement& upper,
+                     double numDistinct) {
+    if (compareValues(interval.start, upper) >= 0 || compareValues(interval.end, lower) <= 0) {
+        return 0;
+    }
+
+    const bool coversStart = compareValues(interval.start, lower) <= 0;
+    const bool coversEnd = compareValues(interval.end, upper) >= 0;
+    if (coversStart && coversEnd) {
+        return 1;
+    }
+    if (interval.isPoint()) {
+        return 1 / std::max(numDistinct, 1.0);
+    }
+
+    // Interpolate within numeric ranges. A bound which falls strictly between two numbers must
+    // itself be a number.
+    if (lower.isNumber() && upper.isNumber()) {
+        const double low = lower.numberDouble();
+        const double high = upper.numberDouble();
+        const double start = coversStart ? low : interval.start.numberDouble();
+        const double end = coversEnd ? high : interval.end.numberDouble();
+        const double fraction = (end - start) / (high - low);
+        if (std::isfinite(fraction)) {
+            return std::min(std::max(fraction, 0.0), 1.0);
+        }
+    }
+    return 0.5;
+}
+
+}  // namespace
+
+DistinctValueSketch::DistinctValueSketch(size_t size) : _size(std::max<size_t>(size, 2)) {}
+
+void DistinctValueSketch::add(const BSONElement& value) {
+    // The estimate relies on hashes being spread uniformly, so mix the bits of the BSON hash.
+    uint64_t hash = SimpleBSONElementComparator::kInstance.hash(value);
+    hash = (hash ^ (hash >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    hash = (hash ^ (hash >> 27)) * 0x94d049bb133111ebULL;
+    hash = hash ^ (hash >> 31);
+
+    if (_minHashes.size() == _size && hash >= *_minHashes.rbegin()) {
+        return;
+    }
+    if (_minHashes.insert(hash).second && _minHashes.size() > _size) {
+        _minHashes.erase(std::prev(_minHashes.end()));
+    }
+}
+
+double DistinctValueSketch::estimate() const {
+    if (_minHashes.size() < _size) {
+        return _minHashes.size();
+    }
+    const double largest = static_cast<double>(*_minHashes.rbegin()) /
+        static_cast<double>(std::numeric_limits<uint64_t>::max());
+    return (_size - 1) / std::max(largest, std::numeric_limits<double>::min());
+}
+
+FieldHistogram FieldHistogram::build(std::vector<BSONElement> values, size_t maxBuckets) {
+    FieldHistogram histogram;
+    if (values.empty()) {
+        return histogram;
+    }
+
+    const auto& comparator = SimpleBSONElementComparator::kInstance;
+    std::sort(values.begin(), values.end(), comparator.makeLessThan());
+    histogram._total = values.size();
+
+    // The first bucket holds only the smallest value, so that every other bucket's range has a
+    // lower bound. The remaining values are split into buckets of about 'targetDepth' values.
+    const double targetDepth =
+        static_cast<double>(values.size()) / std::max<size_t>(maxBuckets - 1, 1);
+    double rangeCount = 0;
+    double rangeDistinct = 0;
+    for (size_t runStart = 0; runStart < values.size();) {
+        size_t runEnd = runStart + 1;
+        while (runEnd < values.size() && comparator.evaluate(values[runEnd] == values[runStart])) {
+            ++runEnd;
+        }
+        const double runCount = runEnd - runStart;
+
+        if (histogram._buckets.empty() || runEnd == values.size() ||
+            rangeCount + runCount >= targetDepth) {
+            histogram._buckets.push_back(
+                {values[runStart].wrap(""), runCount, rangeCount, rangeDistinct});
+            rangeCount = 0;
+            rangeDistinct = 0;
+        } else {
+            rangeCount += runCount;
+            ++rangeDistinct;
+        }
+        runStart = runEnd;
+    }
+    return histogram;
+}
+
+FieldHistogram FieldHistogram::parse(const BSONElement& elem) {
+    uassert(5380302,
+            str::stream() << "Expected an array for a histogram, got: " << elem,
+            elem.type() == Array);
+
+    FieldHistogram histogram;
+    BSONElement previousBound;
+    for (auto&& bucketElem : elem.Obj()) {
+        uassert(5380303,
+                str::stream() << "Expected an object for a histogram bucket, got: " << bucketElem,
+                bucketElem.type() == Object);
+        const auto bucketObj = bucketElem.Obj();
+        const auto upperBound = bucketObj["upperBound"];
+        uassert(5380304, "Histogram bucket is missing its upper bound", !upperBound.eoo());
+        uassert(5380305,
+                "Histogram buckets are not in ascending order",
+                previousBound.eoo() || compareValues(previousBound, upperBound) < 0);
+        previousBound = upperBound;
+
+        Bucket bucket{upperBound.wrap(""),
+                      getNumber(bucketObj, "boundCount"),
+                      getNumber(bucketObj, "rangeCount"),
+                      getNumber(bucketObj, "rangeDistinct")};
+        histogram._total += bucket.boundCount + bucket.rangeCount;
+        histogram._buckets.push_back(std::move(bucket));
+    }
+    return histogram;
+}
+
+void FieldHistogram::serialize(StringData fieldName, BSONObjBuilder* builder) const {
+    BSONArrayBuilder bucketsBuilder(builder->subarrayStart(fieldName));
+    for (auto&& bucket : _buckets) {
+        BSONObjBuilder bucketBuilder(bucketsBuilder.subobjStart());
+        bucketBuilder.appendAs(bucket.upperBound.firstElement(), "upperBound");
+        bucketBuilder.append("boundCount", bucket.boundCount);
+        bucketBuilder.append("rangeCount", bucket.rangeCount);
+        bucketBuilder.append("rangeDistinct", bucket.rangeDistinct);
+    }
+}
+
+double FieldHistogram::estimate(const Interval& interval) const {
+    if (interval.getDirection() == Interval::Direction::kDirectionDescending) {
+        return estimate(interval.reverseClone());
+    }
+
+    double result = 0;
+    BSONElement lower;
+    for (auto&& bucket : _buckets) {
+        const auto upper = bucket.upperBound.firstElement();
+        if (!lower.eoo() && bucket.rangeCount > 0) {
+            result +=
+                bucket.rangeCount * rangeFraction(interval, lower, upper, bucket.rangeDistinct);
+        }
+
+        const int startCmp = compareValues(interval.start, upper);
+        const int endCmp = compareValues(interval.end, upper);
+        if ((startCmp < 0 || (startCmp == 0 && interval.startInclusive)) &&
+            (endCmp > 0 || (endCmp == 0 && interval.endInclusive))) {
+            result += bucket.boundCount;
+        }
+        if (endCmp < 0) {
+            // No later bucket overlaps the interval.
+            break;
+        }
+        lower = upper;
+    }
+    return result;
+}
+
+double FieldHistogram::estimate(const OrderedIntervalList& oil) const {
+    double result = 0;
+    for (auto&& interval : oil.intervals) {
+        result += estimate(interval);
+    }
+    return std::min(result, _total);
+}
+
+FieldStatistics FieldStatistics::parse(const BSONObj& obj) {
+    const auto id = obj["_id"];
+    uassert(5380306,
+            str::stream() << "Expected an object for the _id of statistics, got: " << id,
+            id.type() == Object && id.Obj()["field"].type() == String);
+
+    FieldStatistics stats;
+    stats.field = id.Obj()["field"].str();
+    stats.numDocs = getNumber(obj, "numDocs");
+    stats.numKeys = getNumber(obj, "numKeys");
+    stats.numDistinct = getNumber(obj, "numDistinct");
+    stats.histogram = FieldHistogram::parse(obj["histogram"]);
+    stats.lastUpdated = obj["lastUpdated"].date();
+    return stats;
+}
+
+BSONObj FieldStatistics::makeId(const NamespaceString& nss, StringData field) {
+    return BSON("coll" << nss.coll() << "field" << field);
+}
+
+BSONObj FieldStatistics::toBSON(const NamespaceString& nss) const {
+    BSONObjBuilder builder;
+    builder.append("_id", makeId(nss, field));
+    builder.append("numDocs", numDocs);
+    builder.append("numKeys", numKeys);
+    builder.append("numDistinct", numDistinct);
+    histogram.serialize("histogram", &builder);
+    builder.append("lastUpdated", lastUpdated);
+    return builder.obj();
+}
+
+boost::optional<double> FieldStatistics::estimateSelectivity(
+    const OrderedIntervalList& oil) const {
+    if (histogram.total() <= 0) {
+        return boost::none;
+    }
+    return histogram.estimate(oil) / histogram.total();
+}
+
+FieldStatisticsBuilder::FieldStatisticsBuilder(std::string field,
+                                               size_t sampleSize,
+                                               size_t maxBuckets,
+                                               int64_t seed)
+    : _field(std::move(field)), _sampleSize(sampleSize), _maxBuckets(maxBuckets), _random(seed) {
+    invariant(_sampleSize > 0);
+}
+
+void FieldStatisticsBuilder::addDocument(const BSONObj& doc) {
+    ++_numDocs;
+
+    // Collect the values an index on the field would have keys for. A document without the field
+    // is indexed as null.
+    BSONElementSet keys;
+    dotted_path_support::extractAllElementsAlongPath(doc, _field, keys);
+    if (keys.empty()) {
+        static const BSONObj kNullKey = BSON("" << BSONNULL);
+        _addKey(kNullKey.firstElement());
+        return;
+    }
+    for (auto&& key : keys) {
+        _addKey(key);
+    }
+}
+
+void FieldStatisticsBuilder::_addKey(const BSONElement& key) {
+    ++_numKeys;
+    _sketch.add(key);
+
+    // Reservoir sampling keeps every key seen so far in the sample with equal probability.
+    if (_sample.size() < _sampleSize) {
+        _sample.push_back(key.wrap(""));
+        return;
+    }
+    const auto slot = _random.nextInt64(_numKeys);
+    if (slot < static_cast<long long>(_sampleSize)) {
+        _sample[slot] = key.wrap("");
+    }
+}
+
+FieldStatistics FieldStatisticsBuilder::done(Date_t now) {
+    std::vector<BSONElement> values;
+    values.reserve(_sample.size());
+    for (auto&& key : _sample) {
+        values.push_back(key.firstElement());
+    }
+
+    FieldStatistics stats;
+    stats.field = _field;
+    stats.numDocs = _numDocs;
+    stats.numKeys = _numKeys;
+    stats.numDistinct = _sketch.estimate();
+    stats.histogram = FieldHistogram::build(std::move(values), _maxBuckets);
+    stats.lastUpdated = now;
+    return stats;
+}
+
+CollectionStatisticsCache& CollectionStatisticsCache::get(ServiceContext* serviceContext) {
+    return getCollectionStatisticsCache(serviceContext);
+}
+
+std::shared_ptr<const FieldStatistics> CollectionStatisticsCache::getFieldStatistics(
+    OperationContext* opCtx, const NamespaceString& nss, StringData field) {
+    const auto now = opCtx->getServiceContext()->getFastClockSource()->now();
+    const bool canLoad = opCtx->lockState()->isDbLockedForMode(nss.db(), MODE_IS);
+    {
+        stdx::lock_guard<Latch> lk(_mutex);
+        auto it = _entries.find(nss);
+        if (it != _entries.end() &&
+            (!canLoad ||
+             now - it->second.loadedAt <
+                 Seconds(internalQueryStatisticsCacheRefreshSecs.load()))) {
+            auto fieldIt = it->second.fields.find(field);
+            return fieldIt == it->second.fields.end() ? nullptr : fieldIt->second;
+        }
+    }
+    if (!canLoad) {
+        return nullptr;
+    }
+
+    auto fields = _load(opCtx, nss);
+    auto fieldIt = fields.find(field);
+    auto result = fieldIt == fields.end() ? nullptr : fieldIt->second;
+
+    stdx::lock_guard<Latch> lk(_mutex);
+    _entries[nss] = {now, std::move(fields)};
+    return result;
+}
+
+void CollectionStatisticsCache::invalidate(const NamespaceString& nss) {
+    stdx::lock_guard<Latch> lk(_mutex);
+    _entries.erase(nss);
+}
+
+CollectionStatisticsCache::FieldStatisticsMap CollectionStatisticsCache::_load(
+    OperationContext* opCtx, const NamespaceString& nss) {
+    FieldStatisticsMap fields;
+
+    const NamespaceString statsNss(nss.db(), NamespaceString::kSystemDotStatisticsCollectionName);
+    Lock::CollectionLock statsLock(opCtx, statsNss, MODE_IS);
+    auto statsCollection =
+        CollectionCatalog::get(opCtx).lookupCollectionByNamespace(opCtx, statsNss);
+    if (!statsCollection) {
+        return fields;
+    }
+
+    // The statistics collection holds a few documents per analyzed collection, so scan it rather
+    // than planning a query against it.
+    auto cursor = statsCollection->getCursor(opCtx);
+    while (auto record = cursor->next()) {
+        const auto doc = record->data.releaseToBson();
+        const auto id = doc["_id"];
+        if (id.type() != Object || id.Obj()["coll"].valueStringDataSafe() != nss.coll()) {
+            continue;
+        }
+
+        try {
+            auto stats = std::make_shared<const FieldStatistics>(FieldStatistics::parse(doc));
+            fields[stats->field] = std::move(stats);
+        } catch (const AssertionException& ex) {
+            LOGV2_WARNING(5380300,
+                          "Ignoring invalid statistics document",
+                          "namespace"_attr = statsNss,
+                          "document"_attr = redact(doc),
+                          "error"_attr = redact(ex.toStatus()));
+        }
+    }
+    return fields;
+}
+
+}  // namespace mongo
@@ -0,0 +1,248 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#pragma once
+
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "mongo/bson/bsonelement.h"
+#include "mongo/bson/bsonobj.h"
+#include "mongo/db/namespace_string.h"
+#include "mongo/db/query/index_bounds.h"
+#include "mongo/platform/mutex.h"
+#include "mongo/platform/random.h"
+#include "mongo/stdx/unordered_map.h"
+#include "mongo/util/string_map.h"
+#include "mongo/util/time_support.h"
+
+namespace mongo {
+
+class OperationContext;
+class ServiceContext;
+
+/**
+ * Estimates the number of distinct values in a stream of values by keeping the 'k' smallest of
+ * their hashes (a "k minimum values" sketch). Exact while fewer than 'k' distinct hashes were seen.
+ */
+class DistinctValueSketch {
+public:
+    static constexpr size_t kDefaultSize = 1024;
+
+    explicit DistinctValueSketch(size_t size = kDefaultSize);
+
+    /**
+     * Adds a value to the sketch. Equal values must be added with equal hashes.
+     */
+    void add(const BSONElement& value);
+
+    double estimate() const;
+
+private:
+    const size_t _size;
+
+    // The smallest distinct hashes seen so far, at most '_size' of them.
+    std::set<uint64_t> _minHashes;
+};
+
+/**
+ * An equi-depth histogram of the values of a field, ordered as BSON orders them without a
+ * collation. Each bucket counts the values equal to its upper bound separately from the values
+ * between the previous bucket's upper bound and its own, so that frequent values are described
+ * exactly.
+ */
+class FieldHistogram {
+public:
+    struct Bucket {
+        // A single-field object holding the (inclusive) upper bound of the bucket.
+        BSONObj upperBound;
+
+        // The number of values equal to the upper bound.
+        double boundCount = 0;
+
+        // The number of values, and of distinct values, greater than the previous bucket's upper
+        // bound and less than this bucket's upper bound.
+        double rangeCount = 0;
+        double rangeDistinct = 0;
+    };
+
+    FieldHistogram() = default;
+
+    /**
+     * Builds a histogram of at most 'maxBuckets' buckets from a sample of the field's values.
+     */
+    static FieldHistogram build(std::vector<BSONElement> values, size_t maxBuckets);
+
+    /**
+     * Parses a histogram serialized by serialize(). Throws on invalid input.
+     */
+    static FieldHistogram parse(const BSONElement& elem);
+
+    void serialize(StringData fieldName, BSONObjBuilder* builder) const;
+
+    /**
+     * Returns the estimated number of the sampled values which fall within 'interval'.
+     */
+    double estimate(const Interval& interval) const;
+
+    /**
+     * Returns the estimated number of the sampled values which fall within any of the intervals of
+     * 'oil'.
+     */
+    double estimate(const OrderedIntervalList& oil) const;
+
+    /**
+     * The total number of sampled values described by the histogram.
+     */
+    double total() const {
+        return _total;
+    }
+
+    const std::vector<Bucket>& buckets() const {
+        return _buckets;
+    }
+
+private:
+    std::vector<Bucket> _buckets;
+    double _total = 0;
+};
+
+/**
+ * The statistics about one field of a collection collected by the 'analyze' command, and
+ * persisted in the database's statistics collection.
+ */
+struct FieldStatistics {
+    /**
+     * Parses a document of the statistics collection. Throws on invalid input.
+     */
+    static FieldStatistics parse(const BSONObj& obj);
+
+    /**
+     * Returns the document of the statistics collection for this field of the collection 'nss'.
+     */
+    BSONObj toBSON(const NamespaceString& nss) const;
+
+    /**
+     * Returns the _id of the statistics document for 'field' of the collection 'nss'.
+     */
+    static BSONObj makeId(const NamespaceString& nss, StringData field);
+
+    /**
+     * Returns the fraction of the field's index keys which fall within 'oil', or boost::none if
+     * the histogram holds no values.
+     */
+    boost::optional<double> estimateSelectivity(const OrderedIntervalList& oil) const;
+
+    std::string field;
+
+    // The number of documents scanned, and of the index keys generated from them for this field.
+    // A document with an array generates one key per distinct array element.
+    long long numDocs = 0;
+    long long numKeys = 0;
+
+    // The estimated number of distinct keys.
+    double numDistinct = 0;
+
+    // A histogram of a sample of the keys.
+    FieldHistogram histogram;
+
+    Date_t lastUpdated;
+};
+
+/**
+ * Collects the statistics of one field from the documents of a collection. Every index key of the
+ * field goes into the distinct value sketch, while the histogram is built from a uniform sample
+ * of at most 'sampleSize' keys.
+ */
+class FieldStatisticsBuilder {
+public:
+    FieldStatisticsBuilder(std::string field, size_t sampleSize, size_t maxBuckets, int64_t seed);
+
+    void addDocument(const BSONObj& doc);
+
+    FieldStatistics done(Date_t now);
+
+private:
+    void _addKey(const BSONElement& key);
+
+    const std::string _field;
+    const size_t _sampleSize;
+    const size_t _maxBuckets;
+    PseudoRandom _random;
+
+    long long _numDocs = 0;
+    long long _numKeys = 0;
+    DistinctValueSketch _sketch;
+
+    // Single-field objects holding the sampled keys.
+    std::vector<BSONObj> _sample;
+};
+
+/**
+ * A cache of the statistics of the collections on this node. Statistics are loaded from the
+ * statistics collection the first time they are needed and reloaded after
+ * 'internalQueryStatisticsCacheRefreshSecs', which lets changes replicated from other nodes take
+ * effect.
+ */
+class CollectionStatisticsCache {
+public:
+    static CollectionStatisticsCache& get(ServiceContext* serviceContext);
+
+    /**
+     * Returns the statistics for 'field' of the collection 'nss', or nullptr if there are none.
+     * Loading statistics requires a lock on the database of 'nss', which the caller must hold;
+     * without it only cached statistics are returned.
+     */
+    std::shared_ptr<const FieldStatistics> getFieldStatistics(OperationContext* opCtx,
+                                                              const NamespaceString& nss,
+                                                              StringData field);
+
+    /**
+     * Drops the cached statistics of 'nss', so that they are reloaded on the next use.
+     */
+    void invalidate(const NamespaceString& nss);
+
+private:
+    using FieldStatisticsMap = StringMap<std::shared_ptr<const FieldStatistics>>;
+
+    struct Entry {
+        Date_t loadedAt;
+        FieldStatisticsMap fields;
+    };
+
+    static FieldStatisticsMap _load(OperationContext* opCtx, const NamespaceString& nss);
+
+    Mutex _mutex = MONGO_MAKE_LATCH("CollectionStatisticsCache::_mutex");
+    stdx::unordered_map<NamespaceString, Entry> _entries;
+};
+
+}  // namespace mongo
@@ -0,0 +1,263 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/query/collection_statistics.h"
+
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/db/jsobj.h"
+#include "mongo/db/query/index_bounds_builder.h"
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+namespace {
+
+/**
+ * Returns the values 1 through 'n' as elements of 'storage'.
+ */
+std::vector<BSONElement> makeSequence(int n, std::vector<BSONObj>* storage) {
+    std::vector<BSONElement> values;
+    for (int i = 1; i <= n; ++i) {
+        storage->push_back(BSON("" << i));
+        values.push_back(storage->back().firstElement());
+    }
+    return values;
+}
+
+Interval makeRange(int start, int end, bool startInclusive = true, bool endInclusive = true) {
+    return Interval(BSON("" << start << "" << end), startInclusive, endInclusive);
+}
+
+TEST(FieldHistogramTest, EmptyHistogramEstimatesNothing) {
+    auto histogram = FieldHistogram::build({}, 10);
+    ASSERT_EQ(histogram.total(), 0);
+    ASSERT(histogram.buckets().empty());
+    ASSERT_EQ(histogram.estimate(makeRange(0, 10)), 0);
+}
+
+TEST(FieldHistogramTest, BuildSplitsValuesIntoBucketsOfEqualDepth) {
+    std::vector<BSONObj> storage;
+    auto histogram = FieldHistogram::build(makeSequence(100, &storage), 11);
+    ASSERT_EQ(histogram.total(), 100);
+    ASSERT_EQ(histogram.buckets().size(), 11U);
+
+    // The first bucket holds only the smallest value.
+    const auto& first = histogram.buckets().front();
+    ASSERT_BSONOBJ_EQ(first.upperBound, BSON("" << 1));
+    ASSERT_EQ(first.boundCount, 1);
+    ASSERT_EQ(first.rangeCount, 0);
+
+    const auto& second = histogram.buckets()[1];
+    ASSERT_BSONOBJ_EQ(second.upperBound, BSON("" << 11));
+    ASSERT_EQ(second.boundCount, 1);
+    ASSERT_EQ(second.rangeCount, 9);
+    ASSERT_EQ(second.rangeDistinct, 9);
+
+    ASSERT_BSONOBJ_EQ(histogram.buckets().back().upperBound, BSON("" << 100));
+}
+
+TEST(FieldHistogramTest, BuildCountsDuplicateValuesInBucketBounds) {
+    std::vector<BSONObj> storage;
+    std::vector<BSONElement> values;
+    for (int i = 0; i < 50; ++i) {
+        storage.push_back(BSON("" << (i < 40 ? 7 : i)));
+    }
+    for (auto&& obj : storage) {
+        values.push_back(obj.firstElement());
+    }
+
+    auto histogram = FieldHistogram::build(values, 5);
+    ASSERT_EQ(histogram.total(), 50);
+    ASSERT_BSONOBJ_EQ(histogram.buckets().front().upperBound, BSON("" << 7));
+    ASSERT_EQ(histogram.buckets().front().boundCount, 40);
+    ASSERT_EQ(histogram.estimate(IndexBoundsBuilder::makePointInterval(7)), 40);
+}
+
+TEST(FieldHistogramTest, EstimatesPointIntervals) {
+    std::vector<BSONObj> storage;
+    auto histogram = FieldHistogram::build(makeSequence(100, &storage), 11);
+
+    // A bucket bound is counted exactly, and a value within a bucket's range is assumed to occur
+    // as often as every other distinct value of the range.
+    ASSERT_EQ(histogram.estimate(IndexBoundsBuilder::makePointInterval(51)), 1);
+    ASSERT_APPROX_EQUAL(histogram.estimate(IndexBoundsBuilder::makePointInterval(50)), 1, 1e-9);
+    ASSERT_EQ(histogram.estimate(IndexBoundsBuilder::makePointInterval(1000)), 0);
+    ASSERT_EQ(histogram.estimate(IndexBoundsBuilder::makePointInterval("a")), 0);
+}
+
+TEST(FieldHistogramTest, EstimatesRangeIntervalsByInterpolation) {
+    std::vector<BSONObj> storage;
+    auto histogram = FieldHistogram::build(makeSequence(100, &storage), 11);
+
+    ASSERT_EQ(histogram.estimate(makeRange(1, 100)), 100);
+    ASSERT_EQ(histogram.estimate(makeRange(1, 100, false, false)), 98);
+    ASSERT_APPROX_EQUAL(histogram.estimate(makeRange(0, 50)), 50, 1);
+    ASSERT_APPROX_EQUAL(histogram.estimate(makeRange(25, 75)), 51, 2);
+    ASSERT_EQ(histogram.estimate(IndexBoundsBuilder::allValues()), 100);
+}
+
+TEST(FieldHistogramTest, EstimatesDescendingIntervals) {
+    std::vector<BSONObj> storage;
+    auto histogram = FieldHistogram::build(makeSequence(100, &storage), 11);
+
+    auto descending = makeRange(0, 50);
+    IndexBoundsBuilder::reverseInterval(&descending);
+    ASSERT_EQ(histogram.estimate(descending), histogram.estimate(makeRange(0, 50)));
+}
+
+TEST(FieldHistogramTest, EstimateOfIntervalListIsBoundedByTotal) {
+    std::vector<BSONObj> storage;
+    auto histogram = FieldHistogram::build(makeSequence(100, &storage), 11);
+
+    OrderedIntervalList oil("a");
+    oil.intervals.push_back(IndexBoundsBuilder::makePointInterval(11));
+    oil.intervals.push_back(IndexBoundsBuilder::makePointInterval(21));
+    ASSERT_EQ(histogram.estimate(oil), 2);
+
+    oil.intervals.push_back(IndexBoundsBuilder::allValues());
+    ASSERT_EQ(histogram.estimate(oil), 100);
+}
+
+TEST(FieldHistogramTest, SerializeRoundTrips) {
+    std::vector<BSONObj> storage;
+    auto histogram = FieldHistogram::build(makeSequence(100, &storage), 11);
+
+    BSONObjBuilder builder;
+    histogram.serialize("histogram", &builder);
+    const auto obj = builder.obj();
+    auto parsed = FieldHistogram::parse(obj["histogram"]);
+
+    ASSERT_EQ(parsed.total(), histogram.total());
+    ASSERT_EQ(parsed.buckets().size(), histogram.buckets().size());
+    for (size_t i = 0; i < parsed.buckets().size(); ++i) {
+        ASSERT_BSONOBJ_EQ(parsed.buckets()[i].upperBound, histogram.buckets()[i].upperBound);
+        ASSERT_EQ(parsed.buckets()[i].boundCount, histogram.buckets()[i].boundCount);
+        ASSERT_EQ(parsed.buckets()[i].rangeCount, histogram.buckets()[i].rangeCount);
+        ASSERT_EQ(parsed.buckets()[i].rangeDistinct, histogram.buckets()[i].rangeDistinct);
+    }
+}
+
+TEST(FieldHistogramTest, ParseRejectsInvalidHistograms) {
+    ASSERT_THROWS_CODE(FieldHistogram::parse(BSON("h" << 1).firstElement()), DBException, 5380302);
+    ASSERT_THROWS_CODE(
+        FieldHistogram::parse(BSON("h" << BSON_ARRAY(1)).firstElement()), DBException, 5380303);
+    ASSERT_THROWS_CODE(FieldHistogram::parse(BSON("h" << BSON_ARRAY(BSON("boundCount" << 1)))
+                                                 .firstElement()),
+                       DBException,
+                       5380304);
+
+    const auto outOfOrder = BSON(
+        "h" << BSON_ARRAY(BSON("upperBound" << 2 << "boundCount" << 1 << "rangeCount" << 0
+                                            << "rangeDistinct" << 0)
+                          << BSON("upperBound" << 1 << "boundCount" << 1 << "rangeCount" << 0
+                                               << "rangeDistinct" << 0)));
+    ASSERT_THROWS_CODE(FieldHistogram::parse(outOfOrder.firstElement()), DBException, 5380305);
+}
+
+TEST(DistinctValueSketchTest, CountsSmallNumbersOfValuesExactly) {
+    DistinctValueSketch sketch(64);
+    for (int i = 0; i < 1000; ++i) {
+        sketch.add(BSON("" << i % 50).firstElement());
+    }
+    ASSERT_EQ(sketch.estimate(), 50);
+}
+
+TEST(DistinctValueSketchTest, ApproximatesLargeNumbersOfValues) {
+    DistinctValueSketch sketch;
+    for (int i = 0; i < 100000; ++i) {
+        sketch.add(BSON("" << i).firstElement());
+    }
+
+    // The standard error of the estimate is about 1/sqrt(k), so allow for five of those.
+    const double error = 5.0 / std::sqrt(DistinctValueSketch::kDefaultSize);
+    ASSERT_APPROX_EQUAL(sketch.estimate(), 100000, 100000 * error);
+}
+
+TEST(FieldStatisticsBuilderTest, CollectsKeysOfArraysAndMissingFields) {
+    FieldStatisticsBuilder builder("a.b", 100, 10, 1);
+    builder.addDocument(fromjson("{a: {b: [1, 2]}}"));
+    builder.addDocument(fromjson("{a: [{b: 3}, {b: 3}]}"));
+    builder.addDocument(fromjson("{c: 1}"));
+
+    const auto now = Date_t::fromMillisSinceEpoch(1000);
+    auto stats = builder.done(now);
+    ASSERT_EQ(stats.field, "a.b");
+    ASSERT_EQ(stats.numDocs, 3);
+    ASSERT_EQ(stats.numKeys, 4);
+    ASSERT_EQ(stats.numDistinct, 4);
+    ASSERT_EQ(stats.histogram.total(), 4);
+    ASSERT_EQ(stats.lastUpdated, now);
+
+    // Documents without the field are indexed as null, so they match an equality to null.
+    OrderedIntervalList nullBounds("a.b");
+    nullBounds.intervals.push_back(IndexBoundsBuilder::makePointInterval(BSON("" << BSONNULL)));
+    ASSERT_EQ(*stats.estimateSelectivity(nullBounds), 0.25);
+}
+
+TEST(FieldStatisticsBuilderTest, SamplesAtMostSampleSizeKeys) {
+    FieldStatisticsBuilder builder("a", 10, 5, 1);
+    for (int i = 0; i < 1000; ++i) {
+        builder.addDocument(BSON("a" << i));
+    }
+
+    auto stats = builder.done(Date_t::fromMillisSinceEpoch(0));
+    ASSERT_EQ(stats.numDocs, 1000);
+    ASSERT_EQ(stats.numKeys, 1000);
+    ASSERT_EQ(stats.histogram.total(), 10);
+    ASSERT_LTE(stats.histogram.buckets().size(), 5U);
+}
+
+TEST(FieldStatisticsTest, DocumentRoundTrips) {
+    FieldStatisticsBuilder builder("a", 100, 10, 1);
+    for (int i = 0; i < 20; ++i) {
+        builder.addDocument(BSON("a" << i % 5));
+    }
+    auto stats = builder.done(Date_t::fromMillisSinceEpoch(1000));
+
+    const NamespaceString nss("test.coll");
+    const auto obj = stats.toBSON(nss);
+    ASSERT_BSONOBJ_EQ(obj["_id"].Obj(), FieldStatistics::makeId(nss, "a"));
+
+    auto parsed = FieldStatistics::parse(obj);
+    ASSERT_EQ(parsed.field, stats.field);
+    ASSERT_EQ(parsed.numDocs, stats.numDocs);
+    ASSERT_EQ(parsed.numKeys, stats.numKeys);
+    ASSERT_EQ(parsed.numDistinct, stats.numDistinct);
+    ASSERT_EQ(parsed.lastUpdated, stats.lastUpdated);
+    ASSERT_EQ(parsed.histogram.total(), stats.histogram.total());
+
+    OrderedIntervalList oil("a");
+    oil.intervals.push_back(IndexBoundsBuilder::makePointInterval(3));
+    ASSERT_EQ(*parsed.estimateSelectivity(oil), 0.2);
+}
+
+}  // namespace
+}  // namespace mongo
@@ -62,6 +62,7 @@
 #include "mongo/db/matcher/extensions_callback_noop.h"
 #include "mongo/db/matcher/extensions_callback_real.h"
 #include "mongo/db/query/canonical_query.h"
+#include "mongo/db/query/cardinality_estimator.h"
 #include "mongo/db/query/canonical_query_encoder.h"
 #include "mongo/db/query/collation/collator_factory_interface.h"
 #include "mongo/db/query/collection_query_info.h"
@@ -580,6 +581,11 @@ StatusWith<PrepareExecutionResult> prepareExecution(OperationContext* opCtx,
         }
     }
 
+    // Discard the solutions which statistics show to be far more expensive than the best one,
+    // rather than trial running them.
+    cardinality_estimator::estimateAndPruneSolutions(
+        opCtx, collection, *canonicalQuery, &solutions);
+
     if (1 == solutions.size()) {
         // Only one possible plan.  Run it.  Build the stages from the solution.
         auto root = StageBuilder::build(opCtx, collection, *canonicalQuery, *solutions[0], ws);
@@ -827,7 +827,10 @@ void IndexBoundsBuilder::_translatePredicate(const MatchExpression* expr,
 
         *tightnessOut = IndexBoundsBuilder::EXACT;
 
-        // Create our various intervals.
+        // Create our various intervals. Every equality and regex adds at least one interval, so
+        // size the list up front rather than regrowing it for large $in lists.
+        oilOut->intervals.reserve(oilOut->intervals.size() + ime->getEqualities().size() +
+                                  ime->getRegexes().size());
 
         IndexBoundsBuilder::BoundsTightness tightness;
         bool arrayOrNullPresent = false;
@@ -607,6 +607,46 @@ TEST(PlanCacheTest, PlanCacheFlushDeletesInactiveEntries) {
     ASSERT_EQ(planCache.get(*cq).state, PlanCache::CacheEntryState::kNotPresent);
 }
 
+TEST(PlanCacheTest, PartitionedCacheTracksEntriesOfEveryPartition) {
+    // A cache this large is split into several partitions.
+    const size_t kCacheSize = 1024;
+    const size_t kNumShapes = 100;
+    PlanCache planCache(kCacheSize);
+    QueryTestServiceContext serviceContext;
+
+    std::vector<unique_ptr<CanonicalQuery>> queries;
+    for (size_t i = 0; i < kNumShapes; ++i) {
+        const std::string fieldName = str::stream() << "f" << i;
+        queries.push_back(canonicalize(BSON(fieldName << 1)));
+        addCacheEntryForShape(*queries.back(), &planCache);
+    }
+    ASSERT_EQ(planCache.size(), kNumShapes);
+    ASSERT_EQ(planCache.getAllEntries().size(), kNumShapes);
+    ASSERT_EQ(planCache
+                  .getMatchingStats([](const PlanCacheEntry&) { return BSONObj(); },
+                                    [](const BSONObj&) { return true; })
+                  .size(),
+              kNumShapes);
+    for (auto&& cq : queries) {
+        ASSERT_EQ(planCache.get(*cq).state, PlanCache::CacheEntryState::kPresentInactive);
+    }
+
+    // Remove every other entry.
+    for (size_t i = 0; i < kNumShapes; i += 2) {
+        ASSERT_OK(planCache.remove(*queries[i]));
+    }
+    ASSERT_EQ(planCache.size(), kNumShapes / 2);
+    for (size_t i = 0; i < kNumShapes; ++i) {
+        ASSERT_EQ(planCache.get(*queries[i]).state,
+                  i % 2 ? PlanCache::CacheEntryState::kPresentInactive
+                        : PlanCache::CacheEntryState::kNotPresent);
+    }
+
+    planCache.clear();
+    ASSERT_EQ(planCache.size(), 0U);
+    ASSERT_EQ(planCache.getAllEntries().size(), 0U);
+}
+
 TEST(PlanCacheTest, AddActiveCacheEntry) {
     PlanCache planCache;
     unique_ptr<CanonicalQuery> cq(canonicalize("{a: 1}"));
@@ -54,6 +54,7 @@
 #include "mongo/db/query/find_common.h"
 #include "mongo/db/query/mock_yield_policies.h"
 #include "mongo/db/query/plan_yield_policy.h"
+#include "mongo/db/query/query_knobs_gen.h"
 #include "mongo/db/repl/replication_coordinator.h"
 #include "mongo/db/service_context.h"
 #include "mongo/logv2/log.h"
@@ -248,6 +249,10 @@ PlanExecutorImpl::PlanExecutorImpl(OperationContext* opCtx,
         _oplogTrackingStage = static_cast<CollectionScan*>(collectionScan);
     }
 
+    if (internalQueryEnableBatchedExecution.load() && _root->supportsBatchedWork()) {
+        _batch = std::make_unique<RecordBatch>(internalQueryExecBatchedWorkSize.load());
+    }
+
     // We may still need to initialize _nss from either collection or _cq.
     if (!_nss.isEmpty()) {
         return;  // We already have an _nss set, so there's nothing more to do.
@@ -548,6 +553,10 @@ PlanExecutor::ExecState PlanExecutorImpl::_getNextImpl(Snapshotted<Document>* ob
         return PlanExecutor::ADVANCED;
     }
 
+    if (_batch) {
+        return _getNextBatched(objOut, dlOut);
+    }
+
     // Incremented on every writeConflict, reset to 0 on any successful call to _root->work.
     size_t writeConflictsInARow = 0;
 
@@ -680,9 +689,79 @@ PlanExecutor::ExecState PlanExecutorImpl::_getNextImpl(Snapshotted<Document>* ob
     }
 }
 
+PlanExecutor::ExecState PlanExecutorImpl::_getNextBatched(Snapshotted<Document>* objOut,
+                                                          RecordId* dlOut) {
+    // Incremented on every writeConflict, reset to 0 on any successful call to _root->workBatch.
+    size_t writeConflictsInARow = 0;
+
+    for (;;) {
+        while (_batchPosition < _batch->size()) {
+            const size_t i = _batchPosition++;
+            if (nullptr != dlOut) {
+                if (_batch->getRecordId(i).isNull()) {
+                    // This result didn't have the data the caller wanted, try the next one.
+                    continue;
+                }
+                *dlOut = _batch->getRecordId(i);
+            }
+            if (nullptr != objOut) {
+                // Reuse the caller's DocumentStorage if it is not shared.
+                MutableDocument md(std::move(objOut->value()));
+                md.reset(_batch->getObj(i), false);
+                *objOut = Snapshotted<Document>(_batch->getSnapshotId(), md.freeze());
+            }
+            return PlanExecutor::ADVANCED;
+        }
+
+        // Yielding and interrupts are checked once per batch. The documents of the current batch
+        // are owned by '_batch', so any that remain are unaffected by a yield.
+        if (_yieldPolicy->shouldYieldOrInterrupt()) {
+            auto yieldStatus = _yieldPolicy->yieldOrInterrupt();
+            if (!yieldStatus.isOK()) {
+                if (objOut) {
+                    *objOut = Snapshotted<Document>(
+                        SnapshotId(), WorkingSetCommon::buildMemberStatusObject(yieldStatus));
+                }
+                return PlanExecutor::FAILURE;
+            }
+        }
+
+        _batch->clear();
+        _batchPosition = 0;
+        PlanStage::StageState code = _root->workBatch(_batch.get());
+
+        if (code != PlanStage::NEED_YIELD)
+            writeConflictsInARow = 0;
+
+        if (PlanStage::NEED_YIELD == code) {
+            if (!_yieldPolicy->canAutoYield() ||
+                MONGO_unlikely(skipWriteConflictRetries.shouldFail())) {
+                throw WriteConflictException();
+            }
+
+            CurOp::get(_opCtx)->debug().additiveMetrics.incrementWriteConflicts(1);
+            writeConflictsInARow++;
+            WriteConflictException::logAndBackoff(
+                writeConflictsInARow, "plan execution", _nss.ns());
+
+            // If we're allowed to, we will yield next time through the loop.
+            if (_yieldPolicy->canAutoYield()) {
+                _yieldPolicy->forceYield();
+            }
+        } else if (PlanStage::IS_EOF == code) {
+            // Batched execution is never used for tailable plans, so there are no inserts to
+            // wait for.
+            return PlanExecutor::IS_EOF;
+        }
+        // Otherwise the batch is either returned from by the next iteration (ADVANCED) or is
+        // empty (NEED_TIME) and we ask for another.
+    }
+}
+
 bool PlanExecutorImpl::isEOF() {
     invariant(_currentState == kUsable);
-    return isMarkedAsKilled() || (_stash.empty() && _root->isEOF());
+    return isMarkedAsKilled() ||
+        (_stash.empty() && (!_batch || _batchPosition == _batch->size()) && _root->isEOF());
 }
 
 void PlanExecutorImpl::markAsKilled(Status killStatus) {
@@ -32,6 +32,7 @@
 #include <boost/optional.hpp>
 #include <queue>
 
+#include "mongo/db/exec/record_batch.h"
 #include "mongo/db/query/plan_executor.h"
 
 namespace mongo {
@@ -155,6 +156,12 @@ private:
      */
     ExecState _getNextImpl(Snapshotted<Document>* objOut, RecordId* dlOut);
 
+    /**
+     * Implementation of _getNextImpl() for plans executed in batched mode. Returns the next
+     * document of the current batch, asking the root stage for a new batch once it is exhausted.
+     */
+    ExecState _getNextBatched(Snapshotted<Document>* objOut, RecordId* dlOut);
+
     // The OperationContext that we're executing within. This can be updated if necessary by using
     // detachFromOperationContext() and reattachToOperationContext().
     OperationContext* _opCtx;
@@ -193,6 +200,12 @@ private:
     // allocating and freeing DocumentStorage.
     Document _docOutput;
 
+    // Set if every stage of the plan supports batched execution and it has been enabled with the
+    // 'internalQueryEnableBatchedExecution' knob. In that case results are produced from '_batch'
+    // and '_batchPosition' is the index of the next document of '_batch' to return.
+    std::unique_ptr<RecordBatch> _batch;
+    size_t _batchPosition = 0;
+
     enum { kUsable, kSaved, kDetached, kDisposed } _currentState = kUsable;
 
     bool _everDetachedFromOperationContext = false;
@@ -150,6 +150,39 @@ StatusWith<std::unique_ptr<PlanRankingDecision>> PlanRanker::pickBestPlan(
         double runnerUpScore = scoresAndCandidateindices[1].first;
         const double epsilon = 1e-10;
         why->tieForBest = std::abs(bestScore - runnerUpScore) < epsilon;
+
+        if (why->tieForBest) {
+            // Prefer the tied plan which statistics estimate to examine the least. Only break the
+            // tie if every tied plan has an estimate and the best one is strictly the smallest.
+            auto estimateOf = [&](const std::pair<double, size_t>& scoreAndCandidate) {
+                const auto& solution = candidates[scoreAndCandidate.second].solution;
+                return solution ? solution->estimatedNumExamined : boost::none;
+            };
+            auto tiedEnd = std::find_if(
+                scoresAndCandidateindices.begin(), scoresAndCandidateindices.end(), [&](auto&& s) {
+                    return std::abs(bestScore - s.first) >= epsilon;
+                });
+            const bool allEstimated = std::all_of(
+                scoresAndCandidateindices.begin(), tiedEnd, [&](auto&& s) {
+                    return static_cast<bool>(estimateOf(s));
+                });
+            if (allEstimated) {
+                auto byEstimate = [&](auto&& lhs, auto&& rhs) {
+                    return *estimateOf(lhs) < *estimateOf(rhs);
+                };
+                std::stable_sort(scoresAndCandidateindices.begin(), tiedEnd, byEstimate);
+                if (byEstimate(scoresAndCandidateindices[0], scoresAndCandidateindices[1])) {
+                    LOGV2_DEBUG(5380308,
+                                2,
+                                "Broke a tie between plans using their estimated cost",
+                                "winningPlanEstimate"_attr =
+                                    *estimateOf(scoresAndCandidateindices[0]),
+                                "runnerUpEstimate"_attr =
+                                    *estimateOf(scoresAndCandidateindices[1]));
+                    why->tieForBest = false;
+                }
+            }
+        }
     }
 
     // Update results in 'why'
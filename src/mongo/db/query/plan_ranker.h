@@ -73,7 +73,7 @@ public:
  */
 struct CandidatePlan {
     CandidatePlan(std::unique_ptr<QuerySolution> solution, PlanStage* r, WorkingSet* w)
-        : solution(std::move(solution)), root(r), ws(w), failed(false) {}
+        : solution(std::move(solution)), root(r), ws(w), failed(false), eliminated(false) {}
 
     std::unique_ptr<QuerySolution> solution;
     PlanStage* root;  // Not owned here.
@@ -83,6 +83,10 @@ struct CandidatePlan {
     std::queue<WorkingSetID> results;
 
     bool failed;
+
+    // Set if the plan stopped being worked before the end of the trial period because it was far
+    // less productive than another candidate. It is still ranked using the work it has done.
+    bool eliminated;
 };
 
 /**
@@ -52,6 +52,7 @@
 #include "mongo/db/query/planner_access.h"
 #include "mongo/db/query/planner_analysis.h"
 #include "mongo/db/query/planner_ixselect.h"
+#include "mongo/db/query/query_knobs_gen.h"
 #include "mongo/db/query/query_planner_common.h"
 #include "mongo/db/query/query_solution.h"
 #include "mongo/logv2/log.h"
@@ -297,6 +298,125 @@ bool providesSort(const CanonicalQuery& query, const BSONObj& kp) {
     return query.getQueryRequest().getSort().isPrefixOf(kp, SimpleBSONElementComparator::kInstance);
 }
 
+/**
+ * Returns solutions which answer equality predicates on the non-leading fields of a compound index
+ * when the query has no predicate on the index's leading field. The index bounds on the leading
+ * field include every value, and the index scan seeks past the keys which cannot match the
+ * predicates on later fields, so it examines a few keys per distinct leading value rather than
+ * the whole index.
+ *
+ * Only indexes whose leading field is not in 'fields', the fields the query has predicates over,
+ * are considered: the enumerator already plans every other index.
+ */
+std::vector<std::unique_ptr<QuerySolution>> buildSkipScanSolns(
+    const CanonicalQuery& query,
+    const QueryPlannerParams& params,
+    const std::vector<IndexEntry>& indices,
+    const stdx::unordered_set<std::string>& fields) {
+    std::vector<std::unique_ptr<QuerySolution>> out;
+
+    std::vector<IndexEntry> candidates;
+    for (auto&& index : indices) {
+        if (index.type == IndexType::INDEX_BTREE && index.keyPattern.nFields() > 1 &&
+            fields.count(index.keyPattern.firstElementFieldName()) == 0) {
+            candidates.push_back(index);
+        }
+    }
+    if (candidates.empty()) {
+        return out;
+    }
+
+    // Use the usual index selection to find which predicates each candidate index can answer.
+    auto ratedTree = query.root()->shallowClone();
+    QueryPlannerIXSelect::rateIndices(ratedTree.get(), "", candidates, query.getCollator());
+    QueryPlannerIXSelect::stripInvalidAssignments(ratedTree.get(), candidates);
+
+    // Only equality predicates which must hold for every matching document are eligible, which
+    // means predicates which are either the whole filter or a child of a top-level $and.
+    std::vector<MatchExpression*> preds;
+    if (MatchExpression::AND == ratedTree->matchType()) {
+        for (size_t i = 0; i < ratedTree->numChildren(); ++i) {
+            preds.push_back(ratedTree->getChild(i));
+        }
+    } else {
+        preds.push_back(ratedTree.get());
+    }
+
+    for (size_t indexNo = 0; indexNo < candidates.size(); ++indexNo) {
+        const auto& index = candidates[indexNo];
+
+        // Assign at most one predicate to each field of the index. The bounds of a multikey index
+        // may only be compounded across fields which don't share an array, so only one predicate is
+        // assigned to a multikey index.
+        std::vector<std::pair<size_t, size_t>> assignments;
+        std::vector<bool> assignedFields(index.keyPattern.nFields(), false);
+        for (size_t predNo = 0; predNo < preds.size(); ++predNo) {
+            const auto* pred = preds[predNo];
+            const auto* tag = static_cast<RelevantTag*>(pred->getTag());
+            if (!tag ||
+                (MatchExpression::EQ != pred->matchType() &&
+                 MatchExpression::MATCH_IN != pred->matchType()) ||
+                std::find(tag->notFirst.begin(), tag->notFirst.end(), indexNo) ==
+                    tag->notFirst.end()) {
+                continue;
+            }
+
+            size_t pos = 0;
+            for (auto&& keyElt : index.keyPattern) {
+                if (keyElt.fieldNameStringData() == tag->path) {
+                    break;
+                }
+                ++pos;
+            }
+            if (pos < assignedFields.size() && !assignedFields[pos]) {
+                assignedFields[pos] = true;
+                assignments.emplace_back(predNo, pos);
+            }
+            if (index.multikey && !assignments.empty()) {
+                break;
+            }
+        }
+        if (assignments.empty()) {
+            continue;
+        }
+
+        auto taggedTree = query.root()->shallowClone();
+        for (auto&& [predNo, pos] : assignments) {
+            auto* pred = MatchExpression::AND == taggedTree->matchType()
+                ? taggedTree->getChild(predNo)
+                : taggedTree.get();
+            pred->setTag(new IndexTag(indexNo, pos, true));
+        }
+
+        auto statusWithCacheData =
+            QueryPlanner::cacheDataFromTaggedTree(taggedTree.get(), candidates);
+        prepareForAccessPlanning(taggedTree.get());
+
+        std::unique_ptr<QuerySolutionNode> solnRoot(QueryPlannerAccess::buildIndexedDataAccess(
+            query, std::move(taggedTree), candidates, params));
+        if (!solnRoot) {
+            continue;
+        }
+
+        auto soln = QueryPlannerAnalysis::analyzeDataAccess(query, params, std::move(solnRoot));
+        if (soln) {
+            LOGV2_DEBUG(5380401,
+                        5,
+                        "Planner: adding skip scan solution",
+                        "solution"_attr = redact(soln->toString()));
+            if (statusWithCacheData.isOK()) {
+                SolutionCacheData* scd = new SolutionCacheData();
+                scd->tree = std::move(statusWithCacheData.getValue());
+                soln->cacheData.reset(scd);
+            }
+            out.push_back(std::move(soln));
+        }
+    }
+
+    ratedTree->resetTag();
+    return out;
+}
+
 // static
 const int QueryPlanner::kPlannerVersion = 1;
 
@@ -899,6 +1019,20 @@ StatusWith<std::vector<std::unique_ptr<QuerySolution>>> QueryPlanner::plan(
     // Don't leave tags on query tree.
     query.root()->resetTag();
 
+    // A skip scan is much slower than a collection scan when the leading field of its index has
+    // many distinct values, so a collection scan is added below to compete with it.
+    bool addedSkipScan = false;
+    if (internalQueryPlannerEnableSkipScan.load() && hintedIndex.isEmpty() && !gnNode &&
+        !textNode) {
+        for (auto&& soln : buildSkipScanSolns(query, params, fullIndexList, fields)) {
+            if (out.size() >= params.maxIndexedSolutions) {
+                break;
+            }
+            out.push_back(std::move(soln));
+            addedSkipScan = true;
+        }
+    }
+
     LOGV2_DEBUG(20979,
                 5,
                 "Planner: outputted {numSolutions} indexed solutions",
@@ -1069,8 +1203,10 @@ StatusWith<std::vector<std::unique_ptr<QuerySolution>>> QueryPlanner::plan(
         }
     }
 
-    // The caller can explicitly ask for a collscan.
-    bool collscanRequested = (params.options & QueryPlannerParams::INCLUDE_COLLSCAN);
+    // The caller can explicitly ask for a collscan, and a skip scan always competes with one unless
+    // table scans are disallowed.
+    bool collscanRequested = (params.options & QueryPlannerParams::INCLUDE_COLLSCAN) ||
+        (addedSkipScan && canTableScan);
 
     // No indexed plans?  We must provide a collscan if possible or else we can't run the query.
     bool collScanRequired = 0 == out.size();
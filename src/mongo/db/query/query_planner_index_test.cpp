@@ -31,9 +31,11 @@
 
 #include "mongo/db/matcher/expression_always_boolean.h"
 #include "mongo/db/query/collation/collator_interface_mock.h"
+#include "mongo/db/query/query_knobs_gen.h"
 #include "mongo/db/query/query_planner.h"
 #include "mongo/db/query/query_planner_test_fixture.h"
 #include "mongo/unittest/unittest.h"
+#include "mongo/util/scopeguard.h"
 
 namespace mongo {
 namespace {
@@ -1426,5 +1428,87 @@ TEST_F(QueryPlannerTest, PlansForWholeIndexScanWithSortAreGenerated) {
         "{proj: {spec: {'b': 1, _id: 0}, node: {fetch: {node: {ixscan: {pattern: {a: 1}}}}}}}");
 }
 
+TEST_F(QueryPlannerTest, EqualityOnNonLeadingFieldDoesNotUseIndexWithoutSkipScan) {
+    addIndex(BSON("a" << 1 << "b" << 1));
+
+    runQuery(fromjson("{b: 5}"));
+    assertNumSolutions(1U);
+    assertSolutionExists("{cscan: {dir: 1}}");
+}
+
+TEST_F(QueryPlannerTest, SkipScanAnswersEqualityOnNonLeadingField) {
+    internalQueryPlannerEnableSkipScan.store(true);
+    ON_BLOCK_EXIT([] { internalQueryPlannerEnableSkipScan.store(false); });
+    addIndex(BSON("a" << 1 << "b" << 1));
+
+    runQuery(fromjson("{b: 5}"));
+    assertNumSolutions(2U);
+    assertSolutionExists("{cscan: {dir: 1}}");
+    assertSolutionExists(
+        "{fetch: {filter: null, node: {ixscan: {pattern: {a: 1, b: 1}, bounds: "
+        "{a: [['MinKey', 'MaxKey', true, true]], b: [[5, 5, true, true]]}}}}}");
+}
+
+TEST_F(QueryPlannerTest, SkipScanCompoundsEqualitiesOnSeveralNonLeadingFields) {
+    internalQueryPlannerEnableSkipScan.store(true);
+    ON_BLOCK_EXIT([] { internalQueryPlannerEnableSkipScan.store(false); });
+    params.options &= ~QueryPlannerParams::INCLUDE_COLLSCAN;
+    addIndex(BSON("a" << 1 << "b" << 1 << "c" << 1));
+
+    runQuery(fromjson("{b: 5, c: {$in: [1, 2]}, d: 1}"));
+    assertNumSolutions(2U);
+    assertSolutionExists("{cscan: {dir: 1}}");
+    assertSolutionExists(
+        "{fetch: {filter: {d: 1}, node: {ixscan: {pattern: {a: 1, b: 1, c: 1}, bounds: "
+        "{a: [['MinKey', 'MaxKey', true, true]], b: [[5, 5, true, true]], "
+        "c: [[1, 1, true, true], [2, 2, true, true]]}}}}}");
+}
+
+TEST_F(QueryPlannerTest, SkipScanCompetesWithCollectionScanWhenNoneIsRequested) {
+    internalQueryPlannerEnableSkipScan.store(true);
+    ON_BLOCK_EXIT([] { internalQueryPlannerEnableSkipScan.store(false); });
+    params.options &= ~QueryPlannerParams::INCLUDE_COLLSCAN;
+    addIndex(BSON("a" << 1 << "b" << 1));
+
+    // The skip scan is not the only plan, so it has to win a trial run against a collection scan.
+    runQuery(fromjson("{b: 5}"));
+    assertNumSolutions(2U);
+    assertSolutionExists("{cscan: {dir: 1}}");
+    assertSolutionExists(
+        "{fetch: {filter: null, node: {ixscan: {pattern: {a: 1, b: 1}, bounds: "
+        "{a: [['MinKey', 'MaxKey', true, true]], b: [[5, 5, true, true]]}}}}}");
+
+    // Unless table scans are disallowed.
+    params.options |= QueryPlannerParams::NO_TABLE_SCAN;
+    runQuery(fromjson("{b: 5}"));
+    assertNumSolutions(1U);
+    assertSolutionExists(
+        "{fetch: {filter: null, node: {ixscan: {pattern: {a: 1, b: 1}, bounds: "
+        "{a: [['MinKey', 'MaxKey', true, true]], b: [[5, 5, true, true]]}}}}}");
+}
+
+TEST_F(QueryPlannerTest, SkipScanIsNotUsedForRangePredicates) {
+    internalQueryPlannerEnableSkipScan.store(true);
+    ON_BLOCK_EXIT([] { internalQueryPlannerEnableSkipScan.store(false); });
+    addIndex(BSON("a" << 1 << "b" << 1));
+
+    runQuery(fromjson("{b: {$gt: 5}}"));
+    assertNumSolutions(1U);
+    assertSolutionExists("{cscan: {dir: 1}}");
+}
+
+TEST_F(QueryPlannerTest, SkipScanIsNotUsedWhenLeadingFieldHasPredicate) {
+    internalQueryPlannerEnableSkipScan.store(true);
+    ON_BLOCK_EXIT([] { internalQueryPlannerEnableSkipScan.store(false); });
+    params.options &= ~QueryPlannerParams::INCLUDE_COLLSCAN;
+    addIndex(BSON("a" << 1 << "b" << 1));
+
+    runQuery(fromjson("{a: {$gt: 1}, b: 5}"));
+    assertNumSolutions(1U);
+    assertSolutionExists(
+        "{fetch: {filter: null, node: {ixscan: {pattern: {a: 1, b: 1}, bounds: "
+        "{a: [[1, Infinity, false, true]], b: [[5, 5, true, true]]}}}}}");
+}
+
 }  // namespace
 }  // namespace mongo
@@ -244,6 +244,10 @@ struct QuerySolution {
     // if the planning process for this solution was based on filtered indices.
     bool indexFilterApplied;
 
+    // The number of index keys and documents the solution is estimated to examine, if statistics
+    // allow estimating it. See cardinality_estimator.h.
+    boost::optional<double> estimatedNumExamined;
+
     // Owned here. Used by the plan cache.
     std::unique_ptr<SolutionCacheData> cacheData;
 
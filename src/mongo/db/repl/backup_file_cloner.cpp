@@ -0,0 +1,314 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#define MONGO_LOGV2_DEFAULT_COMPONENT ::mongo::logv2::LogComponent::kReplicationInitialSync
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/repl/backup_file_cloner.h"
+
+#include <boost/filesystem.hpp>
+
+#include "mongo/db/repl/repl_server_parameters_gen.h"
+#include "mongo/db/repl/replication_consistency_markers_gen.h"
+#include "mongo/db/repl/replication_consistency_markers_impl.h"
+#include "mongo/logv2/log.h"
+#include "mongo/rpc/get_status_from_command_result.h"
+#include "mongo/util/assert_util.h"
+#include "mongo/util/file.h"
+
+namespace mongo {
+namespace repl {
+
+BackupFileCloner::BackupFileCloner(InitialSyncSharedData* sharedData,
+                                   const HostAndPort& source,
+                                   DBClientConnection* client,
+                                   StorageInterface* storageInterface,
+                                   ThreadPool* dbPool,
+                                   boost::filesystem::path stagingPath)
+    : BaseCloner("BackupFileCloner"_sd, sharedData, source, client, storageInterface, dbPool),
+      _connectStage("connect", this, &BackupFileCloner::connectStage),
+      _getInitialSyncIdStage("getInitialSyncId", this, &BackupFileCloner::getInitialSyncIdStage),
+      _openBackupCursorStage("openBackupCursor", this, &BackupFileCloner::openBackupCursorStage),
+      _copyFilesStage("copyFiles", this, &BackupFileCloner::copyFilesStage),
+      _stagingPath(std::move(stagingPath)) {}
+
+BaseCloner::ClonerStages BackupFileCloner::getStages() {
+    return {&_connectStage, &_getInitialSyncIdStage, &_openBackupCursorStage, &_copyFilesStage};
+}
+
+void BackupFileCloner::preStage() {
+    boost::system::error_code ec;
+    boost::filesystem::remove_all(_stagingPath, ec);
+    if (!ec) {
+        boost::filesystem::create_directories(_stagingPath, ec);
+    }
+    uassert(ErrorCodes::InitialSyncFailure,
+            str::stream() << "Failed to prepare staging directory " << _stagingPath.string()
+                          << ": " << ec.message(),
+            !ec);
+
+    stdx::lock_guard<Latch> lk(_mutex);
+    _stats.start = getSharedData()->getClock()->now();
+}
+
+BaseCloner::AfterStageBehavior BackupFileCloner::connectStage() {
+    auto* client = getClient();
+    // If the client already has the address (from a previous attempt), we must allow it to
+    // handle the reconnect itself. This is necessary to get correct backoff behavior.
+    if (client->getServerHostAndPort() != getSource()) {
+        uassertStatusOK(client->connect(getSource(), StringData()));
+    } else {
+        client->checkConnection();
+    }
+    uassertStatusOK(replAuthenticate(client).withContext(
+        str::stream() << "Failed to authenticate to " << getSource()));
+    return kContinueNormally;
+}
+
+BaseCloner::AfterStageBehavior BackupFileCloner::getInitialSyncIdStage() {
+    auto wireVersion = static_cast<WireVersion>(getClient()->getMaxWireVersion());
+    uassert(ErrorCodes::InitialSyncFailure,
+            "Sync source does not support file copy based initial sync",
+            wireVersion >= WireVersion::RESUMABLE_INITIAL_SYNC);
+    {
+        stdx::lock_guard<InitialSyncSharedData> lk(*getSharedData());
+        getSharedData()->setSyncSourceWireVersion(lk, wireVersion);
+    }
+
+    auto initialSyncId = getClient()->findOne(
+        ReplicationConsistencyMarkersImpl::kDefaultInitialSyncIdNamespace.toString(), Query());
+    uassert(ErrorCodes::InitialSyncFailure,
+            "Cannot retrieve sync source initial sync ID",
+            !initialSyncId.isEmpty());
+    InitialSyncIdDocument initialSyncIdDoc =
+        InitialSyncIdDocument::parse(IDLParserErrorContext("initialSyncId"), initialSyncId);
+    {
+        stdx::lock_guard<InitialSyncSharedData> lk(*getSharedData());
+        getSharedData()->setInitialSyncSourceId(lk, initialSyncIdDoc.get_id());
+    }
+    return kContinueNormally;
+}
+
+BaseCloner::AfterStageBehavior BackupFileCloner::openBackupCursorStage() {
+    BSONObjBuilder cmd;
+    cmd.append("_initialSyncOpenBackupCursor", 1);
+    _backupId.appendToBuilder(&cmd, "backupId");
+    BSONObj res;
+    getClient()->runCommand("admin", cmd.obj(), res);
+    uassertStatusOK(getStatusFromCommandResult(res));
+
+    const auto checkpointTimestamp = res["checkpointTimestamp"].timestamp();
+    uassert(ErrorCodes::InitialSyncFailure,
+            "Sync source returned an invalid checkpoint timestamp",
+            !checkpointTimestamp.isNull());
+
+    _files.clear();
+    std::uint64_t bytesToCopy = 0;
+    for (const auto& fileElem : res["files"].Array()) {
+        auto fileObj = fileElem.Obj();
+        BackupFile file{fileObj["filename"].str(),
+                        static_cast<std::uint64_t>(fileObj["fileSize"].safeNumberLong())};
+        // Refuse anything that would be written outside of the staging directory.
+        const boost::filesystem::path relativePath(file.filename);
+        uassert(ErrorCodes::InitialSyncFailure,
+                str::stream() << "Sync source returned an invalid backup file name "
+                              << file.filename,
+                !file.filename.empty() && relativePath.is_relative() &&
+                    std::find(relativePath.begin(), relativePath.end(), "..") ==
+                        relativePath.end());
+        bytesToCopy += file.fileSize;
+        _files.push_back(std::move(file));
+    }
+
+    LOGV2(5380020,
+          "Opened backup cursor on sync source for file copy based initial sync",
+          "source"_attr = getSource(),
+          "backupId"_attr = _backupId,
+          "checkpointTimestamp"_attr = checkpointTimestamp,
+          "numFiles"_attr = _files.size(),
+          "totalBytes"_attr = bytesToCopy);
+
+    stdx::lock_guard<Latch> lk(_mutex);
+    _checkpointTimestamp = checkpointTimestamp;
+    _stats.filesToCopy = _files.size();
+    _stats.bytesToCopy = bytesToCopy;
+    return kContinueNormally;
+}
+
+BaseCloner::AfterStageBehavior BackupFileCloner::copyFilesStage() {
+    while (_currentFile < _files.size()) {
+        const auto& backupFile = _files[_currentFile];
+        const auto path = _stagingPath / backupFile.filename;
+        boost::filesystem::create_directories(path.parent_path());
+
+        File file;
+        file.open(path.string().c_str());
+        uassert(ErrorCodes::FileOpenFailed,
+                str::stream() << "Failed to open staged file " << path.string(),
+                file.is_open());
+
+        bool eof = backupFile.fileSize == 0;
+        while (!eof) {
+            {
+                stdx::lock_guard<InitialSyncSharedData> lk(*getSharedData());
+                if (!getSharedData()->getInitialSyncStatus(lk).isOK()) {
+                    static constexpr char message[] =
+                        "Backup file cloning cancelled due to initial sync failure";
+                    LOGV2(5380021,
+                          message,
+                          "error"_attr = getSharedData()->getInitialSyncStatus(lk));
+                    uasserted(ErrorCodes::CallbackCanceled,
+                              str::stream()
+                                  << message << ": " << getSharedData()->getInitialSyncStatus(lk));
+                }
+            }
+
+            BSONObjBuilder cmd;
+            cmd.append("_initialSyncReadBackupFile", 1);
+            _backupId.appendToBuilder(&cmd, "backupId");
+            cmd.append("filename", backupFile.filename);
+            cmd.append("offset", static_cast<long long>(_currentOffset));
+            cmd.append("length", fileCopyBasedInitialSyncChunkSizeBytes.load());
+            BSONObj res;
+            getClient()->runCommand("admin", cmd.obj(), res);
+            uassertStatusOK(getStatusFromCommandResult(res));
+
+            int length = 0;
+            const char* data = res["data"].binData(length);
+            eof = res["eof"].trueValue();
+            uassert(ErrorCodes::InitialSyncFailure,
+                    str::stream() << "Sync source returned no data for backup file "
+                                  << backupFile.filename << " at offset " << _currentOffset,
+                    length > 0 || eof);
+
+            if (length > 0) {
+                file.write(_currentOffset, data, length);
+                uassert(ErrorCodes::FileStreamFailed,
+                        str::stream() << "Failed to write staged file " << path.string(),
+                        !file.bad());
+                _currentOffset += length;
+            }
+
+            // A chunk was copied, so a later failure starts a new retry period.
+            clearRetryingState();
+            stdx::lock_guard<Latch> lk(_mutex);
+            _stats.bytesCopied += length;
+            _stats.receivedChunks++;
+        }
+
+        file.fsync();
+        LOGV2_DEBUG(5380022,
+                    1,
+                    "Finished copying backup file",
+                    "filename"_attr = backupFile.filename,
+                    "fileSize"_attr = backupFile.fileSize);
+        _currentFile++;
+        _currentOffset = 0;
+        stdx::lock_guard<Latch> lk(_mutex);
+        _stats.filesCopied++;
+    }
+    return kContinueNormally;
+}
+
+void BackupFileCloner::postStage() {
+    BSONObjBuilder cmd;
+    cmd.append("_initialSyncCloseBackupCursor", 1);
+    _backupId.appendToBuilder(&cmd, "backupId");
+    BSONObj res;
+    try {
+        getClient()->runCommand("admin", cmd.obj(), res);
+        auto status = getStatusFromCommandResult(res);
+        if (!status.isOK()) {
+            // The sync source closes an abandoned backup cursor by itself, so this is not fatal.
+            LOGV2_WARNING(5380023,
+                          "Failed to close backup cursor on sync source",
+                          "backupId"_attr = _backupId,
+                          "error"_attr = status);
+        }
+    } catch (const DBException& e) {
+        LOGV2_WARNING(5380024,
+                      "Failed to close backup cursor on sync source",
+                      "backupId"_attr = _backupId,
+                      "error"_attr = e.toStatus());
+    }
+
+    stdx::lock_guard<Latch> lk(_mutex);
+    _stats.end = getSharedData()->getClock()->now();
+}
+
+BackupFileCloner::Stats BackupFileCloner::getStats() const {
+    stdx::lock_guard<Latch> lk(_mutex);
+    return _stats;
+}
+
+Timestamp BackupFileCloner::getCheckpointTimestamp() const {
+    stdx::lock_guard<Latch> lk(_mutex);
+    return _checkpointTimestamp;
+}
+
+std::string BackupFileCloner::toString() const {
+    stdx::lock_guard<Latch> lk(_mutex);
+    return str::stream() << "backup file cloner --"
+                         << " active:" << isActive(lk) << " status:" << getStatus(lk).toString()
+                         << " source:" << getSource() << " backupId:" << _backupId
+                         << " files copied:" << _stats.filesCopied << "/" << _stats.filesToCopy
+                         << " bytes copied:" << _stats.bytesCopied << "/" << _stats.bytesToCopy;
+}
+
+std::string BackupFileCloner::Stats::toString() const {
+    return toBSON().toString();
+}
+
+BSONObj BackupFileCloner::Stats::toBSON() const {
+    BSONObjBuilder bob;
+    append(&bob);
+    return bob.obj();
+}
+
+void BackupFileCloner::Stats::append(BSONObjBuilder* builder) const {
+    builder->appendNumber("filesToCopy", static_cast<long long>(filesToCopy));
+    builder->appendNumber("filesCopied", static_cast<long long>(filesCopied));
+    builder->appendNumber("bytesToCopy", static_cast<long long>(bytesToCopy));
+    builder->appendNumber("bytesCopied", static_cast<long long>(bytesCopied));
+    builder->appendNumber("receivedChunks", static_cast<long long>(receivedChunks));
+    if (start != Date_t()) {
+        builder->appendDate("start", start);
+        if (end != Date_t()) {
+            builder->appendDate("end", end);
+            auto elapsed = end - start;
+            long long elapsedMillis = duration_cast<Milliseconds>(elapsed).count();
+            builder->appendNumber("elapsedMillis", elapsedMillis);
+        }
+    }
+}
+
+}  // namespace repl
+}  // namespace mongo
@@ -0,0 +1,163 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#pragma once
+
+#include <boost/filesystem/path.hpp>
+#include <vector>
+
+#include "mongo/bson/timestamp.h"
+#include "mongo/db/repl/base_cloner.h"
+#include "mongo/util/uuid.h"
+
+namespace mongo {
+namespace repl {
+
+/**
+ * Copies the data files of the sync source's last stable checkpoint into a local staging directory
+ * for file copy based initial sync. The sync source pins the checkpoint with a backup cursor and
+ * serves the files in chunks over the cloner's connection, and every file is flushed once copied.
+ * The initial syncer then installs the staged files by reinitializing the storage engine, after
+ * which recovery replays the copied oplog from the checkpoint timestamp.
+ */
+class BackupFileCloner final : public BaseCloner {
+public:
+    struct Stats {
+        size_t filesToCopy{0};
+        size_t filesCopied{0};
+        std::uint64_t bytesToCopy{0};
+        std::uint64_t bytesCopied{0};
+        size_t receivedChunks{0};
+        Date_t start;
+        Date_t end;
+
+        std::string toString() const;
+        BSONObj toBSON() const;
+        void append(BSONObjBuilder* builder) const;
+    };
+
+    BackupFileCloner(InitialSyncSharedData* sharedData,
+                     const HostAndPort& source,
+                     DBClientConnection* client,
+                     StorageInterface* storageInterface,
+                     ThreadPool* dbPool,
+                     boost::filesystem::path stagingPath);
+
+    virtual ~BackupFileCloner() = default;
+
+    Stats getStats() const;
+
+    std::string toString() const;
+
+    /**
+     * Returns the timestamp of the checkpoint being copied. Null until the backup cursor has been
+     * opened on the sync source.
+     */
+    Timestamp getCheckpointTimestamp() const;
+
+protected:
+    ClonerStages getStages() final;
+
+private:
+    friend class BackupFileClonerTest;
+
+    class ConnectStage : public ClonerStage<BackupFileCloner> {
+    public:
+        ConnectStage(std::string name, BackupFileCloner* cloner, ClonerRunFn stageFunc)
+            : ClonerStage<BackupFileCloner>(name, cloner, stageFunc){};
+        bool checkSyncSourceValidityOnRetry() final {
+            return false;
+        }
+    };
+
+    struct BackupFile {
+        std::string filename;
+        std::uint64_t fileSize;
+    };
+
+    /**
+     * Stage function that makes a connection to the sync source.
+     */
+    AfterStageBehavior connectStage();
+
+    /**
+     * Stage function that gets the wire version and initial sync ID.
+     */
+    AfterStageBehavior getInitialSyncIdStage();
+
+    /**
+     * Stage function that opens a backup cursor on the sync source and retrieves the list of files
+     * it pins.
+     */
+    AfterStageBehavior openBackupCursorStage();
+
+    /**
+     * Stage function that copies the files into the staging directory. On retry it resumes from
+     * the last chunk written.
+     */
+    AfterStageBehavior copyFilesStage();
+
+    /**
+     * The preStage discards anything left in the staging directory by an earlier attempt.
+     */
+    void preStage() final;
+
+    /**
+     * The postStage releases the backup cursor on the sync source and marks the staging directory
+     * complete.
+     */
+    void postStage() final;
+
+    std::string describeForFuzzer(BaseClonerStage* stage) const final {
+        return "admin db: { " + stage->getName() + ": 1 }";
+    }
+
+    // All member variables are labeled with one of the following codes indicating the
+    // synchronization rules for accessing them.
+    //
+    // (R)  Read-only in concurrent operation; no synchronization required.
+    // (X)  Access only allowed from the main flow of control called from run() or constructor.
+    // (MX) Write access with mutex from main flow of control, read access with mutex from other
+    //      threads, read access allowed from main flow without mutex.
+    ConnectStage _connectStage;                            // (R)
+    ConnectStage _getInitialSyncIdStage;                   // (R)
+    ClonerStage<BackupFileCloner> _openBackupCursorStage;  // (R)
+    ClonerStage<BackupFileCloner> _copyFilesStage;         // (R)
+    const boost::filesystem::path _stagingPath;            // (R)
+    const UUID _backupId = UUID::gen();                    // (R)
+    Timestamp _checkpointTimestamp;                        // (MX)
+    std::vector<BackupFile> _files;                        // (X)
+    size_t _currentFile = 0;                               // (X)
+    std::uint64_t _currentOffset = 0;                      // (X)
+    Stats _stats;                                          // (MX)
+};
+
+}  // namespace repl
+}  // namespace mongo
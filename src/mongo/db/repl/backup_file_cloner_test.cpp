@@ -0,0 +1,172 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#define MONGO_LOGV2_DEFAULT_COMPONENT ::mongo::logv2::LogComponent::kTest
+
+#include "mongo/platform/basic.h"
+
+#include <boost/filesystem.hpp>
+#include <fstream>
+
+#include "mongo/db/repl/backup_file_cloner.h"
+#include "mongo/db/repl/cloner_test_fixture.h"
+#include "mongo/db/storage/staged_backup_files.h"
+#include "mongo/dbtests/mock/mock_dbclient_connection.h"
+#include "mongo/unittest/temp_dir.h"
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+namespace repl {
+
+class BackupFileClonerTest : public ClonerTestFixture {
+public:
+    BackupFileClonerTest() : _tempDir("backup_file_cloner_test") {}
+
+protected:
+    void setUp() override {
+        ClonerTestFixture::setUp();
+        _mockClient->setWireVersions(WireVersion::RESUMABLE_INITIAL_SYNC,
+                                     WireVersion::RESUMABLE_INITIAL_SYNC);
+        _stagingPath = getStagedBackupFilesPath(_tempDir.path());
+    }
+
+    std::unique_ptr<BackupFileCloner> makeBackupFileCloner() {
+        return std::make_unique<BackupFileCloner>(_sharedData.get(),
+                                                  _source,
+                                                  _mockClient.get(),
+                                                  &_storageInterface,
+                                                  _dbWorkThreadPool.get(),
+                                                  _stagingPath);
+    }
+
+    static BSONObj makeReadReply(StringData data, bool eof) {
+        BSONObjBuilder bob;
+        bob.append("ok", 1);
+        bob.appendBinData("data", data.size(), BinDataGeneral, data.rawData());
+        bob.append("eof", eof);
+        return bob.obj();
+    }
+
+    std::string readStagedFile(const std::string& filename) {
+        std::ifstream stream((_stagingPath / filename).string(), std::ios::binary);
+        return std::string(std::istreambuf_iterator<char>(stream),
+                           std::istreambuf_iterator<char>());
+    }
+
+    unittest::TempDir _tempDir;
+    boost::filesystem::path _stagingPath;
+    const Timestamp _checkpointTimestamp{Seconds(100), 1};
+};
+
+TEST_F(BackupFileClonerTest, CopiesFilesInChunks) {
+    _mockServer->setCommandReply(
+        "_initialSyncOpenBackupCursor",
+        BSON("ok" << 1 << "checkpointTimestamp" << _checkpointTimestamp << "files"
+                  << BSON_ARRAY(BSON("filename"
+                                     << "collection-1.wt"
+                                     << "fileSize" << 6)
+                                << BSON("filename"
+                                        << "journal/WiredTigerLog.0000000001"
+                                        << "fileSize" << 3))));
+    _mockServer->setCommandReply("_initialSyncReadBackupFile",
+                                 {makeReadReply("abc", false),
+                                  makeReadReply("def", true),
+                                  makeReadReply("xyz", true)});
+    _mockServer->setCommandReply("_initialSyncCloseBackupCursor", BSON("ok" << 1));
+    auto cloner = makeBackupFileCloner();
+
+    ASSERT_OK(cloner->run());
+
+    ASSERT_EQ(_checkpointTimestamp, cloner->getCheckpointTimestamp());
+    ASSERT_EQ("abcdef", readStagedFile("collection-1.wt"));
+    ASSERT_EQ("xyz", readStagedFile("journal/WiredTigerLog.0000000001"));
+    // The staged files are marked complete by the node when it installs them.
+    ASSERT_FALSE(hasCompleteStagedBackupFiles(_stagingPath));
+
+    auto stats = cloner->getStats();
+    ASSERT_EQ(2u, stats.filesToCopy);
+    ASSERT_EQ(2u, stats.filesCopied);
+    ASSERT_EQ(9u, stats.bytesToCopy);
+    ASSERT_EQ(9u, stats.bytesCopied);
+    ASSERT_EQ(3u, stats.receivedChunks);
+}
+
+TEST_F(BackupFileClonerTest, DiscardsLeftoverStagedFiles) {
+    boost::filesystem::create_directories(_stagingPath);
+    std::ofstream(((_stagingPath / "leftover.wt").string())) << "stale";
+    _mockServer->setCommandReply("_initialSyncOpenBackupCursor",
+                                 BSON("ok" << 1 << "checkpointTimestamp" << _checkpointTimestamp
+                                           << "files" << BSONArray()));
+    _mockServer->setCommandReply("_initialSyncCloseBackupCursor", BSON("ok" << 1));
+    auto cloner = makeBackupFileCloner();
+
+    ASSERT_OK(cloner->run());
+
+    ASSERT_FALSE(boost::filesystem::exists(_stagingPath / "leftover.wt"));
+}
+
+TEST_F(BackupFileClonerTest, RejectsFileNamesOutsideStagingDirectory) {
+    _mockServer->setCommandReply(
+        "_initialSyncOpenBackupCursor",
+        BSON("ok" << 1 << "checkpointTimestamp" << _checkpointTimestamp << "files"
+                  << BSON_ARRAY(BSON("filename"
+                                     << "../WiredTiger.wt"
+                                     << "fileSize" << 1))));
+    auto cloner = makeBackupFileCloner();
+
+    ASSERT_EQ(ErrorCodes::InitialSyncFailure, cloner->run());
+    ASSERT_FALSE(hasCompleteStagedBackupFiles(_stagingPath));
+}
+
+TEST_F(BackupFileClonerTest, FailsOnOpenBackupCursor) {
+    Status expectedResult{ErrorCodes::CannotBackup, "foo"};
+    _mockServer->setCommandReply("_initialSyncOpenBackupCursor", expectedResult);
+    auto cloner = makeBackupFileCloner();
+
+    ASSERT_EQ(expectedResult, cloner->run());
+    ASSERT_FALSE(hasCompleteStagedBackupFiles(_stagingPath));
+}
+
+TEST_F(BackupFileClonerTest, FailsWhenSourceReturnsNoData) {
+    _mockServer->setCommandReply(
+        "_initialSyncOpenBackupCursor",
+        BSON("ok" << 1 << "checkpointTimestamp" << _checkpointTimestamp << "files"
+                  << BSON_ARRAY(BSON("filename"
+                                     << "collection-1.wt"
+                                     << "fileSize" << 6))));
+    _mockServer->setCommandReply("_initialSyncReadBackupFile", makeReadReply("", false));
+    auto cloner = makeBackupFileCloner();
+
+    ASSERT_EQ(ErrorCodes::InitialSyncFailure, cloner->run());
+    ASSERT_FALSE(hasCompleteStagedBackupFiles(_stagingPath));
+}
+
+}  // namespace repl
+}  // namespace mongo
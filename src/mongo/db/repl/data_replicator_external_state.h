@@ -100,6 +100,14 @@ public:
                                     const rpc::ReplSetMetadata& replMetadata,
                                     const rpc::OplogQueryMetadata& oqMetadata) = 0;
 
+    /**
+     * Forwards the measured latency and size of a batch fetched from a sync source which had more
+     * oplog entries to send to the replication system.
+     */
+    virtual void recordSyncSourceFetchStats(const HostAndPort& source,
+                                            Milliseconds getMoreLatency,
+                                            long long numBytes) = 0;
+
     /**
      * This function creates an oplog buffer of the type specified at server startup.
      */
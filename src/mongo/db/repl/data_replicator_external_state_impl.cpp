@@ -118,6 +118,12 @@ bool DataReplicatorExternalStateImpl::shouldStopFetching(
     return false;
 }
 
+void DataReplicatorExternalStateImpl::recordSyncSourceFetchStats(const HostAndPort& source,
+                                                                 Milliseconds getMoreLatency,
+                                                                 long long numBytes) {
+    _replicationCoordinator->recordSyncSourceFetchStats(source, getMoreLatency, numBytes);
+}
+
 std::unique_ptr<OplogBuffer> DataReplicatorExternalStateImpl::makeInitialSyncOplogBuffer(
     OperationContext* opCtx) const {
     if (initialSyncOplogBuffer == kCollectionOplogBufferName) {
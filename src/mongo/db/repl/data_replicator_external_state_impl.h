@@ -59,6 +59,10 @@ public:
                             const rpc::ReplSetMetadata& replMetadata,
                             const rpc::OplogQueryMetadata& oqMetadata) override;
 
+    void recordSyncSourceFetchStats(const HostAndPort& source,
+                                    Milliseconds getMoreLatency,
+                                    long long numBytes) override;
+
     std::unique_ptr<OplogBuffer> makeInitialSyncOplogBuffer(OperationContext* opCtx) const override;
 
     /**
@@ -103,6 +103,14 @@ bool DataReplicatorExternalStateMock::shouldStopFetching(
     return shouldStopFetchingResult;
 }
 
+void DataReplicatorExternalStateMock::recordSyncSourceFetchStats(const HostAndPort& source,
+                                                                 Milliseconds getMoreLatency,
+                                                                 long long numBytes) {
+    ++numSyncSourceFetchStatsRecorded;
+    lastRecordedGetMoreLatency = getMoreLatency;
+    lastRecordedNumBytes = numBytes;
+}
+
 std::unique_ptr<OplogBuffer> DataReplicatorExternalStateMock::makeInitialSyncOplogBuffer(
     OperationContext* opCtx) const {
     return std::make_unique<OplogBufferBlockingQueue>();
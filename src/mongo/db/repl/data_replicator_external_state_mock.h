@@ -56,6 +56,10 @@ public:
                             const rpc::ReplSetMetadata& replMetadata,
                             const rpc::OplogQueryMetadata& oqMetadata) override;
 
+    void recordSyncSourceFetchStats(const HostAndPort& source,
+                                    Milliseconds getMoreLatency,
+                                    long long numBytes) override;
+
     std::unique_ptr<OplogBuffer> makeInitialSyncOplogBuffer(OperationContext* opCtx) const override;
 
     std::unique_ptr<OplogApplier> makeOplogApplier(
@@ -88,6 +92,11 @@ public:
     // Returned by shouldStopFetching.
     bool shouldStopFetchingResult = false;
 
+    // Set by recordSyncSourceFetchStats.
+    int numSyncSourceFetchStatsRecorded = 0;
+    Milliseconds lastRecordedGetMoreLatency{0};
+    long long lastRecordedNumBytes = 0;
+
     // Override to change applyOplogBatch behavior.
     using ApplyOplogBatchFn = std::function<StatusWith<OpTime>(
         OperationContext*, std::vector<OplogEntry>, OplogApplier::Observer*)>;
@@ -0,0 +1,277 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#define MONGO_LOGV2_DEFAULT_COMPONENT ::mongo::logv2::LogComponent::kReplication
+
+#include "mongo/platform/basic.h"
+
+#include <boost/filesystem/path.hpp>
+#include <map>
+
+#include "mongo/bson/util/bson_extract.h"
+#include "mongo/db/repl/repl_set_command.h"
+#include "mongo/db/repl/replication_coordinator.h"
+#include "mongo/db/service_context.h"
+#include "mongo/db/storage/backup_cursor_hooks.h"
+#include "mongo/db/storage/storage_engine.h"
+#include "mongo/db/storage/storage_options.h"
+#include "mongo/logv2/log.h"
+#include "mongo/platform/mutex.h"
+#include "mongo/util/file.h"
+#include "mongo/util/str.h"
+
+namespace mongo {
+namespace repl {
+namespace {
+
+// A backup cursor which has not been used by its initial syncing node for this long is assumed to
+// be abandoned, and may be closed to allow another node to start a file copy based initial sync.
+// While it is open, the backup cursor prevents the oplog from being truncated.
+constexpr Minutes kAbandonedBackupCursorTimeout{10};
+
+// Upper bound on the number of bytes returned by a single _initialSyncReadBackupFile command, to
+// leave ample room for the reply's other fields.
+constexpr long long kMaxReadBackupFileChunkSizeBytes = BSONObjMaxUserSize / 2;
+
+/**
+ * The backup cursor opened on behalf of a node running a file copy based initial sync. WiredTiger
+ * only allows a single backup cursor at a time, so there is at most one per process.
+ */
+struct InitialSyncBackupCursor {
+    Mutex mutex = MONGO_MAKE_LATCH("InitialSyncBackupCursor::mutex");
+    boost::optional<UUID> backupId;
+    Timestamp checkpointTimestamp;
+    // Maps the name of each file relative to the dbpath to the size it had when the cursor was
+    // opened. Only these files may be read, and only up to that size.
+    std::map<std::string, std::uint64_t> files;
+    Date_t lastUsed;
+};
+
+const auto getInitialSyncBackupCursor =
+    ServiceContext::declareDecoration<InitialSyncBackupCursor>();
+
+UUID parseBackupId(const BSONObj& cmdObj) {
+    return uassertStatusOK(UUID::parse(cmdObj["backupId"]));
+}
+
+void closeBackupCursor(WithLock, OperationContext* opCtx, InitialSyncBackupCursor& cursor) {
+    opCtx->getServiceContext()->getStorageEngine()->endNonBlockingBackup(opCtx);
+    LOGV2(5380010, "Closed initial sync backup cursor", "backupId"_attr = *cursor.backupId);
+    cursor.backupId = boost::none;
+    cursor.files.clear();
+}
+
+/**
+ * Returns the open backup cursor, throwing if it does not have the given id.
+ */
+InitialSyncBackupCursor& checkBackupCursor(WithLock,
+                                           OperationContext* opCtx,
+                                           InitialSyncBackupCursor& cursor,
+                                           const UUID& backupId) {
+    uassert(ErrorCodes::CannotBackup,
+            str::stream() << "No initial sync backup cursor with id " << backupId << " is open",
+            cursor.backupId == backupId);
+    cursor.lastUsed = opCtx->getServiceContext()->getFastClockSource()->now();
+    return cursor;
+}
+
+/**
+ * Opens a backup cursor on this node's storage engine and returns the files it pins, for use by
+ * a node running a file copy based initial sync. Retrying with the same backupId returns the
+ * already open cursor.
+ */
+class CmdInitialSyncOpenBackupCursor : public ReplSetCommand {
+public:
+    CmdInitialSyncOpenBackupCursor() : ReplSetCommand("_initialSyncOpenBackupCursor") {}
+
+    bool run(OperationContext* opCtx,
+             const std::string&,
+             const BSONObj& cmdObj,
+             BSONObjBuilder& result) override {
+        auto replCoord = ReplicationCoordinator::get(opCtx);
+        uassertStatusOK(replCoord->checkReplEnabledForCommand(&result));
+        const auto memberState = replCoord->getMemberState();
+        uassert(ErrorCodes::NotPrimaryOrSecondary,
+                str::stream() << "Cannot open a backup cursor for initial sync in state "
+                              << memberState.toString(),
+                memberState.primary() || memberState.secondary());
+
+        auto backupCursorHooks = BackupCursorHooks::get(opCtx->getServiceContext());
+        uassert(ErrorCodes::CannotBackup,
+                "Cannot open a backup cursor for initial sync while a user backup cursor is open",
+                !backupCursorHooks->enabled() || !backupCursorHooks->isBackupCursorOpen());
+
+        const auto backupId = parseBackupId(cmdObj);
+        auto storageEngine = opCtx->getServiceContext()->getStorageEngine();
+        auto& cursor = getInitialSyncBackupCursor(opCtx->getServiceContext());
+        stdx::lock_guard<Latch> lk(cursor.mutex);
+        const auto now = opCtx->getServiceContext()->getFastClockSource()->now();
+
+        if (cursor.backupId && cursor.backupId != backupId) {
+            uassert(ErrorCodes::CannotBackup,
+                    str::stream() << "Another node is already running a file copy based initial "
+                                     "sync from this node using backup cursor "
+                                  << *cursor.backupId,
+                    now - cursor.lastUsed >= kAbandonedBackupCursorTimeout);
+            LOGV2(5380011,
+                  "Closing abandoned initial sync backup cursor",
+                  "backupId"_attr = *cursor.backupId,
+                  "lastUsed"_attr = cursor.lastUsed);
+            closeBackupCursor(lk, opCtx, cursor);
+        }
+
+        if (!cursor.backupId) {
+            auto backupInformation = uassertStatusOK(
+                storageEngine->beginNonBlockingBackup(opCtx, StorageEngine::BackupOptions()));
+            auto endBackupGuard =
+                makeGuard([&] { storageEngine->endNonBlockingBackup(opCtx); });
+
+            // The syncing node recovers from the checkpoint pinned by the backup cursor before
+            // replaying the copied oplog. Its timestamp must come from the backup cursor itself,
+            // as a checkpoint may have completed since the cursor was opened.
+            auto checkpointTimestamp = storageEngine->getBackupCheckpointTimestamp();
+            uassert(ErrorCodes::CannotBackup,
+                    "Cannot open a backup cursor for initial sync before the first stable "
+                    "checkpoint has been taken",
+                    checkpointTimestamp && !checkpointTimestamp->isNull());
+
+            const boost::filesystem::path dbpath(storageGlobalParams.dbpath);
+            std::map<std::string, std::uint64_t> files;
+            for (const auto& [path, file] : backupInformation) {
+                files.emplace(
+                    boost::filesystem::path(path).lexically_relative(dbpath).generic_string(),
+                    file.fileSize);
+            }
+
+            endBackupGuard.dismiss();
+            cursor.backupId = backupId;
+            cursor.checkpointTimestamp = *checkpointTimestamp;
+            cursor.files = std::move(files);
+            LOGV2(5380012,
+                  "Opened initial sync backup cursor",
+                  "backupId"_attr = backupId,
+                  "checkpointTimestamp"_attr = cursor.checkpointTimestamp,
+                  "numFiles"_attr = cursor.files.size());
+        }
+        cursor.lastUsed = now;
+
+        backupId.appendToBuilder(&result, "backupId");
+        result.append("checkpointTimestamp", cursor.checkpointTimestamp);
+        BSONArrayBuilder filesBuilder(result.subarrayStart("files"));
+        for (const auto& [filename, fileSize] : cursor.files) {
+            filesBuilder.append(BSON("filename" << filename << "fileSize"
+                                                << static_cast<long long>(fileSize)));
+        }
+        filesBuilder.doneFast();
+        return true;
+    }
+} cmdInitialSyncOpenBackupCursor;
+
+/**
+ * Returns a chunk of one of the files pinned by the open initial sync backup cursor.
+ */
+class CmdInitialSyncReadBackupFile : public ReplSetCommand {
+public:
+    CmdInitialSyncReadBackupFile() : ReplSetCommand("_initialSyncReadBackupFile") {}
+
+    bool run(OperationContext* opCtx,
+             const std::string&,
+             const BSONObj& cmdObj,
+             BSONObjBuilder& result) override {
+        const auto backupId = parseBackupId(cmdObj);
+        std::string filename;
+        uassertStatusOK(bsonExtractStringField(cmdObj, "filename", &filename));
+        long long offset;
+        uassertStatusOK(bsonExtractIntegerField(cmdObj, "offset", &offset));
+        long long length;
+        uassertStatusOK(bsonExtractIntegerField(cmdObj, "length", &length));
+        uassert(ErrorCodes::BadValue,
+                str::stream() << "Invalid offset " << offset << " or length " << length,
+                offset >= 0 && length > 0);
+        length = std::min(length, kMaxReadBackupFileChunkSizeBytes);
+
+        std::uint64_t fileSize;
+        {
+            auto& cursor = getInitialSyncBackupCursor(opCtx->getServiceContext());
+            stdx::lock_guard<Latch> lk(cursor.mutex);
+            checkBackupCursor(lk, opCtx, cursor, backupId);
+            auto it = cursor.files.find(filename);
+            uassert(ErrorCodes::BadValue,
+                    str::stream() << "File " << filename << " is not part of backup " << backupId,
+                    it != cursor.files.end());
+            fileSize = it->second;
+        }
+
+        const auto remaining =
+            static_cast<long long>(fileSize) - std::min(offset, static_cast<long long>(fileSize));
+        const auto toRead = static_cast<unsigned>(std::min(length, remaining));
+        std::unique_ptr<char[]> buffer(new char[toRead]);
+        if (toRead > 0) {
+            const auto path = boost::filesystem::path(storageGlobalParams.dbpath) / filename;
+            File file;
+            file.open(path.string().c_str(), /*readOnly*/ true);
+            uassert(ErrorCodes::FileOpenFailed,
+                    str::stream() << "Failed to open backup file " << path.string(),
+                    file.is_open());
+            file.read(offset, buffer.get(), toRead);
+            uassert(ErrorCodes::FileStreamFailed,
+                    str::stream() << "Failed to read backup file " << path.string(),
+                    !file.bad());
+        }
+
+        result.appendBinData("data", toRead, BinDataGeneral, buffer.get());
+        result.append("eof", offset + toRead >= static_cast<long long>(fileSize));
+        return true;
+    }
+} cmdInitialSyncReadBackupFile;
+
+/**
+ * Closes the initial sync backup cursor, allowing the oplog to be truncated past its checkpoint.
+ */
+class CmdInitialSyncCloseBackupCursor : public ReplSetCommand {
+public:
+    CmdInitialSyncCloseBackupCursor() : ReplSetCommand("_initialSyncCloseBackupCursor") {}
+
+    bool run(OperationContext* opCtx,
+             const std::string&,
+             const BSONObj& cmdObj,
+             BSONObjBuilder& result) override {
+        const auto backupId = parseBackupId(cmdObj);
+        auto& cursor = getInitialSyncBackupCursor(opCtx->getServiceContext());
+        stdx::lock_guard<Latch> lk(cursor.mutex);
+        checkBackupCursor(lk, opCtx, cursor, backupId);
+        closeBackupCursor(lk, opCtx, cursor);
+        return true;
+    }
+} cmdInitialSyncCloseBackupCursor;
+
+}  // namespace
+}  // namespace repl
+}  // namespace mongo
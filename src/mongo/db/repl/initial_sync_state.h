@@ -38,6 +38,7 @@
 #include "mongo/bson/timestamp.h"
 #include "mongo/db/namespace_string.h"
 #include "mongo/db/repl/all_database_cloner.h"
+#include "mongo/db/repl/backup_file_cloner.h"
 #include "mongo/db/repl/optime.h"
 #include "mongo/util/net/hostandport.h"
 
@@ -50,10 +51,15 @@ namespace repl {
 struct InitialSyncState {
     InitialSyncState(std::unique_ptr<AllDatabaseCloner> cloner)
         : allDatabaseCloner(std::move(cloner)){};
+    InitialSyncState(std::unique_ptr<BackupFileCloner> cloner)
+        : backupFileCloner(std::move(cloner)){};
 
     std::unique_ptr<AllDatabaseCloner>
         allDatabaseCloner;                 // Cloner for all databases included in initial sync.
     Future<void> allDatabaseClonerFuture;  // Future for holding result of AllDatabaseCloner
+    std::unique_ptr<BackupFileCloner>
+        backupFileCloner;                 // Cloner for file copy based initial sync.
+    Future<void> backupFileClonerFuture;  // Future for holding result of BackupFileCloner
     Timestamp beginApplyingTimestamp;  // Timestamp from the latest entry in oplog when started. It
                                        // is also the timestamp after which we will start applying
                                        // operations during initial sync.
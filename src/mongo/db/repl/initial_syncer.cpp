@@ -50,6 +50,7 @@
 #include "mongo/db/jsobj.h"
 #include "mongo/db/namespace_string.h"
 #include "mongo/db/repl/all_database_cloner.h"
+#include "mongo/db/repl/initial_sync_method.h"
 #include "mongo/db/repl/initial_sync_state.h"
 #include "mongo/db/repl/member_state.h"
 #include "mongo/db/repl/oplog_buffer.h"
@@ -62,6 +63,8 @@
 #include "mongo/db/repl/sync_source_selector.h"
 #include "mongo/db/repl/transaction_oplog_application.h"
 #include "mongo/db/session_txn_record_gen.h"
+#include "mongo/db/storage/staged_backup_files.h"
+#include "mongo/db/storage/storage_options.h"
 #include "mongo/executor/task_executor.h"
 #include "mongo/executor/thread_pool_task_executor.h"
 #include "mongo/logv2/log.h"
@@ -471,6 +474,11 @@ BSONObj InitialSyncer::_getInitialSyncProgress_inlock() const {
                 _initialSyncState->allDatabaseCloner->getStats().append(&dbsBuilder);
                 dbsBuilder.doneFast();
             }
+            if (_initialSyncState->backupFileCloner) {
+                BSONObjBuilder filesBuilder(bob.subobjStart("backupFiles"));
+                _initialSyncState->backupFileCloner->getStats().append(&filesBuilder);
+                filesBuilder.doneFast();
+            }
         }
         return bob.obj();
     } catch (const DBException& e) {
@@ -549,6 +557,7 @@ void InitialSyncer::_tearDown_inlock(OperationContext* opCtx,
     if (!lastApplied.isOK()) {
         return;
     }
+
     const auto lastAppliedOpTime = lastApplied.getValue().opTime;
     auto initialDataTimestamp = lastAppliedOpTime.getTimestamp();
 
@@ -1131,6 +1140,12 @@ void InitialSyncer::_fcvFetcherCallback(const StatusWith<Fetcher::QueryResponse>
                                                 _allowedOutageDuration,
                                                 getGlobalServiceContext()->getFastClockSource());
     _client = _createClientFn();
+
+    if (initialSyncMethod == kInitialSyncMethodFileCopyBased) {
+        _startBackupFileCloner(lock, onCompletionGuard);
+        return;
+    }
+
     _initialSyncState = std::make_unique<InitialSyncState>(std::make_unique<AllDatabaseCloner>(
         _sharedData.get(), _syncSource, _client.get(), _storage, _writerPool));
 
@@ -1271,6 +1286,89 @@ void InitialSyncer::_fcvFetcherCallback(const StatusWith<Fetcher::QueryResponse>
     (*_clonerAttemptExec)->signalEvent(startCloner);
 }
 
+void InitialSyncer::_startBackupFileCloner(stdx::unique_lock<Latch>& lock,
+                                           std::shared_ptr<OnCompletionGuard> onCompletionGuard) {
+    _initialSyncState = std::make_unique<InitialSyncState>(
+        std::make_unique<BackupFileCloner>(_sharedData.get(),
+                                           _syncSource,
+                                           _client.get(),
+                                           _storage,
+                                           _writerPool,
+                                           getStagedBackupFilesPath(storageGlobalParams.dbpath)));
+
+    LOGV2(5380032,
+          "Starting file copy based initial sync",
+          "backupFileCloner"_attr = _initialSyncState->backupFileCloner->toString());
+
+    auto [startClonerFuture, startCloner] =
+        _initialSyncState->backupFileCloner->runOnExecutorEvent(*_clonerAttemptExec);
+    // runOnExecutorEvent ensures the future is not ready unless an error has occurred.
+    if (startClonerFuture.isReady()) {
+        auto status = startClonerFuture.getNoThrow();
+        invariant(!status.isOK());
+        onCompletionGuard->setResultAndCancelRemainingWork_inlock(lock, status);
+        lock.unlock();
+        return;
+    }
+    _initialSyncState->backupFileClonerFuture =
+        std::move(startClonerFuture).onCompletion([this, onCompletionGuard](Status status) mutable {
+            // As with the AllDatabaseCloner, the completion guard must run on the main executor,
+            // and never inline.
+            stdx::unique_lock<Latch> lock(_mutex);
+            auto exec_status = (*_attemptExec)
+                                   ->scheduleWork([this, status, onCompletionGuard](
+                                                      executor::TaskExecutor::CallbackArgs args) {
+                                       _backupFileClonerCallback(status, onCompletionGuard);
+                                   });
+            if (!exec_status.isOK()) {
+                onCompletionGuard->setResultAndCancelRemainingWork_inlock(lock,
+                                                                          exec_status.getStatus());
+                lock.unlock();
+            }
+            onCompletionGuard.reset();
+        });
+    lock.unlock();
+    (*_clonerAttemptExec)->signalEvent(startCloner);
+}
+
+void InitialSyncer::_backupFileClonerCallback(
+    const Status& backupFileClonerFinishStatus,
+    std::shared_ptr<OnCompletionGuard> onCompletionGuard) {
+    LOGV2(5380033,
+          "Finished copying backup files",
+          "backupFileClonerFinishStatus"_attr = redact(backupFileClonerFinishStatus));
+    _client->shutdownAndDisallowReconnect();
+
+    {
+        stdx::lock_guard<Latch> lock(_mutex);
+        _client.reset();
+        auto status = _checkForShutdownAndConvertStatus_inlock(backupFileClonerFinishStatus,
+                                                               "error copying backup files");
+        if (!status.isOK()) {
+            onCompletionGuard->setResultAndCancelRemainingWork_inlock(lock, status);
+            return;
+        }
+    }
+
+    // Installing the files reinitializes the storage engine under the global exclusive lock, so
+    // the mutex must not be held, as operations holding the global lock may wait for it.
+    StatusWith<OpTimeAndWallTime> lastApplied = [&] {
+        try {
+            return _opts.installStagedBackupFiles(makeOpCtx().get());
+        } catch (const DBException& e) {
+            return StatusWith<OpTimeAndWallTime>(e.toStatus());
+        }
+    }();
+
+    stdx::lock_guard<Latch> lock(_mutex);
+    if (!lastApplied.isOK()) {
+        LOGV2_ERROR(5380031,
+                    "Failed to install the backup files copied by initial sync",
+                    "error"_attr = lastApplied.getStatus());
+    }
+    onCompletionGuard->setResultAndCancelRemainingWork_inlock(lock, lastApplied);
+}
+
 void InitialSyncer::_oplogFetcherCallback(const Status& oplogFetcherFinishStatus,
                                           std::shared_ptr<OnCompletionGuard> onCompletionGuard) {
     stdx::lock_guard<Latch> lock(_mutex);
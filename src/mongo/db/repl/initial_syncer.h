@@ -91,6 +91,13 @@ struct InitialSyncerOptions {
     /** Function to sets this node into a specific follower mode. */
     using SetFollowerModeFn = std::function<bool(const MemberState&)>;
 
+    /**
+     * Function to install the files staged by a file copy based initial sync in place of this
+     * node's data, returning the optime of the last oplog entry once they have been recovered.
+     */
+    using InstallStagedBackupFilesFn =
+        std::function<StatusWith<OpTimeAndWallTime>(OperationContext* opCtx)>;
+
     // Retry values
     Milliseconds syncSourceRetryWait{1000};
     Milliseconds initialSyncRetryWait{1000};
@@ -107,6 +114,7 @@ struct InitialSyncerOptions {
     GetMyLastOptimeFn getMyLastOptime;
     SetMyLastOptimeFn setMyLastOptime;
     ResetOptimesFn resetOptimes;
+    InstallStagedBackupFilesFn installStagedBackupFiles;
 
     SyncSourceSelector* syncSourceSelector = nullptr;
 
@@ -442,6 +450,19 @@ private:
      *         |
      *         V
      *    _finishCallback()
+     *
+     * When 'initialSyncMethod' is "fileCopyBased", _fcvFetcherCallback() starts the
+     * BackupFileCloner instead of the oplog fetcher and the AllDatabaseCloner:
+     *
+     *    _fcvFetcherCallback()
+     *         |
+     *         |
+     *         V
+     *    _backupFileClonerCallback()
+     *         |
+     *         |
+     *         V
+     *    _finishInitialSyncAttempt()
      */
 
     /**
@@ -545,6 +566,20 @@ private:
     void _allDatabaseClonerCallback(const Status& status,
                                     std::shared_ptr<OnCompletionGuard> onCompletionGuard);
 
+    /**
+     * Starts the BackupFileCloner for a file copy based initial sync. Releases 'lock' before
+     * returning.
+     */
+    void _startBackupFileCloner(stdx::unique_lock<Latch>& lock,
+                                std::shared_ptr<OnCompletionGuard> onCompletionGuard);
+
+    /**
+     * Callback for BackupFileCloner. On success, completes the initial sync attempt with the
+     * checkpoint timestamp of the copied files; the files are installed when the node restarts.
+     */
+    void _backupFileClonerCallback(const Status& status,
+                                   std::shared_ptr<OnCompletionGuard> onCompletionGuard);
+
     /**
      * Callback for second '_lastOplogEntryFetcher' callback. This is scheduled to obtain the stop
      * timestamp after DatabasesCloner has completed and enables us to determine if the oplog on
@@ -164,6 +164,11 @@ public:
                                 const rpc::OplogQueryMetadata& oqMetadata) override {
         return _syncSourceSelector->shouldChangeSyncSource(currentSource, replMetadata, oqMetadata);
     }
+    void recordSyncSourceFetchStats(const HostAndPort& source,
+                                    Milliseconds getMoreLatency,
+                                    long long numBytes) override {
+        _syncSourceSelector->recordSyncSourceFetchStats(source, getMoreLatency, numBytes);
+    }
 
     void scheduleNetworkResponse(std::string cmdName, const BSONObj& obj) {
         NetworkInterfaceMock* net = getNet();
@@ -860,6 +860,14 @@ Status OplogFetcher::_onSuccessfulBatch(const Documents& documents) {
 
     oplogBatchStats.recordMillis(_lastBatchElapsedMS, documents.empty());
 
+    // Only a getMore which returned while the sync source had more entries to send measures how
+    // fast the source serves the oplog. Any other getMore waited for new writes, and the initial
+    // find also pays for establishing the cursor.
+    if (!_firstBatch && !documents.empty() && info.lastDocument < oqMetadata.getLastOpApplied()) {
+        _dataReplicatorExternalState->recordSyncSourceFetchStats(
+            _source, Milliseconds(_lastBatchElapsedMS), info.networkDocumentBytes);
+    }
+
     auto status = _enqueueDocumentsFn(firstDocToApply, documents.cend(), info);
     if (!status.isOK()) {
         return status;
@@ -1392,6 +1392,49 @@ TEST_F(OplogFetcherTest, OplogFetcherWorksWithoutExhaust) {
     ASSERT_EQUALS(ErrorCodes::CallbackCanceled, shutdownState.getStatus());
 }
 
+TEST_F(OplogFetcherTest, OplogFetcherRecordsSyncSourceFetchStatsOnlyForLaggingSubsequentBatches) {
+    ShutdownState shutdownState;
+
+    oplogFetcherUsesExhaust = false;
+
+    // Create an oplog fetcher with one retry.
+    auto oplogFetcher = getOplogFetcherAfterConnectionCreated(std::ref(shutdownState), 1);
+
+    CursorId cursorId = 22LL;
+    auto firstEntry = makeNoopOplogEntry(lastFetched);
+    auto secondEntry = makeNoopOplogEntry({{Seconds(456), 0}, lastFetched.getTerm()});
+    auto metadataObj = makeOplogBatchMetadata(replSetMetadata, oqMetadata);
+
+    // The latency of the first batch includes establishing the cursor, so it is not recorded.
+    processSingleRequestResponse(oplogFetcher->getDBClientConnection_forTest(),
+                                 makeFirstBatch(cursorId, {firstEntry, secondEntry}, metadataObj),
+                                 true);
+    ASSERT_EQUALS(0, dataReplicatorExternalState->numSyncSourceFetchStatsRecorded);
+
+    // The sync source has applied entries past this batch, so the batch was limited by how fast
+    // the sync source served it rather than by the rate of writes.
+    auto thirdEntry = makeNoopOplogEntry({{Seconds(457), 0}, lastFetched.getTerm()});
+    auto fourthEntry = makeNoopOplogEntry({{Seconds(458), 0}, lastFetched.getTerm()});
+    processSingleRequestResponse(
+        oplogFetcher->getDBClientConnection_forTest(),
+        makeSubsequentBatch(cursorId, {thirdEntry, fourthEntry}, metadataObj, false),
+        true);
+    ASSERT_EQUALS(1, dataReplicatorExternalState->numSyncSourceFetchStatsRecorded);
+    ASSERT_EQUALS(thirdEntry.objsize() + fourthEntry.objsize(),
+                  dataReplicatorExternalState->lastRecordedNumBytes);
+
+    // An empty batch means the sync source had nothing more to return.
+    processSingleRequestResponse(oplogFetcher->getDBClientConnection_forTest(),
+                                 makeSubsequentBatch(cursorId, {}, metadataObj, false),
+                                 true);
+    ASSERT_EQUALS(1, dataReplicatorExternalState->numSyncSourceFetchStatsRecorded);
+
+    oplogFetcher->shutdown();
+    oplogFetcher->join();
+
+    ASSERT_EQUALS(ErrorCodes::CallbackCanceled, shutdownState.getStatus());
+}
+
 TEST_F(OplogFetcherTest, CursorIsDeadShutsDownOplogFetcherWithSuccessfulStatus) {
     ShutdownState shutdownState;
 
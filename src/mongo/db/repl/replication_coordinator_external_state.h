@@ -209,6 +209,22 @@ public:
      */
     virtual StatusWith<OpTimeAndWallTime> loadLastOpTimeAndWallTime(OperationContext* opCtx) = 0;
 
+    /**
+     * Replaces this node's data with the files staged by a file copy based initial sync by
+     * reinitializing the storage engine, restores this node's own replica set state over the one
+     * copied from the sync source, and recovers from the copied oplog. Returns the optime, and
+     * corresponding wall clock time, of the last entry in the oplog. Returns an error only if this
+     * node's data has not been touched.
+     */
+    virtual StatusWith<OpTimeAndWallTime> installStagedBackupFiles(OperationContext* opCtx) = 0;
+
+    /**
+     * Restores this node's own replica set state over the one copied by a file copy based initial
+     * sync, if the copied files were installed without it being restored, such as when the node
+     * crashed in between.
+     */
+    virtual void restoreLocalStateAfterInstallingBackupFiles(OperationContext* opCtx) = 0;
+
     /**
      * Returns the HostAndPort of the remote client connected to us that initiated the operation
      * represented by "opCtx".
@@ -41,6 +41,7 @@
 #include "mongo/bson/oid.h"
 #include "mongo/bson/util/bson_extract.h"
 #include "mongo/db/auth/authorization_session.h"
+#include "mongo/db/catalog/catalog_control.h"
 #include "mongo/db/catalog/coll_mod.h"
 #include "mongo/db/catalog/database.h"
 #include "mongo/db/catalog/database_holder.h"
@@ -77,6 +78,7 @@
 #include "mongo/db/repl/replication_metrics.h"
 #include "mongo/db/repl/replication_process.h"
 #include "mongo/db/repl/storage_interface.h"
+#include "mongo/db/repl/storage_interface_impl.h"
 #include "mongo/db/s/balancer/balancer.h"
 #include "mongo/db/s/chunk_splitter.h"
 #include "mongo/db/s/config/sharding_catalog_manager.h"
@@ -90,7 +92,10 @@
 #include "mongo/db/service_context.h"
 #include "mongo/db/session_catalog_mongod.h"
 #include "mongo/db/storage/flow_control.h"
+#include "mongo/db/storage/staged_backup_files.h"
 #include "mongo/db/storage/storage_engine.h"
+#include "mongo/db/storage/storage_engine_init.h"
+#include "mongo/db/storage/storage_options.h"
 #include "mongo/db/system_index.h"
 #include "mongo/executor/network_connection_hook.h"
 #include "mongo/executor/network_interface.h"
@@ -127,6 +132,11 @@ const char meCollectionName[] = "local.me";
 const auto meDatabaseName = localDbName;
 const char tsFieldName[] = "ts";
 
+// Fields of the node-local state recorded before installing the files copied by initial sync.
+constexpr StringData kLocalStateConfigFieldName = "config"_sd;
+constexpr StringData kLocalStateLastVoteFieldName = "lastVote"_sd;
+constexpr StringData kLocalStateRollbackIdFieldName = "rollbackId"_sd;
+
 MONGO_FAIL_POINT_DEFINE(dropPendingCollectionReaperHang);
 
 // The count of items in the buffer
@@ -744,6 +754,99 @@ StatusWith<OpTimeAndWallTime> ReplicationCoordinatorExternalStateImpl::loadLastO
     }
 }
 
+StatusWith<OpTimeAndWallTime> ReplicationCoordinatorExternalStateImpl::installStagedBackupFiles(
+    OperationContext* opCtx) {
+    // The global exclusive lock keeps this node from voting or otherwise changing its own replica
+    // set state between recording that state and installing the files that overwrite it.
+    Lock::GlobalWrite globalWrite(opCtx);
+
+    BSONObjBuilder localState;
+    auto config = loadLocalConfigDocument(opCtx);
+    if (config.isOK()) {
+        localState.append(kLocalStateConfigFieldName, config.getValue());
+    }
+    auto lastVote = loadLocalLastVoteDocument(opCtx);
+    if (!lastVote.isOK()) {
+        return lastVote.getStatus();
+    }
+    localState.append(kLocalStateLastVoteFieldName, lastVote.getValue().toBSON());
+    localState.append(kLocalStateRollbackIdFieldName, _replicationProcess->getRollbackID());
+
+    try {
+        markStagedBackupFilesComplete(getStagedBackupFilesPath(storageGlobalParams.dbpath),
+                                      localState.obj());
+    } catch (const DBException& ex) {
+        return ex.toStatus();
+    }
+
+    // Past this point the staged files are installed the next time the storage engine starts, so
+    // failing to install them now leaves this node with no usable data until it restarts.
+    try {
+        LOGV2(5380038, "Installing the data files copied by initial sync");
+        catalog::closeCatalog(opCtx);
+        reinitializeStorageEngine(opCtx);
+        _service->getStorageEngine()->setJournalListener(this);
+        catalog::openCatalog(opCtx, {});
+
+        restoreLocalStateAfterInstallingBackupFiles(opCtx);
+
+        const auto stableTimestamp = boost::none;
+        _replicationProcess->getReplicationRecovery()->recoverFromOplog(opCtx, stableTimestamp);
+        _service->getStorageEngine()->notifyStartupComplete();
+        return fassert(5380039, loadLastOpTimeAndWallTime(opCtx));
+    } catch (const DBException& ex) {
+        LOGV2_FATAL_NOTRACE(5380040,
+                            "Failed to install the data files copied by initial sync",
+                            "error"_attr = ex.toStatus());
+    }
+}
+
+void ReplicationCoordinatorExternalStateImpl::restoreLocalStateAfterInstallingBackupFiles(
+    OperationContext* opCtx) {
+    auto localState = getInstalledBackupFilesLocalState(storageGlobalParams.dbpath);
+    if (!localState) {
+        return;
+    }
+
+    LOGV2(5380041,
+          "Restoring this node's replica set state over the one copied by initial sync",
+          "localState"_attr = redact(*localState));
+
+    auto config = (*localState)[kLocalStateConfigFieldName];
+    if (config.isABSONObj()) {
+        fassert(5380042, storeLocalConfigDocument(opCtx, config.Obj(), false /* writeOplog */));
+    }
+
+    // Unlike storeLocalLastVoteDocument(), replace the sync source's lastVote even if its term is
+    // higher, as this node never cast that vote.
+    writeConflictRetry(opCtx, "restore replica set lastVote", lastVoteCollectionName, [&] {
+        AutoGetCollection coll(opCtx, NamespaceString(lastVoteCollectionName), MODE_X);
+        WriteUnitOfWork wunit(opCtx);
+        Helpers::putSingleton(
+            opCtx, lastVoteCollectionName, (*localState)[kLocalStateLastVoteFieldName].Obj());
+        wunit.commit();
+    });
+
+    // Members that synced from this node remember its rollback ID, which must therefore move past
+    // both its own and the copied one.
+    auto copiedRollbackId = _storageInterface->getRollbackID(opCtx);
+    const int rollbackId =
+        std::max((*localState)[kLocalStateRollbackIdFieldName].numberInt(),
+                 copiedRollbackId.isOK() ? copiedRollbackId.getValue() : 0);
+    fassert(5380043,
+            _storageInterface->putSingleton(
+                opCtx,
+                NamespaceString(StorageInterfaceImpl::kDefaultRollbackIdNamespace),
+                {BSON("$set" << BSON(StorageInterfaceImpl::kRollbackIdFieldName << rollbackId)),
+                 Timestamp()}));
+    fassert(5380044, _replicationProcess->incrementRollbackID(opCtx));
+
+    // The copied initial sync ID belongs to the sync source.
+    _replicationProcess->getConsistencyMarkers()->clearInitialSyncId(opCtx);
+
+    removeInstalledBackupFilesLocalState(storageGlobalParams.dbpath);
+}
+
 bool ReplicationCoordinatorExternalStateImpl::isSelf(const HostAndPort& host, ServiceContext* ctx) {
     return repl::isSelf(host, ctx);
 }
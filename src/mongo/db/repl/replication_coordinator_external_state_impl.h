@@ -96,6 +96,8 @@ public:
     virtual Timestamp getGlobalTimestamp(ServiceContext* service);
     bool oplogExists(OperationContext* opCtx) final;
     virtual StatusWith<OpTimeAndWallTime> loadLastOpTimeAndWallTime(OperationContext* opCtx);
+    StatusWith<OpTimeAndWallTime> installStagedBackupFiles(OperationContext* opCtx) final;
+    void restoreLocalStateAfterInstallingBackupFiles(OperationContext* opCtx) final;
     virtual HostAndPort getClientHostAndPort(const OperationContext* opCtx);
     virtual void closeConnections();
     virtual void shardingOnStepDownHook();
@@ -204,6 +204,14 @@ StatusWith<OpTimeAndWallTime> ReplicationCoordinatorExternalStateMock::loadLastO
     }
 }
 
+StatusWith<OpTimeAndWallTime> ReplicationCoordinatorExternalStateMock::installStagedBackupFiles(
+    OperationContext* opCtx) {
+    return {ErrorCodes::IllegalOperation, "Cannot install staged backup files in a mock"};
+}
+
+void ReplicationCoordinatorExternalStateMock::restoreLocalStateAfterInstallingBackupFiles(
+    OperationContext* opCtx) {}
+
 void ReplicationCoordinatorExternalStateMock::setLastOpTimeAndWallTime(
     const StatusWith<OpTime>& lastApplied, Date_t lastAppliedWall) {
     _lastOpTime = lastApplied;
@@ -86,6 +86,8 @@ public:
     virtual Timestamp getGlobalTimestamp(ServiceContext* service);
     bool oplogExists(OperationContext* opCtx) override;
     virtual StatusWith<OpTimeAndWallTime> loadLastOpTimeAndWallTime(OperationContext* opCtx);
+    StatusWith<OpTimeAndWallTime> installStagedBackupFiles(OperationContext* opCtx) override;
+    void restoreLocalStateAfterInstallingBackupFiles(OperationContext* opCtx) override;
     virtual void closeConnections();
     virtual void shardingOnStepDownHook();
     virtual void stopAsyncUpdatesOfAndClearOplogTruncateAfterPoint() override;
@@ -182,62 +182,6 @@ StatusOrStatusWith<T> futureGetNoThrowWithDeadline(OperationContext* opCtx,
 
 }  // namespace
 
-void ReplicationCoordinatorImpl::WaiterList::add_inlock(const OpTime& opTime,
-                                                        SharedWaiterHandle waiter) {
-    _waiters.emplace(opTime, std::move(waiter));
-}
-
-SharedSemiFuture<void> ReplicationCoordinatorImpl::WaiterList::add_inlock(
-    const OpTime& opTime, boost::optional<WriteConcernOptions> wc) {
-    auto pf = makePromiseFuture<void>();
-    _waiters.emplace(opTime, std::make_shared<Waiter>(std::move(pf.promise), std::move(wc)));
-    return std::move(pf.future);
-}
-
-bool ReplicationCoordinatorImpl::WaiterList::remove_inlock(SharedWaiterHandle waiter) {
-    for (auto iter = _waiters.begin(); iter != _waiters.end(); iter++) {
-        if (iter->second == waiter) {
-            _waiters.erase(iter);
-            return true;
-        }
-    }
-    return false;
-}
-
-template <typename Func>
-void ReplicationCoordinatorImpl::WaiterList::setValueIf_inlock(Func&& func,
-                                                               boost::optional<OpTime> opTime) {
-    for (auto it = _waiters.begin(); it != _waiters.end() && (!opTime || it->first <= *opTime);) {
-        const auto& waiter = it->second;
-        try {
-            if (func(it->first, waiter)) {
-                waiter->promise.emplaceValue();
-                it = _waiters.erase(it);
-            } else {
-                ++it;
-            }
-        } catch (const DBException& e) {
-            waiter->promise.setError(e.toStatus());
-            it = _waiters.erase(it);
-        }
-    }
-}
-
-void ReplicationCoordinatorImpl::WaiterList::setValueAll_inlock() {
-    for (auto& [opTime, waiter] : _waiters) {
-        waiter->promise.emplaceValue();
-    }
-    _waiters.clear();
-}
-
-void ReplicationCoordinatorImpl::WaiterList::setErrorAll_inlock(Status status) {
-    invariant(!status.isOK());
-    for (auto& [opTime, waiter] : _waiters) {
-        waiter->promise.setError(status);
-    }
-    _waiters.clear();
-}
-
 namespace {
 ReplicationCoordinator::Mode getReplicationModeFromSettings(const ReplSettings& settings) {
     if (settings.usingReplSets()) {
@@ -257,6 +201,9 @@ InitialSyncerOptions createInitialSyncerOptions(
         replCoord->setMyLastAppliedOpTimeAndWallTimeForward(opTimeAndWallTime, consistency);
     };
     options.resetOptimes = [replCoord]() { replCoord->resetMyLastOpTimes(); };
+    options.installStagedBackupFiles = [externalState](OperationContext* opCtx) {
+        return externalState->installStagedBackupFiles(opCtx);
+    };
     options.syncSourceSelector = replCoord;
     options.oplogFetcherMaxFetcherRestarts =
         externalState->getOplogFetcherInitialSyncMaxFetcherRestarts();
@@ -420,6 +367,10 @@ bool ReplicationCoordinatorImpl::_startLoadLocalConfig(
 
     fassert(51240, _externalState->createLocalLastVoteCollection(opCtx));
 
+    // A node that crashed while installing the files copied by a file copy based initial sync
+    // starts with the sync source's replica set state, which must be replaced before it is loaded.
+    _externalState->restoreLocalStateAfterInstallingBackupFiles(opCtx);
+
     StatusWith<LastVote> lastVote = _externalState->loadLocalLastVoteDocument(opCtx);
     if (!lastVote.isOK()) {
         LOGV2_FATAL_NOTRACE(40367,
@@ -4295,7 +4246,9 @@ ReplicationCoordinatorImpl::_setCurrentRSConfig(WithLock lk,
 }
 
 void ReplicationCoordinatorImpl::_wakeReadyWaiters(WithLock lk, boost::optional<OpTime> opTime) {
-    _replicationWaiterList.setValueIf_inlock(
+    // Whether a write concern is satisfied is monotonic in the opTime waited for, so only the
+    // ready prefix of each write concern's waiters needs to be visited.
+    _replicationWaiterList.setValueForReadyPrefix_inlock(
         [this](const OpTime& opTime, const SharedWaiterHandle& waiter) {
             invariant(waiter->writeConcern);
             return _doneWaitingForReplication_inlock(opTime, waiter->writeConcern.get());
@@ -4515,6 +4468,13 @@ bool ReplicationCoordinatorImpl::shouldChangeSyncSource(const HostAndPort& curre
         currentSource, replMetadata, oqMetadata, _replExecutor->now());
 }
 
+void ReplicationCoordinatorImpl::recordSyncSourceFetchStats(const HostAndPort& source,
+                                                            Milliseconds getMoreLatency,
+                                                            long long numBytes) {
+    stdx::lock_guard<Latch> lock(_mutex);
+    _topCoord->recordSyncSourceFetchStats(source, getMoreLatency, numBytes, _replExecutor->now());
+}
+
 void ReplicationCoordinatorImpl::_updateLastCommittedOpTimeAndWallTime(WithLock lk) {
     if (_topCoord->updateLastCommittedOpTimeAndWallTime()) {
         _setStableTimestampForStorage(lk);
@@ -44,6 +44,7 @@
 #include "mongo/db/repl/repl_set_config.h"
 #include "mongo/db/repl/replication_coordinator.h"
 #include "mongo/db/repl/replication_coordinator_external_state.h"
+#include "mongo/db/repl/replication_waiter_list.h"
 #include "mongo/db/repl/sync_source_resolver.h"
 #include "mongo/db/repl/topology_coordinator.h"
 #include "mongo/db/repl/update_position_args.h"
@@ -280,6 +281,10 @@ public:
                                         const rpc::ReplSetMetadata& replMetadata,
                                         const rpc::OplogQueryMetadata& oqMetadata) override;
 
+    virtual void recordSyncSourceFetchStats(const HostAndPort& source,
+                                            Milliseconds getMoreLatency,
+                                            long long numBytes) override;
+
     virtual OpTime getLastCommittedOpTime() const override;
     virtual OpTimeAndWallTime getLastCommittedOpTimeAndWallTime() const override;
 
@@ -647,37 +652,8 @@ private:
         ReplicationCoordinator::OpsKillingStateTransitionEnum _stateTransition;
     };
 
-    struct Waiter {
-        Promise<void> promise;
-        boost::optional<WriteConcernOptions> writeConcern;
-        explicit Waiter(Promise<void> p, boost::optional<WriteConcernOptions> w = boost::none)
-            : promise(std::move(p)), writeConcern(w) {}
-    };
-
-    using SharedWaiterHandle = std::shared_ptr<Waiter>;
-
-    class WaiterList {
-    public:
-        // Adds waiter into the list.
-        void add_inlock(const OpTime& opTime, SharedWaiterHandle waiter);
-        // Adds a waiter into the list and returns the future of the waiter's promise.
-        SharedSemiFuture<void> add_inlock(const OpTime& opTime,
-                                          boost::optional<WriteConcernOptions> w = boost::none);
-        // Returns whether waiter is found and removed.
-        bool remove_inlock(SharedWaiterHandle waiter);
-        // Signals all waiters whose opTime is <= the given opTime (if any) that satisfy the
-        // condition in func.
-        template <typename Func>
-        void setValueIf_inlock(Func&& func, boost::optional<OpTime> opTime = boost::none);
-        // Signals all waiters from the list and fulfills promises with OK status.
-        void setValueAll_inlock();
-        // Signals all waiters from the list and fulfills promises with Error status.
-        void setErrorAll_inlock(Status status);
-
-    private:
-        // Waiters sorted by OpTime.
-        std::multimap<OpTime, SharedWaiterHandle> _waiters;
-    };
+    using Waiter = ReplicationWaiterList::Waiter;
+    using SharedWaiterHandle = ReplicationWaiterList::SharedWaiterHandle;
 
     typedef std::vector<executor::TaskExecutor::CallbackHandle> HeartbeatHandles;
 
@@ -1486,11 +1462,11 @@ private:
     // Waiters in this list are checked and notified on remote nodes' opTime updates and self's
     // lastDurable opTime updates. We do not check this list on self's lastApplied opTime updates to
     // avoid checking all waiters in the list on every write.
-    WaiterList _replicationWaiterList;  // (M)
+    ReplicationWaiterList _replicationWaiterList;  // (M)
 
     // list of information about clients waiting for a particular lastApplied opTime.
     // Waiters in this list are checked and notified on self's lastApplied opTime updates.
-    WaiterList _opTimeWaiterList;  // (M)
+    ReplicationWaiterList _opTimeWaiterList;  // (M)
 
     // Maps a horizon name to the promise waited on by awaitable isMaster requests when the node
     // has an initialized replica set config and is an active member of the replica set.
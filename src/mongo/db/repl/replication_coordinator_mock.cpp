@@ -453,6 +453,10 @@ bool ReplicationCoordinatorMock::shouldChangeSyncSource(const HostAndPort& curre
     MONGO_UNREACHABLE;
 }
 
+void ReplicationCoordinatorMock::recordSyncSourceFetchStats(const HostAndPort& source,
+                                                            Milliseconds getMoreLatency,
+                                                            long long numBytes) {}
+
 OpTime ReplicationCoordinatorMock::getLastCommittedOpTime() const {
     return OpTime();
 }
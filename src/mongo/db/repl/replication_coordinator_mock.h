@@ -244,6 +244,10 @@ public:
                                         const rpc::ReplSetMetadata& replMetadata,
                                         const rpc::OplogQueryMetadata& oqMetadata);
 
+    virtual void recordSyncSourceFetchStats(const HostAndPort& source,
+                                            Milliseconds getMoreLatency,
+                                            long long numBytes);
+
     virtual OpTime getLastCommittedOpTime() const;
 
     virtual OpTimeAndWallTime getLastCommittedOpTimeAndWallTime() const;
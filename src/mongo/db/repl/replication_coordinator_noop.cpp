@@ -389,6 +389,12 @@ bool ReplicationCoordinatorNoOp::shouldChangeSyncSource(const HostAndPort&,
     MONGO_UNREACHABLE;
 }
 
+void ReplicationCoordinatorNoOp::recordSyncSourceFetchStats(const HostAndPort&,
+                                                            Milliseconds,
+                                                            long long) {
+    MONGO_UNREACHABLE;
+}
+
 void ReplicationCoordinatorNoOp::advanceCommitPoint(const OpTimeAndWallTime&, bool fromSyncSource) {
     MONGO_UNREACHABLE;
 }
@@ -209,6 +209,8 @@ public:
                                 const rpc::ReplSetMetadata&,
                                 const rpc::OplogQueryMetadata&) final;
 
+    void recordSyncSourceFetchStats(const HostAndPort&, Milliseconds, long long) final;
+
     OpTime getLastCommittedOpTime() const final;
 
     OpTimeAndWallTime getLastCommittedOpTimeAndWallTime() const final;
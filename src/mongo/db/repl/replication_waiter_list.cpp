@@ -0,0 +1,107 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/repl/replication_waiter_list.h"
+
+namespace mongo {
+namespace repl {
+
+ReplicationWaiterList::GroupKey ReplicationWaiterList::_makeGroupKey(
+    const boost::optional<WriteConcernOptions>& writeConcern) {
+    if (!writeConcern) {
+        return {false, "", 0, WriteConcernOptions::SyncMode::UNSET, {}};
+    }
+    return {true,
+            writeConcern->wMode,
+            writeConcern->wNumNodes,
+            writeConcern->syncMode,
+            writeConcern->checkCondition};
+}
+
+void ReplicationWaiterList::add_inlock(const OpTime& opTime, SharedWaiterHandle waiter) {
+    _waiters[_makeGroupKey(waiter->writeConcern)].emplace(opTime, std::move(waiter));
+}
+
+SharedSemiFuture<void> ReplicationWaiterList::add_inlock(const OpTime& opTime,
+                                                         boost::optional<WriteConcernOptions> wc) {
+    auto pf = makePromiseFuture<void>();
+    add_inlock(opTime, std::make_shared<Waiter>(std::move(pf.promise), std::move(wc)));
+    return std::move(pf.future);
+}
+
+bool ReplicationWaiterList::remove_inlock(SharedWaiterHandle waiter) {
+    auto groupIt = _waiters.find(_makeGroupKey(waiter->writeConcern));
+    if (groupIt == _waiters.end()) {
+        return false;
+    }
+    auto& group = groupIt->second;
+    for (auto iter = group.begin(); iter != group.end(); iter++) {
+        if (iter->second == waiter) {
+            group.erase(iter);
+            if (group.empty()) {
+                _waiters.erase(groupIt);
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+void ReplicationWaiterList::setValueAll_inlock() {
+    for (auto& [key, group] : _waiters) {
+        for (auto& [opTime, waiter] : group) {
+            waiter->promise.emplaceValue();
+        }
+    }
+    _waiters.clear();
+}
+
+void ReplicationWaiterList::setErrorAll_inlock(Status status) {
+    invariant(!status.isOK());
+    for (auto& [key, group] : _waiters) {
+        for (auto& [opTime, waiter] : group) {
+            waiter->promise.setError(status);
+        }
+    }
+    _waiters.clear();
+}
+
+size_t ReplicationWaiterList::size_inlock() const {
+    size_t size = 0;
+    for (const auto& [key, group] : _waiters) {
+        size += group.size();
+    }
+    return size;
+}
+
+}  // namespace repl
+}  // namespace mongo
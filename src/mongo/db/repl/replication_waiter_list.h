@@ -0,0 +1,153 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#pragma once
+
+#include <boost/optional.hpp>
+#include <map>
+#include <memory>
+#include <string>
+#include <tuple>
+
+#include "mongo/base/status.h"
+#include "mongo/db/repl/optime.h"
+#include "mongo/db/write_concern_options.h"
+#include "mongo/util/future.h"
+
+namespace mongo {
+namespace repl {
+
+/**
+ * Waiters for an opTime to be replicated according to a write concern, or for an opTime to be
+ * applied locally, ordered by opTime.
+ *
+ * Waiters are grouped by write concern. For a given write concern, a waiter whose opTime has been
+ * replicated implies that all waiters with earlier opTimes have been replicated too, so
+ * setValueForReadyPrefix_inlock() only visits the waiters it wakes plus one per group, instead of
+ * every waiter below the opTime that advanced.
+ *
+ * This class is not thread-safe; all calls must be made while holding the replication coordinator
+ * mutex.
+ */
+class ReplicationWaiterList {
+public:
+    struct Waiter {
+        Promise<void> promise;
+        boost::optional<WriteConcernOptions> writeConcern;
+        explicit Waiter(Promise<void> p, boost::optional<WriteConcernOptions> w = boost::none)
+            : promise(std::move(p)), writeConcern(w) {}
+    };
+
+    using SharedWaiterHandle = std::shared_ptr<Waiter>;
+
+    // Adds waiter into the list.
+    void add_inlock(const OpTime& opTime, SharedWaiterHandle waiter);
+    // Adds a waiter into the list and returns the future of the waiter's promise.
+    SharedSemiFuture<void> add_inlock(const OpTime& opTime,
+                                      boost::optional<WriteConcernOptions> w = boost::none);
+    // Returns whether waiter is found and removed.
+    bool remove_inlock(SharedWaiterHandle waiter);
+    // Signals all waiters whose opTime is <= the given opTime (if any) that satisfy the condition
+    // in func. Visits every such waiter.
+    template <typename Func>
+    void setValueIf_inlock(Func&& func, boost::optional<OpTime> opTime = boost::none);
+    // Like setValueIf_inlock(), but stops visiting the waiters with a given write concern at the
+    // first one that does not satisfy the condition in func. The condition must therefore hold for
+    // every earlier opTime with the same write concern whenever it holds for a later one.
+    template <typename Func>
+    void setValueForReadyPrefix_inlock(Func&& func, boost::optional<OpTime> opTime = boost::none);
+    // Signals all waiters from the list and fulfills promises with OK status.
+    void setValueAll_inlock();
+    // Signals all waiters from the list and fulfills promises with Error status.
+    void setErrorAll_inlock(Status status);
+    // Returns the number of waiters in the list.
+    size_t size_inlock() const;
+
+private:
+    // Identifies waiters whose write concerns are satisfied by the same set of opTimes. The
+    // wtimeout is enforced by the waiting thread, so it is not part of the key.
+    using GroupKey = std::tuple<bool,
+                                std::string,
+                                int,
+                                WriteConcernOptions::SyncMode,
+                                WriteConcernOptions::CheckCondition>;
+    using WaiterGroup = std::multimap<OpTime, SharedWaiterHandle>;
+
+    static GroupKey _makeGroupKey(const boost::optional<WriteConcernOptions>& writeConcern);
+
+    // Waiters grouped by write concern, each group sorted by OpTime.
+    std::map<GroupKey, WaiterGroup> _waiters;
+};
+
+template <typename Func>
+void ReplicationWaiterList::setValueIf_inlock(Func&& func, boost::optional<OpTime> opTime) {
+    for (auto groupIt = _waiters.begin(); groupIt != _waiters.end();) {
+        auto& group = groupIt->second;
+        for (auto it = group.begin(); it != group.end() && (!opTime || it->first <= *opTime);) {
+            const auto& waiter = it->second;
+            try {
+                if (func(it->first, waiter)) {
+                    waiter->promise.emplaceValue();
+                    it = group.erase(it);
+                } else {
+                    ++it;
+                }
+            } catch (const DBException& e) {
+                waiter->promise.setError(e.toStatus());
+                it = group.erase(it);
+            }
+        }
+        groupIt = group.empty() ? _waiters.erase(groupIt) : std::next(groupIt);
+    }
+}
+
+template <typename Func>
+void ReplicationWaiterList::setValueForReadyPrefix_inlock(Func&& func,
+                                                          boost::optional<OpTime> opTime) {
+    for (auto groupIt = _waiters.begin(); groupIt != _waiters.end();) {
+        auto& group = groupIt->second;
+        for (auto it = group.begin(); it != group.end() && (!opTime || it->first <= *opTime);) {
+            const auto& waiter = it->second;
+            try {
+                if (!func(it->first, waiter)) {
+                    break;
+                }
+                waiter->promise.emplaceValue();
+            } catch (const DBException& e) {
+                waiter->promise.setError(e.toStatus());
+            }
+            it = group.erase(it);
+        }
+        groupIt = group.empty() ? _waiters.erase(groupIt) : std::next(groupIt);
+    }
+}
+
+}  // namespace repl
+}  // namespace mongo
@@ -0,0 +1,95 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#include "mongo/platform/basic.h"
+
+#include <benchmark/benchmark.h>
+#include <vector>
+
+#include "mongo/db/repl/replication_waiter_list.h"
+
+namespace mongo {
+namespace repl {
+namespace {
+
+/**
+ * Models 'state.range(0)' concurrent w:majority writers: on every iteration the commit point
+ * advances past the oldest waiter, which is woken, and a new writer starts waiting for the newest
+ * opTime. The secondaries' opTimes are ahead of the commit point, so every waiter up to the newest
+ * opTime is a candidate for waking.
+ */
+template <bool readyPrefixOnly>
+void runMajorityWaiters(benchmark::State& state) {
+    const WriteConcernOptions writeConcern(WriteConcernOptions::kMajority,
+                                           WriteConcernOptions::SyncMode::NONE,
+                                           Milliseconds(0));
+    const auto numWaiters = static_cast<unsigned int>(state.range(0));
+
+    ReplicationWaiterList waiters;
+    std::vector<SharedSemiFuture<void>> futures;
+    futures.reserve(numWaiters);
+    for (unsigned int i = 1; i <= numWaiters; ++i) {
+        futures.push_back(waiters.add_inlock(OpTime(Timestamp(i, 0), 1), writeConcern));
+    }
+
+    unsigned int committed = 0;
+    unsigned int newest = numWaiters;
+    for (auto _ : state) {
+        const OpTime commitPoint(Timestamp(++committed, 0), 1);
+        const OpTime newestOpTime(Timestamp(newest, 0), 1);
+        auto isReplicated = [&](const OpTime& opTime,
+                                const ReplicationWaiterList::SharedWaiterHandle& waiter) {
+            return opTime <= commitPoint;
+        };
+        if (readyPrefixOnly) {
+            waiters.setValueForReadyPrefix_inlock(isReplicated, newestOpTime);
+        } else {
+            waiters.setValueIf_inlock(isReplicated, newestOpTime);
+        }
+        futures[committed % numWaiters] =
+            waiters.add_inlock(OpTime(Timestamp(++newest, 0), 1), writeConcern);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+void BM_WakeReadyPrefix(benchmark::State& state) {
+    runMajorityWaiters<true>(state);
+}
+
+void BM_WakeFullScan(benchmark::State& state) {
+    runMajorityWaiters<false>(state);
+}
+
+BENCHMARK(BM_WakeReadyPrefix)->RangeMultiplier(10)->Range(10, 100 * 1000);
+BENCHMARK(BM_WakeFullScan)->RangeMultiplier(10)->Range(10, 100 * 1000);
+
+}  // namespace
+}  // namespace repl
+}  // namespace mongo
@@ -0,0 +1,159 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/repl/replication_waiter_list.h"
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+namespace repl {
+namespace {
+
+WriteConcernOptions makeWriteConcern(int wNumNodes) {
+    return WriteConcernOptions(wNumNodes, WriteConcernOptions::SyncMode::NONE, Milliseconds(0));
+}
+
+WriteConcernOptions makeMajorityWriteConcern() {
+    return WriteConcernOptions(WriteConcernOptions::kMajority,
+                               WriteConcernOptions::SyncMode::NONE,
+                               Milliseconds(0));
+}
+
+OpTime makeOpTime(unsigned int secs) {
+    return OpTime(Timestamp(secs, 1), 1);
+}
+
+TEST(ReplicationWaiterListTest, ReadyPrefixIsSignaledPerWriteConcern) {
+    ReplicationWaiterList waiters;
+    auto w2At1 = waiters.add_inlock(makeOpTime(1), makeWriteConcern(2));
+    auto w2At2 = waiters.add_inlock(makeOpTime(2), makeWriteConcern(2));
+    auto w2At3 = waiters.add_inlock(makeOpTime(3), makeWriteConcern(2));
+    auto majorityAt1 = waiters.add_inlock(makeOpTime(1), makeMajorityWriteConcern());
+    auto majorityAt2 = waiters.add_inlock(makeOpTime(2), makeMajorityWriteConcern());
+
+    // w:2 is satisfied up to opTime 2 and majority only up to opTime 1.
+    waiters.setValueForReadyPrefix_inlock(
+        [](const OpTime& opTime, const ReplicationWaiterList::SharedWaiterHandle& waiter) {
+            if (waiter->writeConcern->wMode == WriteConcernOptions::kMajority) {
+                return opTime <= makeOpTime(1);
+            }
+            return opTime <= makeOpTime(2);
+        });
+
+    ASSERT_TRUE(w2At1.isReady());
+    ASSERT_TRUE(w2At2.isReady());
+    ASSERT_FALSE(w2At3.isReady());
+    ASSERT_TRUE(majorityAt1.isReady());
+    ASSERT_FALSE(majorityAt2.isReady());
+    ASSERT_EQ(2U, waiters.size_inlock());
+}
+
+TEST(ReplicationWaiterListTest, ReadyPrefixStopsAtFirstUnsatisfiedWaiter) {
+    ReplicationWaiterList waiters;
+    std::vector<SharedSemiFuture<void>> futures;
+    for (unsigned int i = 1; i <= 10; ++i) {
+        futures.push_back(waiters.add_inlock(makeOpTime(i), makeWriteConcern(2)));
+    }
+
+    int visited = 0;
+    waiters.setValueForReadyPrefix_inlock(
+        [&](const OpTime& opTime, const ReplicationWaiterList::SharedWaiterHandle& waiter) {
+            ++visited;
+            return opTime <= makeOpTime(3);
+        });
+
+    // Three waiters are signaled and one more is visited to find the end of the prefix.
+    ASSERT_EQ(4, visited);
+    ASSERT_EQ(7U, waiters.size_inlock());
+}
+
+TEST(ReplicationWaiterListTest, ReadyPrefixRespectsOpTimeBound) {
+    ReplicationWaiterList waiters;
+    auto at1 = waiters.add_inlock(makeOpTime(1), makeWriteConcern(2));
+    auto at2 = waiters.add_inlock(makeOpTime(2), makeWriteConcern(2));
+
+    waiters.setValueForReadyPrefix_inlock(
+        [](const OpTime& opTime, const ReplicationWaiterList::SharedWaiterHandle& waiter) {
+            return true;
+        },
+        makeOpTime(1));
+
+    ASSERT_TRUE(at1.isReady());
+    ASSERT_FALSE(at2.isReady());
+}
+
+TEST(ReplicationWaiterListTest, ExceptionSetsErrorOnWaiter) {
+    ReplicationWaiterList waiters;
+    auto future = waiters.add_inlock(makeOpTime(1), makeWriteConcern(2));
+
+    waiters.setValueForReadyPrefix_inlock(
+        [](const OpTime& opTime, const ReplicationWaiterList::SharedWaiterHandle& waiter) -> bool {
+            uasserted(ErrorCodes::UnsatisfiableWriteConcern, "unsatisfiable");
+        });
+
+    ASSERT_EQ(ErrorCodes::UnsatisfiableWriteConcern, future.getNoThrow());
+    ASSERT_EQ(0U, waiters.size_inlock());
+}
+
+TEST(ReplicationWaiterListTest, SetValueIfVisitsEveryWaiter) {
+    ReplicationWaiterList waiters;
+    auto at1 = waiters.add_inlock(makeOpTime(1), makeWriteConcern(2));
+    auto at2 = waiters.add_inlock(makeOpTime(2), makeWriteConcern(2));
+
+    waiters.setValueIf_inlock(
+        [](const OpTime& opTime, const ReplicationWaiterList::SharedWaiterHandle& waiter) {
+            return opTime == makeOpTime(2);
+        });
+
+    ASSERT_FALSE(at1.isReady());
+    ASSERT_TRUE(at2.isReady());
+}
+
+TEST(ReplicationWaiterListTest, RemoveWaiter) {
+    ReplicationWaiterList waiters;
+    auto pf = makePromiseFuture<void>();
+    auto waiter =
+        std::make_shared<ReplicationWaiterList::Waiter>(std::move(pf.promise), makeWriteConcern(2));
+    waiters.add_inlock(makeOpTime(1), waiter);
+    auto other = waiters.add_inlock(makeOpTime(1));
+
+    ASSERT_TRUE(waiters.remove_inlock(waiter));
+    ASSERT_FALSE(waiters.remove_inlock(waiter));
+    ASSERT_EQ(1U, waiters.size_inlock());
+
+    waiters.setErrorAll_inlock({ErrorCodes::ShutdownInProgress, "shutting down"});
+    ASSERT_EQ(ErrorCodes::ShutdownInProgress, other.getNoThrow());
+    ASSERT_EQ(0U, waiters.size_inlock());
+}
+
+}  // namespace
+}  // namespace repl
+}  // namespace mongo
@@ -0,0 +1,78 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/repl/sync_source_fetch_stats.h"
+
+#include <algorithm>
+
+#include "mongo/util/assert_util.h"
+
+namespace mongo {
+namespace repl {
+
+constexpr size_t SyncSourceFetchStats::kMaxSamples;
+constexpr size_t SyncSourceFetchStats::kMinSamples;
+constexpr double SyncSourceFetchStats::kThroughputSmoothingFactor;
+
+void SyncSourceFetchStats::record(Milliseconds latency, long long numBytes, Date_t now) {
+    // Batches served faster than the clock resolution are counted as taking one millisecond.
+    const auto millis = std::max<long long>(durationCount<Milliseconds>(latency), 1);
+    const double throughput = static_cast<double>(numBytes) / millis;
+    _throughputBytesPerMilli = _latencies.empty()
+        ? throughput
+        : kThroughputSmoothingFactor * throughput +
+            (1 - kThroughputSmoothingFactor) * _throughputBytesPerMilli;
+
+    if (_latencies.size() < kMaxSamples) {
+        _latencies.push_back(Milliseconds(millis));
+    } else {
+        _latencies[_nextLatencyIndex] = Milliseconds(millis);
+    }
+    _nextLatencyIndex = (_nextLatencyIndex + 1) % kMaxSamples;
+    _lastRecordedDate = now;
+}
+
+bool SyncSourceFetchStats::hasMeasurements(Date_t oldestUsable) const {
+    return _latencies.size() >= kMinSamples && _lastRecordedDate >= oldestUsable;
+}
+
+Milliseconds SyncSourceFetchStats::getLatencyPercentile(int percentile) const {
+    invariant(!_latencies.empty());
+    invariant(percentile >= 0 && percentile <= 100);
+    auto latencies = _latencies;
+    auto nth = latencies.begin() + (latencies.size() - 1) * percentile / 100;
+    std::nth_element(latencies.begin(), nth, latencies.end());
+    return *nth;
+}
+
+}  // namespace repl
+}  // namespace mongo
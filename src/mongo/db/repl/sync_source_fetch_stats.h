@@ -0,0 +1,102 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#pragma once
+
+#include <vector>
+
+#include "mongo/util/duration.h"
+#include "mongo/util/time_support.h"
+
+namespace mongo {
+namespace repl {
+
+/**
+ * Rolling measurements of how quickly a sync source serves oplog batches to this node.
+ *
+ * Only batches fetched while the sync source had more oplog entries than it returned should be
+ * recorded. The latency of any other batch is governed by the rate of writes on the primary, not
+ * by how fast the sync source serves them.
+ */
+class SyncSourceFetchStats {
+public:
+    // The number of most recent batch latencies kept for computing percentiles.
+    static constexpr size_t kMaxSamples = 32;
+
+    // The number of batches which must be recorded before the measurements are used.
+    static constexpr size_t kMinSamples = 5;
+
+    // The weight of the most recent batch in the rolling throughput.
+    static constexpr double kThroughputSmoothingFactor = 0.2;
+
+    /**
+     * Records a batch of 'numBytes' bytes which took 'latency' to fetch.
+     */
+    void record(Milliseconds latency, long long numBytes, Date_t now);
+
+    /**
+     * Returns true if at least kMinSamples batches have been recorded, the most recent of them
+     * no earlier than 'oldestUsable'.
+     */
+    bool hasMeasurements(Date_t oldestUsable) const;
+
+    /**
+     * Returns the 'percentile'th (between 0 and 100) percentile of the recent batch latencies.
+     * Must only be called if a batch has been recorded.
+     */
+    Milliseconds getLatencyPercentile(int percentile) const;
+
+    /**
+     * Returns the exponentially weighted moving average of the fetch throughput, in bytes per
+     * millisecond.
+     */
+    double getThroughputBytesPerMilli() const {
+        return _throughputBytesPerMilli;
+    }
+
+    size_t getNumSamples() const {
+        return _latencies.size();
+    }
+
+    Date_t getLastRecordedDate() const {
+        return _lastRecordedDate;
+    }
+
+private:
+    // Circular buffer of the latencies of the last kMaxSamples batches.
+    std::vector<Milliseconds> _latencies;
+    size_t _nextLatencyIndex = 0;
+
+    double _throughputBytesPerMilli = 0;
+    Date_t _lastRecordedDate;
+};
+
+}  // namespace repl
+}  // namespace mongo
@@ -0,0 +1,109 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/repl/sync_source_fetch_stats.h"
+
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+namespace repl {
+namespace {
+
+const Date_t kNow = Date_t::fromMillisSinceEpoch(100000);
+
+TEST(SyncSourceFetchStatsTest, NoMeasurementsUntilMinSamplesRecorded) {
+    SyncSourceFetchStats stats;
+    ASSERT_FALSE(stats.hasMeasurements(Date_t()));
+    for (size_t i = 1; i < SyncSourceFetchStats::kMinSamples; ++i) {
+        stats.record(Milliseconds(10), 1000, kNow);
+        ASSERT_FALSE(stats.hasMeasurements(Date_t()));
+    }
+    stats.record(Milliseconds(10), 1000, kNow);
+    ASSERT_TRUE(stats.hasMeasurements(Date_t()));
+    ASSERT_EQUALS(SyncSourceFetchStats::kMinSamples, stats.getNumSamples());
+}
+
+TEST(SyncSourceFetchStatsTest, MeasurementsExpire) {
+    SyncSourceFetchStats stats;
+    for (size_t i = 0; i < SyncSourceFetchStats::kMinSamples; ++i) {
+        stats.record(Milliseconds(10), 1000, kNow);
+    }
+    ASSERT_EQUALS(kNow, stats.getLastRecordedDate());
+    ASSERT_TRUE(stats.hasMeasurements(kNow));
+    ASSERT_FALSE(stats.hasMeasurements(kNow + Milliseconds(1)));
+}
+
+TEST(SyncSourceFetchStatsTest, ThroughputIsExponentiallyWeighted) {
+    SyncSourceFetchStats stats;
+    stats.record(Milliseconds(10), 1000, kNow);
+    ASSERT_EQUALS(100.0, stats.getThroughputBytesPerMilli());
+
+    const auto alpha = SyncSourceFetchStats::kThroughputSmoothingFactor;
+    stats.record(Milliseconds(10), 2000, kNow);
+    ASSERT_APPROX_EQUAL(
+        alpha * 200.0 + (1 - alpha) * 100.0, stats.getThroughputBytesPerMilli(), 1e-9);
+}
+
+TEST(SyncSourceFetchStatsTest, ZeroLatencyIsCountedAsOneMillisecond) {
+    SyncSourceFetchStats stats;
+    stats.record(Milliseconds(0), 500, kNow);
+    ASSERT_EQUALS(500.0, stats.getThroughputBytesPerMilli());
+    ASSERT_EQUALS(Milliseconds(1), stats.getLatencyPercentile(50));
+}
+
+TEST(SyncSourceFetchStatsTest, LatencyPercentiles) {
+    SyncSourceFetchStats stats;
+    // Record latencies 1..11ms out of order.
+    for (int latency : {7, 3, 11, 1, 9, 5, 2, 10, 4, 8, 6}) {
+        stats.record(Milliseconds(latency), 1000, kNow);
+    }
+    ASSERT_EQUALS(Milliseconds(1), stats.getLatencyPercentile(0));
+    ASSERT_EQUALS(Milliseconds(6), stats.getLatencyPercentile(50));
+    ASSERT_EQUALS(Milliseconds(10), stats.getLatencyPercentile(90));
+    ASSERT_EQUALS(Milliseconds(11), stats.getLatencyPercentile(100));
+}
+
+TEST(SyncSourceFetchStatsTest, OnlyMostRecentLatenciesAreKept) {
+    SyncSourceFetchStats stats;
+    for (size_t i = 0; i < SyncSourceFetchStats::kMaxSamples; ++i) {
+        stats.record(Milliseconds(1000), 1000, kNow);
+    }
+    for (size_t i = 0; i < SyncSourceFetchStats::kMaxSamples; ++i) {
+        stats.record(Milliseconds(10), 1000, kNow);
+    }
+    ASSERT_EQUALS(SyncSourceFetchStats::kMaxSamples, stats.getNumSamples());
+    ASSERT_EQUALS(Milliseconds(10), stats.getLatencyPercentile(100));
+}
+
+}  // namespace
+}  // namespace repl
+}  // namespace mongo
@@ -87,6 +87,14 @@ public:
     virtual bool shouldChangeSyncSource(const HostAndPort& currentSource,
                                         const rpc::ReplSetMetadata& replMetadata,
                                         const rpc::OplogQueryMetadata& oqMetadata) = 0;
+
+    /**
+     * Records that a batch of 'numBytes' bytes took 'getMoreLatency' to fetch from 'source' while
+     * the source had more oplog entries to send, for use in choosing future sync sources.
+     */
+    virtual void recordSyncSourceFetchStats(const HostAndPort& source,
+                                            Milliseconds getMoreLatency,
+                                            long long numBytes) = 0;
 };
 
 }  // namespace repl
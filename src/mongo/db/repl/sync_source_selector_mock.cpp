@@ -62,6 +62,10 @@ bool SyncSourceSelectorMock::shouldChangeSyncSource(const HostAndPort&,
     return false;
 }
 
+void SyncSourceSelectorMock::recordSyncSourceFetchStats(const HostAndPort&,
+                                                        Milliseconds,
+                                                        long long) {}
+
 void SyncSourceSelectorMock::setChooseNewSyncSourceResult_forTest(const HostAndPort& syncSource) {
     _chooseNewSyncSourceResult = syncSource;
 }
@@ -56,6 +56,7 @@ public:
     bool shouldChangeSyncSource(const HostAndPort&,
                                 const rpc::ReplSetMetadata&,
                                 const rpc::OplogQueryMetadata& oqMetadata) override;
+    void recordSyncSourceFetchStats(const HostAndPort&, Milliseconds, long long) override;
 
     /**
      * Sets a function that will be run every time chooseNewSyncSource() is called.
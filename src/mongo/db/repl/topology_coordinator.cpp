@@ -386,10 +386,22 @@ HostAndPort TopologyCoordinator::_chooseNearbySyncSource(Date_t now,
                             "lastOpTimeFetched"_attr = lastOpTimeFetched.toBSON());
                 continue;
             }
-            // Candidate cannot be more latent than anything we've already considered.
-            if ((closestIndex != -1) &&
-                (_getPing(itMemberConfig.getHostAndPort()) >
-                 _getPing(_rsConfig.getMemberAt(closestIndex).getHostAndPort()))) {
+            if (gEnableSyncSourceScoring.load()) {
+                // Candidate cannot score worse than anything we've already considered.
+                if ((closestIndex != -1) &&
+                    _scoreSyncSource(itIndex, now).cost >
+                        _scoreSyncSource(closestIndex, now).cost) {
+                    LOGV2_DEBUG(5380200,
+                                2,
+                                "Cannot select sync source with a worse score than the best "
+                                "candidate",
+                                "syncSourceCandidate"_attr = itMemberConfig.getHostAndPort());
+                    continue;
+                }
+            } else if ((closestIndex != -1) &&
+                       (_getPing(itMemberConfig.getHostAndPort()) >
+                        _getPing(_rsConfig.getMemberAt(closestIndex).getHostAndPort()))) {
+                // Candidate cannot be more latent than anything we've already considered.
                 LOGV2_DEBUG(3873114,
                             2,
                             "Cannot select sync source with higher latency than the best "
@@ -3017,9 +3029,118 @@ bool TopologyCoordinator::shouldChangeSyncSource(const HostAndPort& currentSourc
         }
     }
 
+    if (gEnableSyncSourceScoring.load()) {
+        // Only measured costs are trusted to justify abandoning a working sync source, so a member
+        // we have not recently synced from is never preferred here. Such members are still
+        // considered by chooseNewSyncSource() using their estimated cost.
+        const auto currentScore = _scoreSyncSource(currentSourceIndex, now);
+        if (currentScore.measured) {
+            const double ratio = gSyncSourceScoreChangeRatio.load();
+            for (int itIndex = 0; itIndex < static_cast<int>(_memberData.size()); ++itIndex) {
+                if (itIndex == _selfIndex || itIndex == currentSourceIndex) {
+                    continue;
+                }
+                const auto& member = _memberData.at(itIndex);
+                const MemberConfig& candidateConfig = _rsConfig.getMemberAt(itIndex);
+                if (!member.up() || !member.getState().readable() ||
+                    (!candidateConfig.isVoter() && _selfConfig().isVoter()) ||
+                    (!candidateConfig.shouldBuildIndexes() &&
+                     _selfConfig().shouldBuildIndexes()) ||
+                    candidateConfig.isHidden() ||
+                    candidateConfig.getSlaveDelay() > _selfConfig().getSlaveDelay() ||
+                    _memberIsBlacklisted(candidateConfig, now) ||
+                    member.getHeartbeatAppliedOpTime() <= myLastOpTime) {
+                    continue;
+                }
+
+                const auto candidateScore = _scoreSyncSource(itIndex, now);
+                if (candidateScore.measured && candidateScore.cost * ratio < currentScore.cost) {
+                    LOGV2(5380201,
+                          "Choosing new sync source because another member is expected to serve "
+                          "oplog batches significantly faster than our current sync source",
+                          "syncSource"_attr = currentSource,
+                          "syncSourceCost"_attr = currentScore.cost,
+                          "otherMember"_attr = candidateConfig.getHostAndPort(),
+                          "otherMemberCost"_attr = candidateScore.cost,
+                          "syncSourceScoreChangeRatio"_attr = ratio);
+                    return true;
+                }
+            }
+        }
+    }
+
     return false;
 }
 
+void TopologyCoordinator::recordSyncSourceFetchStats(const HostAndPort& source,
+                                                     Milliseconds getMoreLatency,
+                                                     long long numBytes,
+                                                     Date_t now) {
+    _syncSourceFetchStats[source].record(getMoreLatency, numBytes, now);
+}
+
+boost::optional<double> TopologyCoordinator::_getMeasuredMillisPerMB(const HostAndPort& host,
+                                                                    Date_t now) const {
+    auto stats = _syncSourceFetchStats.find(host);
+    if (stats == _syncSourceFetchStats.end() ||
+        !stats->second.hasMeasurements(now - Seconds(gSyncSourceFetchStatsExpirySeconds.load())) ||
+        stats->second.getThroughputBytesPerMilli() <= 0) {
+        return boost::none;
+    }
+    return (1024 * 1024) / stats->second.getThroughputBytesPerMilli();
+}
+
+TopologyCoordinator::SyncSourceScore TopologyCoordinator::_scoreSyncSource(int memberIndex,
+                                                                           Date_t now) const {
+    const auto& host = _rsConfig.getMemberAt(memberIndex).getHostAndPort();
+    // Each member already syncing from the candidate competes with us for its oplog reads.
+    const double load = 1 + _getNumMembersSyncingFrom(memberIndex);
+
+    SyncSourceScore score;
+    if (auto millisPerMB = _getMeasuredMillisPerMB(host, now)) {
+        // Inflate the time to fetch a megabyte at the rolling throughput by the spread between the
+        // median and tail latencies of recent batches, so that erratic sources score worse.
+        const auto& stats = _syncSourceFetchStats.find(host)->second;
+        const auto p50 = durationCount<Milliseconds>(stats.getLatencyPercentile(50));
+        const auto p90 = durationCount<Milliseconds>(stats.getLatencyPercentile(90));
+        score.cost = load * *millisPerMB * static_cast<double>(p90) / p50;
+        score.measured = true;
+        return score;
+    }
+
+    // Without measurements, assume the member serves oplog as fast as the fastest member we have
+    // measured, plus a heartbeat round trip. With no measurements at all, this ranks members by
+    // ping time and load alone.
+    boost::optional<double> fastestMillisPerMB;
+    for (const auto& [measuredHost, stats] : _syncSourceFetchStats) {
+        auto millisPerMB = _getMeasuredMillisPerMB(measuredHost, now);
+        if (millisPerMB && (!fastestMillisPerMB || *millisPerMB < *fastestMillisPerMB)) {
+            fastestMillisPerMB = millisPerMB;
+        }
+    }
+    auto ping = _pings.find(host);
+    const auto pingMillis = durationCount<Milliseconds>(
+        ping == _pings.end() ? Milliseconds(0) : ping->second.getMillis());
+    score.cost = load * (fastestMillisPerMB.value_or(0) + pingMillis);
+    score.measured = false;
+    return score;
+}
+
+int TopologyCoordinator::_getNumMembersSyncingFrom(int memberIndex) const {
+    const auto& host = _rsConfig.getMemberAt(memberIndex).getHostAndPort();
+    int numSyncing = 0;
+    for (int itIndex = 0; itIndex < static_cast<int>(_memberData.size()); ++itIndex) {
+        if (itIndex == _selfIndex || itIndex == memberIndex) {
+            continue;
+        }
+        const auto& member = _memberData.at(itIndex);
+        if (member.up() && member.getSyncSource() == host) {
+            ++numSyncing;
+        }
+    }
+    return numSyncing;
+}
+
 rpc::ReplSetMetadata TopologyCoordinator::prepareReplSetMetadata(
     const OpTime& lastVisibleOpTime) const {
     return rpc::ReplSetMetadata(_term,
@@ -42,6 +42,7 @@
 #include "mongo/db/repl/replication_coordinator.h"
 #include "mongo/db/repl/replication_metrics_gen.h"
 #include "mongo/db/repl/split_horizon.h"
+#include "mongo/db/repl/sync_source_fetch_stats.h"
 #include "mongo/db/repl/update_position_args.h"
 #include "mongo/db/server_options.h"
 #include "mongo/rpc/topology_version_gen.h"
@@ -244,6 +245,16 @@ public:
                                 const rpc::OplogQueryMetadata& oqMetadata,
                                 Date_t now) const;
 
+    /**
+     * Records that a batch of "numBytes" bytes took "getMoreLatency" to fetch from "source" while
+     * the source had more oplog entries to send. With enableSyncSourceScoring, these measurements
+     * are used to choose and re-evaluate sync sources.
+     */
+    void recordSyncSourceFetchStats(const HostAndPort& source,
+                                    Milliseconds getMoreLatency,
+                                    long long numBytes,
+                                    Date_t now);
+
     /**
      * Sets the reported mode of this node to one of RS_SECONDARY, RS_STARTUP2, RS_ROLLBACK or
      * RS_RECOVERING, when getRole() == Role::follower.  This is the interface by which the
@@ -868,6 +879,28 @@ private:
     // Returns the current "ping" value for the given member by their address
     Milliseconds _getPing(const HostAndPort& host);
 
+    // How good a member would be as a sync source when enableSyncSourceScoring is set.
+    struct SyncSourceScore {
+        // The estimated milliseconds to fetch a megabyte of oplog from the member, scaled by its
+        // load. Every member is scored on this scale, and lower costs are better.
+        double cost = 0;
+
+        // Whether 'cost' derives from batches this node recently fetched from the member, rather
+        // than from its ping time and the throughput measured from other members.
+        bool measured = false;
+    };
+
+    // Scores the member at 'memberIndex' as a sync source.
+    SyncSourceScore _scoreSyncSource(int memberIndex, Date_t now) const;
+
+    // Returns the milliseconds to fetch a megabyte of oplog from 'host' at the throughput this
+    // node measured, or boost::none if it has no usable measurements of 'host'.
+    boost::optional<double> _getMeasuredMillisPerMB(const HostAndPort& host, Date_t now) const;
+
+    // Returns the number of members, other than this node, which report syncing from the member
+    // at 'memberIndex'.
+    int _getNumMembersSyncingFrom(int memberIndex) const;
+
     // Returns the index of the member with the matching id, or -1 if none match.
     int _getMemberIndex(int id) const;
 
@@ -1047,6 +1080,9 @@ private:
     // current config.
     int pingsInConfig = 0;
 
+    // Oplog fetch measurements for each member this node has synced from, by HostAndPort.
+    std::map<HostAndPort, SyncSourceFetchStats> _syncSourceFetchStats;
+
     // V1 last vote info for elections
     LastVote _lastVote{OpTime::kInitialTerm, -1};
 
@@ -41,6 +41,7 @@
 #include "mongo/db/repl/repl_set_heartbeat_response.h"
 #include "mongo/db/repl/repl_set_request_votes_args.h"
 #include "mongo/db/repl/topology_coordinator.h"
+#include "mongo/db/repl/topology_coordinator_gen.h"
 #include "mongo/db/server_options.h"
 #include "mongo/db/service_context.h"
 #include "mongo/executor/task_executor.h"
@@ -609,6 +610,103 @@ TEST_F(TopoCoordTest, NodeReturnsClosestValidSyncSourceAsSyncSource) {
     ASSERT(getTopoCoord().getSyncSourceAddress().empty());
 }
 
+TEST_F(TopoCoordTest, ScoringPrefersLessLoadedSyncSourceWhenPingsAreEqual) {
+    gEnableSyncSourceScoring.store(true);
+    ON_BLOCK_EXIT([] { gEnableSyncSourceScoring.store(false); });
+
+    updateConfig(BSON("_id"
+                      << "rs0"
+                      << "version" << 1 << "members"
+                      << BSON_ARRAY(BSON("_id" << 10 << "host"
+                                               << "hself")
+                                    << BSON("_id" << 20 << "host"
+                                                  << "h2")
+                                    << BSON("_id" << 30 << "host"
+                                                  << "h3")
+                                    << BSON("_id" << 40 << "host"
+                                                  << "h4"))),
+                 0);
+    setSelfMemberState(MemberState::RS_SECONDARY);
+
+    // h2 and h3 are equally far ahead and equally close, but h4 is already syncing from h3.
+    // Record two rounds of pings to allow choosing a new sync source.
+    for (int i = 0; i < 2; ++i) {
+        receiveUpHeartbeat(HostAndPort("h2"),
+                           "rs0",
+                           MemberState::RS_SECONDARY,
+                           OpTime(),
+                           OpTime(Timestamp(20, 0), 0));
+        receiveUpHeartbeat(HostAndPort("h3"),
+                           "rs0",
+                           MemberState::RS_SECONDARY,
+                           OpTime(),
+                           OpTime(Timestamp(20, 0), 0));
+        receiveUpHeartbeat(HostAndPort("h4"),
+                           "rs0",
+                           MemberState::RS_SECONDARY,
+                           OpTime(),
+                           OpTime(Timestamp(5, 0), 0),
+                           HostAndPort("h3"));
+    }
+
+    getTopoCoord().chooseNewSyncSource(now()++,
+                                       OpTime(Timestamp(10, 0), 0),
+                                       TopologyCoordinator::ChainingPreference::kUseConfiguration,
+                                       ReadPreference::Nearest);
+    ASSERT_EQUALS(HostAndPort("h2"), getTopoCoord().getSyncSourceAddress());
+
+    // Without scoring, ties in ping time go to the last member considered.
+    gEnableSyncSourceScoring.store(false);
+    getTopoCoord().chooseNewSyncSource(now()++,
+                                       OpTime(Timestamp(10, 0), 0),
+                                       TopologyCoordinator::ChainingPreference::kUseConfiguration,
+                                       ReadPreference::Nearest);
+    ASSERT_EQUALS(HostAndPort("h3"), getTopoCoord().getSyncSourceAddress());
+}
+
+TEST_F(TopoCoordTest, ScoringRanksMeasuredAndUnmeasuredSyncSourcesOnOneScale) {
+    gEnableSyncSourceScoring.store(true);
+    ON_BLOCK_EXIT([] { gEnableSyncSourceScoring.store(false); });
+
+    updateConfig(BSON("_id"
+                      << "rs0"
+                      << "version" << 1 << "members"
+                      << BSON_ARRAY(BSON("_id" << 10 << "host"
+                                               << "hself")
+                                    << BSON("_id" << 20 << "host"
+                                                  << "h2")
+                                    << BSON("_id" << 30 << "host"
+                                                  << "h3")
+                                    << BSON("_id" << 40 << "host"
+                                                  << "h4"))),
+                 0);
+    setSelfMemberState(MemberState::RS_SECONDARY);
+
+    // All members are equally close. h2 serves a megabyte in 10ms and h4 in 100ms, and h3 has not
+    // been measured. Comparing h3 to its neighbours by ping time alone would let the slow h4 win.
+    for (int i = 0; i < 2; ++i) {
+        for (auto host : {"h2", "h3", "h4"}) {
+            receiveUpHeartbeat(HostAndPort(host),
+                               "rs0",
+                               MemberState::RS_SECONDARY,
+                               OpTime(),
+                               OpTime(Timestamp(20, 0), 0));
+        }
+    }
+    for (size_t i = 0; i < SyncSourceFetchStats::kMinSamples; ++i) {
+        getTopoCoord().recordSyncSourceFetchStats(
+            HostAndPort("h2"), Milliseconds(10), 1024 * 1024, now());
+        getTopoCoord().recordSyncSourceFetchStats(
+            HostAndPort("h4"), Milliseconds(100), 1024 * 1024, now());
+    }
+
+    getTopoCoord().chooseNewSyncSource(now()++,
+                                       OpTime(Timestamp(10, 0), 0),
+                                       TopologyCoordinator::ChainingPreference::kUseConfiguration,
+                                       ReadPreference::Nearest);
+    ASSERT_EQUALS(HostAndPort("h2"), getTopoCoord().getSyncSourceAddress());
+}
+
 TEST_F(TopoCoordTest, NodeWontChooseSyncSourceFromOlderTerm) {
     updateConfig(BSON("_id"
                       << "rs0"
@@ -4241,6 +4339,92 @@ TEST_F(HeartbeatResponseTestV1, ShouldChangeSyncSourceWhenFresherMemberExists) {
     ASSERT_EQUALS(1, countLogLinesContaining("Choosing new sync source"));
 }
 
+class SyncSourceScoringTestV1 : public HeartbeatResponseTestV1 {
+public:
+    void setUp() override {
+        HeartbeatResponseTestV1::setUp();
+        gEnableSyncSourceScoring.store(true);
+
+        topoCoordSetMyLastAppliedOpTime(lastOpTimeApplied, Date_t(), false);
+        HeartbeatResponseAction nextAction = receiveUpHeartbeat(
+            HostAndPort("host2"), "rs0", MemberState::RS_SECONDARY, OpTime(), sourceOpTime);
+        ASSERT_NO_ACTION(nextAction.getAction());
+        nextAction = receiveUpHeartbeat(
+            HostAndPort("host3"), "rs0", MemberState::RS_SECONDARY, OpTime(), sourceOpTime);
+        ASSERT_NO_ACTION(nextAction.getAction());
+    }
+
+    void tearDown() override {
+        gEnableSyncSourceScoring.store(false);
+        HeartbeatResponseTestV1::tearDown();
+    }
+
+protected:
+    void recordBatches(const HostAndPort& source, Milliseconds latency) {
+        for (size_t i = 0; i < SyncSourceFetchStats::kMinSamples; ++i) {
+            getTopoCoord().recordSyncSourceFetchStats(source, latency, 1024 * 1024, now());
+        }
+    }
+
+    bool shouldChangeFromHost2() {
+        return getTopoCoord().shouldChangeSyncSource(HostAndPort("host2"),
+                                                     makeReplSetMetadata(),
+                                                     makeOplogQueryMetadata(sourceOpTime),
+                                                     now());
+    }
+
+    const OpTime lastOpTimeApplied = OpTime(Timestamp(4, 0), 0);
+    const OpTime sourceOpTime = OpTime(Timestamp(5, 0), 0);
+};
+
+TEST_F(SyncSourceScoringTestV1, ShouldChangeSyncSourceWhenMeasuredMemberIsMuchFaster) {
+    recordBatches(HostAndPort("host2"), Milliseconds(100));
+    recordBatches(HostAndPort("host3"), Milliseconds(10));
+
+    startCapturingLogMessages();
+    ASSERT_TRUE(shouldChangeFromHost2());
+    stopCapturingLogMessages();
+    ASSERT_EQUALS(1, countLogLinesContaining("serve oplog batches significantly faster"));
+}
+
+TEST_F(SyncSourceScoringTestV1, ShouldNotChangeSyncSourceWhenScoringIsDisabled) {
+    recordBatches(HostAndPort("host2"), Milliseconds(100));
+    recordBatches(HostAndPort("host3"), Milliseconds(10));
+
+    gEnableSyncSourceScoring.store(false);
+    ASSERT_FALSE(shouldChangeFromHost2());
+}
+
+TEST_F(SyncSourceScoringTestV1, ShouldNotChangeSyncSourceToUnmeasuredMember) {
+    recordBatches(HostAndPort("host2"), Milliseconds(100));
+    ASSERT_FALSE(shouldChangeFromHost2());
+}
+
+TEST_F(SyncSourceScoringTestV1, ShouldNotChangeSyncSourceWhenImprovementIsBelowRatio) {
+    recordBatches(HostAndPort("host2"), Milliseconds(15));
+    recordBatches(HostAndPort("host3"), Milliseconds(10));
+    ASSERT_FALSE(shouldChangeFromHost2());
+}
+
+TEST_F(SyncSourceScoringTestV1, ShouldNotChangeSyncSourceToMemberNotAheadOfUs) {
+    recordBatches(HostAndPort("host2"), Milliseconds(100));
+    recordBatches(HostAndPort("host3"), Milliseconds(10));
+
+    HeartbeatResponseAction nextAction = receiveUpHeartbeat(
+        HostAndPort("host3"), "rs0", MemberState::RS_SECONDARY, OpTime(), lastOpTimeApplied);
+    ASSERT_NO_ACTION(nextAction.getAction());
+    ASSERT_FALSE(shouldChangeFromHost2());
+}
+
+TEST_F(SyncSourceScoringTestV1, ShouldNotChangeSyncSourceOnceMeasurementsExpire) {
+    recordBatches(HostAndPort("host2"), Milliseconds(100));
+    recordBatches(HostAndPort("host3"), Milliseconds(10));
+
+    now() += Seconds(gSyncSourceFetchStatsExpirySeconds.load() + 1);
+    recordBatches(HostAndPort("host2"), Milliseconds(100));
+    ASSERT_FALSE(shouldChangeFromHost2());
+}
+
 TEST_F(HeartbeatResponseTestV1, ShouldNotChangeSyncSourceFromStalePrimary) {
     // In this test, the TopologyCoordinator should still sync to the primary, "host2", although
     // "host3" is fresher.
@@ -209,6 +209,11 @@ void ServiceContext::setStorageEngine(std::unique_ptr<StorageEngine> engine) {
     _storageEngine = std::move(engine);
 }
 
+void ServiceContext::clearStorageEngine() {
+    invariant(_storageEngine);
+    _storageEngine.reset();
+}
+
 void ServiceContext::setOpObserver(std::unique_ptr<OpObserver> opObserver) {
     _opObserver = std::move(opObserver);
 }
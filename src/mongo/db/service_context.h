@@ -387,10 +387,18 @@ public:
     //
 
     /**
-     * Sets the storage engine for this instance. May be called up to once per instance.
+     * Sets the storage engine for this instance. May be called up to once per instance, unless the
+     * storage engine is cleared in between.
      */
     void setStorageEngine(std::unique_ptr<StorageEngine> engine);
 
+    /**
+     * Destroys the storage engine of this instance, which must have been shut down, so that another
+     * may be set. No operation other than the caller's may hold a recovery unit of it; see
+     * reinitializeStorageEngine().
+     */
+    void clearStorageEngine();
+
     /**
      * Return the storage engine instance we're using.
      */
@@ -49,7 +49,9 @@
 #include "mongo/db/sorter/sorter.h"
 
 #include <boost/filesystem/operations.hpp>
+#include <cstring>
 #include <snappy.h>
+#include <type_traits>
 #include <vector>
 
 #include "mongo/base/string_data.h"
@@ -117,6 +119,151 @@ void dassertCompIsSane(const Comparator& comp, const Data& lhs, const Data& rhs)
 #endif
 }
 
+/**
+ * Detects comparators which can encode an item's key as a byte string whose memcmp() order agrees
+ * with the comparator, by providing 'bool appendNormalizedKey(const Data&, BufBuilder*) const'.
+ * Such a comparator may decline to encode a key by returning false.
+ */
+template <typename Comparator, typename Data, typename = void>
+struct HasNormalizedKeys : std::false_type {};
+
+template <typename Comparator, typename Data>
+struct HasNormalizedKeys<Comparator,
+                         Data,
+                         std::void_t<decltype(std::declval<const Comparator&>().appendNormalizedKey(
+                             std::declval<const Data&>(), std::declval<BufBuilder*>()))>>
+    : std::true_type {};
+
+/**
+ * An encoded key together with the position of its item in the unsorted input.
+ */
+struct NormalizedKey {
+    const unsigned char* key;
+    size_t size;
+    size_t index;
+};
+
+// Returns the byte of 'key' at 'depth', or -1 if 'key' ends before 'depth', so that a key sorts
+// before all of its extensions.
+inline int normalizedKeyByte(const NormalizedKey& key, size_t depth) {
+    return depth < key.size ? key.key[depth] : -1;
+}
+
+// Ranges smaller than this are finished with a comparison sort of the remaining key bytes.
+const ptrdiff_t kMultikeyQuicksortCutoff = 16;
+
+/**
+ * Sorts [begin, end) by key using multikey quicksort (Bentley and Sedgewick). All keys in the range
+ * share their first 'depth' bytes. Keys which are identical are ordered by 'tieBreak'.
+ */
+template <typename TieBreak>
+void multikeyQuicksort(NormalizedKey* begin,
+                       NormalizedKey* end,
+                       size_t depth,
+                       const TieBreak& tieBreak) {
+    while (end - begin > kMultikeyQuicksortCutoff) {
+        const int first = normalizedKeyByte(*begin, depth);
+        const int middle = normalizedKeyByte(begin[(end - begin) / 2], depth);
+        const int last = normalizedKeyByte(end[-1], depth);
+        const int pivot =
+            std::max(std::min(first, middle), std::min(std::max(first, middle), last));
+
+        // Partition into [begin, lt) below the pivot, [lt, gt) equal to it and [gt, end) above it.
+        NormalizedKey* lt = begin;
+        NormalizedKey* gt = end;
+        for (NormalizedKey* it = begin; it < gt;) {
+            const int byte = normalizedKeyByte(*it, depth);
+            if (byte < pivot) {
+                std::swap(*lt++, *it++);
+            } else if (byte > pivot) {
+                std::swap(*it, *--gt);
+            } else {
+                ++it;
+            }
+        }
+
+        multikeyQuicksort(begin, lt, depth, tieBreak);
+        multikeyQuicksort(gt, end, depth, tieBreak);
+        if (pivot < 0) {
+            // Every key in the middle range ends at 'depth', so they are all identical.
+            std::sort(lt, gt, tieBreak);
+            return;
+        }
+        begin = lt;
+        end = gt;
+        ++depth;
+    }
+
+    std::sort(begin, end, [&](const NormalizedKey& lhs, const NormalizedKey& rhs) {
+        const int cmp = std::memcmp(
+            lhs.key + depth, rhs.key + depth, std::min(lhs.size, rhs.size) - depth);
+        if (cmp != 0) {
+            return cmp < 0;
+        }
+        if (lhs.size != rhs.size) {
+            return lhs.size < rhs.size;
+        }
+        return tieBreak(lhs, rhs);
+    });
+}
+
+// Below this many items, encoding the keys costs more than the comparisons it saves.
+const size_t kMinItemsForNormalizedKeySort = 64;
+
+/**
+ * Stably sorts 'data' using the keys encoded by 'comp', if it supports encoding them. Each key is
+ * encoded once into a contiguous buffer and the items are ordered by multikey quicksort over the
+ * encoded bytes, so that the comparator is only consulted for items with identical encodings.
+ * Returns false without modifying 'data' if the keys could not be encoded, in which case the
+ * caller must sort with the comparator.
+ */
+template <typename Container, typename Comparator>
+bool sortByNormalizedKeys(Container& data, const Comparator& comp) {
+    using Data = typename Container::value_type;
+    if constexpr (!HasNormalizedKeys<Comparator, Data>::value) {
+        return false;
+    } else {
+        if (data.size() < kMinItemsForNormalizedKeySort) {
+            return false;
+        }
+
+        BufBuilder keys;
+        std::vector<size_t> offsets;
+        offsets.reserve(data.size() + 1);
+        for (auto&& item : data) {
+            offsets.push_back(keys.len());
+            if (!comp.appendNormalizedKey(item, &keys)) {
+                return false;
+            }
+        }
+        offsets.push_back(keys.len());
+
+        // The buffer may move while it grows, so only take pointers into it once it is complete.
+        const auto base = reinterpret_cast<const unsigned char*>(keys.buf());
+        std::vector<NormalizedKey> entries;
+        entries.reserve(data.size());
+        for (size_t i = 0; i < data.size(); ++i) {
+            entries.push_back({base + offsets[i], offsets[i + 1] - offsets[i], i});
+        }
+
+        multikeyQuicksort(
+            entries.data(),
+            entries.data() + entries.size(),
+            0,
+            [&](const NormalizedKey& lhs, const NormalizedKey& rhs) {
+                const int cmp = comp(data[lhs.index], data[rhs.index]);
+                return cmp != 0 ? cmp < 0 : lhs.index < rhs.index;
+            });
+
+        Container sorted;
+        for (auto&& entry : entries) {
+            sorted.push_back(std::move(data[entry.index]));
+        }
+        data = std::move(sorted);
+        return true;
+    }
+}
+
 /**
  * Returns results from sorted in-memory storage.
  */
@@ -579,6 +726,10 @@ private:
     };
 
     void sort() {
+        if (sortByNormalizedKeys(_data, _comp)) {
+            return;
+        }
+
         STLComparator less(_comp);
         std::stable_sort(_data.begin(), _data.end(), less);
 
@@ -785,6 +936,10 @@ private:
     };
 
     void sort() {
+        if (sortByNormalizedKeys(_data, _comp)) {
+            return;
+        }
+
         STLComparator less(_comp);
 
         if (_data.size() == _opts.limit) {
@@ -146,6 +146,9 @@ public:
     boost::optional<Record> seekExact(const RecordId& id) final {
         return {};
     }
+    boost::optional<Record> seekAtOrAfter(const RecordId& id) final {
+        return {};
+    }
     void save() final {}
     bool restore() final {
         return true;
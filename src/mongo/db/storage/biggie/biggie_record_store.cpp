@@ -434,6 +434,24 @@ boost::optional<Record> RecordStore::Cursor::seekExact(const RecordId& id) {
     return Record{id, RecordData(it->second.c_str(), it->second.length())};
 }
 
+boost::optional<Record> RecordStore::Cursor::seekAtOrAfter(const RecordId& id) {
+    _savedPosition = boost::none;
+    _lastMoveWasRestore = false;
+    _needFirstSeek = false;
+    StringStore* workingCopy(RecoveryUnit::get(opCtx)->getHead());
+    it = workingCopy->lower_bound(createKey(_ident, id.repr()));
+
+    if (it == workingCopy->end() || !inPrefix(it->first))
+        return boost::none;
+
+    RecordId foundId(extractRecordId(it->first));
+    if (_isOplog && foundId > _visibilityManager->getAllCommittedRecord())
+        return boost::none;
+
+    _savedPosition = it->first;
+    return Record{foundId, RecordData(it->second.c_str(), it->second.length())};
+}
+
 // Positions are saved as we go.
 void RecordStore::Cursor::save() {}
 void RecordStore::Cursor::saveUnpositioned() {}
@@ -516,6 +534,26 @@ boost::optional<Record> RecordStore::ReverseCursor::seekExact(const RecordId& id
     return Record{id, RecordData(it->second.c_str(), it->second.length())};
 }
 
+boost::optional<Record> RecordStore::ReverseCursor::seekAtOrAfter(const RecordId& id) {
+    _needFirstSeek = false;
+    _savedPosition = boost::none;
+    _lastMoveWasRestore = false;
+    StringStore* workingCopy(RecoveryUnit::get(opCtx)->getHead());
+    // The reverse iterator dereferences to the last key <= the key for 'id'.
+    it = StringStore::const_reverse_iterator(
+        workingCopy->upper_bound(createKey(_ident, id.repr())));
+
+    if (it == workingCopy->rend() || !inPrefix(it->first))
+        return boost::none;
+
+    RecordId foundId(extractRecordId(it->first));
+    if (_isOplog && foundId > _visibilityManager->getAllCommittedRecord())
+        return boost::none;
+
+    _savedPosition = it->first;
+    return Record{foundId, RecordData(it->second.c_str(), it->second.length())};
+}
+
 void RecordStore::ReverseCursor::save() {}
 void RecordStore::ReverseCursor::saveUnpositioned() {}
 
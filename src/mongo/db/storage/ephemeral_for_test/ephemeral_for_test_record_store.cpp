@@ -150,6 +150,15 @@ public:
         return {{_it->first, _it->second.toRecordData()}};
     }
 
+    boost::optional<Record> seekAtOrAfter(const RecordId& id) final {
+        _lastMoveWasRestore = false;
+        _needFirstSeek = false;
+        _it = _records.lower_bound(id);
+        if (_it == _records.end())
+            return {};
+        return {{_it->first, _it->second.toRecordData()}};
+    }
+
     void save() final {
         if (!_needFirstSeek && !_lastMoveWasRestore)
             _savedId = _it == _records.end() ? RecordId() : _it->first;
@@ -223,6 +232,17 @@ public:
         return {{_it->first, _it->second.toRecordData()}};
     }
 
+    boost::optional<Record> seekAtOrAfter(const RecordId& id) final {
+        _lastMoveWasRestore = false;
+        _needFirstSeek = false;
+
+        // As in restore(), this dereferences to the first element <= 'id'.
+        _it = Records::const_reverse_iterator(_records.upper_bound(id));
+        if (_it == _records.rend())
+            return {};
+        return {{_it->first, _it->second.toRecordData()}};
+    }
+
     void save() final {
         if (!_needFirstSeek && !_lastMoveWasRestore)
             _savedId = _it == _records.rend() ? RecordId() : _it->first;
@@ -270,6 +270,13 @@ public:
                       "The current storage engine doesn't support backup mode");
     }
 
+    /**
+     * See `StorageEngine::getBackupCheckpointTimestamp`
+     */
+    virtual boost::optional<Timestamp> getBackupCheckpointTimestamp() const {
+        return boost::none;
+    }
+
     /**
      * Returns whether the KVEngine supports checkpoints.
      */
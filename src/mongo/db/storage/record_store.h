@@ -171,6 +171,15 @@ public:
      */
     virtual boost::optional<Record> seekExact(const RecordId& id) = 0;
 
+    /**
+     * Seeks to the first Record whose id is 'id' or follows it in the cursor's direction, and
+     * returns it. Unlike seekExact(), the Record with the provided id need not exist, so this can
+     * resume a scan from a position which may since have been deleted.
+     *
+     * If there is no such Record, boost::none will be returned and the cursor is left at EOF.
+     */
+    virtual boost::optional<Record> seekAtOrAfter(const RecordId& id) = 0;
+
     /**
      * Prepares for state changes in underlying data without necessarily saving the current
      * state.
@@ -483,5 +483,67 @@ TEST(RecordStoreTestHarness, SeekExactForMissingRecordReturnsNone) {
     ASSERT_FALSE(recordStore->findRecord(opCtx.get(), recordIds[1], &outputData));
 }
 
+// seekAtOrAfter() must return the record with the RecordId if it exists, and otherwise the next
+// record in the cursor's direction.
+TEST(RecordStoreTestHarness, SeekAtOrAfterSkipsMissingRecord) {
+    const auto harnessHelper{newRecordStoreHarnessHelper()};
+    auto recordStore = harnessHelper->newNonCappedRecordStore();
+    ServiceContext::UniqueOperationContext opCtx{harnessHelper->newOperationContext()};
+
+    // Insert three records and remember their record ids.
+    const int nToInsert = 3;
+    RecordId recordIds[nToInsert];
+    for (int i = 0; i < nToInsert; ++i) {
+        StringBuilder sb;
+        sb << "record " << i;
+        string data = sb.str();
+
+        WriteUnitOfWork uow{opCtx.get()};
+        auto res =
+            recordStore->insertRecord(opCtx.get(), data.c_str(), data.size() + 1, Timestamp{});
+        ASSERT_OK(res.getStatus());
+        recordIds[i] = res.getValue();
+        uow.commit();
+    }
+    std::sort(recordIds, recordIds + nToInsert);
+
+    {
+        auto cursor = recordStore->getCursor(opCtx.get(), true);
+        auto record = cursor->seekAtOrAfter(recordIds[1]);
+        ASSERT(record);
+        ASSERT_EQUALS(recordIds[1], record->id);
+    }
+
+    // Delete the second record.
+    {
+        WriteUnitOfWork uow{opCtx.get()};
+        recordStore->deleteRecord(opCtx.get(), recordIds[1]);
+        uow.commit();
+    }
+
+    // A forward cursor lands on the third record and a reverse cursor on the first, and both
+    // continue from there.
+    {
+        auto cursor = recordStore->getCursor(opCtx.get(), true);
+        auto record = cursor->seekAtOrAfter(recordIds[1]);
+        ASSERT(record);
+        ASSERT_EQUALS(recordIds[2], record->id);
+        ASSERT(!cursor->next());
+    }
+    {
+        auto cursor = recordStore->getCursor(opCtx.get(), false);
+        auto record = cursor->seekAtOrAfter(recordIds[1]);
+        ASSERT(record);
+        ASSERT_EQUALS(recordIds[0], record->id);
+        ASSERT(!cursor->next());
+    }
+
+    // There is nothing after the last record.
+    {
+        auto cursor = recordStore->getCursor(opCtx.get(), true);
+        ASSERT(!cursor->seekAtOrAfter(RecordId(recordIds[2].repr() + 1)));
+    }
+}
+
 }  // namespace
 }  // namespace mongo
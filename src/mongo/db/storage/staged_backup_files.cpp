@@ -0,0 +1,241 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#define MONGO_LOGV2_DEFAULT_COMPONENT ::mongo::logv2::LogComponent::kStorage
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/storage/staged_backup_files.h"
+
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
+#include <vector>
+
+#include "mongo/bson/bson_validate.h"
+#include "mongo/db/storage/storage_file_util.h"
+#include "mongo/logv2/log.h"
+#include "mongo/util/assert_util.h"
+#include "mongo/util/str.h"
+
+namespace mongo {
+
+namespace {
+namespace fs = boost::filesystem;
+
+const std::string kCompleteMarkerFileName = "_copy_complete";
+const std::string kInstallingMarkerFileName = "_installing";
+const std::string kInstalledLocalStateFileName = "_initialsync_local_state.bson";
+
+void touchMarkerFile(const fs::path& markerPath, StringData contents) {
+    fs::ofstream fileStream(markerPath);
+    fileStream << contents;
+    fileStream.close();
+    uassert(ErrorCodes::FileStreamFailed,
+            str::stream() << "Failed to write to file " << markerPath.generic_string() << ": "
+                          << errnoWithDescription(),
+            !fileStream.fail());
+    uassertStatusOK(fsyncFile(markerPath));
+    uassertStatusOK(fsyncParentDirectory(markerPath));
+}
+
+bool isMarkerFile(const fs::path& path) {
+    const auto name = path.filename().string();
+    return name == kCompleteMarkerFileName || name == kInstallingMarkerFileName;
+}
+
+/**
+ * Returns true for files owned by the storage engine, which are replaced by the staged files.
+ * Everything else in the dbpath (the lock file, the storage engine metadata, diagnostic data and
+ * any user files) is left in place.
+ */
+bool isStorageEngineFile(const fs::path& path) {
+    const auto name = path.filename().string();
+    return StringData(name).startsWith("WiredTiger") || StringData(name).endsWith(".wt");
+}
+
+void removeStorageEngineFiles(const fs::path& dbpath, const fs::path& stagingPath) {
+    std::vector<fs::path> toRemove;
+    for (auto it = fs::recursive_directory_iterator(dbpath);
+         it != fs::recursive_directory_iterator();
+         ++it) {
+        if (it->path() == stagingPath) {
+            it.no_push();
+            continue;
+        }
+        if (fs::is_regular_file(it->status()) && isStorageEngineFile(it->path())) {
+            toRemove.push_back(it->path());
+        }
+    }
+
+    for (const auto& path : toRemove) {
+        boost::system::error_code ec;
+        fs::remove(path, ec);
+        if (ec) {
+            LOGV2_FATAL_NOTRACE(5380000,
+                                "Failed to remove data file replaced by staged initial sync files",
+                                "file"_attr = path.generic_string(),
+                                "error"_attr = ec.message());
+        }
+    }
+    fassertNoTrace(5380001, fsyncParentDirectory(stagingPath));
+}
+
+void moveStagedFiles(const fs::path& dbpath, const fs::path& stagingPath) {
+    std::vector<fs::path> toMove;
+    for (auto it = fs::recursive_directory_iterator(stagingPath);
+         it != fs::recursive_directory_iterator();
+         ++it) {
+        if (fs::is_regular_file(it->status()) && !isMarkerFile(it->path())) {
+            toMove.push_back(it->path());
+        }
+    }
+
+    for (const auto& source : toMove) {
+        const auto dest = dbpath / source.lexically_relative(stagingPath);
+        boost::system::error_code ec;
+        fs::create_directories(dest.parent_path(), ec);
+        if (!ec && fs::exists(dest)) {
+            // A previous attempt may have crashed after copying but before removing the source.
+            fs::remove(dest, ec);
+        }
+        if (ec) {
+            LOGV2_FATAL_NOTRACE(5380002,
+                                "Failed to prepare destination for staged initial sync file",
+                                "file"_attr = dest.generic_string(),
+                                "error"_attr = ec.message());
+        }
+        fassertNoTrace(5380003, fsyncRename(source, dest));
+    }
+}
+
+}  // namespace
+
+fs::path getStagedBackupFilesPath(const std::string& dbpath) {
+    return fs::path(dbpath) / kStagedBackupFilesDirName.toString();
+}
+
+void markStagedBackupFilesComplete(const fs::path& stagingPath, const BSONObj& localState) {
+    touchMarkerFile(stagingPath / kCompleteMarkerFileName,
+                    StringData(localState.objdata(), localState.objsize()));
+}
+
+bool hasCompleteStagedBackupFiles(const fs::path& stagingPath) {
+    return fs::exists(stagingPath / kCompleteMarkerFileName) ||
+        fs::exists(stagingPath / kInstallingMarkerFileName);
+}
+
+bool installStagedBackupFiles(const std::string& dbpath) {
+    const auto stagingPath = getStagedBackupFilesPath(dbpath);
+    if (!fs::exists(stagingPath)) {
+        return false;
+    }
+
+    if (!hasCompleteStagedBackupFiles(stagingPath)) {
+        LOGV2(5380004,
+              "Removing incomplete staged initial sync files",
+              "path"_attr = stagingPath.generic_string());
+        boost::system::error_code ec;
+        fs::remove_all(stagingPath, ec);
+        if (ec) {
+            LOGV2_FATAL_NOTRACE(5380005,
+                                "Failed to remove incomplete staged initial sync files",
+                                "path"_attr = stagingPath.generic_string(),
+                                "error"_attr = ec.message());
+        }
+        return false;
+    }
+
+    LOGV2(5380006,
+          "Installing data files staged by file copy based initial sync",
+          "path"_attr = stagingPath.generic_string());
+
+    // This ordering is important. The installing marker must only be written once every file it
+    // replaces has been removed, since staged files that have already been moved into the dbpath
+    // are indistinguishable from the files they replace.
+    const auto installingMarker = stagingPath / kInstallingMarkerFileName;
+    if (!fs::exists(installingMarker)) {
+        removeStorageEngineFiles(dbpath, stagingPath);
+        touchMarkerFile(installingMarker,
+                        "This file indicates that staged initial sync files are being installed.");
+    }
+
+    moveStagedFiles(dbpath, stagingPath);
+
+    // The complete marker holds the node-local state to restore, which must outlive the staging
+    // directory. A previous attempt may have moved it already.
+    const auto completeMarker = stagingPath / kCompleteMarkerFileName;
+    if (fs::exists(completeMarker)) {
+        const auto localStatePath = fs::path(dbpath) / kInstalledLocalStateFileName;
+        fassertNoTrace(5380037, fsyncRename(completeMarker, localStatePath));
+    }
+
+    boost::system::error_code ec;
+    fs::remove_all(stagingPath, ec);
+    if (ec) {
+        LOGV2_FATAL_NOTRACE(5380007,
+                            "Failed to remove staged initial sync directory",
+                            "path"_attr = stagingPath.generic_string(),
+                            "error"_attr = ec.message());
+    }
+    fassertNoTrace(5380008, fsyncParentDirectory(stagingPath));
+    return true;
+}
+
+boost::optional<BSONObj> getInstalledBackupFilesLocalState(const std::string& dbpath) {
+    const auto path = fs::path(dbpath) / kInstalledLocalStateFileName;
+    if (!fs::exists(path)) {
+        return boost::none;
+    }
+
+    fs::ifstream fileStream(path, std::ios_base::in | std::ios_base::binary);
+    const std::string contents((std::istreambuf_iterator<char>(fileStream)),
+                               std::istreambuf_iterator<char>());
+    uassert(ErrorCodes::FileStreamFailed,
+            str::stream() << "Failed to read file " << path.generic_string() << ": "
+                          << errnoWithDescription(),
+            !fileStream.bad());
+    uassertStatusOKWithContext(
+        validateBSON(contents.data(), contents.size(), BSONVersion::kLatest),
+        str::stream() << "Invalid node-local state recorded in " << path.generic_string());
+    return BSONObj(contents.data()).getOwned();
+}
+
+void removeInstalledBackupFilesLocalState(const std::string& dbpath) {
+    const auto path = fs::path(dbpath) / kInstalledLocalStateFileName;
+    boost::system::error_code ec;
+    fs::remove(path, ec);
+    uassert(ErrorCodes::FileStreamFailed,
+            str::stream() << "Failed to remove file " << path.generic_string() << ": "
+                          << ec.message(),
+            !ec);
+    uassertStatusOK(fsyncParentDirectory(path));
+}
+
+}  // namespace mongo
@@ -0,0 +1,104 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#pragma once
+
+#include <boost/filesystem/path.hpp>
+#include <boost/optional.hpp>
+#include <string>
+
+#include "mongo/base/string_data.h"
+#include "mongo/bson/bsonobj.h"
+
+namespace mongo {
+
+/**
+ * Helpers for the directory into which file copy based initial sync stages the data files of its
+ * sync source. Files are copied into the staging directory while the node is running, and are
+ * moved into the dbpath the next time the node starts up, before the storage engine is opened.
+ *
+ * The staging directory goes through the following states, each of which is recorded on disk so
+ * that a crash at any point leaves the dbpath recoverable:
+ *   - incomplete: the directory exists without a marker file. It is discarded at startup.
+ *   - complete: every file has been copied and flushed. At startup, the existing data files are
+ *     removed and the directory moves to the installing state.
+ *   - installing: the existing data files have been removed. At startup, any remaining staged
+ *     files are moved into the dbpath and the directory is removed.
+ *
+ * The copied files hold the sync source's node-local replica set state, such as its lastVote. The
+ * syncing node records its own state when it marks the staged files complete, and that record is
+ * moved into the dbpath along with the files so that the state can be restored once the storage
+ * engine has opened them, even across a crash.
+ */
+
+/**
+ * Name of the staging directory, relative to the dbpath.
+ */
+constexpr StringData kStagedBackupFilesDirName = "_initialsync"_sd;
+
+/**
+ * Returns the path of the staging directory for the given dbpath.
+ */
+boost::filesystem::path getStagedBackupFilesPath(const std::string& dbpath);
+
+/**
+ * Durably records that every file has been copied into the staging directory, along with the
+ * node-local state 'localState' to restore once the files are installed. Throws on error.
+ */
+void markStagedBackupFilesComplete(const boost::filesystem::path& stagingPath,
+                                   const BSONObj& localState);
+
+/**
+ * Returns true if the staging directory holds a complete set of files that will be installed the
+ * next time the node starts.
+ */
+bool hasCompleteStagedBackupFiles(const boost::filesystem::path& stagingPath);
+
+/**
+ * Installs a complete set of staged files into 'dbpath', replacing the existing storage engine
+ * files, and discards an incomplete one. Must be called with the dbpath locked and before the
+ * storage engine is opened. Returns true if staged files were installed.
+ */
+bool installStagedBackupFiles(const std::string& dbpath);
+
+/**
+ * Returns the node-local state recorded by markStagedBackupFilesComplete() for files that have
+ * been installed into 'dbpath', or boost::none if it has already been restored. Throws if the
+ * record is corrupt.
+ */
+boost::optional<BSONObj> getInstalledBackupFilesLocalState(const std::string& dbpath);
+
+/**
+ * Durably removes the record returned by getInstalledBackupFilesLocalState(), once the state it
+ * holds has been restored.
+ */
+void removeInstalledBackupFilesLocalState(const std::string& dbpath);
+
+}  // namespace mongo
@@ -0,0 +1,136 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#include "mongo/platform/basic.h"
+
+#include <boost/filesystem.hpp>
+#include <fstream>
+
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/db/storage/staged_backup_files.h"
+#include "mongo/unittest/temp_dir.h"
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+namespace {
+
+namespace fs = boost::filesystem;
+using unittest::TempDir;
+
+void writeFile(const fs::path& path, const std::string& contents) {
+    fs::create_directories(path.parent_path());
+    std::ofstream ofs(path.string());
+    ofs << contents;
+}
+
+std::string readFile(const fs::path& path) {
+    std::ifstream ifs(path.string());
+    return std::string(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+}
+
+TEST(StagedBackupFilesTest, NothingToInstallWithoutStagingDirectory) {
+    TempDir tempDir("StagedBackupFilesTest_NothingToInstallWithoutStagingDirectory");
+    writeFile(fs::path(tempDir.path()) / "collection-0.wt", "local");
+
+    ASSERT_FALSE(installStagedBackupFiles(tempDir.path()));
+    ASSERT_EQ("local", readFile(fs::path(tempDir.path()) / "collection-0.wt"));
+}
+
+TEST(StagedBackupFilesTest, IncompleteStagingDirectoryIsDiscarded) {
+    TempDir tempDir("StagedBackupFilesTest_IncompleteStagingDirectoryIsDiscarded");
+    const auto stagingPath = getStagedBackupFilesPath(tempDir.path());
+    writeFile(fs::path(tempDir.path()) / "collection-0.wt", "local");
+    writeFile(stagingPath / "collection-0.wt", "remote");
+    ASSERT_FALSE(hasCompleteStagedBackupFiles(stagingPath));
+
+    ASSERT_FALSE(installStagedBackupFiles(tempDir.path()));
+    ASSERT_FALSE(fs::exists(stagingPath));
+    ASSERT_EQ("local", readFile(fs::path(tempDir.path()) / "collection-0.wt"));
+}
+
+TEST(StagedBackupFilesTest, CompleteStagingDirectoryReplacesStorageEngineFiles) {
+    TempDir tempDir("StagedBackupFilesTest_CompleteStagingDirectoryReplacesStorageEngineFiles");
+    const fs::path dbpath(tempDir.path());
+    const auto stagingPath = getStagedBackupFilesPath(tempDir.path());
+    writeFile(dbpath / "WiredTiger.turtle", "local turtle");
+    writeFile(dbpath / "collection-0.wt", "local");
+    writeFile(dbpath / "index-1.wt", "local index");
+    writeFile(dbpath / "journal" / "WiredTigerLog.0000000001", "local log");
+    writeFile(dbpath / "storage.bson", "metadata");
+    writeFile(dbpath / "mongod.lock", "12345");
+
+    writeFile(stagingPath / "WiredTiger.turtle", "remote turtle");
+    writeFile(stagingPath / "collection-0.wt", "remote");
+    writeFile(stagingPath / "journal" / "WiredTigerLog.0000000007", "remote log");
+    markStagedBackupFilesComplete(stagingPath, BSON("rollbackId" << 3));
+    ASSERT_TRUE(hasCompleteStagedBackupFiles(stagingPath));
+    ASSERT_FALSE(getInstalledBackupFilesLocalState(tempDir.path()));
+
+    ASSERT_TRUE(installStagedBackupFiles(tempDir.path()));
+    ASSERT_FALSE(fs::exists(stagingPath));
+
+    ASSERT_EQ("remote turtle", readFile(dbpath / "WiredTiger.turtle"));
+    ASSERT_EQ("remote", readFile(dbpath / "collection-0.wt"));
+    ASSERT_EQ("remote log", readFile(dbpath / "journal" / "WiredTigerLog.0000000007"));
+    ASSERT_FALSE(fs::exists(dbpath / "index-1.wt"));
+    ASSERT_FALSE(fs::exists(dbpath / "journal" / "WiredTigerLog.0000000001"));
+
+    // Files which do not belong to the storage engine are left alone.
+    ASSERT_EQ("metadata", readFile(dbpath / "storage.bson"));
+    ASSERT_EQ("12345", readFile(dbpath / "mongod.lock"));
+
+    // The node-local state recorded with the staged files is kept until it has been restored.
+    auto localState = getInstalledBackupFilesLocalState(tempDir.path());
+    ASSERT_TRUE(localState);
+    ASSERT_BSONOBJ_EQ(BSON("rollbackId" << 3), *localState);
+    removeInstalledBackupFilesLocalState(tempDir.path());
+    ASSERT_FALSE(getInstalledBackupFilesLocalState(tempDir.path()));
+}
+
+TEST(StagedBackupFilesTest, InterruptedInstallationResumes) {
+    TempDir tempDir("StagedBackupFilesTest_InterruptedInstallationResumes");
+    const fs::path dbpath(tempDir.path());
+    const auto stagingPath = getStagedBackupFilesPath(tempDir.path());
+
+    // Simulate a crash after the existing files were removed and one staged file was moved.
+    writeFile(dbpath / "collection-0.wt", "remote");
+    writeFile(stagingPath / "collection-2.wt", "remote other");
+    markStagedBackupFilesComplete(stagingPath, BSON("rollbackId" << 3));
+    writeFile(stagingPath / "_installing", "");
+
+    ASSERT_TRUE(installStagedBackupFiles(tempDir.path()));
+    ASSERT_FALSE(fs::exists(stagingPath));
+    ASSERT_EQ("remote", readFile(dbpath / "collection-0.wt"));
+    ASSERT_EQ("remote other", readFile(dbpath / "collection-2.wt"));
+    ASSERT_TRUE(getInstalledBackupFilesLocalState(tempDir.path()));
+}
+
+}  // namespace
+}  // namespace mongo
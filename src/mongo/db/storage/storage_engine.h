@@ -348,6 +348,12 @@ public:
 
     virtual StatusWith<std::vector<std::string>> extendBackupCursor(OperationContext* opCtx) = 0;
 
+    /**
+     * Returns the stable timestamp of the checkpoint pinned by the open non-blocking backup
+     * cursor, or boost::none if that checkpoint is not stable or no backup cursor is open.
+     */
+    virtual boost::optional<Timestamp> getBackupCheckpointTimestamp() const = 0;
+
     /**
      * Recover as much data as possible from a potentially corrupt RecordStore.
      * This only recovers the record data, not indexes or anything else.
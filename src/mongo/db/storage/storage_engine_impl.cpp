@@ -723,6 +723,10 @@ StatusWith<std::vector<std::string>> StorageEngineImpl::extendBackupCursor(
     return _engine->extendBackupCursor(opCtx);
 }
 
+boost::optional<Timestamp> StorageEngineImpl::getBackupCheckpointTimestamp() const {
+    return _engine->getBackupCheckpointTimestamp();
+}
+
 bool StorageEngineImpl::supportsCheckpoints() const {
     return _engine->supportsCheckpoints();
 }
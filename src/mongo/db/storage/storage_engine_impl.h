@@ -109,6 +109,8 @@ public:
     virtual StatusWith<std::vector<std::string>> extendBackupCursor(
         OperationContext* opCtx) override;
 
+    virtual boost::optional<Timestamp> getBackupCheckpointTimestamp() const override;
+
     virtual bool supportsCheckpoints() const override;
 
     virtual bool isDurable() const override;
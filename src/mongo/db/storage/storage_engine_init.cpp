@@ -38,20 +38,83 @@
 
 #include "mongo/base/init.h"
 #include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/db/client.h"
 #include "mongo/db/concurrency/lock_state.h"
 #include "mongo/db/operation_context.h"
+#include "mongo/db/storage/recovery_unit_noop.h"
+#include "mongo/db/storage/staged_backup_files.h"
 #include "mongo/db/storage/storage_engine_lock_file.h"
 #include "mongo/db/storage/storage_engine_metadata.h"
 #include "mongo/db/storage/storage_options.h"
 #include "mongo/db/storage/storage_repair_observer.h"
+#include "mongo/db/storage/write_unit_of_work.h"
 #include "mongo/db/unclean_shutdown.h"
 #include "mongo/logv2/log.h"
+#include "mongo/platform/mutex.h"
+#include "mongo/stdx/condition_variable.h"
 #include "mongo/util/assert_util.h"
+#include "mongo/util/scopeguard.h"
 #include "mongo/util/str.h"
 
 namespace mongo {
 
 namespace {
+/**
+ * Synchronizes giving operations a recovery unit of the storage engine with replacing the storage
+ * engine, so that no operation holds a recovery unit of a storage engine which is destroyed.
+ */
+struct StorageChangeState {
+    Mutex mutex = MONGO_MAKE_LATCH("StorageChangeState::mutex");
+    stdx::condition_variable cv;
+
+    // The client replacing the storage engine, if any. Operations of other clients wait for it to
+    // finish before being given a recovery unit.
+    Client* changingClient = nullptr;
+
+    // The number of operations holding a recovery unit of the storage engine.
+    size_t numOperations = 0;
+};
+
+const auto getStorageChangeState = ServiceContext::declareDecoration<StorageChangeState>();
+
+// Whether the operation was given a recovery unit of the storage engine.
+const auto usesStorageEngine = OperationContext::declareDecoration<bool>();
+
+/**
+ * Kills the operations of every client other than that of 'opCtx', and waits for all of those
+ * holding a recovery unit of the storage engine to finish. The caller must be replacing the
+ * storage engine, so that no such operation can be created in the meantime.
+ */
+void killAndWaitForOtherOperations(OperationContext* opCtx) {
+    auto service = opCtx->getServiceContext();
+    auto& state = getStorageChangeState(service);
+    invariant(usesStorageEngine(opCtx));
+
+    while (true) {
+        // Operations which were given a recovery unit but are not yet attached to their client are
+        // killed on a later pass.
+        for (ServiceContext::LockedClientsCursor cursor(service); auto client = cursor.next();) {
+            if (client == opCtx->getClient()) {
+                continue;
+            }
+            stdx::lock_guard<Client> lk(*client);
+            if (auto otherOpCtx = client->getOperationContext()) {
+                service->killOperation(lk, otherOpCtx, ErrorCodes::InterruptedDueToReplStateChange);
+            }
+        }
+
+        stdx::unique_lock<Latch> lk(state.mutex);
+        if (state.cv.wait_for(lk, Seconds(1).toSystemDuration(), [&] {
+                return state.numOperations == 1;
+            })) {
+            return;
+        }
+        LOGV2(5380045,
+              "Waiting for operations to finish before replacing the storage engine",
+              "numOperations"_attr = state.numOperations - 1);
+    }
+}
+
 /**
  * Creates the lock file used to prevent concurrent processes from accessing the data files,
  * as appropriate.
@@ -85,6 +148,12 @@ LastStorageEngineShutdownState initializeStorageEngine(ServiceContext* service,
                 "operation unexpectedly failed before completing. MongoDB will not start up "
                 "again without --repair.");
         }
+
+        // Files staged by a file copy based initial sync must be moved into place before the
+        // storage engine opens the dbpath.
+        if (!storageGlobalParams.repair) {
+            installStagedBackupFiles(dbpath);
+        }
     }
 
     if (auto existingStorageEngine = StorageEngineMetadata::getStorageEngineForPath(dbpath)) {
@@ -191,6 +260,51 @@ void shutdownGlobalStorageEngineCleanly(ServiceContext* service) {
     }
 }
 
+void reinitializeStorageEngine(OperationContext* opCtx) {
+    auto service = opCtx->getServiceContext();
+    auto& state = getStorageChangeState(service);
+    invariant(opCtx->lockState()->isW());
+    invariant(service->getStorageEngine());
+
+    opCtx->recoveryUnit()->abandonSnapshot();
+    LOGV2(5380035, "Shutting down the storage engine to reinitialize it");
+    // The storage engine's own threads, which may create operations, are stopped before operations
+    // are made to wait for the new storage engine.
+    service->getStorageEngine()->cleanShutdown();
+
+    {
+        stdx::lock_guard<Latch> lk(state.mutex);
+        invariant(!state.changingClient);
+        state.changingClient = opCtx->getClient();
+    }
+    ON_BLOCK_EXIT([&] {
+        stdx::lock_guard<Latch> lk(state.mutex);
+        state.changingClient = nullptr;
+        state.cv.notify_all();
+    });
+
+    // Other operations hold their recovery units until they finish, even those which are only
+    // waiting for the global lock, so they must be gone before the storage engine is destroyed.
+    killAndWaitForOtherOperations(opCtx);
+
+    // The recovery unit of 'opCtx' belongs to the storage engine that was just shut down.
+    opCtx->setRecoveryUnit(std::make_unique<RecoveryUnitNoop>(),
+                           WriteUnitOfWork::RecoveryUnitState::kNotInUnitOfWork);
+    service->clearStorageEngine();
+
+    // mongod.lock stayed locked by this process, so it is neither created nor checked again.
+    initializeStorageEngine(service, StorageEngineInitFlags::kAllowNoLockFile);
+    LOGV2(5380036, "Reinitialized the storage engine");
+
+    opCtx->setRecoveryUnit(
+        std::unique_ptr<RecoveryUnit>(service->getStorageEngine()->newRecoveryUnit()),
+        WriteUnitOfWork::RecoveryUnitState::kNotInUnitOfWork);
+
+    // The new storage engine loads its catalog on construction, but the caller reopens it along
+    // with the rest of the catalog.
+    service->getStorageEngine()->closeCatalog(opCtx);
+}
+
 namespace {
 
 void createLockFile(ServiceContext* service) {
@@ -313,6 +427,12 @@ public:
     void onDestroyClient(Client* client) override{};
     void onCreateOperationContext(OperationContext* opCtx) {
         auto service = opCtx->getServiceContext();
+        auto& state = getStorageChangeState(service);
+        stdx::unique_lock<Latch> lk(state.mutex);
+        state.cv.wait(lk, [&] {
+            return !state.changingClient || state.changingClient == opCtx->getClient();
+        });
+
         auto storageEngine = service->getStorageEngine();
         // NOTE(schwerin): The following uassert would be more desirable than the early return when
         // no storage engine is set, but to achieve that we would have to ensure that this file was
@@ -327,8 +447,23 @@ public:
         opCtx->setLockState(std::make_unique<LockerImpl>());
         opCtx->setRecoveryUnit(std::unique_ptr<RecoveryUnit>(storageEngine->newRecoveryUnit()),
                                WriteUnitOfWork::RecoveryUnitState::kNotInUnitOfWork);
+        usesStorageEngine(opCtx) = true;
+        ++state.numOperations;
+    }
+    void onDestroyOperationContext(OperationContext* opCtx) {
+        if (!usesStorageEngine(opCtx)) {
+            return;
+        }
+
+        // The recovery unit is destroyed before the storage engine can be replaced.
+        opCtx->setRecoveryUnit(std::make_unique<RecoveryUnitNoop>(),
+                               WriteUnitOfWork::RecoveryUnitState::kNotInUnitOfWork);
+
+        auto& state = getStorageChangeState(opCtx->getServiceContext());
+        stdx::lock_guard<Latch> lk(state.mutex);
+        --state.numOperations;
+        state.cv.notify_all();
     }
-    void onDestroyOperationContext(OperationContext* opCtx) {}
 };
 
 ServiceContext::ConstructorActionRegisterer registerStorageClientObserverConstructor{
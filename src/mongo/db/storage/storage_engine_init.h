@@ -64,6 +64,17 @@ LastStorageEngineShutdownState initializeStorageEngine(ServiceContext* service,
  */
 void shutdownGlobalStorageEngineCleanly(ServiceContext* service);
 
+/**
+ * Shuts down the storage engine cleanly, destroys it and initializes a new one on the same dbpath,
+ * keeping mongod.lock locked in between. This is how files staged by a file copy based initial sync
+ * are installed without restarting the process. Every other operation is killed and waited for
+ * before the old storage engine is destroyed, and operations created in the meantime wait for the
+ * new one. The caller must hold the global exclusive lock, close the catalog beforehand, reopen it
+ * afterwards and notify the new storage engine once startup recovery is complete. 'opCtx' is given
+ * a recovery unit of the new storage engine.
+ */
+void reinitializeStorageEngine(OperationContext* opCtx);
+
 /**
  * Registers a storage engine onto the given "service".
  */
@@ -91,6 +91,9 @@ public:
         return Status(ErrorCodes::CommandNotSupported,
                       "The current storage engine doesn't support backup mode");
     }
+    boost::optional<Timestamp> getBackupCheckpointTimestamp() const final {
+        return boost::none;
+    }
     Status repairRecordStore(OperationContext* opCtx,
                              RecordId catalogId,
                              const NamespaceString& ns) final {
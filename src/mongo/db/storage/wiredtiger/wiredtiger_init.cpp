@@ -120,8 +120,7 @@ public:
             ++setupCountForUnitTests;
 
             // Intentionally leaked.
-            MONGO_COMPILER_VARIABLE_UNUSED auto leakedSection =
-                new WiredTigerServerStatusSection(kv);
+            MONGO_COMPILER_VARIABLE_UNUSED auto leakedSection = new WiredTigerServerStatusSection();
 
             // This allows unit tests to run this code without encountering memory leaks
 #if __has_feature(address_sanitizer)
@@ -48,6 +48,7 @@
 #include "mongo/db/storage/wiredtiger/wiredtiger_kv_engine.h"
 
 #include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
 #include <boost/filesystem/operations.hpp>
 #include <boost/filesystem/path.hpp>
 #include <boost/system/error_code.hpp>
@@ -1443,6 +1444,44 @@ Status WiredTigerKVEngine::disableIncrementalBackup(OperationContext* opCtx) {
     return Status::OK();
 }
 
+namespace {
+
+/**
+ * Returns the stable timestamp of the checkpoint pinned by the backup cursor just opened on the
+ * database at 'path', or boost::none if it is not a stable checkpoint.
+ *
+ * While holding the checkpoint lock, the backup cursor writes the metadata of the checkpoint it
+ * pins to WiredTiger.backup. That includes the "system:checkpoint" entry, whose
+ * "checkpoint_timestamp" is the checkpoint's stable timestamp, so unlike the last checkpoint
+ * timestamp of the connection it can't be changed by a checkpoint that completes concurrently.
+ */
+boost::optional<Timestamp> readBackupCheckpointTimestamp(const std::string& path) {
+    boost::filesystem::ifstream metadataFile(boost::filesystem::path(path) / "WiredTiger.backup");
+    std::string uri;
+    std::string config;
+    while (std::getline(metadataFile, uri) && std::getline(metadataFile, config)) {
+        if (uri != "system:checkpoint") {
+            continue;
+        }
+
+        WiredTigerConfigParser parser(config);
+        WT_CONFIG_ITEM timestamp;
+        if (parser.get("checkpoint_timestamp", &timestamp) != 0) {
+            return boost::none;
+        }
+        // The timestamp is hex encoded.
+        const auto value = std::stoull(std::string(timestamp.str, timestamp.len), nullptr, 16);
+        if (value == 0) {
+            return boost::none;
+        }
+        return Timestamp(value);
+    }
+    // WiredTiger leaves out the entry for a checkpoint without a timestamp.
+    return boost::none;
+}
+
+}  // namespace
+
 StatusWith<StorageEngine::BackupInformation> WiredTigerKVEngine::beginNonBlockingBackup(
     OperationContext* opCtx, const StorageEngine::BackupOptions& options) {
     uassert(51034, "Cannot open backup cursor with in-memory mode.", !isEphemeral());
@@ -1496,6 +1535,7 @@ StatusWith<StorageEngine::BackupInformation> WiredTigerKVEngine::beginNonBlockin
     pinOplogGuard.dismiss();
     _backupSession = std::move(sessionRaii);
     _backupCursor = cursor;
+    _backupCheckpointTimestamp = readBackupCheckpointTimestamp(_path);
 
     return swBackupInfo;
 }
@@ -1506,6 +1546,12 @@ void WiredTigerKVEngine::endNonBlockingBackup(OperationContext* opCtx) {
     stdx::lock_guard<Latch> lock(_oplogPinnedByBackupMutex);
     _oplogPinnedByBackup = boost::none;
     _backupCursor = nullptr;
+    _backupCheckpointTimestamp = boost::none;
+}
+
+boost::optional<Timestamp> WiredTigerKVEngine::getBackupCheckpointTimestamp() const {
+    stdx::lock_guard<Latch> lock(_oplogPinnedByBackupMutex);
+    return _backupCheckpointTimestamp;
 }
 
 StatusWith<std::vector<std::string>> WiredTigerKVEngine::extendBackupCursor(
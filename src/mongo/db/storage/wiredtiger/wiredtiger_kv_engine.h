@@ -197,6 +197,8 @@ public:
     virtual StatusWith<std::vector<std::string>> extendBackupCursor(
         OperationContext* opCtx) override;
 
+    boost::optional<Timestamp> getBackupCheckpointTimestamp() const override;
+
     int64_t getIdentSize(OperationContext* opCtx, StringData ident) override;
 
     Status repairIdent(OperationContext* opCtx, StringData ident) override;
@@ -467,6 +469,9 @@ private:
     mutable Mutex _oplogPinnedByBackupMutex =
         MONGO_MAKE_LATCH("WiredTigerKVEngine::_oplogPinnedByBackupMutex");
     boost::optional<Timestamp> _oplogPinnedByBackup;
+    // The stable timestamp of the checkpoint pinned by '_backupCursor', if any. Guarded by
+    // '_oplogPinnedByBackupMutex'.
+    boost::optional<Timestamp> _backupCheckpointTimestamp;
     Timestamp _recoveryTimestamp;
 
     // Tracks the stable and oldest timestamps we've set on the storage engine.
@@ -2204,6 +2204,51 @@ boost::optional<Record> WiredTigerRecordStoreCursorBase::seekExact(const RecordI
     return {{id, {static_cast<const char*>(value.data), static_cast<int>(value.size)}}};
 }
 
+boost::optional<Record> WiredTigerRecordStoreCursorBase::seekAtOrAfter(const RecordId& id) {
+    invariant(_hasRestored);
+
+    // Ensure an active transaction is open, as in seekExact().
+    WiredTigerRecoveryUnit::get(_opCtx)->getSession();
+
+    _skipNextAdvance = false;
+    WT_CURSOR* c = _cursor->get();
+    setKey(c, id);
+    // Nothing after the next line can throw WCEs.
+    int cmp;
+    int ret = wiredTigerPrepareConflictRetry(_opCtx, [&] { return c->search_near(c, &cmp); });
+    if (ret != WT_NOTFOUND && ((_forward && cmp < 0) || (!_forward && cmp > 0))) {
+        // We landed on the record before 'id' in our direction, so step once to the one after it.
+        invariantWTOK(ret);
+        ret = wiredTigerPrepareConflictRetry(_opCtx,
+                                             [&] { return _forward ? c->next(c) : c->prev(c); });
+    }
+    RecordId foundId;
+    if (ret == WT_NOTFOUND) {
+        _eof = true;
+        return {};
+    }
+    invariantWTOK(ret);
+    if (hasWrongPrefix(c, &foundId)) {
+        _eof = true;
+        return {};
+    }
+    if (!foundId.isValid()) {
+        foundId = getKey(c);
+    }
+
+    if (_oplogVisibleTs && foundId.repr() > *_oplogVisibleTs) {
+        _eof = true;
+        return {};
+    }
+
+    WT_ITEM value;
+    invariantWTOK(c->get_value(c, &value));
+
+    _lastReturnedId = foundId;
+    _eof = false;
+    return {{foundId, {static_cast<const char*>(value.data), static_cast<int>(value.size)}}};
+}
+
 
 void WiredTigerRecordStoreCursorBase::save() {
     try {
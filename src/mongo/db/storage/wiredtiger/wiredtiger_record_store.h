@@ -445,6 +445,8 @@ public:
 
     boost::optional<Record> seekExact(const RecordId& id);
 
+    boost::optional<Record> seekAtOrAfter(const RecordId& id);
+
     void save();
 
     void saveUnpositioned();
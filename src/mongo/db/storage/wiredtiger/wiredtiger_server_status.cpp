@@ -34,6 +34,8 @@
 #include "mongo/base/checked_cast.h"
 #include "mongo/bson/bsonobjbuilder.h"
 #include "mongo/db/concurrency/d_concurrency.h"
+#include "mongo/db/service_context.h"
+#include "mongo/db/storage/storage_engine.h"
 #include "mongo/db/storage/wiredtiger/wiredtiger_kv_engine.h"
 #include "mongo/db/storage/wiredtiger/wiredtiger_record_store.h"
 #include "mongo/db/storage/wiredtiger/wiredtiger_recovery_unit.h"
@@ -45,8 +47,8 @@ namespace mongo {
 
 using std::string;
 
-WiredTigerServerStatusSection::WiredTigerServerStatusSection(WiredTigerKVEngine* engine)
-    : ServerStatusSection(kWiredTigerEngineName), _engine(engine) {}
+WiredTigerServerStatusSection::WiredTigerServerStatusSection()
+    : ServerStatusSection(kWiredTigerEngineName) {}
 
 bool WiredTigerServerStatusSection::includeByDefault() const {
     return true;
@@ -56,6 +58,10 @@ BSONObj WiredTigerServerStatusSection::generateSection(OperationContext* opCtx,
                                                        const BSONElement& configElement) const {
     Lock::GlobalLock lk(opCtx, LockMode::MODE_IS);
 
+    // Looked up under the global lock, as the storage engine may be reinitialized at runtime.
+    auto engine = checked_cast<WiredTigerKVEngine*>(
+        opCtx->getServiceContext()->getStorageEngine()->getEngine());
+
     // The session does not open a transaction here as one is not needed and opening one would
     // mean that execution could become blocked when a new transaction cannot be allocated
     // immediately.
@@ -80,12 +86,12 @@ BSONObj WiredTigerServerStatusSection::generateSection(OperationContext* opCtx,
 
     WiredTigerKVEngine::appendGlobalStats(bob);
 
-    WiredTigerUtil::appendSnapshotWindowSettings(_engine, session, &bob);
+    WiredTigerUtil::appendSnapshotWindowSettings(engine, session, &bob);
 
     {
         BSONObjBuilder subsection(bob.subobjStart("oplog"));
         subsection.append("visibility timestamp",
-                          Timestamp(_engine->getOplogManager()->getOplogReadTimestamp()));
+                          Timestamp(engine->getOplogManager()->getOplogReadTimestamp()));
     }
 
     return bob.obj();
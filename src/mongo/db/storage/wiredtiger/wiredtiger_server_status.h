@@ -33,20 +33,15 @@
 
 namespace mongo {
 
-class WiredTigerKVEngine;
-
 /**
  * Adds "wiredTiger" to the results of db.serverStatus().
  */
 class WiredTigerServerStatusSection : public ServerStatusSection {
 public:
-    WiredTigerServerStatusSection(WiredTigerKVEngine* engine);
+    WiredTigerServerStatusSection();
     bool includeByDefault() const override;
     BSONObj generateSection(OperationContext* opCtx,
                             const BSONElement& configElement) const override;
-
-private:
-    WiredTigerKVEngine* _engine;
 };
 
 }  // namespace mongo
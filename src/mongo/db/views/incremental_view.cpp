@@ -0,0 +1,289 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/views/incremental_view.h"
+
+#include "mongo/db/exec/document_value/document.h"
+#include "mongo/db/pipeline/document_source_group.h"
+#include "mongo/db/pipeline/document_source_match.h"
+#include "mongo/db/pipeline/document_source_queue.h"
+#include "mongo/db/pipeline/document_source_single_document_transformation.h"
+#include "mongo/db/pipeline/expression_context.h"
+#include "mongo/db/pipeline/pipeline.h"
+#include "mongo/platform/overflow_arithmetic.h"
+#include "mongo/util/str.h"
+
+namespace mongo {
+
+namespace {
+// The fields of the documents the delta pipeline outputs.
+constexpr StringData kCountField = "n"_sd;
+
+std::string sumField(size_t i) {
+    return str::stream() << "s" << i;
+}
+
+std::string countField(size_t i) {
+    return str::stream() << "c" << i;
+}
+
+std::string fieldPath(StringData field) {
+    return str::stream() << "$" << field;
+}
+
+// Adds two numbers with the same widening rules as $sum.
+Value addNumbers(const Value& lhs, const Value& rhs) {
+    switch (Value::getWidestNumeric(lhs.getType(), rhs.getType())) {
+        case NumberDecimal:
+            return Value(lhs.coerceToDecimal().add(rhs.coerceToDecimal()));
+        case NumberDouble:
+            return Value(lhs.coerceToDouble() + rhs.coerceToDouble());
+        default: {
+            long long result;
+            if (overflow::add(lhs.coerceToLong(), rhs.coerceToLong(), &result)) {
+                return Value(lhs.coerceToDouble() + rhs.coerceToDouble());
+            }
+            return Value(result);
+        }
+    }
+}
+
+Value negateNumber(const Value& val) {
+    switch (val.getType()) {
+        case NumberDecimal:
+            return Value(val.getDecimal().negate());
+        case NumberDouble:
+            return Value(-val.getDouble());
+        case NumberLong:
+            if (val.getLong() == std::numeric_limits<long long>::min()) {
+                return Value(-val.coerceToDouble());
+            }
+            return Value(-val.getLong());
+        default:
+            return Value(-val.coerceToLong());
+    }
+}
+
+bool isSupportedTransformation(TransformerInterface::TransformerType type) {
+    switch (type) {
+        case TransformerInterface::TransformerType::kInclusionProjection:
+        case TransformerInterface::TransformerType::kExclusionProjection:
+        case TransformerInterface::TransformerType::kComputedProjection:
+            return true;
+        default:
+            return false;
+    }
+}
+}  // namespace
+
+constexpr StringData IncrementalView::kStateFieldName;
+
+IncrementalView IncrementalView::parse(const boost::intrusive_ptr<ExpressionContext>& expCtx,
+                                       NamespaceString source,
+                                       NamespaceString target,
+                                       std::vector<BSONObj> pipeline) {
+    uassert(5380614,
+            "The pipeline of an incremental view must end with a $group stage",
+            !pipeline.empty() &&
+                pipeline.back().firstElementFieldNameStringData() ==
+                    DocumentSourceGroup::kStageName);
+
+    // Parsing the pipeline validates the specification of each of its stages.
+    auto parsed = Pipeline::parse(pipeline, expCtx);
+    for (auto&& stage : parsed->getSources()) {
+        if (auto match = dynamic_cast<DocumentSourceMatch*>(stage.get())) {
+            uassert(
+                5380615, "$text is not supported in an incremental view", !match->isTextQuery());
+            continue;
+        }
+        if (auto transformation =
+                dynamic_cast<DocumentSourceSingleDocumentTransformation*>(stage.get());
+            transformation && isSupportedTransformation(transformation->getType())) {
+            continue;
+        }
+        uassert(5380616,
+                str::stream() << "Stage " << stage->getSourceName()
+                              << " is not supported in an incremental view, only $match, "
+                                 "$project, $addFields and $set followed by a final $group are",
+                dynamic_cast<DocumentSourceGroup*>(stage.get()) &&
+                    stage == parsed->getSources().back());
+    }
+
+    // Rewrite the $group to output the number of documents in each group and, for each accumulated
+    // field, the sum of its numeric arguments and, for a $avg, the number of them.
+    std::vector<std::pair<std::string, Accumulator>> accumulatedFields;
+    BSONObjBuilder groupBuilder;
+    for (auto&& elem : pipeline.back().firstElement().embeddedObject()) {
+        const auto fieldName = elem.fieldNameStringData();
+        if (fieldName == "_id"_sd) {
+            groupBuilder.append(elem);
+            groupBuilder.append(kCountField, BSON("$sum" << 1));
+            continue;
+        }
+        uassert(5380617,
+                str::stream() << "The field name " << kStateFieldName
+                              << " is reserved in an incremental view",
+                fieldName != kStateFieldName);
+
+        const auto i = accumulatedFields.size();
+        const auto accumulator = elem.embeddedObject().firstElement();
+        if (accumulator.fieldNameStringData() == "$sum"_sd) {
+            groupBuilder.append(sumField(i), BSON("$sum" << accumulator));
+            accumulatedFields.emplace_back(fieldName.toString(), Accumulator::kSum);
+        } else if (accumulator.fieldNameStringData() == "$avg"_sd) {
+            groupBuilder.append(sumField(i), BSON("$sum" << accumulator));
+            groupBuilder.append(
+                countField(i),
+                BSON("$sum" << BSON("$cond" << BSON_ARRAY(BSON("$isNumber" << accumulator)
+                                                          << 1 << 0))));
+            accumulatedFields.emplace_back(fieldName.toString(), Accumulator::kAvg);
+        } else {
+            uasserted(5380618,
+                      str::stream() << "Accumulator " << accumulator.fieldNameStringData()
+                                    << " is not supported in an incremental view, only $sum and "
+                                       "$avg are");
+        }
+    }
+
+    std::vector<BSONObj> deltaPipeline(pipeline.begin(), pipeline.end() - 1);
+    deltaPipeline.push_back(BSON(DocumentSourceGroup::kStageName << groupBuilder.obj()));
+
+    return IncrementalView(std::move(source),
+                           std::move(target),
+                           std::move(pipeline),
+                           std::move(deltaPipeline),
+                           std::move(accumulatedFields));
+}
+
+bool IncrementalView::Delta::isEmpty() const {
+    if (count != 0) {
+        return false;
+    }
+    for (size_t i = 0; i < sums.size(); ++i) {
+        if (counts[i] != 0 || ValueComparator::kInstance.evaluate(sums[i] != Value(0))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void IncrementalView::addDeltas(const boost::intrusive_ptr<ExpressionContext>& expCtx,
+                                const std::vector<BSONObj>& docs,
+                                int sign,
+                                DeltaMap* deltas) const {
+    if (docs.empty()) {
+        return;
+    }
+
+    auto queue = DocumentSourceQueue::create(expCtx);
+    for (auto&& doc : docs) {
+        queue->emplace_back(Document(doc));
+    }
+    auto pipeline = Pipeline::parse(_deltaPipeline, expCtx);
+    pipeline->addInitialSource(std::move(queue));
+
+    while (auto group = pipeline->getNext()) {
+        auto& delta = deltas->emplace((*group)["_id"], Delta{}).first->second;
+        if (delta.sums.empty()) {
+            delta.sums.resize(_accumulatedFields.size(), Value(0));
+            delta.counts.resize(_accumulatedFields.size(), 0);
+        }
+
+        delta.count += sign * (*group)[kCountField].coerceToLong();
+        for (size_t i = 0; i < _accumulatedFields.size(); ++i) {
+            const auto sum = (*group)[sumField(i)];
+            delta.sums[i] = addNumbers(delta.sums[i], sign > 0 ? sum : negateNumber(sum));
+            if (_accumulatedFields[i].second == Accumulator::kAvg) {
+                delta.counts[i] += sign * (*group)[countField(i)].coerceToLong();
+            }
+        }
+    }
+}
+
+std::vector<BSONObj> IncrementalView::makeUpdate(const Delta& delta, const OID& batchId) const {
+    const std::string statePrefix = str::stream() << kStateFieldName << ".";
+    const std::string countPath = statePrefix + "count";
+    const std::string batchPath = statePrefix + "batch";
+
+    // The counters of a group whose target document doesn't exist yet start from zero, and those
+    // of a group the batch was already applied to are left as they are.
+    auto increment = [&](StringData path, const Value& by) {
+        return BSON(
+            "$cond" << BSON_ARRAY(
+                BSON("$eq" << BSON_ARRAY(fieldPath(batchPath) << BSON("$literal" << batchId)))
+                << fieldPath(path)
+                << BSON("$add" << BSON_ARRAY(BSON("$ifNull" << BSON_ARRAY(fieldPath(path) << 0))
+                                             << BSON("$literal" << by)))));
+    };
+
+    // The first stage updates the state, and the second the accumulated fields, so that each $avg
+    // is computed from its updated sum and count. The last stage records the batch once both have
+    // read the id of the batch last applied.
+    BSONObjBuilder stateBuilder;
+    stateBuilder.append(countPath, increment(countPath, Value(delta.count)));
+
+    BSONObjBuilder fieldsBuilder;
+    for (size_t i = 0; i < _accumulatedFields.size(); ++i) {
+        const auto& fieldName = _accumulatedFields[i].first;
+        if (_accumulatedFields[i].second == Accumulator::kSum) {
+            fieldsBuilder.append(fieldName, increment(fieldName, delta.sums[i]));
+            continue;
+        }
+
+        const std::string sumPath = statePrefix + fieldName + ".sum";
+        const std::string avgCountPath = statePrefix + fieldName + ".count";
+        stateBuilder.append(sumPath, increment(sumPath, delta.sums[i]));
+        stateBuilder.append(avgCountPath, increment(avgCountPath, Value(delta.counts[i])));
+
+        // Like $avg, output null when there are no numeric values to average.
+        fieldsBuilder.append(
+            fieldName,
+            BSON("$cond" << BSON_ARRAY(
+                     BSON("$gt" << BSON_ARRAY(fieldPath(avgCountPath) << 0))
+                     << BSON("$divide" << BSON_ARRAY(fieldPath(sumPath) << fieldPath(avgCountPath)))
+                     << BSONNULL)));
+    }
+
+    std::vector<BSONObj> update{BSON("$set" << stateBuilder.obj())};
+    if (!_accumulatedFields.empty()) {
+        update.push_back(BSON("$set" << fieldsBuilder.obj()));
+    }
+    update.push_back(BSON("$set" << BSON(batchPath << batchId)));
+    return update;
+}
+
+BSONObj IncrementalView::makeEmptyGroupFilter(const Value& id) const {
+    return BSON("_id" << id << (str::stream() << kStateFieldName << ".count")
+                      << BSON("$lte" << 0));
+}
+
+}  // namespace mongo
@@ -0,0 +1,162 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#pragma once
+
+#include <boost/intrusive_ptr.hpp>
+#include <string>
+#include <vector>
+
+#include "mongo/base/string_data.h"
+#include "mongo/bson/bsonobj.h"
+#include "mongo/bson/oid.h"
+#include "mongo/db/exec/document_value/value.h"
+#include "mongo/db/exec/document_value/value_comparator.h"
+#include "mongo/db/namespace_string.h"
+
+namespace mongo {
+
+class ExpressionContext;
+
+/**
+ * An incrementally maintained materialized view: the output of an aggregation over a source
+ * collection, kept up to date in a target collection by applying to it the change each write to
+ * the source makes to the groups the written documents belong to, rather than by re-running the
+ * aggregation. The pipeline is made of any number of $match, $project, $addFields and $set stages
+ * followed by a $group whose accumulators are all invertible, i.e. $sum and $avg.
+ *
+ * Each target document holds the group's _id and accumulated fields as $group would output them,
+ * plus a subdocument under kStateFieldName holding the number of source documents in the group, the
+ * running sum and count behind each $avg and the id of the last batch of deltas applied to it.
+ */
+class IncrementalView {
+public:
+    static constexpr StringData kStateFieldName = "_incrementalView"_sd;
+
+    /**
+     * The change that some number of writes to the source make to one group.
+     */
+    struct Delta {
+        // The change to the number of source documents in the group.
+        long long count = 0;
+
+        // For each accumulated field, the change to the sum of its numeric arguments and, for a
+        // $avg, the change to the number of its numeric arguments.
+        std::vector<Value> sums;
+        std::vector<long long> counts;
+
+        /**
+         * Returns true if applying this delta would not change the group.
+         */
+        bool isEmpty() const;
+    };
+
+    // Maps each group's _id to the change to it.
+    using DeltaMap = ValueUnorderedMap<Delta>;
+
+    /**
+     * Parses the definition of a view of 'pipeline' over 'source' which is materialized in
+     * 'target'. Throws if the pipeline is invalid or can't be maintained incrementally.
+     */
+    static IncrementalView parse(const boost::intrusive_ptr<ExpressionContext>& expCtx,
+                                 NamespaceString source,
+                                 NamespaceString target,
+                                 std::vector<BSONObj> pipeline);
+
+    /**
+     * Returns an empty DeltaMap telling groups apart with 'comparator', which must outlive it and
+     * should compare strings with the collation of the source.
+     */
+    static DeltaMap makeDeltaMap(const ValueComparator& comparator = ValueComparator::kInstance) {
+        return comparator.makeUnorderedValueMap<Delta>();
+    }
+
+    const NamespaceString& getSource() const {
+        return _source;
+    }
+
+    const NamespaceString& getTarget() const {
+        return _target;
+    }
+
+    const std::vector<BSONObj>& getPipeline() const {
+        return _pipeline;
+    }
+
+    /**
+     * Adds to 'deltas' the change that inserting (when 'sign' is 1) or deleting (when 'sign' is -1)
+     * the source documents 'docs' makes to the groups they belong to.
+     */
+    void addDeltas(const boost::intrusive_ptr<ExpressionContext>& expCtx,
+                   const std::vector<BSONObj>& docs,
+                   int sign,
+                   DeltaMap* deltas) const;
+
+    /**
+     * Returns the pipeline-style update which applies 'delta', part of the batch of deltas
+     * 'batchId', to the target document of its group, inserting it if it doesn't exist yet. The
+     * update leaves a document to which the batch was already applied unchanged, so that a batch
+     * can be retried after it was partially applied.
+     */
+    std::vector<BSONObj> makeUpdate(const Delta& delta, const OID& batchId) const;
+
+    /**
+     * Returns the filter matching the target document of the group 'id' if it no longer holds any
+     * source documents.
+     */
+    BSONObj makeEmptyGroupFilter(const Value& id) const;
+
+private:
+    enum class Accumulator { kSum, kAvg };
+
+    IncrementalView(NamespaceString source,
+                    NamespaceString target,
+                    std::vector<BSONObj> pipeline,
+                    std::vector<BSONObj> deltaPipeline,
+                    std::vector<std::pair<std::string, Accumulator>> accumulatedFields)
+        : _source(std::move(source)),
+          _target(std::move(target)),
+          _pipeline(std::move(pipeline)),
+          _deltaPipeline(std::move(deltaPipeline)),
+          _accumulatedFields(std::move(accumulatedFields)) {}
+
+    NamespaceString _source;
+    NamespaceString _target;
+    std::vector<BSONObj> _pipeline;
+
+    // The view's pipeline with its $group rewritten to output, for each group, the number of
+    // documents and the sums and counts of Delta rather than the accumulated values.
+    std::vector<BSONObj> _deltaPipeline;
+
+    // The name and accumulator of each of the $group's accumulated fields, in order.
+    std::vector<std::pair<std::string, Accumulator>> _accumulatedFields;
+};
+
+}  // namespace mongo
@@ -0,0 +1,839 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#define MONGO_LOGV2_DEFAULT_COMPONENT ::mongo::logv2::LogComponent::kQuery
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/views/incremental_view_catalog.h"
+
+#include "mongo/db/catalog/collection.h"
+#include "mongo/db/catalog/index_catalog.h"
+#include "mongo/db/catalog_raii.h"
+#include "mongo/db/client.h"
+#include "mongo/db/dbdirectclient.h"
+#include "mongo/db/exec/working_set_common.h"
+#include "mongo/db/operation_context.h"
+#include "mongo/db/pipeline/expression_context.h"
+#include "mongo/db/query/collation/collation_index_key.h"
+#include "mongo/db/query/internal_plans.h"
+#include "mongo/db/query/query_knobs_gen.h"
+#include "mongo/db/repl/replication_coordinator.h"
+#include "mongo/db/service_context.h"
+#include "mongo/logv2/log.h"
+#include "mongo/rpc/get_status_from_command_result.h"
+#include "mongo/util/fail_point.h"
+#include "mongo/util/scopeguard.h"
+
+namespace mongo {
+
+namespace {
+const auto getIncrementalViewCatalog =
+    ServiceContext::declareDecoration<IncrementalViewCatalog>();
+
+MONGO_FAIL_POINT_DEFINE(failIncrementalViewRefreshBeforeDeletes);
+
+// The maximum number of groups updated by one write command.
+constexpr size_t kMaxGroupsPerBatch = 1000;
+
+// The number of source documents read at a time while building a view.
+constexpr size_t kBuildBatchSize = 1000;
+
+// Whether a write which failed with 'code' may succeed if retried later.
+bool isTransientError(ErrorCodes::Error code) {
+    return ErrorCodes::isNotPrimaryError(code) || ErrorCodes::isShutdownError(code) ||
+        ErrorCodes::isInterruption(code) || ErrorCodes::isRetriableError(code) ||
+        code == ErrorCodes::WriteConflict;
+}
+
+// Returns an ExpressionContext evaluating the pipeline of a view under the collation of its source.
+boost::intrusive_ptr<ExpressionContext> makeExpressionContext(OperationContext* opCtx,
+                                                              const CollatorInterface* collator,
+                                                              const NamespaceString& source) {
+    return make_intrusive<ExpressionContext>(
+        opCtx, CollatorInterface::cloneCollator(collator), source);
+}
+
+void runCommand(DBDirectClient* client, StringData db, const BSONObj& cmd) {
+    BSONObj reply;
+    client->runCommand(db.toString(), cmd, reply);
+    uassertStatusOK(getStatusFromCommandResult(reply));
+}
+}  // namespace
+
+const NamespaceString IncrementalViewCatalog::kRegistryNamespace(NamespaceString::kConfigDb,
+                                                                 "incrementalViews");
+
+IncrementalViewCatalog* IncrementalViewCatalog::get(ServiceContext* serviceContext) {
+    return &getIncrementalViewCatalog(serviceContext);
+}
+
+IncrementalViewCatalog* IncrementalViewCatalog::get(OperationContext* opCtx) {
+    return get(opCtx->getServiceContext());
+}
+
+void IncrementalViewCatalog::startRefreshing(ServiceContext* serviceContext) {
+    stdx::lock_guard<Latch> lk(_mutex);
+    auto periodicRunner = serviceContext->getPeriodicRunner();
+    if (_refreshJob || !periodicRunner) {
+        return;
+    }
+
+    PeriodicRunner::PeriodicJob job(
+        "refreshIncrementalViews",
+        [](Client* client) {
+            auto opCtx = client->makeOperationContext();
+            try {
+                IncrementalViewCatalog::get(opCtx.get())->flush(opCtx.get());
+            } catch (const DBException& ex) {
+                LOGV2_WARNING(5380503,
+                              "Failed to refresh incremental views",
+                              "error"_attr = ex.toStatus());
+            }
+        },
+        Milliseconds(internalQueryIncrementalViewRefreshIntervalMillis.load()));
+    _refreshJob = std::make_unique<PeriodicJobAnchor>(periodicRunner->makeJob(std::move(job)));
+    _refreshJob->start();
+}
+
+void IncrementalViewCatalog::createView(OperationContext* opCtx, IncrementalView view) {
+    stdx::lock_guard<Latch> flushLock(_flushMutex);
+    uassert(ErrorCodes::NotWritablePrimary,
+            "Incremental views can only be created on the primary",
+            _loadIfNeeded(opCtx));
+
+    auto entry = std::make_shared<Entry>(std::move(view), OID::gen());
+    const auto& target = entry->view.getTarget();
+
+    BSONArrayBuilder pipeline;
+    for (auto&& stage : entry->view.getPipeline()) {
+        pipeline.append(stage);
+    }
+    DBDirectClient client(opCtx);
+    BSONObj reply;
+    client.runCommand(
+        kRegistryNamespace.db().toString(),
+        BSON("insert" << kRegistryNamespace.coll() << "documents"
+                      << BSON_ARRAY(BSON("_id" << target.ns() << "source"
+                                               << entry->view.getSource().ns() << "pipeline"
+                                               << pipeline.arr() << "registration"
+                                               << entry->registration << "state"
+                                               << "building"))),
+        reply);
+    const auto status = getStatusFromWriteCommandReply(reply);
+    uassert(5380619,
+            str::stream() << "An incremental view is already materialized in " << target,
+            status != ErrorCodes::DuplicateKey);
+    uassertStatusOK(status);
+    entry->persistedState = State::kBuilding;
+
+    {
+        stdx::lock_guard<Latch> lk(_mutex);
+        uassert(5380619,
+                str::stream() << "An incremental view is already materialized in " << target,
+                _views.emplace(target, entry).second);
+        _numViews.store(_views.size());
+    }
+
+    _buildOrInvalidate(opCtx, entry.get());
+
+    // Write the initial contents of the view now rather than waiting for the periodic refresh.
+    _flush(opCtx);
+}
+
+void IncrementalViewCatalog::dropView(OperationContext* opCtx, const NamespaceString& target) {
+    stdx::lock_guard<Latch> flushLock(_flushMutex);
+    uassert(ErrorCodes::NotWritablePrimary,
+            "Incremental views can only be dropped on the primary",
+            _loadIfNeeded(opCtx));
+
+    std::shared_ptr<Entry> entry;
+    {
+        stdx::lock_guard<Latch> lk(_mutex);
+        auto it = _views.find(target);
+        uassert(5380620,
+                str::stream() << "No incremental view is materialized in " << target,
+                it != _views.end());
+        entry = it->second;
+    }
+
+    DBDirectClient client(opCtx);
+    BSONObj reply;
+    client.runCommand(kRegistryNamespace.db().toString(),
+                      BSON("delete" << kRegistryNamespace.coll() << "deletes"
+                                    << BSON_ARRAY(BSON("q" << BSON("_id" << target.ns()
+                                                                         << "registration"
+                                                                         << entry->registration)
+                                                           << "limit" << 1))),
+                      reply);
+    uassertStatusOK(getStatusFromWriteCommandReply(reply));
+
+    stdx::lock_guard<Latch> lk(_mutex);
+    auto it = _views.find(target);
+    if (it != _views.end() && it->second == entry) {
+        _views.erase(it);
+        _numViews.store(_views.size());
+    }
+}
+
+void IncrementalViewCatalog::onInsert(OperationContext* opCtx,
+                                      const NamespaceString& nss,
+                                      const BSONObj& doc) {
+    _recordWrite(opCtx, nss, boost::none, doc);
+}
+
+void IncrementalViewCatalog::onUpdate(OperationContext* opCtx,
+                                      const NamespaceString& nss,
+                                      const boost::optional<BSONObj>& preImage,
+                                      const BSONObj& postImage) {
+    _recordWrite(opCtx, nss, preImage ? preImage : BSONObj(), postImage);
+}
+
+void IncrementalViewCatalog::onDelete(OperationContext* opCtx,
+                                      const NamespaceString& nss,
+                                      const boost::optional<BSONObj>& preImage) {
+    _recordWrite(opCtx, nss, preImage ? preImage : BSONObj(), boost::none);
+}
+
+void IncrementalViewCatalog::onDropCollection(OperationContext* opCtx,
+                                              const NamespaceString& nss) {
+    if (_numViews.load() == 0) {
+        return;
+    }
+
+    stdx::lock_guard<Latch> lk(_mutex);
+    for (auto it = _views.begin(); it != _views.end();) {
+        const auto& entry = *it->second;
+        const auto& view = entry.view;
+        if (view.getSource() == nss || (view.getTarget() == nss && !entry.replacingTarget)) {
+            LOGV2(5380504,
+                  "Unregistering incremental view of a dropped collection",
+                  "source"_attr = view.getSource(),
+                  "target"_attr = view.getTarget());
+            _unregister(lk, opCtx, entry);
+            it = _views.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    _numViews.store(_views.size());
+}
+
+void IncrementalViewCatalog::onRenameCollection(OperationContext* opCtx,
+                                                const NamespaceString& from,
+                                                const NamespaceString& to) {
+    if (_numViews.load() == 0) {
+        return;
+    }
+
+    stdx::lock_guard<Latch> lk(_mutex);
+    for (auto it = _views.begin(); it != _views.end();) {
+        const auto& entry = *it->second;
+        const auto& view = entry.view;
+        // A build renames the collection it built over the target of its view.
+        const bool replacesOwnTarget = view.getTarget() == to && entry.replacingTarget;
+        if (!replacesOwnTarget &&
+            (view.getSource() == from || view.getSource() == to || view.getTarget() == from ||
+             view.getTarget() == to)) {
+            LOGV2(5380514,
+                  "Unregistering incremental view of a renamed collection",
+                  "source"_attr = view.getSource(),
+                  "target"_attr = view.getTarget(),
+                  "from"_attr = from,
+                  "to"_attr = to);
+            _unregister(lk, opCtx, entry);
+            it = _views.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    _numViews.store(_views.size());
+}
+
+void IncrementalViewCatalog::_unregister(WithLock, OperationContext* opCtx, const Entry& entry) {
+    // The primary removes the registration, which secondaries replicate.
+    if (opCtx->writesAreReplicated()) {
+        _droppedRegistrations.emplace_back(entry.view.getTarget(), entry.registration);
+    }
+}
+
+void IncrementalViewCatalog::_recordWrite(OperationContext* opCtx,
+                                          const NamespaceString& nss,
+                                          const boost::optional<BSONObj>& removed,
+                                          const boost::optional<BSONObj>& added) {
+    // Writes applied by a secondary are reflected in the views by those of the primary.
+    if (_numViews.load() == 0 || !opCtx->writesAreReplicated()) {
+        return;
+    }
+
+    std::vector<std::shared_ptr<Entry>> entries;
+    {
+        stdx::lock_guard<Latch> lk(_mutex);
+        for (auto&& [target, entry] : _views) {
+            if (entry->view.getSource() == nss) {
+                entries.push_back(entry);
+            }
+        }
+    }
+    if (entries.empty()) {
+        return;
+    }
+
+    opCtx->recoveryUnit()->onCommit(
+        [this,
+         entries = std::move(entries),
+         removed = removed ? boost::make_optional(removed->getOwned()) : boost::none,
+         added = added ? boost::make_optional(added->getOwned()) : boost::none](
+            boost::optional<Timestamp>) {
+            stdx::lock_guard<Latch> lk(_mutex);
+            for (auto&& entry : entries) {
+                if (entry->state == State::kInvalid) {
+                    continue;
+                }
+                if (removed && removed->isEmpty()) {
+                    // An update or delete without a pre-image can't be applied to the groups.
+                    _invalidate(lk,
+                                entry.get(),
+                                Status(ErrorCodes::InvalidOptions,
+                                       "The source has stopped recording pre-images"));
+                    continue;
+                }
+                if (entry->state == State::kBuilding && !entry->sourceRead) {
+                    // Builds hold a lock excluding writers while moving the boundary, so a write
+                    // beyond it is to a document which is yet to be read.
+                    const auto id = Value((added ? *added : *removed)["_id"]);
+                    if (!entry->buildBoundary ||
+                        ValueComparator(entry->collator.get())
+                            .evaluate(id > *entry->buildBoundary)) {
+                        continue;
+                    }
+                }
+                if (removed) {
+                    entry->removed.push_back(*removed);
+                }
+                if (added) {
+                    entry->added.push_back(*added);
+                }
+            }
+        });
+}
+
+void IncrementalViewCatalog::_invalidate(WithLock, Entry* entry, const Status& reason) {
+    if (entry->state == State::kInvalid) {
+        return;
+    }
+
+    LOGV2_WARNING(5380505,
+                  "Incremental view no longer matches its source and won't be maintained until it "
+                  "is rebuilt",
+                  "source"_attr = entry->view.getSource(),
+                  "target"_attr = entry->view.getTarget(),
+                  "reason"_attr = reason);
+    entry->state = State::kInvalid;
+    entry->invalidReason = reason.toString();
+    entry->buildBoundary.reset();
+    entry->sourceRead = false;
+    entry->removed.clear();
+    entry->added.clear();
+}
+
+bool IncrementalViewCatalog::_loadIfNeeded(OperationContext* opCtx) {
+    auto replCoord = repl::ReplicationCoordinator::get(opCtx);
+    if (!replCoord->canAcceptWritesForDatabase_UNSAFE(opCtx, kRegistryNamespace.db())) {
+        stdx::lock_guard<Latch> lk(_mutex);
+        if (!_views.empty()) {
+            LOGV2(5380509, "Incremental views are only maintained by the primary");
+        }
+        _views.clear();
+        _numViews.store(0);
+        _droppedRegistrations.clear();
+        _loadedTerm.reset();
+        return false;
+    }
+
+    const auto term = replCoord->getTerm();
+    if (_loadedTerm == term) {
+        return true;
+    }
+
+    LOGV2(5380510, "Loading incremental views", "term"_attr = term);
+    std::vector<std::shared_ptr<Entry>> entries;
+    DBDirectClient client(opCtx);
+    auto cursor = client.query(kRegistryNamespace, BSONObj());
+    while (cursor->more()) {
+        const auto doc = cursor->nextSafe();
+        try {
+            const NamespaceString source(doc["source"].String());
+            const NamespaceString target(doc["_id"].String());
+            std::vector<BSONObj> pipeline;
+            for (auto&& stage : doc["pipeline"].Array()) {
+                pipeline.push_back(stage.Obj().getOwned());
+            }
+            auto expCtx = make_intrusive<ExpressionContext>(opCtx, nullptr, source);
+            entries.push_back(std::make_shared<Entry>(
+                IncrementalView::parse(expCtx, source, target, std::move(pipeline)),
+                doc["registration"].OID()));
+        } catch (const DBException& ex) {
+            LOGV2_WARNING(5380511,
+                          "Skipping malformed incremental view registration",
+                          "registration"_attr = doc,
+                          "error"_attr = ex.toStatus());
+        }
+    }
+
+    {
+        stdx::lock_guard<Latch> lk(_mutex);
+        _views.clear();
+        for (auto&& entry : entries) {
+            _views.emplace(entry->view.getTarget(), entry);
+        }
+        _numViews.store(_views.size());
+        _droppedRegistrations.clear();
+    }
+    _loadedTerm = term;
+
+    // The writes made since the views were last maintained by this node weren't observed, so each
+    // view is rebuilt from its source.
+    for (auto&& entry : entries) {
+        try {
+            _buildOrInvalidate(opCtx, entry.get());
+        } catch (const DBException& ex) {
+            if (isTransientError(ex.code())) {
+                throw;
+            }
+        }
+    }
+    return true;
+}
+
+void IncrementalViewCatalog::_build(OperationContext* opCtx, Entry* entry) {
+    const auto& view = entry->view;
+    const auto& source = view.getSource();
+    const auto& target = view.getTarget();
+    LOGV2(5380512, "Building incremental view", "source"_attr = source, "target"_attr = target);
+
+    // The groups are compared, and the target is created, with the collation of the source.
+    BSONObj collation;
+    {
+        AutoGetCollection autoColl(opCtx, source, MODE_IS);
+        uassert(ErrorCodes::NamespaceNotFound,
+                str::stream() << "Collection " << source << " does not exist",
+                autoColl.getCollection());
+        auto collator = autoColl.getCollection()->getDefaultCollator();
+        if (collator) {
+            collation = collator->getSpec().toBSON();
+        }
+
+        entry->inFlight.reset();
+        stdx::lock_guard<Latch> lk(_mutex);
+        entry->collator = CollatorInterface::cloneCollator(collator);
+        entry->comparator = ValueComparator(entry->collator.get());
+        entry->deltas = IncrementalView::makeDeltaMap(entry->comparator);
+    }
+
+    // The view is built into a temporary collection, with the indexes of the target, which is
+    // renamed over the target once complete, so that readers never see a partially built view.
+    // The temporary collection is dropped if the build fails, or else on startup.
+    DBDirectClient client(opCtx);
+    const NamespaceString tempNss(target.db(),
+                                  str::stream() << "tmp.incremental_view." << OID::gen());
+    BSONObjBuilder createCmd;
+    createCmd.append("create", tempNss.coll());
+    createCmd.append("temp", true);
+    if (!collation.isEmpty()) {
+        createCmd.append("collation", collation);
+    }
+    runCommand(&client, tempNss.db(), createCmd.obj());
+    auto dropTemp = makeGuard([&] {
+        try {
+            client.dropCollection(tempNss.ns());
+        } catch (const DBException& ex) {
+            LOGV2_WARNING(5380515,
+                          "Failed to drop the collection of a failed incremental view build",
+                          "namespace"_attr = tempNss,
+                          "error"_attr = ex.toStatus());
+        }
+    });
+
+    BSONArrayBuilder indexes;
+    for (auto&& spec : client.getIndexSpecs(target, false /* includeBuildUUIDs */, 0)) {
+        if (spec["name"].str() != "_id_") {
+            indexes.append(spec.removeField("ns"));
+        }
+    }
+    if (indexes.arrSize() > 0) {
+        runCommand(&client,
+                   tempNss.db(),
+                   BSON("createIndexes" << tempNss.coll() << "indexes" << indexes.arr()));
+    }
+
+    BSONObj startKey = BSON("" << MINKEY);
+    auto boundInclusion = BoundInclusion::kIncludeBothStartAndEndKeys;
+    while (true) {
+        std::vector<BSONObj> batch;
+        {
+            // The source is read in _id order, one batch at a time, each under its own lock and
+            // snapshot, so that writers are only excluded while a batch is read and the boundary
+            // moved past it.
+            opCtx->recoveryUnit()->abandonSnapshot();
+            AutoGetCollection autoColl(opCtx, source, MODE_S);
+            auto collection = autoColl.getCollection();
+            uassert(ErrorCodes::NamespaceNotFound,
+                    str::stream() << "Collection " << source << " does not exist",
+                    collection);
+            uassert(ErrorCodes::InvalidOptions,
+                    str::stream() << "Collection " << source
+                                  << " must have recordPreImages enabled to be the source of an "
+                                     "incremental view",
+                    collection->getRecordPreImages());
+            auto idIndex = collection->getIndexCatalog()->findIdIndex(opCtx);
+            uassert(ErrorCodes::IndexNotFound,
+                    str::stream()
+                        << "Collection " << source
+                        << " must have an _id index to be the source of an incremental view",
+                    idIndex);
+
+            auto exec = InternalPlanner::indexScan(opCtx,
+                                                   collection,
+                                                   idIndex,
+                                                   startKey,
+                                                   BSON("" << MAXKEY),
+                                                   boundInclusion,
+                                                   PlanExecutor::NO_YIELD,
+                                                   InternalPlanner::FORWARD,
+                                                   InternalPlanner::IXSCAN_FETCH);
+            BSONObj doc;
+            PlanExecutor::ExecState state = PlanExecutor::ADVANCED;
+            while (batch.size() < kBuildBatchSize &&
+                   PlanExecutor::ADVANCED == (state = exec->getNext(&doc, nullptr))) {
+                batch.push_back(doc.getOwned());
+            }
+            if (PlanExecutor::FAILURE == state) {
+                uassertStatusOK(WorkingSetCommon::getMemberObjectStatus(doc).withContext(
+                    "Executor error while building incremental view"));
+            }
+
+            stdx::lock_guard<Latch> lk(_mutex);
+            if (entry->state != State::kBuilding) {
+                return;
+            }
+            if (batch.size() < kBuildBatchSize) {
+                entry->sourceRead = true;
+                entry->buildBoundary.reset();
+            } else {
+                const auto lastId = batch.back()["_id"];
+                entry->buildBoundary = Value(lastId);
+
+                BSONObjBuilder keyBuilder;
+                CollationIndexKey::collationAwareIndexKeyAppend(
+                    lastId, collection->getDefaultCollator(), &keyBuilder);
+                startKey = keyBuilder.obj();
+                boundInclusion = BoundInclusion::kIncludeEndKeyOnly;
+            }
+        }
+
+        // The changes are written once they span a full batch of groups, so that the memory held
+        // by a build doesn't grow with the number of groups.
+        view.addDeltas(
+            makeExpressionContext(opCtx, entry->collator.get(), source), batch, 1, &entry->deltas);
+        if (entry->deltas.size() >= kMaxGroupsPerBatch || batch.size() < kBuildBatchSize) {
+            uassertStatusOK(_applyDeltas(opCtx, entry, tempNss)
+                                .withContext("Failed to write the groups of the view"));
+        }
+        if (batch.size() < kBuildBatchSize) {
+            break;
+        }
+    }
+
+    {
+        stdx::lock_guard<Latch> lk(_mutex);
+        auto it = _views.find(target);
+        if (entry->state != State::kBuilding || it == _views.end() || it->second.get() != entry) {
+            return;
+        }
+        entry->replacingTarget = true;
+    }
+    ON_BLOCK_EXIT([&] {
+        stdx::lock_guard<Latch> lk(_mutex);
+        entry->replacingTarget = false;
+    });
+    runCommand(&client,
+               NamespaceString::kAdminDb,
+               BSON("renameCollection" << tempNss.ns() << "to" << target.ns() << "dropTarget"
+                                       << true));
+    dropTemp.dismiss();
+
+    // The writes recorded since the source was read are applied to the target by the next flush.
+    stdx::lock_guard<Latch> lk(_mutex);
+    if (entry->state == State::kBuilding) {
+        entry->state = State::kReady;
+        entry->sourceRead = false;
+    }
+}
+
+void IncrementalViewCatalog::_buildOrInvalidate(OperationContext* opCtx, Entry* entry) {
+    try {
+        _persistState(opCtx, entry);
+        _build(opCtx, entry);
+    } catch (const DBException& ex) {
+        if (isTransientError(ex.code())) {
+            // Leave the view to be rebuilt once the registry is loaded again.
+            _loadedTerm.reset();
+        } else {
+            stdx::lock_guard<Latch> lk(_mutex);
+            _invalidate(lk, entry, ex.toStatus().withContext("Failed to build the view"));
+        }
+        _persistState(opCtx, entry);
+        throw;
+    }
+    _persistState(opCtx, entry);
+}
+
+void IncrementalViewCatalog::flush(OperationContext* opCtx) {
+    stdx::lock_guard<Latch> flushLock(_flushMutex);
+    if (_loadIfNeeded(opCtx)) {
+        _flush(opCtx);
+    }
+}
+
+void IncrementalViewCatalog::_flush(OperationContext* opCtx) {
+    std::vector<std::pair<NamespaceString, OID>> dropped;
+    std::vector<std::tuple<std::shared_ptr<Entry>, std::vector<BSONObj>, std::vector<BSONObj>>>
+        pending;
+    {
+        stdx::lock_guard<Latch> lk(_mutex);
+        dropped = std::move(_droppedRegistrations);
+        _droppedRegistrations.clear();
+        for (auto&& [target, entry] : _views) {
+            if (entry->state == State::kBuilding) {
+                continue;
+            }
+            pending.emplace_back(entry, std::move(entry->removed), std::move(entry->added));
+            entry->removed.clear();
+            entry->added.clear();
+        }
+    }
+
+    if (!dropped.empty()) {
+        BSONArrayBuilder deletes;
+        for (auto&& [target, registration] : dropped) {
+            deletes.append(BSON(
+                "q" << BSON("_id" << target.ns() << "registration" << registration) << "limit"
+                    << 1));
+        }
+        DBDirectClient client(opCtx);
+        BSONObj reply;
+        client.runCommand(
+            kRegistryNamespace.db().toString(),
+            BSON("delete" << kRegistryNamespace.coll() << "deletes" << deletes.arr()),
+            reply);
+        if (auto status = getStatusFromWriteCommandReply(reply); !status.isOK()) {
+            LOGV2_WARNING(5380506,
+                          "Failed to unregister incremental views of dropped collections, will "
+                          "retry",
+                          "error"_attr = status);
+            stdx::lock_guard<Latch> lk(_mutex);
+            _droppedRegistrations.insert(
+                _droppedRegistrations.end(), dropped.begin(), dropped.end());
+        }
+    }
+
+    for (auto&& [entry, removed, added] : pending) {
+        const auto& view = entry->view;
+        try {
+            auto expCtx = makeExpressionContext(opCtx, entry->collator.get(), view.getSource());
+            view.addDeltas(expCtx, removed, -1, &entry->deltas);
+            view.addDeltas(expCtx, added, 1, &entry->deltas);
+        } catch (const DBException& ex) {
+            // The writes can't be applied, so the view no longer matches its source.
+            stdx::lock_guard<Latch> lk(_mutex);
+            _invalidate(
+                lk, entry.get(), ex.toStatus().withContext("Failed to compute the changes"));
+        }
+
+        // A write which fails, as a whole or for some groups, e.g. because this node stepped down,
+        // leaves its batch in place to be retried by the next flush. One which would fail again,
+        // e.g. because the _id of a group is an array, leaves the view invalid.
+        try {
+            auto status = _applyDeltas(opCtx, entry.get(), view.getTarget());
+            if (!status.isOK() && !isTransientError(status.code())) {
+                stdx::lock_guard<Latch> lk(_mutex);
+                _invalidate(lk, entry.get(), status.withContext("Failed to apply changes"));
+            } else if (!status.isOK()) {
+                LOGV2_WARNING(5380507,
+                              "Failed to apply changes to an incremental view, will retry",
+                              "target"_attr = view.getTarget(),
+                              "error"_attr = status);
+            }
+            _persistState(opCtx, entry.get());
+        } catch (const DBException& ex) {
+            LOGV2_WARNING(5380507,
+                          "Failed to apply changes to an incremental view, will retry",
+                          "target"_attr = view.getTarget(),
+                          "error"_attr = ex.toStatus());
+        }
+    }
+}
+
+Status IncrementalViewCatalog::_applyDeltas(OperationContext* opCtx,
+                                            Entry* entry,
+                                            const NamespaceString& nss) {
+    while (true) {
+        {
+            stdx::lock_guard<Latch> lk(_mutex);
+            if (entry->state == State::kInvalid) {
+                entry->inFlight.reset();
+                entry->deltas.clear();
+                return Status::OK();
+            }
+        }
+
+        // A batch is retried until it is fully applied before any later change is, so that the
+        // changes to each group are applied in order.
+        if (!entry->inFlight) {
+            Batch batch{OID::gen(), {}};
+            for (auto it = entry->deltas.begin();
+                 it != entry->deltas.end() && batch.groups.size() < kMaxGroupsPerBatch;) {
+                if (!it->second.isEmpty()) {
+                    batch.groups.emplace_back(it->first, std::move(it->second));
+                }
+                entry->deltas.erase(it++);
+            }
+            if (batch.groups.empty()) {
+                return Status::OK();
+            }
+            entry->inFlight = std::move(batch);
+        }
+
+        if (auto status = _applyBatch(opCtx, entry, nss); !status.isOK()) {
+            return status;
+        }
+        entry->inFlight.reset();
+    }
+}
+
+Status IncrementalViewCatalog::_applyBatch(OperationContext* opCtx,
+                                           Entry* entry,
+                                           const NamespaceString& nss) {
+    const auto& view = entry->view;
+    const auto& batch = *entry->inFlight;
+
+    BSONArrayBuilder updates;
+    BSONArrayBuilder deletes;
+    for (auto&& [id, delta] : batch.groups) {
+        updates.append(BSON("q" << BSON("_id" << id) << "u" << view.makeUpdate(delta, batch.id)
+                                << "upsert" << true));
+        // Groups which may have lost their last document are removed after being updated. If the
+        // batch is retried, those already removed are inserted again holding no documents, and so
+        // removed again.
+        if (delta.count < 0) {
+            deletes.append(BSON("q" << view.makeEmptyGroupFilter(id) << "limit" << 1));
+        }
+    }
+
+    DBDirectClient client(opCtx);
+    auto runWrites = [&](StringData command, StringData field, BSONArray writes) {
+        if (writes.isEmpty()) {
+            return Status::OK();
+        }
+        BSONObj reply;
+        client.runCommand(nss.db().toString(),
+                          BSON(command << nss.coll() << field << writes << "ordered" << false),
+                          reply);
+        return getStatusFromWriteCommandReply(reply);
+    };
+
+    if (auto status = runWrites("update"_sd, "updates"_sd, updates.arr()); !status.isOK()) {
+        return status;
+    }
+    const auto deleteWrites = deletes.arr();
+    if (MONGO_unlikely(failIncrementalViewRefreshBeforeDeletes.shouldFail()) &&
+        !deleteWrites.isEmpty()) {
+        LOGV2(5380513,
+              "Hit failIncrementalViewRefreshBeforeDeletes fail point",
+              "target"_attr = nss);
+        return Status(ErrorCodes::Interrupted,
+                      "Hit failIncrementalViewRefreshBeforeDeletes fail point");
+    }
+    return runWrites("delete"_sd, "deletes"_sd, deleteWrites);
+}
+
+void IncrementalViewCatalog::_persistState(OperationContext* opCtx, Entry* entry) {
+    State state;
+    std::string reason;
+    {
+        stdx::lock_guard<Latch> lk(_mutex);
+        state = entry->state;
+        reason = entry->invalidReason;
+    }
+    if (entry->persistedState == state) {
+        return;
+    }
+
+    BSONObj update;
+    switch (state) {
+        case State::kBuilding:
+            update = BSON("$set" << BSON("state"
+                                         << "building")
+                                 << "$unset" << BSON("reason" << 1));
+            break;
+        case State::kReady:
+            update = BSON("$set" << BSON("state"
+                                         << "ready")
+                                 << "$unset" << BSON("reason" << 1));
+            break;
+        case State::kInvalid:
+            update = BSON("$set" << BSON("state"
+                                         << "invalid"
+                                         << "reason" << reason));
+            break;
+    }
+
+    DBDirectClient client(opCtx);
+    BSONObj reply;
+    client.runCommand(
+        kRegistryNamespace.db().toString(),
+        BSON("update" << kRegistryNamespace.coll() << "updates"
+                      << BSON_ARRAY(BSON("q" << BSON("_id" << entry->view.getTarget().ns()
+                                                           << "registration"
+                                                           << entry->registration)
+                                             << "u" << update))),
+        reply);
+    if (auto status = getStatusFromWriteCommandReply(reply); !status.isOK()) {
+        LOGV2_WARNING(5380508,
+                      "Failed to record the state of an incremental view, will retry",
+                      "target"_attr = entry->view.getTarget(),
+                      "error"_attr = status);
+        return;
+    }
+    entry->persistedState = state;
+}
+
+}  // namespace mongo
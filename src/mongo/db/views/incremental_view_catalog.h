@@ -0,0 +1,241 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#pragma once
+
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "mongo/bson/oid.h"
+#include "mongo/db/namespace_string.h"
+#include "mongo/db/query/collation/collator_interface.h"
+#include "mongo/db/views/incremental_view.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/platform/mutex.h"
+#include "mongo/util/concurrency/with_lock.h"
+#include "mongo/util/periodic_runner.h"
+
+namespace mongo {
+
+class OperationContext;
+class ServiceContext;
+
+/**
+ * The IncrementalViews maintained by this node, keyed by their target collections.
+ *
+ * The catalog queues the documents that committed writes to a view's source remove and add, and a
+ * periodic job running every internalQueryIncrementalViewRefreshIntervalMillis turns them into the
+ * changes to the view's groups and applies those to its target, so the cost of keeping the view up
+ * to date scales with the rate of writes to the source rather than with its size. Updates and
+ * deletes are only observed with the document they replace, so a source must record pre-images.
+ *
+ * The views are registered in kRegistryNamespace, along with the state of each. Only a primary
+ * maintains views: whenever a node starts accepting writes in a new term, it loads the registry
+ * and rebuilds each view from its source, since the writes made under another primary were not
+ * observed by this node. A view is rebuilt into a temporary collection which is then renamed over
+ * its target, so readers keep seeing the previous contents of the target until then. A view which
+ * stops matching its source, e.g. because the source stopped recording pre-images, is marked
+ * invalid and no longer maintained until it is rebuilt. A view whose source or target is dropped or
+ * renamed is unregistered.
+ */
+class IncrementalViewCatalog {
+public:
+    // Holds one document per view: {_id: <target>, source: <source>, pipeline: [<stages>],
+    // registration: <ObjectId>, state: "building" | "ready" | "invalid", reason: <string>}.
+    static const NamespaceString kRegistryNamespace;
+
+    static IncrementalViewCatalog* get(ServiceContext* serviceContext);
+    static IncrementalViewCatalog* get(OperationContext* opCtx);
+
+    /**
+     * Starts the periodic job which maintains the views.
+     */
+    void startRefreshing(ServiceContext* serviceContext);
+
+    /**
+     * Registers 'view' and builds its target from the current contents of its source. Throws if a
+     * view with the same target is registered or this node can't accept writes. Also throws if the
+     * build fails, leaving the view registered: as invalid, unless the failure was transient, e.g.
+     * an interruption, in which case the view is rebuilt by the next flush.
+     */
+    void createView(OperationContext* opCtx, IncrementalView view);
+
+    /**
+     * Unregisters the view whose target is 'target', leaving the target collection as it is.
+     * Throws if there is no such view.
+     */
+    void dropView(OperationContext* opCtx, const NamespaceString& target);
+
+    /**
+     * Record the write 'opCtx' is making to the collection 'nss', to be applied to the views on it
+     * if the write commits.
+     */
+    void onInsert(OperationContext* opCtx, const NamespaceString& nss, const BSONObj& doc);
+    void onUpdate(OperationContext* opCtx,
+                  const NamespaceString& nss,
+                  const boost::optional<BSONObj>& preImage,
+                  const BSONObj& postImage);
+    void onDelete(OperationContext* opCtx,
+                  const NamespaceString& nss,
+                  const boost::optional<BSONObj>& preImage);
+
+    /**
+     * Unregisters the views whose source or target is the dropped collection 'nss'.
+     */
+    void onDropCollection(OperationContext* opCtx, const NamespaceString& nss);
+
+    /**
+     * Unregisters the views whose source or target is the collection 'from' renamed to 'to', or
+     * the collection 'to' which the rename replaces.
+     */
+    void onRenameCollection(OperationContext* opCtx,
+                            const NamespaceString& from,
+                            const NamespaceString& to);
+
+    /**
+     * Applies the writes made to the sources of the views since the last flush to their targets,
+     * after loading the registry if this node started accepting writes since the last flush.
+     */
+    void flush(OperationContext* opCtx);
+
+private:
+    enum class State { kBuilding, kReady, kInvalid };
+
+    // A batch of changes to the groups of a view, applied to its target by one update and one
+    // delete command. The batch's id is recorded in the target document of each group it applies
+    // to, so that retrying a partially applied batch doesn't apply any change twice.
+    struct Batch {
+        OID id;
+        std::vector<std::pair<Value, IncrementalView::Delta>> groups;
+    };
+
+    struct Entry {
+        Entry(IncrementalView view, OID registration)
+            : view(std::move(view)), registration(registration) {}
+
+        const IncrementalView view;
+
+        // Distinguishes this registration from later ones of a view with the same target.
+        const OID registration;
+
+        // The following are guarded by the catalog's '_mutex'.
+        State state = State::kBuilding;
+        std::string invalidReason;
+
+        // While the view is being built, the _id of the last source document included in its
+        // target so far, ordered by the collation of the source. Only writes to the documents up
+        // to it are recorded; those to the others are seen when they are read. Once the whole
+        // source has been read, every write is recorded.
+        boost::optional<Value> buildBoundary;
+        bool sourceRead = false;
+
+        // Set while a build renames the collection it built over the target, so that dropping the
+        // previous target doesn't unregister the view.
+        bool replacingTarget = false;
+
+        // The default collation of the source, and a comparator telling groups apart with it. Set
+        // when the view starts being built, with '_flushMutex' held too.
+        std::unique_ptr<CollatorInterface> collator;
+        ValueComparator comparator;
+
+        // The source documents removed and added by the writes committed since the last flush.
+        std::vector<BSONObj> removed;
+        std::vector<BSONObj> added;
+
+        // The following are guarded by the catalog's '_flushMutex'.
+        // The state recorded in the registry, if known.
+        boost::optional<State> persistedState;
+
+        // The changes to the groups which have not been applied to the target yet, starting with
+        // those of the batch being applied, if any.
+        boost::optional<Batch> inFlight;
+        IncrementalView::DeltaMap deltas = IncrementalView::makeDeltaMap();
+    };
+
+    void _recordWrite(OperationContext* opCtx,
+                      const NamespaceString& nss,
+                      const boost::optional<BSONObj>& removed,
+                      const boost::optional<BSONObj>& added);
+
+    /**
+     * Stops maintaining the view of 'entry', which no longer matches its source. Must be called
+     * with '_mutex' held.
+     */
+    void _invalidate(WithLock, Entry* entry, const Status& reason);
+
+    /**
+     * Unregisters the view of 'entry', whose source or target was dropped or renamed by 'opCtx'.
+     * Must be called with '_mutex' held.
+     */
+    void _unregister(WithLock, OperationContext* opCtx, const Entry& entry);
+
+    /**
+     * Loads the registry if this node started accepting writes in a new term. Returns false if
+     * this node can't accept writes, in which case the views are forgotten.
+     */
+    bool _loadIfNeeded(OperationContext* opCtx);
+
+    void _build(OperationContext* opCtx, Entry* entry);
+    void _buildOrInvalidate(OperationContext* opCtx, Entry* entry);
+
+    void _flush(OperationContext* opCtx);
+
+    /**
+     * Applies the changes to the groups of 'entry' to the collection 'nss', a batch at a time.
+     * Returns the first failure, leaving the batch it occurred in to be retried.
+     */
+    Status _applyDeltas(OperationContext* opCtx, Entry* entry, const NamespaceString& nss);
+    Status _applyBatch(OperationContext* opCtx, Entry* entry, const NamespaceString& nss);
+    void _persistState(OperationContext* opCtx, Entry* entry);
+
+    mutable Mutex _mutex = MONGO_MAKE_LATCH("IncrementalViewCatalog::_mutex");
+    std::map<NamespaceString, std::shared_ptr<Entry>> _views;
+
+    // The number of views, which lets writes check for views without taking '_mutex'.
+    AtomicWord<size_t> _numViews{0};
+
+    // The registrations of the views of dropped collections, to be removed from the registry by the
+    // next flush. Guarded by '_mutex'.
+    std::vector<std::pair<NamespaceString, OID>> _droppedRegistrations;
+
+    // Runs flush() periodically. Guarded by '_mutex'.
+    std::unique_ptr<PeriodicJobAnchor> _refreshJob;
+
+    // Serializes loading the registry, building views and flushes, so that the changes to each
+    // group are applied in order.
+    Mutex _flushMutex = MONGO_MAKE_LATCH("IncrementalViewCatalog::_flushMutex");
+
+    // The term in which the registry was loaded, if this node has been accepting writes since.
+    // Guarded by '_flushMutex'.
+    boost::optional<long long> _loadedTerm;
+};
+
+}  // namespace mongo
@@ -0,0 +1,108 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/views/incremental_view_op_observer.h"
+
+#include "mongo/db/views/incremental_view_catalog.h"
+
+namespace mongo {
+
+void IncrementalViewOpObserver::onInserts(OperationContext* opCtx,
+                                          const NamespaceString& nss,
+                                          OptionalCollectionUUID uuid,
+                                          std::vector<InsertStatement>::const_iterator begin,
+                                          std::vector<InsertStatement>::const_iterator end,
+                                          bool fromMigrate) {
+    // Chunk migrations move documents between shards without changing the collection's contents.
+    if (fromMigrate) {
+        return;
+    }
+
+    auto catalog = IncrementalViewCatalog::get(opCtx);
+    for (auto it = begin; it != end; ++it) {
+        catalog->onInsert(opCtx, nss, it->doc);
+    }
+}
+
+void IncrementalViewOpObserver::onUpdate(OperationContext* opCtx,
+                                         const OplogUpdateEntryArgs& args) {
+    if (args.updateArgs.update.isEmpty() || args.updateArgs.fromMigrate) {
+        return;
+    }
+
+    IncrementalViewCatalog::get(opCtx)->onUpdate(
+        opCtx, args.nss, args.updateArgs.preImageDoc, args.updateArgs.updatedDoc);
+}
+
+void IncrementalViewOpObserver::onDelete(OperationContext* opCtx,
+                                         const NamespaceString& nss,
+                                         OptionalCollectionUUID uuid,
+                                         StmtId stmtId,
+                                         bool fromMigrate,
+                                         const boost::optional<BSONObj>& deletedDoc) {
+    if (fromMigrate) {
+        return;
+    }
+
+    IncrementalViewCatalog::get(opCtx)->onDelete(opCtx, nss, deletedDoc);
+}
+
+repl::OpTime IncrementalViewOpObserver::onDropCollection(OperationContext* opCtx,
+                                                         const NamespaceString& collectionName,
+                                                         OptionalCollectionUUID uuid,
+                                                         std::uint64_t numRecords,
+                                                         CollectionDropType dropType) {
+    IncrementalViewCatalog::get(opCtx)->onDropCollection(opCtx, collectionName);
+    return {};
+}
+
+void IncrementalViewOpObserver::onRenameCollection(OperationContext* opCtx,
+                                                   const NamespaceString& fromCollection,
+                                                   const NamespaceString& toCollection,
+                                                   OptionalCollectionUUID uuid,
+                                                   OptionalCollectionUUID dropTargetUUID,
+                                                   std::uint64_t numRecords,
+                                                   bool stayTemp) {
+    IncrementalViewCatalog::get(opCtx)->onRenameCollection(opCtx, fromCollection, toCollection);
+}
+
+void IncrementalViewOpObserver::postRenameCollection(OperationContext* opCtx,
+                                                     const NamespaceString& fromCollection,
+                                                     const NamespaceString& toCollection,
+                                                     OptionalCollectionUUID uuid,
+                                                     OptionalCollectionUUID dropTargetUUID,
+                                                     bool stayTemp) {
+    // Renames which replace their target are observed in two steps, of which this is the second.
+    IncrementalViewCatalog::get(opCtx)->onRenameCollection(opCtx, fromCollection, toCollection);
+}
+
+}  // namespace mongo
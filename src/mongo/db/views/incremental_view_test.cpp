@@ -0,0 +1,234 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/bson/bsonmisc.h"
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/db/exec/document_value/value_comparator.h"
+#include "mongo/db/pipeline/expression_context_for_test.h"
+#include "mongo/db/views/incremental_view.h"
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+namespace {
+
+const NamespaceString sourceNss("testdb.source");
+const NamespaceString targetNss("testdb.target");
+
+IncrementalView parseView(const std::vector<BSONObj>& pipeline) {
+    auto expCtx = make_intrusive<ExpressionContextForTest>(sourceNss);
+    return IncrementalView::parse(expCtx, sourceNss, targetNss, pipeline);
+}
+
+IncrementalView::DeltaMap addDeltas(const IncrementalView& view,
+                                    const std::vector<BSONObj>& inserted,
+                                    const std::vector<BSONObj>& deleted) {
+    auto expCtx = make_intrusive<ExpressionContextForTest>(sourceNss);
+    auto deltas = IncrementalView::makeDeltaMap();
+    view.addDeltas(expCtx, inserted, 1, &deltas);
+    view.addDeltas(expCtx, deleted, -1, &deltas);
+    return deltas;
+}
+
+void assertValueEq(const Value& expected, const Value& actual) {
+    ASSERT(ValueComparator::kInstance.evaluate(expected == actual))
+        << "expected " << expected.toString() << " but got " << actual.toString();
+}
+
+TEST(IncrementalViewTest, RejectsPipelineNotEndingInGroup) {
+    ASSERT_THROWS_CODE(parseView({BSON("$match" << BSON("a" << 1))}), DBException, 5380614);
+    ASSERT_THROWS_CODE(parseView({BSON("$group" << BSON("_id"
+                                                        << "$a")),
+                                  BSON("$match" << BSON("_id" << 1))}),
+                       DBException,
+                       5380614);
+}
+
+TEST(IncrementalViewTest, RejectsTextSearch) {
+    ASSERT_THROWS_CODE(parseView({BSON("$match" << BSON("$text" << BSON("$search"
+                                                                         << "x"))),
+                                  BSON("$group" << BSON("_id"
+                                                        << "$a"))}),
+                       DBException,
+                       5380615);
+}
+
+TEST(IncrementalViewTest, RejectsStagesWhichDependOnOtherDocuments) {
+    ASSERT_THROWS_CODE(parseView({BSON("$limit" << 10),
+                                  BSON("$group" << BSON("_id"
+                                                        << "$a"))}),
+                       DBException,
+                       5380616);
+    ASSERT_THROWS_CODE(parseView({BSON("$sort" << BSON("a" << 1)),
+                                  BSON("$group" << BSON("_id"
+                                                        << "$a"))}),
+                       DBException,
+                       5380616);
+}
+
+TEST(IncrementalViewTest, RejectsReservedFieldName) {
+    ASSERT_THROWS_CODE(
+        parseView({BSON("$group" << BSON("_id"
+                                         << "$a" << IncrementalView::kStateFieldName
+                                         << BSON("$sum" << 1)))}),
+        DBException,
+        5380617);
+}
+
+TEST(IncrementalViewTest, RejectsNonInvertibleAccumulators) {
+    ASSERT_THROWS_CODE(parseView({BSON("$group" << BSON("_id"
+                                                        << "$a"
+                                                        << "m"
+                                                        << BSON("$max"
+                                                                << "$b")))}),
+                       DBException,
+                       5380618);
+}
+
+TEST(IncrementalViewTest, InsertsAndDeletesProduceOpposingDeltas) {
+    auto view = parseView({BSON("$match" << BSON("b" << BSON("$gt" << 0))),
+                           BSON("$group" << BSON("_id"
+                                                 << "$a"
+                                                 << "total"
+                                                 << BSON("$sum"
+                                                         << "$b")
+                                                 << "mean"
+                                                 << BSON("$avg"
+                                                         << "$b")))});
+
+    auto deltas = addDeltas(view,
+                            {BSON("a" << 1 << "b" << 2),
+                             BSON("a" << 1 << "b" << 4),
+                             BSON("a" << 2 << "b" << 3),
+                             BSON("a" << 2 << "b" << -3)},
+                            {BSON("a" << 2 << "b" << 5)});
+    ASSERT_EQ(deltas.size(), 2U);
+
+    const auto& first = deltas.at(Value(1));
+    ASSERT_EQ(first.count, 2);
+    assertValueEq(Value(6), first.sums[0]);
+    assertValueEq(Value(6), first.sums[1]);
+    ASSERT_EQ(first.counts[1], 2);
+
+    const auto& second = deltas.at(Value(2));
+    ASSERT_EQ(second.count, 0);
+    assertValueEq(Value(-2), second.sums[0]);
+    ASSERT_EQ(second.counts[1], 0);
+    ASSERT_FALSE(second.isEmpty());
+}
+
+TEST(IncrementalViewTest, UpdateWithinGroupCancelsOut) {
+    auto view = parseView({BSON("$project" << BSON("a" << 1 << "b" << 1)),
+                           BSON("$group" << BSON("_id"
+                                                 << "$a"
+                                                 << "total"
+                                                 << BSON("$sum"
+                                                         << "$b")))});
+
+    auto deltas = addDeltas(view,
+                            {BSON("a" << 1 << "b" << 2 << "c" << 1)},
+                            {BSON("a" << 1 << "b" << 2 << "c" << 0)});
+    ASSERT_EQ(deltas.size(), 1U);
+    ASSERT_TRUE(deltas.at(Value(1)).isEmpty());
+}
+
+TEST(IncrementalViewTest, AvgIgnoresNonNumericArguments) {
+    auto view = parseView({BSON("$group" << BSON("_id"
+                                                 << "$a"
+                                                 << "mean"
+                                                 << BSON("$avg"
+                                                         << "$b")))});
+
+    auto deltas = addDeltas(view,
+                            {BSON("a" << 1 << "b" << 4),
+                             BSON("a" << 1 << "b"
+                                      << "x"),
+                             BSON("a" << 1)},
+                            {});
+    const auto& delta = deltas.at(Value(1));
+    ASSERT_EQ(delta.count, 3);
+    assertValueEq(Value(4), delta.sums[0]);
+    ASSERT_EQ(delta.counts[0], 1);
+}
+
+TEST(IncrementalViewTest, MakeUpdateMaintainsStateBeforeAccumulatedFields) {
+    auto view = parseView({BSON("$group" << BSON("_id"
+                                                 << "$a"
+                                                 << "total"
+                                                 << BSON("$sum"
+                                                         << "$b")
+                                                 << "mean"
+                                                 << BSON("$avg"
+                                                         << "$b")))});
+
+    auto deltas = addDeltas(view, {BSON("a" << 1 << "b" << 3)}, {});
+    const auto batchId = OID::gen();
+    auto update = view.makeUpdate(deltas.at(Value(1)), batchId);
+    ASSERT_EQ(update.size(), 3U);
+
+    auto increment = [&](StringData path, auto by) {
+        return BSON(
+            "$cond" << BSON_ARRAY(
+                BSON("$eq" << BSON_ARRAY("$_incrementalView.batch" << BSON("$literal" << batchId)))
+                << "$" + path.toString()
+                << BSON("$add"
+                        << BSON_ARRAY(BSON("$ifNull" << BSON_ARRAY("$" + path.toString() << 0))
+                                      << BSON("$literal" << by)))));
+    };
+    ASSERT_BSONOBJ_EQ(update[0],
+                      BSON("$set" << BSON("_incrementalView.count"
+                                          << increment("_incrementalView.count", 1LL)
+                                          << "_incrementalView.mean.sum"
+                                          << increment("_incrementalView.mean.sum", 3)
+                                          << "_incrementalView.mean.count"
+                                          << increment("_incrementalView.mean.count", 1LL))));
+    ASSERT_BSONOBJ_EQ(
+        update[1],
+        BSON("$set" << BSON(
+                 "total" << increment("total", 3) << "mean"
+                         << BSON("$cond" << BSON_ARRAY(
+                                     BSON("$gt" << BSON_ARRAY("$_incrementalView.mean.count" << 0))
+                                     << BSON("$divide"
+                                             << BSON_ARRAY("$_incrementalView.mean.sum"
+                                                           << "$_incrementalView.mean.count"))
+                                     << BSONNULL)))));
+    ASSERT_BSONOBJ_EQ(update[2], BSON("$set" << BSON("_incrementalView.batch" << batchId)));
+}
+
+TEST(IncrementalViewTest, EmptyGroupFilterMatchesOnCount) {
+    auto view = parseView({BSON("$group" << BSON("_id"
+                                                 << "$a"))});
+    ASSERT_BSONOBJ_EQ(view.makeEmptyGroupFilter(Value(1)),
+                      BSON("_id" << 1 << "_incrementalView.count" << BSON("$lte" << 0)));
+}
+
+}  // namespace
+}  // namespace mongo
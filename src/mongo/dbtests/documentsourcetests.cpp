@@ -33,6 +33,7 @@
 
 #include "mongo/platform/basic.h"
 
+#include "mongo/base/checked_cast.h"
 #include "mongo/db/catalog/collection.h"
 #include "mongo/db/client.h"
 #include "mongo/db/db_raii.h"
@@ -44,14 +45,19 @@
 #include "mongo/db/pipeline/dependencies.h"
 #include "mongo/db/pipeline/document_source.h"
 #include "mongo/db/pipeline/document_source_cursor.h"
+#include "mongo/db/pipeline/document_source_group.h"
+#include "mongo/db/pipeline/document_source_parallel_collection_scan.h"
 #include "mongo/db/pipeline/expression_context_for_test.h"
 #include "mongo/db/pipeline/pipeline.h"
+#include "mongo/db/pipeline/pipeline_d.h"
 #include "mongo/db/query/get_executor.h"
 #include "mongo/db/query/mock_yield_policies.h"
 #include "mongo/db/query/plan_executor.h"
+#include "mongo/db/query/query_knobs_gen.h"
 #include "mongo/db/query/query_planner.h"
 #include "mongo/db/query/stage_builder.h"
 #include "mongo/dbtests/dbtests.h"
+#include "mongo/util/fail_point.h"
 #include "mongo/util/scopeguard.h"
 
 namespace mongo {
@@ -462,5 +468,171 @@ TEST_F(DocumentSourceCursorTest, NormalCursorShouldErrorAfterBeingKilled) {
     ASSERT_THROWS_CODE(cursor->getNext().isEOF(), AssertionException, ErrorCodes::QueryPlanKilled);
 }
 
+class DocumentSourceParallelCollectionScanTest : public DocumentSourceCursorTest {
+protected:
+    static constexpr int kNumDocs = 1000;
+    static constexpr int kNumGroups = 10;
+
+    // Inserts documents {_id: i, key: i % kNumGroups, x: i}.
+    void insertDocs() {
+        for (int i = 0; i < kNumDocs; ++i) {
+            client.insert(nss.ns(), BSON("_id" << i << "key" << i % kNumGroups << "x" << i));
+        }
+    }
+
+    // Splits the collection into 'numPartitions' ranges with the same number of records.
+    vector<RecordId> splitPoints(OperationContext* opCtx, size_t numPartitions) {
+        AutoGetCollectionForRead autoColl(opCtx, nss);
+        vector<RecordId> recordIds;
+        auto cursor = autoColl.getCollection()->getCursor(opCtx);
+        while (auto record = cursor->next()) {
+            recordIds.push_back(record->id);
+        }
+
+        vector<RecordId> splitPoints;
+        for (size_t i = 1; i < numPartitions; ++i) {
+            splitPoints.push_back(recordIds[i * recordIds.size() / numPartitions]);
+        }
+        return splitPoints;
+    }
+
+    // Creates a parallel scan computing the partial groups of 'groupSpec', followed by the stage
+    // which merges them.
+    intrusive_ptr<DocumentSource> makeParallelGroup(const intrusive_ptr<ExpressionContext>& expCtx,
+                                                    const BSONObj& groupSpec,
+                                                    size_t numPartitions) {
+        auto source = DocumentSourceGroup::createFromBson(groupSpec.firstElement(), expCtx);
+        auto group = checked_cast<DocumentSourceGroup*>(source.get());
+        auto points = splitPoints(expCtx->opCtx, numPartitions);
+
+        AutoGetCollectionForRead autoColl(expCtx->opCtx, nss);
+        _scan = DocumentSourceParallelCollectionScan::create(
+            expCtx, autoColl.getCollection(), BSONObj(), *group, std::move(points));
+        auto merger = group->distributedPlanLogic()->mergingStage;
+        merger->setSource(_scan.get());
+        return merger;
+    }
+
+    // Checks the results of {$group: {_id: "$key", count: {$sum: 1}, total: {$sum: "$x"}}}.
+    void assertGroupResults(const vector<Document>& results) {
+        ASSERT_EQUALS(static_cast<size_t>(kNumGroups), results.size());
+        for (auto&& result : results) {
+            const int key = result["_id"].coerceToInt();
+            long long expectedTotal = 0;
+            for (int i = key; i < kNumDocs; i += kNumGroups) {
+                expectedTotal += i;
+            }
+            ASSERT_EQUALS(kNumDocs / kNumGroups, result["count"].coerceToInt());
+            ASSERT_EQUALS(expectedTotal, result["total"].coerceToLong());
+        }
+    }
+
+    const BSONObj kGroupSpec = fromjson(
+        "{$group: {_id: '$key', count: {$sum: 1}, total: {$sum: '$x'}}}");
+
+private:
+    intrusive_ptr<DocumentSourceParallelCollectionScan> _scan;
+};
+
+TEST_F(DocumentSourceParallelCollectionScanTest, MergesGroupsFromEveryPartition) {
+    insertDocs();
+    auto merger = makeParallelGroup(ctx(), kGroupSpec, 4);
+    ON_BLOCK_EXIT([&] { merger->dispose(); });
+
+    // Every group has documents in every partition, so each partition produces a partial result
+    // for each group which the merging stage must combine.
+    vector<Document> results;
+    for (auto next = merger->getNext(); next.isAdvanced(); next = merger->getNext()) {
+        results.push_back(next.releaseDocument());
+    }
+    assertGroupResults(results);
+}
+
+TEST_F(DocumentSourceParallelCollectionScanTest, PipelineRewritesLeadingGroupToParallelScan) {
+    insertDocs();
+
+    const auto oldWorkers = internalQueryParallelCollectionScanWorkers.load();
+    const auto oldMinRecords = internalQueryParallelCollectionScanMinRecords.load();
+    internalQueryParallelCollectionScanWorkers.store(4);
+    internalQueryParallelCollectionScanMinRecords.store(0);
+    ON_BLOCK_EXIT([&] {
+        internalQueryParallelCollectionScanWorkers.store(oldWorkers);
+        internalQueryParallelCollectionScanMinRecords.store(oldMinRecords);
+    });
+
+    auto pipeline = Pipeline::parse({kGroupSpec}, ctx());
+    {
+        AutoGetCollectionForRead autoColl(opCtx(), nss);
+        if (!autoColl.getCollection()->getRecordStore()->getRandomCursor(opCtx())) {
+            // The split points are sampled with a random cursor, so the scan is not split.
+            return;
+        }
+        PipelineD::buildAndAttachInnerQueryExecutorToPipeline(
+            autoColl.getCollection(), nss, nullptr, pipeline.get());
+    }
+
+    auto&& sources = pipeline->getSources();
+    ASSERT_EQUALS(2U, sources.size());
+    ASSERT_EQUALS(DocumentSourceParallelCollectionScan::kStageName,
+                  sources.front()->getSourceName());
+    ASSERT_EQUALS("$group"_sd, sources.back()->getSourceName());
+
+    vector<Document> results;
+    while (auto next = pipeline->getNext()) {
+        results.push_back(*next);
+    }
+    assertGroupResults(results);
+}
+
+TEST_F(DocumentSourceParallelCollectionScanTest, WorkerErrorIsReturnedToConsumer) {
+    insertDocs();
+
+    // Only the document with x: 0, which is in the first partition, fails to evaluate.
+    auto merger = makeParallelGroup(
+        ctx(), fromjson("{$group: {_id: null, s: {$sum: {$divide: [1, '$x']}}}}"), 4);
+    ON_BLOCK_EXIT([&] { merger->dispose(); });
+
+    ASSERT_THROWS_CODE(
+        [&] {
+            while (merger->getNext().isAdvanced()) {
+            }
+        }(),
+        AssertionException,
+        16608);
+}
+
+TEST_F(DocumentSourceParallelCollectionScanTest, KillingTheOperationStopsTheWorkers) {
+    insertDocs();
+
+    // Run on an operation of its own, which can be killed without affecting the fixture.
+    auto client = opCtx()->getServiceContext()->makeClient("parallelCollectionScanKillTest");
+    AlternativeClientRegion acr(client);
+    auto killedOpCtx = cc().makeOperationContext();
+    auto expCtx = make_intrusive<ExpressionContextForTest>(killedOpCtx.get(),
+                                                           AggregationRequest(nss, {}));
+    auto merger = makeParallelGroup(expCtx, kGroupSpec, 4);
+
+    // Hold the workers before they produce anything, so that the only way for them to finish is
+    // to be interrupted.
+    FailPointEnableBlock failPoint("hangParallelCollectionScanWorkerBeforeScanning");
+    {
+        stdx::lock_guard<Client> lk(*killedOpCtx->getClient());
+        killedOpCtx->markKilled(ErrorCodes::Interrupted);
+    }
+    ASSERT_THROWS_CODE(merger->getNext(), AssertionException, ErrorCodes::Interrupted);
+
+    // Disposing of the stages interrupts the waiting workers and joins them.
+    merger->dispose();
+}
+
+TEST_F(DocumentSourceParallelCollectionScanTest, DisposeBeforeExhaustionJoinsTheWorkers) {
+    insertDocs();
+
+    // Each document is its own group, so the workers produce more results than are consumed.
+    auto merger = makeParallelGroup(ctx(), fromjson("{$group: {_id: '$_id'}}"), 4);
+    ASSERT(merger->getNext().isAdvanced());
+    merger->dispose();
+}
+
 }  // namespace
 }  // namespace mongo
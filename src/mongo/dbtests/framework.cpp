@@ -50,6 +50,7 @@
 #include "mongo/db/s/sharding_state.h"
 #include "mongo/db/service_context.h"
 #include "mongo/db/storage/storage_engine_init.h"
+#include "mongo/db/views/incremental_view_op_observer.h"
 #include "mongo/dbtests/dbtests.h"
 #include "mongo/dbtests/framework_options.h"
 #include "mongo/platform/mutex.h"
@@ -112,6 +113,7 @@ int runDbTests(int argc, char** argv) {
     IndexBuildsCoordinator::set(globalServiceContext,
                                 std::make_unique<IndexBuildsCoordinatorMongod>());
     auto registry = std::make_unique<OpObserverRegistry>();
+    registry->addObserver(std::make_unique<IncrementalViewOpObserver>());
     globalServiceContext->setOpObserver(std::move(registry));
 
     int ret = unittest::Suite::run(frameworkGlobalParams.suites,
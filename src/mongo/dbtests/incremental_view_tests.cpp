@@ -0,0 +1,289 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#include "mongo/platform/basic.h"
+
+#include <algorithm>
+
+#include "mongo/client/dbclient_cursor.h"
+#include "mongo/db/client.h"
+#include "mongo/db/dbdirectclient.h"
+#include "mongo/db/pipeline/expression_context.h"
+#include "mongo/db/views/incremental_view_catalog.h"
+#include "mongo/unittest/unittest.h"
+#include "mongo/util/fail_point.h"
+
+namespace mongo {
+namespace {
+
+const NamespaceString kSourceNss("unittests.incremental_view_source");
+const NamespaceString kTargetNss("unittests.incremental_view_target");
+const NamespaceString kRenamedNss("unittests.incremental_view_renamed");
+
+/**
+ * Maintains a view summing 'b' by 'a' over a source written to through a direct client, so that
+ * the writes reach the catalog through the op observer.
+ */
+class IncrementalViewCatalogTest : public unittest::Test {
+public:
+    IncrementalViewCatalogTest() : _opCtx(cc().makeOperationContext()), _client(_opCtx.get()) {
+        _client.dropCollection(kSourceNss.ns());
+        _client.dropCollection(kTargetNss.ns());
+        _client.dropCollection(kRenamedNss.ns());
+        _client.remove(IncrementalViewCatalog::kRegistryNamespace.ns(), BSONObj());
+        createSource(BSONObj());
+    }
+
+    ~IncrementalViewCatalogTest() {
+        // Dropping the source unregisters the view.
+        _client.dropCollection(kSourceNss.ns());
+        _client.dropCollection(kTargetNss.ns());
+        _client.dropCollection(kRenamedNss.ns());
+        _client.remove(IncrementalViewCatalog::kRegistryNamespace.ns(), BSONObj());
+    }
+
+protected:
+    void createSource(const BSONObj& collation) {
+        BSONObjBuilder cmd;
+        cmd.append("create", kSourceNss.coll());
+        cmd.append("recordPreImages", true);
+        if (!collation.isEmpty()) {
+            cmd.append("collation", collation);
+        }
+        BSONObj info;
+        ASSERT(_client.runCommand(kSourceNss.db().toString(), cmd.obj(), info)) << info;
+    }
+
+    IncrementalViewCatalog* catalog() {
+        return IncrementalViewCatalog::get(_opCtx.get());
+    }
+
+    void createView() {
+        auto expCtx = make_intrusive<ExpressionContext>(_opCtx.get(), nullptr, kSourceNss);
+        catalog()->createView(
+            _opCtx.get(),
+            IncrementalView::parse(expCtx,
+                                   kSourceNss,
+                                   kTargetNss,
+                                   {BSON("$group" << BSON("_id"
+                                                          << "$a"
+                                                          << "total"
+                                                          << BSON("$sum"
+                                                                  << "$b")))}));
+    }
+
+    void flush() {
+        catalog()->flush(_opCtx.get());
+    }
+
+    void assertGroup(int id, long long count, long long total) {
+        auto doc = _client.findOne(kTargetNss.ns(), BSON("_id" << id));
+        ASSERT_FALSE(doc.isEmpty()) << "group " << id;
+        ASSERT_EQ(doc[IncrementalView::kStateFieldName]["count"].numberLong(), count) << doc;
+        ASSERT_EQ(doc["total"].numberLong(), total) << doc;
+    }
+
+    void assertNoGroup(int id) {
+        auto doc = _client.findOne(kTargetNss.ns(), BSON("_id" << id));
+        ASSERT(doc.isEmpty()) << doc;
+    }
+
+    BSONObj registration() {
+        return _client.findOne(IncrementalViewCatalog::kRegistryNamespace.ns(),
+                               BSON("_id" << kTargetNss.ns()));
+    }
+
+    ServiceContext::UniqueOperationContext _opCtx;
+    DBDirectClient _client;
+};
+
+TEST_F(IncrementalViewCatalogTest, FlushAppliesWritesToTarget) {
+    _client.insert(kSourceNss.ns(),
+                   {BSON("_id" << 1 << "a" << 1 << "b" << 2),
+                    BSON("_id" << 2 << "a" << 1 << "b" << 4),
+                    BSON("_id" << 3 << "a" << 2 << "b" << 3)});
+    createView();
+    assertGroup(1, 2, 6);
+    assertGroup(2, 1, 3);
+    ASSERT_EQ(registration()["state"].str(), "ready");
+
+    _client.update(kSourceNss.ns(), BSON("_id" << 3), BSON("$set" << BSON("a" << 1)));
+    _client.remove(kSourceNss.ns(), BSON("_id" << 1));
+    _client.insert(kSourceNss.ns(), BSON("_id" << 4 << "a" << 3 << "b" << 1));
+    flush();
+
+    assertGroup(1, 2, 7);
+    assertNoGroup(2);
+    assertGroup(3, 1, 1);
+}
+
+TEST_F(IncrementalViewCatalogTest, BuildReadsSourceInBatches) {
+    std::vector<BSONObj> docs;
+    for (int i = 0; i < 2500; ++i) {
+        docs.push_back(BSON("_id" << i << "a" << i % 3 << "b" << 1));
+    }
+    _client.insert(kSourceNss.ns(), docs);
+    createView();
+
+    assertGroup(0, 834, 834);
+    assertGroup(1, 833, 833);
+    assertGroup(2, 833, 833);
+}
+
+TEST_F(IncrementalViewCatalogTest, BuildWritesGroupsInBatches) {
+    std::vector<BSONObj> docs;
+    for (int i = 0; i < 2500; ++i) {
+        docs.push_back(BSON("_id" << i << "a" << i << "b" << 1));
+    }
+    _client.insert(kSourceNss.ns(), docs);
+    createView();
+
+    ASSERT_EQ(_client.count(kTargetNss), 2500);
+    assertGroup(0, 1, 1);
+    assertGroup(2499, 1, 1);
+}
+
+TEST_F(IncrementalViewCatalogTest, BuildReplacesTargetKeepingItsIndexes) {
+    // The target holds a group the source doesn't have, and an index.
+    _client.insert(kTargetNss.ns(), BSON("_id" << 5 << "total" << 1));
+    _client.createIndex(kTargetNss.ns(), BSON("total" << 1));
+    _client.insert(kSourceNss.ns(),
+                   {BSON("_id" << 1 << "a" << 1 << "b" << 2),
+                    BSON("_id" << 2 << "a" << 1 << "b" << 4)});
+    createView();
+
+    assertGroup(1, 2, 6);
+    assertNoGroup(5);
+    auto indexes = _client.getIndexSpecs(kTargetNss, false /* includeBuildUUIDs */, 0);
+    ASSERT(std::any_of(indexes.begin(), indexes.end(), [](const BSONObj& spec) {
+        return spec["name"].str() == "total_1";
+    }));
+    ASSERT(_client
+               .getCollectionInfos(kTargetNss.db().toString(),
+                                   BSON("name" << BSON("$regex"
+                                                       << "^tmp\\.")))
+               .empty());
+
+    // Replacing the target didn't unregister the view.
+    ASSERT_EQ(registration()["state"].str(), "ready");
+    _client.insert(kSourceNss.ns(), BSON("_id" << 3 << "a" << 1 << "b" << 1));
+    flush();
+    assertGroup(1, 3, 7);
+}
+
+TEST_F(IncrementalViewCatalogTest, GroupsUseCollationOfSource) {
+    _client.dropCollection(kSourceNss.ns());
+    createSource(BSON("locale"
+                      << "en"
+                      << "strength" << 2));
+    _client.insert(kSourceNss.ns(),
+                   {BSON("_id" << 1 << "a"
+                               << "x"
+                               << "b" << 1),
+                    BSON("_id" << 2 << "a"
+                               << "X"
+                               << "b" << 2)});
+    createView();
+    ASSERT_EQ(_client.count(kTargetNss), 1);
+
+    _client.insert(kSourceNss.ns(),
+                   BSON("_id" << 3 << "a"
+                              << "X"
+                              << "b" << 4));
+    flush();
+    ASSERT_EQ(_client.count(kTargetNss), 1);
+    auto doc = _client.findOne(kTargetNss.ns(), BSONObj());
+    ASSERT_EQ(doc[IncrementalView::kStateFieldName]["count"].numberLong(), 3) << doc;
+    ASSERT_EQ(doc["total"].numberLong(), 7) << doc;
+}
+
+TEST_F(IncrementalViewCatalogTest, RenamingSourceUnregistersView) {
+    _client.insert(kSourceNss.ns(), BSON("_id" << 1 << "a" << 1 << "b" << 2));
+    createView();
+
+    BSONObj info;
+    ASSERT(_client.runCommand(
+        "admin", BSON("renameCollection" << kSourceNss.ns() << "to" << kRenamedNss.ns()), info))
+        << info;
+    _client.insert(kRenamedNss.ns(), BSON("_id" << 2 << "a" << 1 << "b" << 4));
+    flush();
+
+    ASSERT(registration().isEmpty());
+    assertGroup(1, 1, 2);
+}
+
+TEST_F(IncrementalViewCatalogTest, PartiallyAppliedBatchIsRetriedWithoutApplyingItTwice) {
+    _client.insert(kSourceNss.ns(),
+                   {BSON("_id" << 1 << "a" << 1 << "b" << 2),
+                    BSON("_id" << 2 << "a" << 2 << "b" << 5)});
+    createView();
+
+    _client.remove(kSourceNss.ns(), BSON("_id" << 2));
+    _client.insert(kSourceNss.ns(), BSON("_id" << 3 << "a" << 1 << "b" << 3));
+    {
+        // The groups are updated, but the emptied one is not removed.
+        FailPointEnableBlock failPoint("failIncrementalViewRefreshBeforeDeletes");
+        flush();
+        assertGroup(1, 2, 5);
+        assertGroup(2, 0, 0);
+
+        flush();
+        assertGroup(1, 2, 5);
+        assertGroup(2, 0, 0);
+    }
+
+    flush();
+    assertGroup(1, 2, 5);
+    assertNoGroup(2);
+}
+
+TEST_F(IncrementalViewCatalogTest, WriteWithoutPreImageInvalidatesView) {
+    _client.insert(kSourceNss.ns(),
+                   {BSON("_id" << 1 << "a" << 1 << "b" << 2),
+                    BSON("_id" << 2 << "a" << 1 << "b" << 4)});
+    createView();
+
+    BSONObj info;
+    ASSERT(_client.runCommand(kSourceNss.db().toString(),
+                              BSON("collMod" << kSourceNss.coll() << "recordPreImages" << false),
+                              info))
+        << info;
+    _client.remove(kSourceNss.ns(), BSON("_id" << 1));
+    _client.insert(kSourceNss.ns(), BSON("_id" << 3 << "a" << 1 << "b" << 8));
+    flush();
+
+    auto doc = registration();
+    ASSERT_EQ(doc["state"].str(), "invalid") << doc;
+    ASSERT_FALSE(doc["reason"].str().empty()) << doc;
+    assertGroup(1, 2, 6);
+}
+
+}  // namespace
+}  // namespace mongo
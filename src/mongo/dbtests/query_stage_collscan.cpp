@@ -34,6 +34,7 @@
 #include "mongo/platform/basic.h"
 
 #include <memory>
+#include <vector>
 
 #include "mongo/client/dbclient_cursor.h"
 #include "mongo/db/catalog/collection.h"
@@ -43,14 +44,18 @@
 #include "mongo/db/dbdirectclient.h"
 #include "mongo/db/exec/collection_scan.h"
 #include "mongo/db/exec/plan_stage.h"
+#include "mongo/db/exec/record_batch.h"
 #include "mongo/db/json.h"
 #include "mongo/db/matcher/expression_parser.h"
 #include "mongo/db/namespace_string.h"
 #include "mongo/db/query/plan_executor.h"
+#include "mongo/db/query/query_knobs_gen.h"
 #include "mongo/db/storage/record_store.h"
+#include "mongo/db/storage/storage_options.h"
 #include "mongo/dbtests/dbtests.h"
 #include "mongo/unittest/unittest.h"
 #include "mongo/util/fail_point.h"
+#include "mongo/util/scopeguard.h"
 
 namespace query_stage_collection_scan {
 
@@ -238,6 +243,150 @@ TEST_F(QueryStageCollectionScanTest, QueryStageCollscanObjectsInOrderBackward) {
     ASSERT_EQUALS(numObj(), count);
 }
 
+// Batched execution returns the same objects, in the same order, as per-document execution.
+TEST_F(QueryStageCollectionScanTest, QueryStageCollscanBatchedExecutionMatchesPerDocument) {
+    internalQueryEnableBatchedExecution.store(true);
+    internalQueryExecBatchedWorkSize.store(7);
+    ON_BLOCK_EXIT([] {
+        internalQueryEnableBatchedExecution.store(false);
+        internalQueryExecBatchedWorkSize.store(128);
+    });
+
+    ASSERT_EQUALS(numObj(), countResults(CollectionScanParams::FORWARD, BSONObj()));
+    ASSERT_EQUALS(25,
+                  countResults(CollectionScanParams::BACKWARD, BSON("foo" << BSON("$lt" << 25))));
+
+    AutoGetCollectionForReadCommand ctx(&_opCtx, nss);
+    auto collection = ctx.getCollection();
+
+    vector<RecordId> recordIds;
+    getRecordIds(collection, CollectionScanParams::FORWARD, &recordIds);
+
+    CollectionScanParams params;
+    params.direction = CollectionScanParams::FORWARD;
+    params.tailable = false;
+
+    unique_ptr<WorkingSet> ws = std::make_unique<WorkingSet>();
+    unique_ptr<PlanStage> ps =
+        std::make_unique<CollectionScan>(_expCtx.get(), collection, params, ws.get(), nullptr);
+    ASSERT_TRUE(ps->supportsBatchedWork());
+
+    auto statusWithPlanExecutor = PlanExecutor::make(
+        &_opCtx, std::move(ws), std::move(ps), collection, PlanExecutor::NO_YIELD);
+    ASSERT_OK(statusWithPlanExecutor.getStatus());
+    auto exec = std::move(statusWithPlanExecutor.getValue());
+
+    int count = 0;
+    PlanExecutor::ExecState state;
+    BSONObj obj;
+    RecordId recordId;
+    while (PlanExecutor::ADVANCED == (state = exec->getNext(&obj, &recordId))) {
+        ASSERT_EQUALS(count, obj["foo"].numberInt());
+        ASSERT_EQUALS(recordIds[count], recordId);
+        ++count;
+    }
+    ASSERT_EQUALS(PlanExecutor::IS_EOF, state);
+    ASSERT_EQUALS(numObj(), count);
+    ASSERT_TRUE(exec->isEOF());
+}
+
+// A batch examines at most its capacity in documents, even if none of them match the filter.
+TEST_F(QueryStageCollectionScanTest, QueryStageCollscanWorkBatchBoundsDocumentsExamined) {
+    AutoGetCollectionForReadCommand ctx(&_opCtx, nss);
+    auto collection = ctx.getCollection();
+
+    CollectionScanParams params;
+    params.direction = CollectionScanParams::FORWARD;
+    params.tailable = false;
+
+    BSONObj filterObj = BSON("foo" << BSON("$gte" << numObj()));
+    auto statusWithMatcher = MatchExpressionParser::parse(filterObj, _expCtx);
+    ASSERT_OK(statusWithMatcher.getStatus());
+    unique_ptr<MatchExpression> filterExpr = std::move(statusWithMatcher.getValue());
+
+    WorkingSet ws;
+    CollectionScan scan(_expCtx.get(), collection, params, &ws, filterExpr.get());
+
+    const size_t batchSize = 10;
+    RecordBatch batch(batchSize);
+    for (int i = 0; i < numObj() / static_cast<int>(batchSize); ++i) {
+        ASSERT_EQUALS(PlanStage::NEED_TIME, scan.workBatch(&batch));
+        ASSERT_TRUE(batch.empty());
+        auto stats = static_cast<const CollectionScanStats*>(scan.getSpecificStats());
+        ASSERT_EQUALS((i + 1) * batchSize, stats->docsTested);
+    }
+    ASSERT_EQUALS(PlanStage::IS_EOF, scan.workBatch(&batch));
+    ASSERT_TRUE(scan.isEOF());
+}
+
+// A write conflict part way through a batch discards the batch and yields. The next batch resumes
+// after the last document returned, so none are lost or returned twice.
+TEST_F(QueryStageCollectionScanTest, QueryStageCollscanWorkBatchRetriesBatchAfterWriteConflict) {
+    if (storageGlobalParams.engine != "wiredTiger") {
+        // The write conflict is injected with a WiredTiger fail point.
+        return;
+    }
+
+    AutoGetCollectionForReadCommand ctx(&_opCtx, nss);
+    auto collection = ctx.getCollection();
+
+    CollectionScanParams params;
+    params.direction = CollectionScanParams::FORWARD;
+    params.tailable = false;
+
+    WorkingSet ws;
+    CollectionScan scan(_expCtx.get(), collection, params, &ws, nullptr);
+
+    std::vector<int> results;
+    RecordBatch batch(10);
+    auto collectBatch = [&] {
+        for (size_t i = 0; i < batch.size(); ++i) {
+            results.push_back(batch.getObj(i)["foo"].numberInt());
+        }
+        batch.clear();
+    };
+
+    ASSERT_EQUALS(PlanStage::ADVANCED, scan.workBatch(&batch));
+    collectBatch();
+
+    {
+        auto failPoint = globalFailPointRegistry().find("WTWriteConflictExceptionForReads");
+        failPoint->setMode(FailPoint::skip, 5);
+        ON_BLOCK_EXIT([&] { failPoint->setMode(FailPoint::off); });
+        ASSERT_EQUALS(PlanStage::NEED_YIELD, scan.workBatch(&batch));
+        ASSERT_TRUE(batch.empty());
+    }
+
+    scan.saveState();
+    _opCtx.recoveryUnit()->abandonSnapshot();
+    scan.restoreState();
+
+    PlanStage::StageState state;
+    while (PlanStage::IS_EOF != (state = scan.workBatch(&batch))) {
+        ASSERT_EQUALS(PlanStage::ADVANCED, state);
+        collectBatch();
+    }
+
+    ASSERT_EQUALS(static_cast<size_t>(numObj()), results.size());
+    for (int i = 0; i < numObj(); ++i) {
+        ASSERT_EQUALS(i, results[i]);
+    }
+}
+
+// Scans which must report their position after each document are not batched.
+TEST_F(QueryStageCollectionScanTest, QueryStageCollscanDoesNotBatchWhenResumeTokenRequested) {
+    AutoGetCollectionForReadCommand ctx(&_opCtx, nss);
+    auto collection = ctx.getCollection();
+
+    CollectionScanParams params;
+    params.direction = CollectionScanParams::FORWARD;
+    params.requestResumeToken = true;
+
+    WorkingSet ws;
+    CollectionScan scan(_expCtx.get(), collection, params, &ws, nullptr);
+    ASSERT_FALSE(scan.supportsBatchedWork());
+}
+
 // Scan through half the objects, delete the one we're about to fetch, then expect to get the "next"
 // object we would have gotten after that.
 TEST_F(QueryStageCollectionScanTest, QueryStageCollscanDeleteUpcomingObject) {
@@ -425,4 +574,70 @@ TEST_F(QueryStageCollectionScanTest, QueryTestCollscanResumeAfterRecordIdSeekFai
     ASSERT_EQUALS(PlanStage::FAILURE, ps->work(&id));
 }
 
+// Verify that a scan restricted to a RecordId range returns exactly the records in the range.
+TEST_F(QueryStageCollectionScanTest, QueryStageCollscanRecordIdRange) {
+    AutoGetCollectionForReadCommand ctx(&_opCtx, nss);
+    auto collection = ctx.getCollection();
+
+    vector<RecordId> recordIds;
+    getRecordIds(collection, CollectionScanParams::FORWARD, &recordIds);
+
+    CollectionScanParams params;
+    params.direction = CollectionScanParams::FORWARD;
+    params.minRecord = recordIds[10];
+    params.maxRecord = recordIds[20];
+
+    unique_ptr<WorkingSet> ws = std::make_unique<WorkingSet>();
+    unique_ptr<PlanStage> ps =
+        std::make_unique<CollectionScan>(_expCtx.get(), collection, params, ws.get(), nullptr);
+    ASSERT_FALSE(ps->supportsBatchedWork());
+
+    auto statusWithPlanExecutor = PlanExecutor::make(
+        &_opCtx, std::move(ws), std::move(ps), collection, PlanExecutor::NO_YIELD);
+    ASSERT_OK(statusWithPlanExecutor.getStatus());
+    auto exec = std::move(statusWithPlanExecutor.getValue());
+
+    int count = 0;
+    PlanExecutor::ExecState state;
+    for (BSONObj obj; PlanExecutor::ADVANCED == (state = exec->getNext(&obj, nullptr));) {
+        ASSERT_EQUALS(count + 10, obj["foo"].numberInt());
+        ++count;
+    }
+    ASSERT_EQUALS(PlanExecutor::IS_EOF, state);
+    ASSERT_EQUALS(10, count);
+}
+
+// Verify that a range scan whose lower bound no longer exists still starts at the first record
+// above the bound.
+TEST_F(QueryStageCollectionScanTest, QueryStageCollscanRecordIdRangeMissingLowerBound) {
+    dbtests::WriteContextForTests ctx(&_opCtx, nss.ns());
+    auto coll = ctx.getCollection();
+
+    vector<RecordId> recordIds;
+    getRecordIds(coll, CollectionScanParams::FORWARD, &recordIds);
+
+    CollectionScanParams params;
+    params.direction = CollectionScanParams::FORWARD;
+    params.minRecord = recordIds[10];
+    remove(coll->docFor(&_opCtx, recordIds[10]).value());
+
+    unique_ptr<WorkingSet> ws = std::make_unique<WorkingSet>();
+    unique_ptr<PlanStage> ps =
+        std::make_unique<CollectionScan>(_expCtx.get(), coll, params, ws.get(), nullptr);
+
+    auto statusWithPlanExecutor =
+        PlanExecutor::make(&_opCtx, std::move(ws), std::move(ps), coll, PlanExecutor::NO_YIELD);
+    ASSERT_OK(statusWithPlanExecutor.getStatus());
+    auto exec = std::move(statusWithPlanExecutor.getValue());
+
+    int count = 0;
+    PlanExecutor::ExecState state;
+    for (BSONObj obj; PlanExecutor::ADVANCED == (state = exec->getNext(&obj, nullptr));) {
+        ASSERT_EQUALS(count + 11, obj["foo"].numberInt());
+        ++count;
+    }
+    ASSERT_EQUALS(PlanExecutor::IS_EOF, state);
+    ASSERT_EQUALS(numObj() - 11, count);
+}
+
 }  // namespace query_stage_collection_scan
@@ -57,6 +57,7 @@
 #include "mongo/db/query/stage_builder.h"
 #include "mongo/dbtests/dbtests.h"
 #include "mongo/util/clock_source_mock.h"
+#include "mongo/util/scopeguard.h"
 
 namespace mongo {
 
@@ -273,6 +274,89 @@ TEST_F(QueryStageMultiPlanTest, MPSCollectionScanVsHighlySelectiveIXScan) {
     ASSERT_EQUALS(results, N / 10);
 }
 
+TEST_F(QueryStageMultiPlanTest, MPSEliminatesUnproductivePlansEarly) {
+    const int N = 5000;
+    for (int i = 0; i < N; ++i) {
+        insert(BSON("foo" << (i % 10)));
+    }
+
+    addIndex(BSON("foo" << 1));
+
+    const auto oldPeriod = internalQueryPlanEvaluationEliminationPeriod.load();
+    internalQueryPlanEvaluationEliminationPeriod.store(10);
+    ON_BLOCK_EXIT([&] { internalQueryPlanEvaluationEliminationPeriod.store(oldPeriod); });
+
+    AutoGetCollectionForReadCommand ctx(_opCtx.get(), nss);
+    const Collection* coll = ctx.getCollection();
+
+    // The index scan produces a result on every call to work(), while the collection scan only
+    // produces one on every tenth call, so the latter is eliminated at the first check.
+    unique_ptr<WorkingSet> sharedWs(new WorkingSet());
+    unique_ptr<PlanStage> ixScanRoot = getIxScanPlan(_expCtx.get(), coll, sharedWs.get(), 7);
+    BSONObj filterObj = BSON("foo" << 7);
+    unique_ptr<MatchExpression> filter = makeMatchExpressionFromFilter(_expCtx.get(), filterObj);
+    unique_ptr<PlanStage> collScanRoot =
+        getCollScanPlan(_expCtx.get(), coll, sharedWs.get(), filter.get());
+
+    auto cq = makeCanonicalQuery(_opCtx.get(), nss, filterObj);
+    unique_ptr<MultiPlanStage> mps =
+        std::make_unique<MultiPlanStage>(_expCtx.get(), coll, cq.get());
+    mps->addPlan(createQuerySolution(), std::move(ixScanRoot), sharedWs.get());
+    mps->addPlan(createQuerySolution(), std::move(collScanRoot), sharedWs.get());
+
+    PlanYieldPolicy yieldPolicy(PlanExecutor::NO_YIELD, _clock);
+    ASSERT_OK(mps->pickBestPlan(&yieldPolicy));
+    ASSERT(mps->bestPlanChosen());
+    ASSERT_EQUALS(0, mps->bestPlanIdx());
+
+    // The index scan kept running until it produced a full batch of results.
+    const size_t numResults = internalQueryPlanEvaluationMaxResults.load();
+    ASSERT_GTE(mps->getChildren()[0]->getStats()->common.advanced, numResults);
+    ASSERT_EQUALS(mps->getChildren()[1]->getStats()->common.works, 10U);
+}
+
+TEST_F(QueryStageMultiPlanTest, MPSDoesNotEliminateBlockingPlansEarly) {
+    const int N = 5000;
+    for (int i = 0; i < N; ++i) {
+        insert(BSON("foo" << (i % 10)));
+    }
+
+    addIndex(BSON("foo" << 1));
+
+    const auto oldPeriod = internalQueryPlanEvaluationEliminationPeriod.load();
+    internalQueryPlanEvaluationEliminationPeriod.store(10);
+    ON_BLOCK_EXIT([&] { internalQueryPlanEvaluationEliminationPeriod.store(oldPeriod); });
+
+    AutoGetCollectionForReadCommand ctx(_opCtx.get(), nss);
+    const Collection* coll = ctx.getCollection();
+
+    // As above, but the collection scan plan claims to have a blocking stage, so its lack of
+    // results so far does not get it eliminated.
+    unique_ptr<WorkingSet> sharedWs(new WorkingSet());
+    unique_ptr<PlanStage> ixScanRoot = getIxScanPlan(_expCtx.get(), coll, sharedWs.get(), 7);
+    BSONObj filterObj = BSON("foo" << 7);
+    unique_ptr<MatchExpression> filter = makeMatchExpressionFromFilter(_expCtx.get(), filterObj);
+    unique_ptr<PlanStage> collScanRoot =
+        getCollScanPlan(_expCtx.get(), coll, sharedWs.get(), filter.get());
+
+    auto cq = makeCanonicalQuery(_opCtx.get(), nss, filterObj);
+    unique_ptr<MultiPlanStage> mps =
+        std::make_unique<MultiPlanStage>(_expCtx.get(), coll, cq.get());
+    mps->addPlan(createQuerySolution(), std::move(ixScanRoot), sharedWs.get());
+    auto blockingSolution = createQuerySolution();
+    blockingSolution->hasBlockingStage = true;
+    mps->addPlan(std::move(blockingSolution), std::move(collScanRoot), sharedWs.get());
+
+    PlanYieldPolicy yieldPolicy(PlanExecutor::NO_YIELD, _clock);
+    ASSERT_OK(mps->pickBestPlan(&yieldPolicy));
+    ASSERT(mps->bestPlanChosen());
+    ASSERT_EQUALS(0, mps->bestPlanIdx());
+
+    // Both plans were worked for the whole trial period.
+    ASSERT_EQUALS(mps->getChildren()[0]->getStats()->common.works,
+                  mps->getChildren()[1]->getStats()->common.works);
+}
+
 TEST_F(QueryStageMultiPlanTest, MPSDoesNotCreateActiveCacheEntryImmediately) {
     const int N = 100;
     for (int i = 0; i < N; ++i) {
@@ -414,6 +414,12 @@ bool ReplicationCoordinatorEmbedded::shouldChangeSyncSource(const HostAndPort&,
     UASSERT_NOT_IMPLEMENTED;
 }
 
+void ReplicationCoordinatorEmbedded::recordSyncSourceFetchStats(const HostAndPort&,
+                                                                Milliseconds,
+                                                                long long) {
+    UASSERT_NOT_IMPLEMENTED;
+}
+
 void ReplicationCoordinatorEmbedded::advanceCommitPoint(const OpTimeAndWallTime&,
                                                         bool fromSyncSource) {
     UASSERT_NOT_IMPLEMENTED;
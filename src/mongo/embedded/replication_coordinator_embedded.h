@@ -216,6 +216,8 @@ public:
                                 const rpc::ReplSetMetadata&,
                                 const rpc::OplogQueryMetadata&) override;
 
+    void recordSyncSourceFetchStats(const HostAndPort&, Milliseconds, long long) override;
+
     repl::OpTime getLastCommittedOpTime() const override;
 
     repl::OpTimeAndWallTime getLastCommittedOpTimeAndWallTime() const override;